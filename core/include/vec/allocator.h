@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace vec {
+
+// Allocators are static policies passed as the second template argument of Vec:
+//     template <typename T> static T* allocate(size_t n);
+//     template <typename T> static void deallocate(T* p, size_t n);
+// buffers hold trivially copyable elements, nothing is constructed or destroyed.
+
+// plain new[]/delete[], the historical behaviour of Vec
+struct NewAllocator {
+    template <typename T>
+    static T* allocate(size_t n) {
+        return new (std::nothrow) T[n];
+    }
+
+    template <typename T>
+    static void deallocate(T* p, size_t /*n*/) {
+        delete[] p;
+    }
+};
+
+// Bump-pointer arena carved out of large 64-byte aligned chunks.
+// Buffers are never freed one by one: reset() hands every buffer back at once
+// (typically at the end of a batch) and keeps the chunks for the next batch.
+// Not thread safe, use one arena per thread (see thread_local_arena()).
+class ChunkArena {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+    explicit ChunkArena(size_t chunk_size = DEFAULT_CHUNK_SIZE) : _chunk_size(chunk_size) {}
+    ~ChunkArena() { release(); }
+
+    ChunkArena(const ChunkArena&) = delete;
+    ChunkArena& operator=(const ChunkArena&) = delete;
+
+    // the arena used by ArenaAllocator on the calling thread
+    static ChunkArena& thread_local_arena();
+
+    void* allocate(size_t bytes) {
+        bytes = round_up(bytes);
+        if (bytes <= static_cast<size_t>(_end - _cursor)) {
+            uint8_t* p = _cursor;
+            _cursor += bytes;
+            return p;
+        }
+        return allocate_slow(bytes);
+    }
+
+    // only the most recent allocation can be given back, anything else waits for reset()
+    void deallocate(void* p, size_t bytes) {
+        if (p != nullptr && static_cast<uint8_t*>(p) + round_up(bytes) == _cursor) {
+            _cursor = static_cast<uint8_t*>(p);
+        }
+    }
+
+    // give back all buffers at once, chunks are kept for reuse
+    void reset();
+
+    // free all chunks
+    void release();
+
+    // bytes handed out since the last reset()
+    size_t used_bytes() const;
+
+    // bytes held by chunks
+    size_t reserved_bytes() const { return _reserved_bytes; }
+
+private:
+    struct Chunk {
+        uint8_t* data;
+        size_t size;
+    };
+
+    static size_t round_up(size_t bytes) { return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+    void* allocate_slow(size_t bytes);
+
+    const size_t _chunk_size;
+    std::vector<Chunk> _chunks;
+    // index of the chunk being carved
+    size_t _current = 0;
+    uint8_t* _cursor = nullptr;
+    uint8_t* _end = nullptr;
+    size_t _reserved_bytes = 0;
+};
+
+// Draws Vec buffers from the calling thread's ChunkArena, eg:
+//     Vec<int, ArenaAllocator> v(4096);
+//     ...
+//     ChunkArena::thread_local_arena().reset(); // end of batch
+// a Vec must not be used after the arena it was allocated from is reset.
+struct ArenaAllocator {
+    template <typename T>
+    static T* allocate(size_t n) {
+        return static_cast<T*>(ChunkArena::thread_local_arena().allocate(n * sizeof(T)));
+    }
+
+    template <typename T>
+    static void deallocate(T* p, size_t n) {
+        ChunkArena::thread_local_arena().deallocate(p, n * sizeof(T));
+    }
+};
+
+// std allocator over an explicit arena, falls back to the heap when arena is null.
+// used by the std::vector based containers (FlatBinaryVec, InlineBinaryVec).
+template <typename T>
+class ArenaStlAllocator {
+public:
+    using value_type = T;
+    // a moved container keeps drawing from the arena of its buffer
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaStlAllocator(ChunkArena* arena = nullptr) : _arena(arena) {}
+
+    template <typename U>
+    ArenaStlAllocator(const ArenaStlAllocator<U>& other) : _arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (_arena == nullptr) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(_arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (_arena == nullptr) {
+            ::operator delete(p);
+        } else {
+            _arena->deallocate(p, n * sizeof(T));
+        }
+    }
+
+    ChunkArena* arena() const { return _arena; }
+
+    template <typename U>
+    bool operator==(const ArenaStlAllocator<U>& other) const {
+        return _arena == other.arena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaStlAllocator<U>& other) const {
+        return _arena != other.arena();
+    }
+
+private:
+    ChunkArena* _arena;
+};
+
+} // namespace vec
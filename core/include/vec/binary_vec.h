@@ -5,33 +5,211 @@
 #include <cstdint>
 #include <vector>
 
+#include "vec/allocator.h"
+#include "vec/bit_vec.h"
 #include "vec/slice.h"
+#include "vec/vec.h"
 
 namespace vec {
 
-class FlatBinaryVec {
+template <typename T>
+using ArenaVector = std::vector<T, ArenaStlAllocator<T>>;
+
+class InlineBinaryVec;
+
+// Rows [begin, end) of a FlatBinaryVec, no copy. Valid until the vector changes.
+class FlatBinaryView {
 public:
-    FlatBinaryVec() : _offsets(1) {}
-    Slice get_slice(int i) {
-        return Slice(reinterpret_cast<char*>(_bytes.data()) + _offsets[i],
-                     _offsets[i] - _offsets[i - 1]);
+    FlatBinaryView(const uint32_t* offsets, const uint8_t* bytes, size_t size)
+            : _offsets(offsets), _bytes(bytes), _size(size) {}
+
+    size_t size() const { return _size; }
+
+    Slice get_slice(size_t i) const {
+        return Slice(reinterpret_cast<const char*>(_bytes) + _offsets[i],
+                     _offsets[i + 1] - _offsets[i]);
     }
+
+    // the bytes of the rows are [offsets()[0], offsets()[size()]) of bytes()
+    const uint32_t* offsets() const { return _offsets; }
+    const uint8_t* bytes() const { return _bytes; }
+
+private:
+    const uint32_t* _offsets;
+    const uint8_t* _bytes;
+    size_t _size;
+};
+
+// Rows of an InlineBinaryVec, no copy. Valid until the vector changes.
+class InlineBinaryView {
+public:
+    InlineBinaryView(const SliceInline* slices, size_t size) : _slices(slices), _size(size) {}
+
+    size_t size() const { return _size; }
+
+    SliceInline get_slice(size_t i) const { return _slices[i]; }
+
+    const SliceInline* slices() const { return _slices; }
+
+private:
+    const SliceInline* _slices;
+    size_t _size;
+};
+
+// binary vectors draw their buffers from arena when given, from the heap otherwise
+
+// Strings back to back in one buffer, row i is [offsets[i], offsets[i + 1]) of the
+// bytes. Compact and a copy of a range of rows is a single memcpy, a row is found
+// through its offset.
+class FlatBinaryVec {
+public:
+    FlatBinaryVec(ChunkArena* arena = nullptr) : _offsets(1, 0, arena), _bytes(arena) {}
+
+    // the rows are slices, the previous ones are dropped
     void build_strings(const std::vector<Slice>& slices);
 
+    size_t size() const { return _offsets.size() - 1; }
+
+    bool empty() const { return size() == 0; }
+
+    Slice get_slice(size_t i) const {
+        return Slice(reinterpret_cast<const char*>(_bytes.data()) + _offsets[i],
+                     _offsets[i + 1] - _offsets[i]);
+    }
+
+    void append(const Slice& slice);
+
+    void append_batch(const Slice* slices, size_t num_rows);
+
+    void append_batch(const FlatBinaryView& rows);
+
+    void reserve(size_t num_rows, size_t num_bytes);
+
+    // no row, the memory is kept
+    void clear();
+
+    // Keeps the selected rows in order, in place: the bytes of the selected rows
+    // are moved down by runs of consecutive rows.
+    template <typename A>
+    void filter(const Vec<bool, A>& selector) {
+        VEC_ASSERT_TRUE(selector.len() == static_cast<int>(size()));
+        _filter(reinterpret_cast<const uint8_t*>(selector.data()));
+    }
+
+    void filter(const BitVec& selector);
+
+    // bit i is row i OP value (or rhs row i)
+    BitVec compare_bits(CompareOp op, const Slice& value) const;
+    BitVec compare_bits(CompareOp op, const FlatBinaryVec& rhs) const;
+
+    // row i of the result is row indices[i], in the same arena
+    FlatBinaryVec gather(const uint32_t* indices, size_t num_rows) const;
+
+    FlatBinaryView view(size_t begin, size_t end) const {
+        return FlatBinaryView(_offsets.data() + begin, _bytes.data(), end - begin);
+    }
+
+    // bytes of the rows: the strings and their offsets
+    size_t byte_size() const { return _bytes.size() + _offsets.size() * sizeof(uint32_t); }
+
+    // bytes allocated, with the room reserved for more rows
+    size_t capacity_bytes() const {
+        return _bytes.capacity() + _offsets.capacity() * sizeof(uint32_t);
+    }
+
+    // the same rows in the inline layout, in the same arena
+    InlineBinaryVec to_inline() const;
+
+    // row i is [offsets()[i], offsets()[i + 1]) of bytes()
+    const uint32_t* offsets() const { return _offsets.data(); }
+    const uint8_t* bytes() const { return _bytes.data(); }
+
 private:
-    std::vector<uint32_t> _offsets;
-    std::vector<uint8_t> _bytes;
+    void _filter(const uint8_t* selection);
+
+    ArenaVector<uint32_t> _offsets;
+    ArenaVector<uint8_t> _bytes;
 };
 
+// German strings: a 16-byte SliceInline a row with the size, the first 4 bytes and
+// either the rest of a string up to 12 bytes or a pointer to its bytes. A compare
+// mostly stays in the row array, and filter/gather move 16 bytes a row.
+//
+// The bytes of longer strings are copied to buffers of the vector that never grow
+// in place, so the pointers of the rows stay valid as rows are appended. Moving the
+// vector keeps them valid too, copying would not and is not allowed.
 class InlineBinaryVec {
 public:
-    InlineBinaryVec() = default;
+    InlineBinaryVec(ChunkArena* arena = nullptr) : _datas(arena), _arena(arena) {}
+
+    InlineBinaryVec(InlineBinaryVec&&) = default;
+    InlineBinaryVec& operator=(InlineBinaryVec&&) = default;
+    InlineBinaryVec(const InlineBinaryVec&) = delete;
+    InlineBinaryVec& operator=(const InlineBinaryVec&) = delete;
+
+    // the rows are slices, the previous ones are dropped
     void build_strings(const std::vector<Slice>& slices);
-    SliceInline get_slice(int i) { return _datas[i]; }
+
+    size_t size() const { return _datas.size(); }
+
+    bool empty() const { return _datas.empty(); }
+
+    SliceInline get_slice(size_t i) const { return _datas[i]; }
+
+    void append(const Slice& slice);
+
+    void append_batch(const Slice* slices, size_t num_rows);
+
+    void append_batch(const InlineBinaryView& rows);
+
+    void reserve(size_t num_rows) { _datas.reserve(num_rows); }
+
+    // no row, the buffers of the long strings are freed
+    void clear();
+
+    // Keeps the selected rows in order, in place. Only the rows move, the bytes of
+    // the long strings that are dropped stay allocated until clear().
+    template <typename A>
+    void filter(const Vec<bool, A>& selector) {
+        VEC_ASSERT_TRUE(selector.len() == static_cast<int>(size()));
+        size_t cnt = vec::filter(reinterpret_cast<const uint8_t*>(selector.data()),
+                                 _datas.data(), size(), _datas.data());
+        _datas.resize(cnt);
+    }
+
+    void filter(const BitVec& selector);
+
+    // bit i is row i OP value (or rhs row i), see vec::compare_bits
+    BitVec compare_bits(CompareOp op, const Slice& value) const;
+    BitVec compare_bits(CompareOp op, const InlineBinaryVec& rhs) const;
+
+    // row i of the result is row indices[i], in the same arena, the long strings
+    // are copied
+    InlineBinaryVec gather(const uint32_t* indices, size_t num_rows) const;
+
+    InlineBinaryView view(size_t begin, size_t end) const {
+        return InlineBinaryView(_datas.data() + begin, end - begin);
+    }
+
+    // bytes of the rows: the SliceInlines and the buffers of the long strings
+    size_t byte_size() const;
+
+    // bytes allocated, with the room reserved for more rows
+    size_t capacity_bytes() const;
+
+    // the same rows in the flat layout, in the same arena
+    FlatBinaryVec to_flat() const;
+
+    const SliceInline* slices() const { return _datas.data(); }
 
 private:
-    std::vector<SliceInline> _datas;
-    std::vector<uint8_t> _bytes;
+    // a copy of size bytes in the last buffer, a new buffer if they do not fit
+    char* _copy_bytes(const char* data, size_t size);
+
+    ArenaVector<SliceInline> _datas;
+    // filled up to their capacity, never reallocated
+    std::vector<ArenaVector<uint8_t>> _buffers;
+    ChunkArena* _arena;
 };
 
-} // namespace vec
\ No newline at end of file
+} // namespace vec
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "vec/allocator.h"
+
+namespace vec {
+
+enum class CompareOp { EQ, NE, LT, LE, GT, GE };
+
+// Bit kernels, dispatched like the ones of kernels.h. Row i is bit i % 64 of
+// words[i / 64], the bits past the last row of the last word are zero.
+
+// number of set bits
+size_t count_bits(const uint64_t* words, size_t num_words);
+
+// one bit per non-zero byte, and back to 0/1 bytes
+void pack_bits(const uint8_t* bytes, size_t num_rows, uint64_t* words);
+void unpack_bits(const uint64_t* words, size_t num_rows, uint8_t* bytes);
+
+// words = lhs[i] OP rhs (or rhs[i]), straight from the SIMD compare masks
+#define VEC_DECLARE_COMPARE_BITS(T)                                                            \
+    void compare_bits(CompareOp op, const T* lhs, T rhs, size_t num_rows, uint64_t* words);    \
+    void compare_bits(CompareOp op, const T* lhs, const T* rhs, size_t num_rows, uint64_t* words);
+
+VEC_DECLARE_COMPARE_BITS(int32_t)
+VEC_DECLARE_COMPARE_BITS(int64_t)
+VEC_DECLARE_COMPARE_BITS(float)
+VEC_DECLARE_COMPARE_BITS(double)
+VEC_DECLARE_COMPARE_BITS(__int128)
+
+#undef VEC_DECLARE_COMPARE_BITS
+
+struct SliceInline;
+
+// Strings of the inline layout. EQ and NE with a constant are SIMD compares of the
+// rows, the bytes of a long string are only read if its size and prefix match. The
+// other ones are scalar, with the prefixes as an early out.
+void compare_bits(CompareOp op, const SliceInline* lhs, const SliceInline& rhs, size_t num_rows,
+                  uint64_t* words);
+void compare_bits(CompareOp op, const SliceInline* lhs, const SliceInline* rhs, size_t num_rows,
+                  uint64_t* words);
+
+template <CompareOp OP, typename T>
+inline bool compare_op(const T& lhs, const T& rhs) {
+    if constexpr (OP == CompareOp::EQ) {
+        return lhs == rhs;
+    } else if constexpr (OP == CompareOp::NE) {
+        return lhs != rhs;
+    } else if constexpr (OP == CompareOp::LT) {
+        return lhs < rhs;
+    } else if constexpr (OP == CompareOp::LE) {
+        return lhs <= rhs;
+    } else if constexpr (OP == CompareOp::GT) {
+        return lhs > rhs;
+    } else {
+        return lhs >= rhs;
+    }
+}
+
+// a < b on the values of two integers, whatever their signedness
+template <typename A, typename B>
+constexpr bool integer_less(A a, B b) {
+    if constexpr (std::is_signed_v<A> == std::is_signed_v<B>) {
+        return a < b;
+    } else if constexpr (std::is_signed_v<A>) {
+        return a < 0 || std::make_unsigned_t<A>(a) < b;
+    } else {
+        return b >= 0 && a < std::make_unsigned_t<B>(b);
+    }
+}
+
+// Turns `x op value`, x a row of a T column, into `x op' *narrowed` on T so the
+// kernels can run it: an int8 column < 300 must not compare with int8(300) = 44.
+// Returns false if the compare does not depend on x, *constant is then the result
+// of every row. A literal the SIMD kernels can't see without rounding (between two
+// Ts, or NaN) is handled the same way.
+template <typename T, typename U>
+bool narrow_compare_literal(CompareOp* op, U value, T* narrowed, bool* constant) {
+    // value below or above every T
+    auto out_of_range = [&](bool below) {
+        switch (*op) {
+        case CompareOp::EQ:
+            *constant = false;
+            break;
+        case CompareOp::NE:
+            *constant = true;
+            break;
+        case CompareOp::LT:
+        case CompareOp::LE:
+            *constant = !below;
+            break;
+        case CompareOp::GT:
+        case CompareOp::GE:
+            *constant = below;
+            break;
+        }
+        return false;
+    };
+    // value strictly between *narrowed and the next T
+    auto between = [&]() {
+        switch (*op) {
+        case CompareOp::EQ:
+            *constant = false;
+            return false;
+        case CompareOp::NE:
+            *constant = true;
+            return false;
+        case CompareOp::LT:
+            *op = CompareOp::LE;
+            return true;
+        case CompareOp::GE:
+            *op = CompareOp::GT;
+            return true;
+        default:
+            return true;
+        }
+    };
+    if constexpr (!std::is_arithmetic_v<T> || !std::is_arithmetic_v<U> || std::is_same_v<T, U>) {
+        *narrowed = static_cast<T>(value);
+        return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        if constexpr (std::is_integral_v<U> || sizeof(U) <= sizeof(T)) {
+            // the conversion `x op value` does itself
+            *narrowed = static_cast<T>(value);
+            return true;
+        } else {
+            if (std::isnan(value)) {
+                *constant = *op == CompareOp::NE;
+                return false;
+            }
+            T rounded = static_cast<T>(value);
+            if (static_cast<U>(rounded) == value) {
+                *narrowed = rounded;
+                return true;
+            }
+            *narrowed = static_cast<U>(rounded) < value
+                                ? rounded
+                                : std::nextafter(rounded, -std::numeric_limits<T>::infinity());
+            return between();
+        }
+    } else if constexpr (std::is_floating_point_v<U>) {
+        if (std::isnan(value)) {
+            *constant = *op == CompareOp::NE;
+            return false;
+        }
+        // [lower, upper) holds every T
+        const U upper = std::ldexp(U(1), std::numeric_limits<T>::digits);
+        const U lower = std::is_signed_v<T> ? -upper : U(0);
+        if (value < lower || value >= upper) {
+            return out_of_range(value < lower);
+        }
+        U floor = std::floor(value);
+        *narrowed = static_cast<T>(floor);
+        return floor == value || between();
+    } else {
+        if (integer_less(value, std::numeric_limits<T>::min()) ||
+            integer_less(std::numeric_limits<T>::max(), value)) {
+            return out_of_range(integer_less(value, std::numeric_limits<T>::min()));
+        }
+        *narrowed = static_cast<T>(value);
+        return true;
+    }
+}
+
+// scalar compare of a column with rhs[0] or, if COLUMN, with rhs[i]
+template <CompareOp OP, bool COLUMN, typename T>
+void compare_bits_scalar(const T* lhs, const T* rhs, size_t num_rows, uint64_t* words) {
+    for (size_t begin = 0; begin < num_rows; begin += 64) {
+        size_t end = std::min(begin + 64, num_rows);
+        uint64_t word = 0;
+        for (size_t i = begin; i < end; ++i) {
+            word |= uint64_t(compare_op<OP>(lhs[i], rhs[COLUMN ? i : 0])) << (i - begin);
+        }
+        words[begin / 64] = word;
+    }
+}
+
+template <bool COLUMN, typename T>
+void compare_bits_scalar(CompareOp op, const T* lhs, const T* rhs, size_t num_rows,
+                         uint64_t* words) {
+    switch (op) {
+    case CompareOp::EQ:
+        return compare_bits_scalar<CompareOp::EQ, COLUMN>(lhs, rhs, num_rows, words);
+    case CompareOp::NE:
+        return compare_bits_scalar<CompareOp::NE, COLUMN>(lhs, rhs, num_rows, words);
+    case CompareOp::LT:
+        return compare_bits_scalar<CompareOp::LT, COLUMN>(lhs, rhs, num_rows, words);
+    case CompareOp::LE:
+        return compare_bits_scalar<CompareOp::LE, COLUMN>(lhs, rhs, num_rows, words);
+    case CompareOp::GT:
+        return compare_bits_scalar<CompareOp::GT, COLUMN>(lhs, rhs, num_rows, words);
+    case CompareOp::GE:
+        return compare_bits_scalar<CompareOp::GE, COLUMN>(lhs, rhs, num_rows, words);
+    }
+}
+
+// types without a SIMD kernel
+template <typename T>
+void compare_bits(CompareOp op, const T* lhs, T rhs, size_t num_rows, uint64_t* words) {
+    compare_bits_scalar<false>(op, lhs, &rhs, num_rows, words);
+}
+
+template <typename T>
+void compare_bits(CompareOp op, const T* lhs, const T* rhs, size_t num_rows, uint64_t* words) {
+    compare_bits_scalar<true>(op, lhs, rhs, num_rows, words);
+}
+
+// Predicate results packed one bit per row, 8x less memory than Vec<bool>.
+// Conjunctions are word-wide ops and Vec::operator[] / Vec::filter take a
+// BitVec as the selection directly.
+class BitVec {
+public:
+    BitVec() : _len(0), _num_words(0), _words(nullptr) {}
+
+    explicit BitVec(int len, bool value = false)
+            : _len(len), _num_words(words_for(len)) {
+        _words = NewAllocator::allocate<uint64_t>(_num_words);
+        memset(_words, value ? 0xFF : 0, _num_words * sizeof(uint64_t));
+        if (value) clear_tail();
+    }
+
+    ~BitVec() { NewAllocator::deallocate(_words, _num_words); }
+
+    BitVec(const BitVec& other) : _len(other._len), _num_words(other._num_words) {
+        _words = NewAllocator::allocate<uint64_t>(_num_words);
+        memcpy(_words, other._words, _num_words * sizeof(uint64_t));
+    }
+
+    BitVec& operator=(const BitVec& other) {
+        if (this != &other) {
+            BitVec copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    BitVec(BitVec&& other) : BitVec() { swap(other); }
+
+    BitVec& operator=(BitVec&& other) {
+        swap(other);
+        return *this;
+    }
+
+    void swap(BitVec& other) {
+        std::swap(_len, other._len);
+        std::swap(_num_words, other._num_words);
+        std::swap(_words, other._words);
+    }
+
+    static constexpr int words_for(int len) { return (len + 63) / 64; }
+
+    // from one byte per row (Vec<bool> layout), any non-zero byte is set
+    static BitVec from_bytes(const uint8_t* bytes, int len) {
+        BitVec bits(len);
+        pack_bits(bytes, len, bits._words);
+        return bits;
+    }
+
+    // len() bytes of 0/1
+    void to_bytes(uint8_t* bytes) const { unpack_bits(_words, _len, bytes); }
+
+    int len() const { return _len; }
+
+    int num_words() const { return _num_words; }
+
+    uint64_t* words() { return _words; }
+
+    const uint64_t* words() const { return _words; }
+
+    bool operator[](int index) const {
+        assert(index < _len);
+        return (_words[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void set(int index, bool value) {
+        assert(index < _len);
+        uint64_t bit = uint64_t(1) << (index & 63);
+        uint64_t& word = _words[index >> 6];
+        word = value ? word | bit : word & ~bit;
+    }
+
+    // number of set rows
+    int count() const { return count_bits(_words, _num_words); }
+
+    bool none() const {
+        return std::all_of(_words, _words + _num_words, [](uint64_t w) { return w == 0; });
+    }
+
+    bool all() const { return count() == _len; }
+
+#define VEC_BIT_ASSIGN_OPERATOR(opt)              \
+    assert(_len == other._len);                   \
+    for (int i = 0; i < _num_words; ++i) {        \
+        _words[i] opt other._words[i];            \
+    }                                             \
+    return *this;
+
+    BitVec& operator&=(const BitVec& other) { VEC_BIT_ASSIGN_OPERATOR(&=) }
+
+    BitVec& operator|=(const BitVec& other) { VEC_BIT_ASSIGN_OPERATOR(|=) }
+
+    BitVec& operator^=(const BitVec& other) { VEC_BIT_ASSIGN_OPERATOR(^=) }
+
+    // this & ~other
+    BitVec& and_not(const BitVec& other) { VEC_BIT_ASSIGN_OPERATOR(&= ~) }
+
+#undef VEC_BIT_ASSIGN_OPERATOR
+
+    BitVec operator~() const {
+        BitVec res(*this);
+        for (int i = 0; i < _num_words; ++i) {
+            res._words[i] = ~res._words[i];
+        }
+        res.clear_tail();
+        return res;
+    }
+
+    friend BitVec operator&(BitVec lhs, const BitVec& rhs) { return std::move(lhs &= rhs); }
+    friend BitVec operator|(BitVec lhs, const BitVec& rhs) { return std::move(lhs |= rhs); }
+    friend BitVec operator^(BitVec lhs, const BitVec& rhs) { return std::move(lhs ^= rhs); }
+
+private:
+    // the bits past the last row stay zero, count() and all() rely on it
+    void clear_tail() {
+        if (_len % 64 != 0) {
+            _words[_num_words - 1] &= (uint64_t(1) << (_len % 64)) - 1;
+        }
+    }
+
+    int _len;
+    int _num_words;
+    uint64_t* _words;
+};
+
+} // namespace vec
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "vec/binary_vec.h"
+#include "vec/bit_vec.h"
+#include "vec/filter.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// A batch of rows as it goes through the operators of a pipeline: a schema, a column
+// per field and one selection shared by all of them.
+//
+// A filter only narrows the selection, the columns are left as they are: the other
+// columns of a chunk are not copied for a predicate on one of them, and a conjunction
+// of predicates costs a few word-wide ANDs. The selected rows are copied once, by
+// materialize(), when an operator needs dense columns (a hash table build, an output
+// buffer) or when few rows are left. Columns are shared between chunks, a projection
+// takes some of them without a copy.
+
+// rows of the batches the operators pass on
+constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+
+enum class DataType { INT32, INT64, FLOAT, DOUBLE, STRING };
+
+template <typename T>
+struct DataTypeOf;
+template <>
+struct DataTypeOf<int32_t> {
+    static constexpr DataType value = DataType::INT32;
+};
+template <>
+struct DataTypeOf<int64_t> {
+    static constexpr DataType value = DataType::INT64;
+};
+template <>
+struct DataTypeOf<float> {
+    static constexpr DataType value = DataType::FLOAT;
+};
+template <>
+struct DataTypeOf<double> {
+    static constexpr DataType value = DataType::DOUBLE;
+};
+
+struct Field {
+    std::string name;
+    DataType type;
+};
+
+class Schema {
+public:
+    Schema() = default;
+    Schema(std::vector<Field> fields) : _fields(std::move(fields)) {}
+
+    size_t num_fields() const { return _fields.size(); }
+
+    const Field& field(size_t i) const { return _fields[i]; }
+
+    // the index of the field, -1 if there is none of that name
+    int index_of(const std::string& name) const;
+
+    void add_field(Field field) { _fields.push_back(std::move(field)); }
+
+private:
+    std::vector<Field> _fields;
+};
+
+class Column;
+using ColumnPtr = std::shared_ptr<Column>;
+
+// The rows of a chunk that are still in, over the num_rows() rows of its columns:
+// either all of them, a bitmap or an ascending list of row numbers. The list is of
+// uint16_t, a chunk is not larger than MAX_ROWS.
+class Selection {
+public:
+    enum class Kind { ALL, BITMAP, INDICES };
+
+    static constexpr size_t MAX_ROWS = size_t(1) << 16;
+
+    explicit Selection(size_t num_rows = 0)
+            : _kind(Kind::ALL), _num_rows(num_rows), _count(num_rows) {
+        VEC_ASSERT_TRUE(num_rows <= MAX_ROWS);
+    }
+
+    explicit Selection(BitVec bits);
+
+    Selection(size_t num_rows, std::vector<uint16_t> indices);
+
+    Kind kind() const { return _kind; }
+
+    // rows of the columns
+    size_t num_rows() const { return _num_rows; }
+
+    // selected rows
+    size_t count() const { return _count; }
+
+    bool all() const { return _kind == Kind::ALL; }
+
+    // BITMAP only
+    const BitVec& bits() const { return _bits; }
+
+    // INDICES only
+    const std::vector<uint16_t>& indices() const { return _indices; }
+
+    // a bitmap of the selected rows, whatever the kind
+    BitVec to_bits() const;
+
+    // the selected rows in order, whatever the kind
+    std::vector<uint16_t> to_indices() const;
+
+    // a row stays selected if selector has it too, the kind is kept (ALL becomes
+    // BITMAP)
+    void intersect(const BitVec& selector);
+
+    // fn(row) for the selected rows in order
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        if (_kind == Kind::ALL) {
+            for (size_t i = 0; i < _num_rows; ++i) {
+                fn(i);
+            }
+        } else if (_kind == Kind::INDICES) {
+            for (uint16_t i : _indices) {
+                fn(size_t(i));
+            }
+        } else {
+            const uint64_t* words = _bits.words();
+            for (int w = 0; w < _bits.num_words(); ++w) {
+                for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                    fn(size_t(w) * 64 + __builtin_ctzll(word));
+                }
+            }
+        }
+    }
+
+private:
+    Kind _kind;
+    size_t _num_rows;
+    size_t _count;
+    BitVec _bits;
+    std::vector<uint16_t> _indices;
+};
+
+// Chunk::filter() picks the kind of the selection by the share of the rows left, as
+// measured by SumSelection of bench_chunk.cpp: a bitmap down to 1 /
+// SELECTION_INDICES_RATIO of the rows, an index list below it and below 1 /
+// SELECTION_COMPACT_RATIO the columns are compacted, a gather of a few rows each.
+// The kernels walk the set bits of a sparse word and mask the rows of a dense one, a
+// bitmap is as fast as an index list down to a few percent; below that the index list
+// is built once for every column a kernel reads.
+constexpr size_t SELECTION_INDICES_RATIO = 16;
+constexpr size_t SELECTION_COMPACT_RATIO = 64;
+
+// Kernels over the selected rows, for every kind of selection.
+
+// Copies the selected rows of values to dst in order, returns their number. dst is
+// either values itself or has room for count() rows plus FILTER_DST_PADDING bytes.
+template <typename T>
+size_t select_rows(const T* values, const Selection& selection, T* dst) {
+    switch (selection.kind()) {
+    case Selection::Kind::ALL:
+        if (dst != values && selection.num_rows() > 0) {
+            memcpy(dst, values, sizeof(T) * selection.num_rows());
+        }
+        return selection.num_rows();
+    case Selection::Kind::BITMAP:
+        return filter_bits(selection.bits().words(), values, selection.num_rows(), dst);
+    case Selection::Kind::INDICES:
+        break;
+    }
+    const uint16_t* indices = selection.indices().data();
+    for (size_t i = 0; i < selection.count(); ++i) {
+        dst[i] = values[indices[i]];
+    }
+    return selection.count();
+}
+
+// the sum of the selected rows, int64_t for integers (wrapping on overflow, the rows
+// add up as uint64_t) and double for floating point
+template <typename T, typename Sum = std::conditional_t<std::is_floating_point_v<T>, double,
+                                                        int64_t>>
+Sum sum_rows(const T* values, const Selection& selection) {
+    using Acc = std::conditional_t<std::is_integral_v<Sum>, uint64_t, Sum>;
+    Acc sum = 0;
+    switch (selection.kind()) {
+    case Selection::Kind::ALL:
+        for (size_t i = 0; i < selection.num_rows(); ++i) {
+            sum += values[i];
+        }
+        return static_cast<Sum>(sum);
+    case Selection::Kind::BITMAP:
+        break;
+    case Selection::Kind::INDICES:
+        for (uint16_t i : selection.indices()) {
+            sum += values[i];
+        }
+        return static_cast<Sum>(sum);
+    }
+    // A word of many rows is masked row by row, with no branch to mispredict, the
+    // others are walked bit by bit: a loop a selected row.
+    const uint64_t* words = selection.bits().words();
+    const size_t full_words = selection.num_rows() / 64;
+    const size_t num_words = static_cast<size_t>(selection.bits().num_words());
+    for (size_t w = 0; w < num_words; ++w) {
+        uint64_t word = words[w];
+        const T* block = values + w * 64;
+        if (word == ~uint64_t(0)) {
+            for (size_t j = 0; j < 64; ++j) {
+                sum += block[j];
+            }
+        } else if (w < full_words && __builtin_popcountll(word) >= 48) {
+            // two chains of adds
+            Acc sums[2] = {0, 0};
+            for (size_t j = 0; j < 64; ++j, word >>= 1) {
+                if constexpr (std::is_integral_v<Sum>) {
+                    sums[j & 1] += Acc(block[j]) & -Acc(word & 1);
+                } else {
+                    sums[j & 1] += (word & 1) ? Acc(block[j]) : Acc(0);
+                }
+            }
+            sum += sums[0] + sums[1];
+        } else {
+            for (; word != 0; word &= word - 1) {
+                sum += block[__builtin_ctzll(word)];
+            }
+        }
+    }
+    return static_cast<Sum>(sum);
+}
+
+// A column of any DataType, the rows in a Vec<T> or a FlatBinaryVec.
+class Column {
+public:
+    virtual ~Column() = default;
+
+    virtual DataType type() const = 0;
+
+    virtual size_t size() const = 0;
+
+    // keeps the selected rows in order, in place
+    virtual void filter(const Selection& selection) = 0;
+
+    // a new column of the selected rows
+    virtual ColumnPtr select(const Selection& selection) const = 0;
+
+    virtual ColumnPtr clone() const = 0;
+};
+
+template <typename T>
+class FixedColumn final : public Column {
+public:
+    FixedColumn() = default;
+    explicit FixedColumn(Vec<T> data) : _data(std::move(data)) {}
+
+    DataType type() const override { return DataTypeOf<T>::value; }
+
+    size_t size() const override { return _data.len(); }
+
+    void filter(const Selection& selection) override {
+        _data.resize(select_rows(_data.data(), selection, _data.data()));
+    }
+
+    ColumnPtr select(const Selection& selection) const override {
+        // the filter kernels store whole SIMD registers past the last selected row
+        size_t capacity = selection.count() + (FILTER_DST_PADDING + sizeof(T) - 1) / sizeof(T);
+        T* data = NewAllocator::allocate<T>(capacity);
+        size_t len = select_rows(_data.data(), selection, data);
+        return std::make_shared<FixedColumn>(
+                Vec<T>(static_cast<int>(capacity), static_cast<int>(len), data));
+    }
+
+    ColumnPtr clone() const override { return std::make_shared<FixedColumn>(_data); }
+
+    const Vec<T>& data() const { return _data; }
+
+    Vec<T>& data() { return _data; }
+
+private:
+    Vec<T> _data;
+};
+
+class BinaryColumn final : public Column {
+public:
+    BinaryColumn() = default;
+    explicit BinaryColumn(FlatBinaryVec data) : _data(std::move(data)) {}
+
+    DataType type() const override { return DataType::STRING; }
+
+    size_t size() const override { return _data.size(); }
+
+    void filter(const Selection& selection) override;
+
+    ColumnPtr select(const Selection& selection) const override;
+
+    ColumnPtr clone() const override { return std::make_shared<BinaryColumn>(_data); }
+
+    const FlatBinaryVec& data() const { return _data; }
+
+    FlatBinaryVec& data() { return _data; }
+
+private:
+    FlatBinaryVec _data;
+};
+
+class Chunk {
+public:
+    Chunk() = default;
+
+    // every column has the type of its field and the same number of rows
+    Chunk(Schema schema, std::vector<ColumnPtr> columns);
+
+    const Schema& schema() const { return _schema; }
+
+    size_t num_columns() const { return _columns.size(); }
+
+    // selected rows
+    size_t num_rows() const { return _selection.count(); }
+
+    // rows of the columns, selected or not
+    size_t num_physical_rows() const { return _selection.num_rows(); }
+
+    const Selection& selection() const { return _selection; }
+
+    const ColumnPtr& column(size_t i) const { return _columns[i]; }
+
+    // the rows of a fixed column, the unselected ones too
+    template <typename T>
+    const Vec<T>& values(size_t i) const {
+        VEC_ASSERT_TRUE(_columns[i]->type() == DataTypeOf<T>::value);
+        return static_cast<const FixedColumn<T>&>(*_columns[i]).data();
+    }
+
+    const FlatBinaryVec& strings(size_t i) const {
+        VEC_ASSERT_TRUE(_columns[i]->type() == DataType::STRING);
+        return static_cast<const BinaryColumn&>(*_columns[i]).data();
+    }
+
+    void add_column(Field field, ColumnPtr column);
+
+    // Selector has a bit per physical row (a predicate over the columns), the rows it
+    // does not have are no longer selected. The kind of the selection follows the
+    // rows left, see SELECTION_INDICES_RATIO.
+    void filter(const BitVec& selector);
+
+    // replaces the selection
+    void set_selection(Selection selection);
+
+    // Copies the selected rows of every column, and all the rows are selected. The
+    // rows of a column shared with another chunk are copied to a new one, the other
+    // chunk is left as is.
+    void materialize();
+
+private:
+    Schema _schema;
+    std::vector<ColumnPtr> _columns;
+    Selection _selection;
+};
+
+} // namespace vec
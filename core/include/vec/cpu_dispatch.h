@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels of libvec are compiled for several instruction sets in the same binary,
+// with target attributes instead of -m flags, and the best version for the host is
+// called at runtime. One portable binary then runs on every node of a mixed fleet.
+//
+// writing a dispatched kernel:
+//     VEC_TARGET_AVX2 size_t foo_avx2(...) { ... }
+//     constexpr KernelTable<FooFn> foo_kernels(foo_scalar, nullptr, foo_avx2, nullptr, nullptr);
+//     size_t foo(...) { return foo_kernels.get()(...); }
+
+#define VEC_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define VEC_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt,fma,sse4.2")))
+#define VEC_TARGET_AVX512 \
+    __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx512cd,avx2,bmi,bmi2,popcnt,fma")))
+#define VEC_TARGET_AVX512_VBMI2                                                            \
+    __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx512cd,avx512vbmi,"      \
+                          "avx512vbmi2,avx512vpopcntdq,avx2,bmi,bmi2,popcnt,fma")))
+
+namespace vec {
+
+// every level includes the previous ones
+enum class SimdLevel : int {
+    SCALAR = 0,
+    // Nehalem
+    SSE42 = 1,
+    // Haswell, Zen1-3
+    AVX2 = 2,
+    // Skylake-X, Cascade Lake
+    AVX512 = 3,
+    // Icelake, Sapphire Rapids, Zen4
+    AVX512_VBMI2 = 4,
+};
+
+constexpr int NUM_SIMD_LEVELS = 5;
+
+const char* simd_level_name(SimdLevel level);
+
+struct CpuInfo {
+    bool amd = false;
+    bool sse42 = false;
+    bool popcnt = false;
+    bool avx2 = false;
+    bool bmi2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool avx512dq = false;
+    bool avx512cd = false;
+    bool avx512vbmi = false;
+    bool avx512vbmi2 = false;
+    bool avx512vpopcntdq = false;
+
+    // detected with cpuid once, AVX/AVX-512 also need the OS to save their registers
+    static const CpuInfo& host();
+
+    // best level supported by this cpu
+    SimdLevel max_level() const;
+};
+
+// Level used by the dispatched kernels: the best level of the host, capped by the
+// VEC_SIMD_LEVEL environment variable (scalar, sse42, avx2, avx512, avx512_vbmi2).
+SimdLevel simd_level();
+
+// cap the level of the dispatched kernels, levels above the host are ignored.
+// meant for tests and for ruling out a kernel while investigating an issue.
+void set_simd_level(SimdLevel level);
+
+// Versions of one kernel ordered by SimdLevel, nullptr for a level without its own
+// version runs the version of the closest lower level.
+template <typename Fn>
+class KernelTable {
+public:
+    template <typename... Impls>
+    constexpr KernelTable(Impls... impls) : _impls() {
+        static_assert(sizeof...(Impls) == NUM_SIMD_LEVELS);
+        int level = 0;
+        ((_impls[level] = pick(impls, level > 0 ? _impls[level - 1] : nullptr), ++level), ...);
+    }
+
+    Fn operator[](SimdLevel level) const { return _impls[static_cast<int>(level)]; }
+
+    Fn get() const { return (*this)[simd_level()]; }
+
+private:
+    static constexpr Fn pick(Fn impl, Fn) { return impl; }
+    static constexpr Fn pick(std::nullptr_t, Fn lower) { return lower; }
+
+    Fn _impls[NUM_SIMD_LEVELS];
+};
+
+} // namespace vec
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "vec/bit_vec.h"
+#include "vec/nullable_vec.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// A DECIMAL(precision, scale) column: row i is values()[i] * 10^-scale, the unscaled
+// values in a NullableVec<__int128> (a null row holds 0).
+//
+// Precision goes up to MAX_PRECISION, the digits an int128 always holds. The
+// operators follow the SQL result types: a sum has the larger scale of its operands
+// and a digit more, capped at MAX_PRECISION. Only a capped result can overflow, those
+// rows are null; the others are plain branch-free loops over the rows.
+class DecimalVec {
+public:
+    static constexpr int MAX_PRECISION = 38;
+
+    // no rows
+    DecimalVec(int precision, int scale);
+
+    // every non-null row has at most precision digits
+    DecimalVec(int precision, int scale, NullableVec<__int128> values);
+
+    // Decodes num_rows big-endian two's complement values of binsz (1..16) bytes,
+    // parquet FIXED_LEN_BYTE_ARRAY decimals. With a null map a row with a non-zero null
+    // byte has no bytes in src.
+    static DecimalVec decode(int precision, int scale, const uint8_t* src, int binsz,
+                             int num_rows, const uint8_t* nulls = nullptr);
+
+    int precision() const { return _precision; }
+
+    int scale() const { return _scale; }
+
+    int len() const { return _values.len(); }
+
+    bool has_null() const { return _values.has_null(); }
+
+    bool is_null(int index) const { return _values.is_null(index); }
+
+    // the unscaled value, 0 for a null row
+    __int128 operator[](int index) const { return _values[index]; }
+
+    const NullableVec<__int128>& values() const { return _values; }
+
+    // "-12.30" for -1230 of scale 2, "NULL" for a null row
+    std::string to_string(int index) const;
+
+    // The values at another scale: a larger one multiplies them (a value past
+    // MAX_PRECISION digits is null), a smaller one divides them, rounding half away
+    // from zero, with a digit more for the rounding (999.5 is 1000).
+    DecimalVec rescale(int scale) const;
+
+    DecimalVec operator+(const DecimalVec& other) const;
+
+    DecimalVec operator-(const DecimalVec& other) const;
+
+    // WHERE semantics: a null row compares false. Values of different scales compare
+    // at the larger one.
+    BitVec compare_bits(CompareOp op, const DecimalVec& other) const;
+
+    // with the constant value * 10^-scale
+    BitVec compare_bits(CompareOp op, __int128 value, int scale) const;
+
+private:
+    template <bool SUB>
+    DecimalVec _add(const DecimalVec& other) const;
+
+    // the unscaled values at a scale not below scale(), saturated past the range of
+    // int128 (they stay in order with any value of MAX_PRECISION digits)
+    Vec<__int128> _upscaled(int scale) const;
+
+    int _precision;
+    int _scale;
+    NullableVec<__int128> _values;
+};
+
+} // namespace vec
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace vec {
+
+// Selection kernels, the implementation follows simd_level() of cpu_dispatch.h
+// (AVX-512 compress, AVX2 shuffle LUT, SSE2, scalar).
+//
+// A selection is one byte per row, any non-zero byte selects its row (Vec<bool> layout).
+
+// vector kernels store whole registers, so a destination other than the input
+// needs this many bytes of room past the last selected row
+constexpr size_t FILTER_DST_PADDING = 64;
+
+// number of selected rows
+size_t count_nonzero(const uint8_t* selection, size_t num_rows);
+
+// number of zero bytes, like the non-null rows of a null map
+inline size_t count_zero(const uint8_t* data, size_t num_rows) {
+    return num_rows - count_nonzero(data, num_rows);
+}
+
+size_t filter_u8(const uint8_t* selection, const uint8_t* data, size_t num_rows, uint8_t* dst);
+size_t filter_u16(const uint8_t* selection, const uint16_t* data, size_t num_rows, uint16_t* dst);
+size_t filter_u32(const uint8_t* selection, const uint32_t* data, size_t num_rows, uint32_t* dst);
+size_t filter_u64(const uint8_t* selection, const uint64_t* data, size_t num_rows, uint64_t* dst);
+
+// Copy the selected rows of data to dst keeping their order, returns the number of
+// selected rows. dst is either data itself (in-place, nothing is allocated) or holds
+// count_nonzero() rows plus FILTER_DST_PADDING bytes.
+template <typename T>
+size_t filter(const uint8_t* selection, const T* data, size_t num_rows, T* dst) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if constexpr (sizeof(T) == 1) {
+        return filter_u8(selection, reinterpret_cast<const uint8_t*>(data), num_rows,
+                         reinterpret_cast<uint8_t*>(dst));
+    } else if constexpr (sizeof(T) == 2) {
+        return filter_u16(selection, reinterpret_cast<const uint16_t*>(data), num_rows,
+                          reinterpret_cast<uint16_t*>(dst));
+    } else if constexpr (sizeof(T) == 4) {
+        return filter_u32(selection, reinterpret_cast<const uint32_t*>(data), num_rows,
+                          reinterpret_cast<uint32_t*>(dst));
+    } else if constexpr (sizeof(T) == 8) {
+        return filter_u64(selection, reinterpret_cast<const uint64_t*>(data), num_rows,
+                          reinterpret_cast<uint64_t*>(dst));
+    } else {
+        size_t cnt = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (selection[i]) dst[cnt++] = data[i];
+        }
+        return cnt;
+    }
+}
+
+size_t filter_bits_u8(const uint64_t* selection, const uint8_t* data, size_t num_rows,
+                      uint8_t* dst);
+size_t filter_bits_u16(const uint64_t* selection, const uint16_t* data, size_t num_rows,
+                       uint16_t* dst);
+size_t filter_bits_u32(const uint64_t* selection, const uint32_t* data, size_t num_rows,
+                       uint32_t* dst);
+size_t filter_bits_u64(const uint64_t* selection, const uint64_t* data, size_t num_rows,
+                       uint64_t* dst);
+
+// filter() with a selection of one bit per row (BitVec words), with the same
+// destination rules
+template <typename T>
+size_t filter_bits(const uint64_t* selection, const T* data, size_t num_rows, T* dst) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if constexpr (sizeof(T) == 1) {
+        return filter_bits_u8(selection, reinterpret_cast<const uint8_t*>(data), num_rows,
+                              reinterpret_cast<uint8_t*>(dst));
+    } else if constexpr (sizeof(T) == 2) {
+        return filter_bits_u16(selection, reinterpret_cast<const uint16_t*>(data), num_rows,
+                               reinterpret_cast<uint16_t*>(dst));
+    } else if constexpr (sizeof(T) == 4) {
+        return filter_bits_u32(selection, reinterpret_cast<const uint32_t*>(data), num_rows,
+                               reinterpret_cast<uint32_t*>(dst));
+    } else if constexpr (sizeof(T) == 8) {
+        return filter_bits_u64(selection, reinterpret_cast<const uint64_t*>(data), num_rows,
+                               reinterpret_cast<uint64_t*>(dst));
+    } else {
+        size_t cnt = 0;
+        for (size_t i = 0; i < num_rows; ++i) {
+            if ((selection[i / 64] >> (i % 64)) & 1) dst[cnt++] = data[i];
+        }
+        return cnt;
+    }
+}
+
+} // namespace vec
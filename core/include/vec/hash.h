@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "vec/binary_vec.h"
+#include "vec/slice.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// Column hashing: the 32-bit hash of every row of a key column in one call, for hash
+// joins, aggregation and shuffle partitioning.
+//
+// Every function is seeded, and the hash of a row is the hash of its bytes (little
+// endian for integers): an int64 key and the 8-byte string of its bytes hash alike.
+// A key of several columns hashes the first column with a seed, then every next
+// column seeded with the hashes so far:
+//
+//     hash_column(HashFunc::MURMUR3, a.data(), n, MURMUR3_SEED, hashes);
+//     hash_combine(HashFunc::MURMUR3, b, hashes);
+//
+// Integer columns have AVX2 and AVX-512 versions (FNV1A and MURMUR3, 8 or 16 rows at
+// a time) and SSE4.2 versions (CRC32C), see cpu_dispatch.h.
+enum class HashFunc {
+    // one multiply a byte, cheap on short keys, weak low bits
+    FNV1A,
+    // the crc32 instruction, no seed mixing: linear in the key, fine for a modulo
+    // or the low bits but not for the top bits of the hash
+    CRC32C,
+    // murmur3_x86_32, every bit depends on every key bit
+    MURMUR3,
+};
+
+constexpr uint32_t FNV1A_SEED = 0x811C9DC5;
+constexpr uint32_t CRC32C_SEED = 0xFFFFFFFF;
+constexpr uint32_t MURMUR3_SEED = 0;
+
+// hashes[i] = the hash of row i seeded with seed
+void hash_column(HashFunc func, const int32_t* keys, size_t num_rows, uint32_t seed,
+                 uint32_t* hashes);
+void hash_column(HashFunc func, const int64_t* keys, size_t num_rows, uint32_t seed,
+                 uint32_t* hashes);
+void hash_column(HashFunc func, const Slice* keys, size_t num_rows, uint32_t seed,
+                 uint32_t* hashes);
+void hash_column(HashFunc func, const FlatBinaryVec& keys, uint32_t seed, uint32_t* hashes);
+void hash_column(HashFunc func, const InlineBinaryVec& keys, uint32_t seed, uint32_t* hashes);
+
+template <typename T, typename A>
+void hash_column(HashFunc func, const Vec<T, A>& keys, uint32_t seed, uint32_t* hashes) {
+    hash_column(func, keys.data(), keys.len(), seed, hashes);
+}
+
+// hashes[i] = the hash of row i seeded with hashes[i]
+void hash_combine(HashFunc func, const int32_t* keys, size_t num_rows, uint32_t* hashes);
+void hash_combine(HashFunc func, const int64_t* keys, size_t num_rows, uint32_t* hashes);
+void hash_combine(HashFunc func, const Slice* keys, size_t num_rows, uint32_t* hashes);
+void hash_combine(HashFunc func, const FlatBinaryVec& keys, uint32_t* hashes);
+void hash_combine(HashFunc func, const InlineBinaryVec& keys, uint32_t* hashes);
+
+template <typename T, typename A>
+void hash_combine(HashFunc func, const Vec<T, A>& keys, uint32_t* hashes) {
+    hash_combine(func, keys.data(), keys.len(), hashes);
+}
+
+// the hash of size bytes seeded with seed, the row version of the column functions
+uint32_t hash_bytes(HashFunc func, const void* data, size_t size, uint32_t seed);
+
+// The hash of a join or GROUP BY key, a row at a time inside the hash table
+// loops: Fibonacci hashing, the table index is the top bits of a multiply by
+// 2^32 / phi, an int64 folded to 32 bits first. Not seeded, not for partitioning
+// across nodes. On integer keys a third of the time of the scalar hash_column(), close
+// to its SIMD versions, and computed inside the loops instead of in a pass over a
+// hashes buffer: the vector probe of the join keeps it in registers (bench_hash.cpp).
+constexpr uint32_t HASH_KEY_MUL = 0x9E3779B1;
+
+inline uint32_t hash_key(int32_t key) {
+    return static_cast<uint32_t>(key) * HASH_KEY_MUL;
+}
+
+inline uint32_t hash_key(int64_t key) {
+    auto bits = static_cast<uint64_t>(key);
+    return static_cast<uint32_t>(bits ^ (bits >> 32)) * HASH_KEY_MUL;
+}
+
+// 8 bytes at a time, a multiply and a shift each
+inline uint32_t hash_key(const Slice& key) {
+    uint64_t h = key.size * 0x9E3779B97F4A7C15;
+    size_t i = 0;
+    for (; i + 8 <= key.size; i += 8) {
+        uint64_t word;
+        memcpy(&word, key.data + i, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCD;
+        h ^= h >> 29;
+    }
+    if (i < key.size) {
+        uint64_t word = 0;
+        memcpy(&word, key.data + i, key.size - i);
+        h = (h ^ word) * 0xFF51AFD7ED558CCD;
+        h ^= h >> 29;
+    }
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// The size and up to 16 bytes of key, the first and the last 8 (or 4) as memequal
+// loads them: no loop and no call for a short tail. Enough to tell apart the few
+// strings of an IN list, not the groups of a GROUP BY that share a prefix and a suffix.
+inline uint32_t hash_key_sampled(const Slice& key) {
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (key.size >= 8) {
+        memcpy(&a, key.data, 8);
+        memcpy(&b, key.data + key.size - 8, 8);
+    } else if (key.size >= 4) {
+        uint32_t x, y;
+        memcpy(&x, key.data, 4);
+        memcpy(&y, key.data + key.size - 4, 4);
+        a = x;
+        b = y;
+    } else if (key.size > 0) {
+        a = uint8_t(key.data[0]) | uint8_t(key.data[key.size / 2]) << 8 |
+            uint8_t(key.data[key.size - 1]) << 16;
+    }
+    uint64_t h = a * 0x9E3779B97F4A7C15 ^ (b + key.size) * 0xC2B2AE3D27D4EB4F;
+    h *= 0x9E3779B97F4A7C15;
+    return static_cast<uint32_t>(h >> 32);
+}
+
+} // namespace vec
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "vec/allocator.h"
+#include "vec/binary_vec.h"
+#include "vec/slice.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// Hash aggregation (GROUP BY) a batch at a time, in two column-at-a-time steps:
+//
+//     GroupByHashTable<int64_t> table;
+//     AggColumn<AggFunc::SUM, int32_t> sum;
+//     for every batch:
+//         table.find_or_insert(keys, num_rows, group_ids);
+//         sum.update(group_ids, values, num_rows, table.num_groups());
+//     table.keys()[g] and sum.finalize()[g] are the key and the sum of group g
+//
+// The table only maps keys to dense group ids, the states of an aggregate are one
+// array indexed by group id, so any number of aggregates of any type share the
+// group ids of a batch.
+
+// Flat open-addressing table (linear probing) from a key to its group id, group ids
+// are given in order of first appearance. K is int32_t, int64_t or Slice.
+//
+// Integer keys skip the hash while all the keys seen so far span less than
+// dense_range values (status and enum columns): the group id of a key is read
+// from an array indexed by the key, sized from the min/max of the batches. The
+// groups move into the hash table for good once the keys span more.
+template <typename K>
+class GroupByHashTable {
+public:
+    static constexpr size_t DENSE_RANGE = 1 << 16;
+
+    // dense_range 0 always hashes
+    explicit GroupByHashTable(size_t dense_range = DENSE_RANGE);
+
+    // the group id of every row into group_ids, a new key gets the next group id
+    void find_or_insert(const K* keys, size_t num_rows, uint32_t* group_ids);
+
+    template <typename A>
+    void find_or_insert(const Vec<K, A>& keys, uint32_t* group_ids) {
+        find_or_insert(keys.data(), keys.len(), group_ids);
+    }
+
+    // the rows of a string column, for Slice keys
+    template <typename V = K, typename = std::enable_if_t<std::is_same_v<V, Slice>>>
+    void find_or_insert(const FlatBinaryVec& keys, uint32_t* group_ids) {
+        _slices.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            _slices[i] = keys.get_slice(i);
+        }
+        find_or_insert(_slices.data(), keys.size(), group_ids);
+    }
+
+    size_t num_groups() const { return _keys.size(); }
+
+    // the key of every group by group id, the bytes of Slice keys are owned by the table
+    const std::vector<K>& keys() const { return _keys; }
+
+    // no group, the memory is kept
+    void clear();
+
+    // whether the group ids come from the key-indexed array
+    bool is_dense() const { return _dense_mode; }
+
+private:
+    static constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+
+    struct Entry {
+        // a copy of the group's key, no indirection on a hit
+        K key;
+        // compared before the bytes of a Slice key, and kept for rehashing
+        uint32_t hash;
+        uint32_t group;
+    };
+
+    // whether the keys of the batch and the keys seen so far span less than
+    // _dense_range values, the array then covers them
+    bool _fit_dense(const K* keys, size_t num_rows);
+
+    void _find_or_insert_dense(const K* keys, size_t num_rows, uint32_t* group_ids);
+
+    // every group into the hash table
+    void _leave_dense();
+
+    bool _overloaded() const;
+
+    void _grow();
+
+    uint32_t _insert(const K& key, uint32_t hash, size_t slot);
+
+    const size_t _dense_range;
+    bool _dense_mode;
+    // the group id of key _dense_base + i, EMPTY for a key not seen yet
+    std::vector<uint32_t> _dense;
+    K _dense_base = K();
+    // min and max of the keys seen
+    K _dense_min = K();
+    K _dense_max = K();
+
+    // the slots are the top bits of a multiplicative hash
+    int _shift;
+    std::vector<Entry> _entries;
+    std::vector<K> _keys;
+    // hashes of a batch
+    std::vector<uint32_t> _hashes;
+    // copies of the Slice keys
+    ChunkArena _arena;
+    // the rows of a FlatBinaryVec batch
+    std::vector<Slice> _slices;
+};
+
+enum class AggFunc { SUM, COUNT, MIN, MAX, AVG };
+
+// The states of one aggregate for every group. T is the value type, an arithmetic
+// type. SUM is int64_t for integers (wrapping on overflow, the states add up as
+// uint64_t) and double for floating point, COUNT int64_t, MIN and MAX a T, AVG a double.
+//
+// Up to REPLICATED_GROUPS groups every state is kept LANES times and row i goes to
+// copy i % LANES: a run of one key (a sorted or low-cardinality column) is then
+// LANES independent read-modify-write chains instead of one that stalls on every
+// row (bench_sum_group_by.cpp). The copies are merged once past that.
+template <AggFunc F, typename T>
+class AggColumn {
+public:
+    static_assert(std::is_arithmetic_v<T>);
+
+    using Sum = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+    using SumState = std::conditional_t<std::is_floating_point_v<T>, double, uint64_t>;
+    using State = std::conditional_t<F == AggFunc::COUNT, int64_t,
+                                     std::conditional_t<F == AggFunc::MIN || F == AggFunc::MAX,
+                                                        T, SumState>>;
+    using Result = std::conditional_t<F == AggFunc::AVG, double,
+                                      std::conditional_t<F == AggFunc::SUM, Sum, State>>;
+
+    static constexpr size_t LANES = 4;
+    static constexpr size_t REPLICATED_GROUPS = 1024;
+
+    // Past the L2 the state of every row is a miss: the state of the row
+    // PREFETCH_DISTANCE ahead is prefetched, the misses overlap.
+    static constexpr size_t PREFETCH_MIN_BYTES = 2 << 20;
+    static constexpr size_t PREFETCH_DISTANCE = 16;
+
+    // Grows the states to num_groups (the table's group count after the batch), then
+    // folds values[i] into the state of group_ids[i]. values is unused by COUNT.
+    void update(const uint32_t* group_ids, const T* values, size_t num_rows, size_t num_groups) {
+        _grow(num_groups);
+        if (_replicated) {
+            _update<LANES>(group_ids, values, num_rows);
+        } else if (_num_groups * sizeof(State) > PREFETCH_MIN_BYTES) {
+            _update_prefetch(group_ids, values, num_rows);
+        } else {
+            _update<1>(group_ids, values, num_rows);
+        }
+    }
+
+    template <typename A>
+    void update(const uint32_t* group_ids, const Vec<T, A>& values, size_t num_groups) {
+        update(group_ids, values.data(), values.len(), num_groups);
+    }
+
+    size_t num_groups() const { return _num_groups; }
+
+    // no group, for the next GROUP BY with a cleared table, the memory is kept
+    void clear() {
+        _states.clear();
+        _counts.clear();
+        _num_groups = 0;
+        _replicated = true;
+    }
+
+    // the result of every group by group id
+    Vec<Result> finalize() const {
+        size_t lanes = _replicated ? LANES : 1;
+        Vec<Result> res(num_groups());
+        for (size_t g = 0; g < num_groups(); ++g) {
+            State state = _states[g * lanes];
+            for (size_t lane = 1; lane < lanes; ++lane) {
+                state = _merge(state, _states[g * lanes + lane]);
+            }
+            if constexpr (F == AggFunc::AVG) {
+                int64_t count = 0;
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    count += _counts[g * lanes + lane];
+                }
+                res[g] = static_cast<double>(static_cast<Sum>(state)) / count;
+            } else {
+                res[g] = static_cast<Result>(state);
+            }
+        }
+        return res;
+    }
+
+private:
+    static constexpr State initial() {
+        if constexpr (F == AggFunc::MIN) {
+            return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                        : std::numeric_limits<T>::max();
+        } else if constexpr (F == AggFunc::MAX) {
+            return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+                                                        : std::numeric_limits<T>::lowest();
+        } else {
+            return State();
+        }
+    }
+
+    static State _merge(State lhs, State rhs) {
+        if constexpr (F == AggFunc::MIN) {
+            return rhs < lhs ? rhs : lhs;
+        } else if constexpr (F == AggFunc::MAX) {
+            return rhs > lhs ? rhs : lhs;
+        } else {
+            return lhs + rhs;
+        }
+    }
+
+    // row i into copy i % L of its state
+    template <size_t L>
+    void _update(const uint32_t* group_ids, const T* values, size_t num_rows) {
+        State* __restrict states = _states.data();
+        size_t i = 0;
+        for (; i + L <= num_rows; i += L) {
+            for (size_t lane = 0; lane < L; ++lane) {
+                _fold(states[group_ids[i + lane] * L + lane], values, i + lane);
+            }
+        }
+        for (; i < num_rows; ++i) {
+            _fold(states[group_ids[i] * L], values, i);
+        }
+        if constexpr (F == AggFunc::AVG) {
+            int64_t* __restrict counts = _counts.data();
+            for (i = 0; i + L <= num_rows; i += L) {
+                for (size_t lane = 0; lane < L; ++lane) {
+                    ++counts[group_ids[i + lane] * L + lane];
+                }
+            }
+            for (; i < num_rows; ++i) {
+                ++counts[group_ids[i] * L];
+            }
+        }
+    }
+
+    void _update_prefetch(const uint32_t* group_ids, const T* values, size_t num_rows) {
+        State* __restrict states = _states.data();
+        int64_t* __restrict counts = _counts.data();
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (i + PREFETCH_DISTANCE < num_rows) {
+                __builtin_prefetch(&states[group_ids[i + PREFETCH_DISTANCE]]);
+                if constexpr (F == AggFunc::AVG) {
+                    __builtin_prefetch(&counts[group_ids[i + PREFETCH_DISTANCE]]);
+                }
+            }
+            _fold(states[group_ids[i]], values, i);
+            if constexpr (F == AggFunc::AVG) {
+                ++counts[group_ids[i]];
+            }
+        }
+    }
+
+    static void _fold(State& state, const T* values, size_t i) {
+        if constexpr (F == AggFunc::COUNT) {
+            ++state;
+        } else if constexpr (F == AggFunc::MIN) {
+            state = values[i] < state ? values[i] : state;
+        } else if constexpr (F == AggFunc::MAX) {
+            state = values[i] > state ? values[i] : state;
+        } else {
+            state += values[i];
+        }
+    }
+
+    void _grow(size_t num_groups) {
+        if (num_groups <= _num_groups) {
+            return;
+        }
+        if (_replicated && num_groups > REPLICATED_GROUPS) {
+            _unreplicate();
+        }
+        _num_groups = num_groups;
+        size_t lanes = _replicated ? LANES : 1;
+        _states.resize(num_groups * lanes, initial());
+        if constexpr (F == AggFunc::AVG) {
+            _counts.resize(num_groups * lanes, 0);
+        }
+    }
+
+    // merge the copies of every state
+    void _unreplicate() {
+        for (size_t g = 0; g < _num_groups; ++g) {
+            State state = _states[g * LANES];
+            for (size_t lane = 1; lane < LANES; ++lane) {
+                state = _merge(state, _states[g * LANES + lane]);
+            }
+            _states[g] = state;
+            if constexpr (F == AggFunc::AVG) {
+                int64_t count = 0;
+                for (size_t lane = 0; lane < LANES; ++lane) {
+                    count += _counts[g * LANES + lane];
+                }
+                _counts[g] = count;
+            }
+        }
+        _states.resize(_num_groups);
+        if constexpr (F == AggFunc::AVG) {
+            _counts.resize(_num_groups);
+        }
+        _replicated = false;
+    }
+
+    bool _replicated = true;
+    size_t _num_groups = 0;
+    // LANES states a group while _replicated
+    std::vector<State> _states;
+    // AVG only
+    std::vector<int64_t> _counts;
+};
+
+} // namespace vec
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vec/slice.h"
+
+namespace vec {
+
+// Build side of an equi-join: the build rows chained by bucket through first/next
+// arrays of row ids (the vectorwise layout), probed by batches.
+//
+// A probe runs in rounds over the probe rows that still have a chain entry to
+// visit: every round compares each of them with one build row and moves it to the
+// next one, so a round is a gather/compare/compress step over a selection (AVX2
+// and AVX-512 versions for int32/int64 keys, see cpu_dispatch.h). The matches of
+// a batch come out grouped by round, not by probe row. The rounds over a table
+// larger than the L2 prefetch the rows a few ahead, so that the misses of the rows
+// of a round overlap instead of waiting on each other (group prefetching, with the
+// round as the group).
+//
+// K is int32_t, int64_t or Slice. Build row ids must stay below 2^31.
+template <typename K>
+class JoinHashTable {
+public:
+    // Probe state of one batch, it may be reused for the next batch.
+    class Probe {
+    public:
+        bool done() const { return _pos == _len && _out == 0; }
+
+    private:
+        friend class JoinHashTable;
+
+        const K* _keys = nullptr;
+        // Slice keys only
+        std::vector<uint32_t> _hashes;
+        // the rows of the current round and their next build row, [_pos, _len)
+        // are left in this round and [0, _out) go to the next one
+        std::vector<uint32_t> _rows;
+        std::vector<uint32_t> _chains;
+        size_t _pos = 0;
+        size_t _len = 0;
+        size_t _out = 0;
+    };
+
+    // build row i is keys[i]. The keys are copied, the bytes of Slice keys are not
+    // and must outlive the table.
+    void build(const K* keys, size_t num_rows);
+
+    size_t num_rows() const { return _keys.size() - 1; }
+
+    // The keys must outlive the probe.
+    void start_probe(const K* keys, size_t num_rows, Probe* probe) const;
+
+    // Writes at most capacity matching (probe row, build row) pairs and returns
+    // their number. Call again with the same probe until probe.done(): a batch may
+    // have more matches than rows.
+    size_t probe(Probe* probe, uint32_t* probe_rids, uint32_t* build_rids,
+                 size_t capacity) const;
+
+private:
+    // the buckets are the top bits of a multiplicative hash
+    int _shift = 31;
+    std::vector<uint32_t> _first = std::vector<uint32_t>(2);
+    // row 0 ends a chain, build row i is stored at i + 1
+    std::vector<uint32_t> _next = std::vector<uint32_t>(1);
+    std::vector<K> _keys = std::vector<K>(1);
+    // Slice keys only, compared before the bytes
+    std::vector<uint32_t> _hashes;
+    // the table is larger than the L2, a probe prefetches the rows ahead
+    bool _prefetch = false;
+};
+
+// Rows scattered by join hash into 2^bits partitions: partition p is
+// [offsets[p], offsets[p + 1]) of keys, with the input row ids in rids.
+template <typename K>
+struct RadixPartitions {
+    std::vector<K> keys;
+    std::vector<uint32_t> rids;
+    std::vector<uint32_t> offsets;
+
+    size_t num_partitions() const { return offsets.size() - 1; }
+};
+
+// One histogram pass and one scatter pass. The scatter goes through a cache line
+// buffer per partition (software write-combining) so the output is written a line
+// at a time, see bench_join_hash_table.cpp. bits is at most 16.
+template <typename K>
+void radix_partition(const K* keys, size_t num_rows, int bits, RadixPartitions<K>* out);
+
+// Radix-partitioned hash join: both sides are partitioned on the join hash so that
+// a partition's JoinHashTable fits in L2, then every partition pair is joined with
+// the vectorwise probe. Past the last level cache the probe of a single table
+// misses on almost every row, a partition's table stays cached.
+template <typename K>
+class PartitionedJoin {
+public:
+    // radix_bits 0 picks the partitioning from the build size
+    explicit PartitionedJoin(int radix_bits = 0) : _radix_bits(radix_bits) {}
+
+    // see JoinHashTable::build
+    void build(const K* keys, size_t num_rows);
+
+    size_t num_rows() const { return _num_rows; }
+
+    // 0 if the build side is small enough for a single table
+    int radix_bits() const { return _bits; }
+
+    // Joins a whole probe side, calling
+    //     consumer(const uint32_t* probe_rids, const uint32_t* build_rids, size_t n)
+    // for every batch of at most BATCH_SIZE matches, in partition order. Not
+    // thread-safe: the probe side is partitioned into buffers of the join.
+    template <typename Consumer>
+    void probe(const K* keys, size_t num_rows, Consumer&& consumer);
+
+    static constexpr size_t BATCH_SIZE = 4096;
+
+private:
+    // Probes rows [begin, end) of keys by chunks, the probe state of a whole
+    // partition would evict its table. probe_map and build_map turn the rows of
+    // keys and of the table into input rows, nullptr if they are input rows.
+    template <typename Consumer>
+    void _probe_rows(const JoinHashTable<K>& table, const K* keys, size_t begin, size_t end,
+                     const uint32_t* probe_map, const uint32_t* build_map, Consumer& consumer);
+
+    int _radix_bits;
+    int _bits = 0;
+    size_t _num_rows = 0;
+    // the keys of partition p are in _tables[p], only the row ids are kept
+    RadixPartitions<K> _build_side;
+    std::vector<JoinHashTable<K>> _tables;
+
+    RadixPartitions<K> _probe_side;
+    typename JoinHashTable<K>::Probe _batch;
+    std::vector<uint32_t> _probe_rids;
+    std::vector<uint32_t> _build_rids;
+};
+
+template <typename K>
+template <typename Consumer>
+void PartitionedJoin<K>::probe(const K* keys, size_t num_rows, Consumer&& consumer) {
+    _probe_rids.resize(BATCH_SIZE);
+    _build_rids.resize(BATCH_SIZE);
+    if (_bits == 0) {
+        _probe_rows(_tables[0], keys, 0, num_rows, nullptr, nullptr, consumer);
+        return;
+    }
+    radix_partition(keys, num_rows, _bits, &_probe_side);
+    for (size_t p = 0; p < _tables.size(); ++p) {
+        uint32_t build_begin = _build_side.offsets[p];
+        if (build_begin == _build_side.offsets[p + 1]) {
+            continue;
+        }
+        _probe_rows(_tables[p], _probe_side.keys.data(), _probe_side.offsets[p],
+                    _probe_side.offsets[p + 1], _probe_side.rids.data(),
+                    _build_side.rids.data() + build_begin, consumer);
+    }
+}
+
+template <typename K>
+template <typename Consumer>
+void PartitionedJoin<K>::_probe_rows(const JoinHashTable<K>& table, const K* keys, size_t begin,
+                                     size_t end, const uint32_t* probe_map,
+                                     const uint32_t* build_map, Consumer& consumer) {
+    uint32_t* probe_rids = _probe_rids.data();
+    uint32_t* build_rids = _build_rids.data();
+    for (size_t chunk = begin; chunk < end; chunk += BATCH_SIZE) {
+        table.start_probe(keys + chunk, std::min(BATCH_SIZE, end - chunk), &_batch);
+        while (!_batch.done()) {
+            size_t cnt = table.probe(&_batch, probe_rids, build_rids, BATCH_SIZE);
+            if (cnt == 0) {
+                break;
+            }
+            for (size_t i = 0; i < cnt; ++i) {
+                size_t row = chunk + probe_rids[i];
+                probe_rids[i] = probe_map != nullptr ? probe_map[row] : row;
+            }
+            if (build_map != nullptr) {
+                for (size_t i = 0; i < cnt; ++i) {
+                    build_rids[i] = build_map[build_rids[i]];
+                }
+            }
+            consumer(static_cast<const uint32_t*>(probe_rids),
+                     static_cast<const uint32_t*>(build_rids), cnt);
+        }
+    }
+}
+
+} // namespace vec
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace vec {
+
+// Kernels with a version per instruction set, the one for simd_level() is called.
+// See cpu_dispatch.h, the selection kernels live in filter.h.
+
+// p1[0, size) == p2[0, size), slice.h inlines the short sizes
+bool memequal(const char* p1, const char* p2, size_t size);
+
+// dst[i] = src[indices[i]], every index must be below 2^31
+void gather_u32(const uint32_t* src, const uint32_t* indices, size_t num_rows, uint32_t* dst);
+void gather_u64(const uint64_t* src, const uint32_t* indices, size_t num_rows, uint64_t* dst);
+
+// gather_u32/gather_u64 for the values of 4 and 8 bytes, a loop of loads otherwise
+template <typename T>
+void gather(const T* src, const uint32_t* indices, size_t num_rows, T* dst) {
+    if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) == 4) {
+        gather_u32(reinterpret_cast<const uint32_t*>(src), indices, num_rows,
+                   reinterpret_cast<uint32_t*>(dst));
+    } else if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) == 8) {
+        gather_u64(reinterpret_cast<const uint64_t*>(src), indices, num_rows,
+                   reinterpret_cast<uint64_t*>(dst));
+    } else {
+        for (size_t i = 0; i < num_rows; ++i) {
+            dst[i] = src[indices[i]];
+        }
+    }
+}
+
+// counts[keys[i]] += 1, every key must be below num_buckets
+void histogram(const uint32_t* keys, size_t num_keys, uint32_t num_buckets, uint32_t* counts);
+
+void zero_nulls_u8(const uint8_t* nulls, size_t num_rows, uint8_t* data);
+void zero_nulls_u16(const uint8_t* nulls, size_t num_rows, uint16_t* data);
+void zero_nulls_u32(const uint8_t* nulls, size_t num_rows, uint32_t* data);
+void zero_nulls_u64(const uint8_t* nulls, size_t num_rows, uint64_t* data);
+void zero_nulls_u128(const uint8_t* nulls, size_t num_rows, unsigned __int128* data);
+
+// data[i] = T() for every row with a non-zero null byte, branch-free
+template <typename T>
+void zero_nulls(const uint8_t* nulls, size_t num_rows, T* data) {
+    // T() is all zero bits
+    if constexpr (std::is_arithmetic_v<T> && sizeof(T) == 1) {
+        zero_nulls_u8(nulls, num_rows, reinterpret_cast<uint8_t*>(data));
+    } else if constexpr (std::is_arithmetic_v<T> && sizeof(T) == 2) {
+        zero_nulls_u16(nulls, num_rows, reinterpret_cast<uint16_t*>(data));
+    } else if constexpr (std::is_arithmetic_v<T> && sizeof(T) == 4) {
+        zero_nulls_u32(nulls, num_rows, reinterpret_cast<uint32_t*>(data));
+    } else if constexpr (std::is_arithmetic_v<T> && sizeof(T) == 8) {
+        zero_nulls_u64(nulls, num_rows, reinterpret_cast<uint64_t*>(data));
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) == 16) {
+        zero_nulls_u128(nulls, num_rows, reinterpret_cast<unsigned __int128*>(data));
+    } else {
+        for (size_t i = 0; i < num_rows; ++i) {
+            data[i] = nulls[i] ? T() : data[i];
+        }
+    }
+}
+
+// Decode big-endian two's complement integers of binsz (1..16) bytes each, like
+// parquet FIXED_LEN_BYTE_ARRAY decimals, to sign extended int128.
+void decode_be_int128(const uint8_t* src, int binsz, size_t num_rows, __int128* dst);
+
+// same as decode_be_int128, a row with a non-zero null byte has no bytes in src
+// and decodes to 0
+void decode_be_int128_nullable(const uint8_t* src, const uint8_t* nulls, int binsz,
+                               size_t num_rows, __int128* dst);
+
+} // namespace vec
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "vec/bit_vec.h"
+#include "vec/filter.h"
+#include "vec/kernels.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// A Vec with a null map of one byte per row, a non-zero byte is a null row (the
+// layout of the decimal readers and of a selection).
+//
+// A null row holds T() in data(), so the operators run branch-free over every row
+// and only mask the result, and a sum over data() needs no masking at all.
+// Without any null the map is not allocated and every operator is the plain Vec
+// one: has_null() is the fast path, not a hint.
+template <typename T, typename Allocator = NewAllocator>
+class NullableVec {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using NullMap = Vec<uint8_t, Allocator>;
+
+    NullableVec() : _has_null(false) {}
+
+    // len rows of T(), none null
+    explicit NullableVec(int len) : _data(len), _has_null(false) {}
+
+    explicit NullableVec(Vec<T, Allocator> data) : _data(std::move(data)), _has_null(false) {}
+
+    NullableVec(Vec<T, Allocator> data, NullMap nulls)
+            : _data(std::move(data)), _nulls(std::move(nulls)) {
+        VEC_ASSERT_TRUE(_data.len() == _nulls.len());
+        _has_null = count_nonzero(_nulls.data(), _nulls.len()) > 0;
+        if (_has_null) {
+            _mask_nulls();
+        } else {
+            _nulls = NullMap();
+        }
+    }
+
+    int len() const { return _data.len(); }
+
+    const Vec<T, Allocator>& data() const { return _data; }
+
+    bool has_null() const { return _has_null; }
+
+    // nullptr if has_null() is false
+    const uint8_t* null_data() const { return _has_null ? _nulls.data() : nullptr; }
+
+    int null_count() const { return _has_null ? count_nonzero(_nulls.data(), len()) : 0; }
+
+    bool is_null(int index) const {
+        VEC_ASSERT_TRUE(index < len());
+        return _has_null && _nulls[index];
+    }
+
+    // T() for a null row
+    const T& operator[](int index) const { return _data[index]; }
+
+    void set(int index, const T& value) {
+        _data[index] = value;
+        if (_has_null) {
+            _nulls[index] = 0;
+        }
+    }
+
+    void set_null(int index) {
+        VEC_ASSERT_TRUE(index < len());
+        if (!_has_null) {
+            _nulls = NullMap(len());
+            _has_null = true;
+        }
+        _nulls[index] = 1;
+        _data[index] = T();
+    }
+
+    void push_back(const T& value) {
+        _data.push_back(value);
+        if (_has_null) {
+            _nulls.push_back(0);
+        }
+    }
+
+    void push_back_null() {
+        push_back(T());
+        set_null(len() - 1);
+    }
+
+    // one bit per null row
+    BitVec null_bits() const {
+        return _has_null ? BitVec::from_bytes(_nulls.data(), len()) : BitVec(len());
+    }
+
+    // null if either side is null, the values go through the fused Vec expression.
+    // A temporary left operand (`a * b + 1`) is updated in place.
+#define VEC_NULLABLE_ARITHMETIC(opt)                                                  \
+    template <typename A>                                                             \
+    NullableVec operator opt(const NullableVec<T, A>& other) const {                  \
+        VEC_ASSERT_TRUE(len() == other.len());                                        \
+        return _make(Vec<T, Allocator>(_data opt other.data()), _merge_nulls(other)); \
+    }                                                                                 \
+                                                                                      \
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>       \
+    NullableVec operator opt(const U& other) const& {                                 \
+        return NullableVec(*this) opt other;                                          \
+    }                                                                                 \
+                                                                                      \
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>       \
+    NullableVec operator opt(const U& other) && {                                     \
+        T* __restrict data = _data.data();                                            \
+        for (int i = 0, num_rows = len(); i < num_rows; ++i) {                        \
+            data[i] = data[i] opt other;                                              \
+        }                                                                             \
+        if (_has_null) {                                                              \
+            _mask_nulls();                                                            \
+        }                                                                             \
+        return std::move(*this);                                                      \
+    }
+
+    VEC_NULLABLE_ARITHMETIC(+)
+    VEC_NULLABLE_ARITHMETIC(-)
+    VEC_NULLABLE_ARITHMETIC(*)
+
+#undef VEC_NULLABLE_ARITHMETIC
+
+    // A zero divisor gives a null row (SQL semantics) instead of a trap or an inf,
+    // the null rows divide by one whatever they hold, and the minimum of a signed
+    // type divided by -1 wraps like the other operators instead of trapping.
+    template <typename A>
+    NullableVec operator/(const NullableVec<T, A>& other) const {
+        VEC_ASSERT_TRUE(len() == other.len());
+        int num_rows = len();
+        NullMap nulls = _uninitialized<uint8_t>(num_rows);
+        uint8_t* __restrict dst_nulls = nulls.data();
+        const T* __restrict divisor = other.data().data();
+        for (int i = 0; i < num_rows; ++i) {
+            dst_nulls[i] = divisor[i] == T(0);
+        }
+        _or_nulls(dst_nulls, null_data(), num_rows);
+        _or_nulls(dst_nulls, other.null_data(), num_rows);
+        Vec<T, Allocator> data = _uninitialized<T>(num_rows);
+        const T* __restrict dividend = _data.data();
+        T* __restrict quotient = data.data();
+        for (int i = 0; i < num_rows; ++i) {
+            quotient[i] = _divide(dividend[i], dst_nulls[i] ? T(1) : divisor[i]);
+        }
+        return NullableVec(std::move(data), std::move(nulls));
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+    NullableVec operator/(const U& other) const {
+        if (other == U(0)) {
+            NullMap nulls(len());
+            memset(nulls.data(), 1, len());
+            return _make(Vec<T, Allocator>(len()), std::move(nulls));
+        }
+        if constexpr (std::is_integral_v<T> && std::is_signed_v<T> && std::is_signed_v<U>) {
+            if (other == U(-1)) {
+                Vec<T, Allocator> data = _uninitialized<T>(len());
+                for (int i = 0; i < len(); ++i) {
+                    data[i] = _divide(_data[i], T(-1));
+                }
+                return _make(std::move(data), _has_null ? _nulls : NullMap());
+            }
+        }
+        Vec<T, Allocator> data(_data);
+        data /= other;
+        return _make(std::move(data), _has_null ? _nulls : NullMap());
+    }
+
+    // WHERE semantics: a null row compares false
+    template <typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+    BitVec compare_bits(CompareOp op, const U& value) const {
+        BitVec bits = _data.compare_bits(op, value);
+        if (_has_null) {
+            bits.and_not(null_bits());
+        }
+        return bits;
+    }
+
+    template <typename A>
+    BitVec compare_bits(CompareOp op, const NullableVec<T, A>& other) const {
+        BitVec bits = _data.compare_bits(op, other.data());
+        if (_has_null) {
+            bits.and_not(null_bits());
+        }
+        if (other.has_null()) {
+            bits.and_not(other.null_bits());
+        }
+        return bits;
+    }
+
+    // three-valued compare: null if either side is null
+    template <typename U>
+    NullableVec<bool, Allocator> compare(CompareOp op, const U& other) const {
+        Vec<bool, Allocator> res(len());
+        compare_bits(op, other).to_bytes(reinterpret_cast<uint8_t*>(res.data()));
+        if constexpr (std::is_arithmetic_v<U>) {
+            return NullableVec<bool, Allocator>::_make(std::move(res),
+                                                       _has_null ? _nulls : NullMap());
+        } else {
+            return NullableVec<bool, Allocator>::_make(std::move(res), _merge_nulls(other));
+        }
+    }
+
+    // the selected rows with their null flags, the selector is a Vec<bool> or a BitVec
+    template <typename A>
+    NullableVec operator[](const Vec<bool, A>& selector) const {
+        return _select(selector);
+    }
+
+    NullableVec operator[](const BitVec& selector) const { return _select(selector); }
+
+    template <typename A>
+    void filter(const Vec<bool, A>& selector) {
+        _filter(selector);
+    }
+
+    void filter(const BitVec& selector) { _filter(selector); }
+
+    // func(const T&) -> U over every row, a null row passes T() and stays null
+    template <typename U = T, typename F>
+    NullableVec<U, Allocator> transform(F&& func) const {
+        int num_rows = len();
+        Vec<U, Allocator> res = _uninitialized<U>(num_rows);
+        const T* __restrict src = _data.data();
+        U* __restrict dst = res.data();
+        for (int i = 0; i < num_rows; ++i) {
+            dst[i] = func(src[i]);
+        }
+        return NullableVec<U, Allocator>::_make(std::move(res), _has_null ? _nulls : NullMap());
+    }
+
+private:
+    template <typename, typename>
+    friend class NullableVec;
+
+    // nulls is either empty or has at least one null row
+    static NullableVec _make(Vec<T, Allocator> data, NullMap nulls) {
+        NullableVec res(std::move(data));
+        if (nulls.len() > 0) {
+            res._nulls = std::move(nulls);
+            res._has_null = true;
+            res._mask_nulls();
+        }
+        return res;
+    }
+
+    template <typename Selector>
+    NullableVec _select(const Selector& selector) const {
+        if (!_has_null) {
+            return NullableVec(_data[selector]);
+        }
+        return NullableVec(_data[selector], _nulls[selector]);
+    }
+
+    template <typename Selector>
+    void _filter(const Selector& selector) {
+        _data.filter(selector);
+        if (_has_null) {
+            _nulls.filter(selector);
+            _has_null = count_nonzero(_nulls.data(), _nulls.len()) > 0;
+            if (!_has_null) {
+                _nulls = NullMap();
+            }
+        }
+    }
+
+    template <typename A>
+    NullMap _merge_nulls(const NullableVec<T, A>& other) const {
+        if (!other.has_null()) {
+            return _has_null ? _nulls : NullMap();
+        }
+        NullMap nulls = _uninitialized<uint8_t>(len());
+        memcpy(nulls.data(), other.null_data(), len());
+        _or_nulls(nulls.data(), null_data(), len());
+        return nulls;
+    }
+
+    // a buffer every row of which is written next
+    template <typename U>
+    static Vec<U, Allocator> _uninitialized(int num_rows) {
+        return Vec<U, Allocator>(num_rows, Allocator::template allocate<U>(num_rows));
+    }
+
+    static void _or_nulls(uint8_t* __restrict dst, const uint8_t* __restrict src, int num_rows) {
+        if (src == nullptr) {
+            return;
+        }
+        for (int i = 0; i < num_rows; ++i) {
+            dst[i] |= src[i];
+        }
+    }
+
+    // dividend / divisor for a non-zero divisor, x / -1 is the wrapping -x
+    static T _divide(T dividend, T divisor) {
+        if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            using Unsigned = std::make_unsigned_t<T>;
+            if (divisor == T(-1)) {
+                return static_cast<T>(Unsigned(0) - static_cast<Unsigned>(dividend));
+            }
+        }
+        return dividend / divisor;
+    }
+
+    void _mask_nulls() { zero_nulls(_nulls.data(), len(), _data.data()); }
+
+    Vec<T, Allocator> _data;
+    // empty without any null row
+    NullMap _nulls;
+    bool _has_null;
+};
+
+} // namespace vec
@@ -1,5 +1,5 @@
-#include <emmintrin.h>
-#include <smmintrin.h>
+#pragma once
+
 #include <sys/types.h>
 
 #include <algorithm>
@@ -7,6 +7,8 @@
 #include <cstdint>
 #include <cstring>
 
+#include "vec/kernels.h"
+
 namespace vec {
 
 template <typename T>
@@ -43,83 +45,31 @@ inline bool memequal(const char* p1, size_t size1, const char* p2, size_t size2)
     if (size1 != size2) {
         return false;
     }
-
-    if (size1 == 0) {
-        return true;
+    // up to 16 bytes: two overlapping loads of the widest word that fits
+    if (size1 > 16) {
+        return memequal(p1, p2, size1);
     }
-
-    // const char * p1_end = p1 + size1;
-    const char* p1_end_16 = p1 + size1 / 16 * 16;
-
-    __m128i zero16 = _mm_setzero_si128();
-
-    while (p1 < p1_end_16) {
-        if (!_mm_testc_si128(zero16,
-                             _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)),
-                                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2)))))
-            return false;
-
-        p1 += 16;
-        p2 += 16;
+    auto equal_at = [&](auto word, size_t offset) {
+        decltype(word) w1, w2;
+        memcpy(&w1, p1 + offset, sizeof(w1));
+        memcpy(&w2, p2 + offset, sizeof(w2));
+        return w1 == w2;
+    };
+    if (size1 >= 8) {
+        return equal_at(uint64_t(), 0) & equal_at(uint64_t(), size1 - 8);
     }
-
-    switch (size1 % 16) {
-    case 15:
-        if (p1[14] != p2[14]) return false;
-        [[fallthrough]];
-    case 14:
-        if (p1[13] != p2[13]) return false;
-        [[fallthrough]];
-    case 13:
-        if (p1[12] != p2[12]) return false;
-        [[fallthrough]];
-    case 12:
-        if (reinterpret_cast<const uint32_t*>(p1)[2] == reinterpret_cast<const uint32_t*>(p2)[2])
-            goto l8;
-        else
-            return false;
-    case 11:
-        if (p1[10] != p2[10]) return false;
-        [[fallthrough]];
-    case 10:
-        if (p1[9] != p2[9]) return false;
-        [[fallthrough]];
-    case 9:
-        if (p1[8] != p2[8]) return false;
-    l8:
-        [[fallthrough]];
-    case 8:
-        return reinterpret_cast<const uint64_t*>(p1)[0] == reinterpret_cast<const uint64_t*>(p2)[0];
-    case 7:
-        if (p1[6] != p2[6]) return false;
-        [[fallthrough]];
-    case 6:
-        if (p1[5] != p2[5]) return false;
-        [[fallthrough]];
-    case 5:
-        if (p1[4] != p2[4]) return false;
-        [[fallthrough]];
-    case 4:
-        return reinterpret_cast<const uint32_t*>(p1)[0] == reinterpret_cast<const uint32_t*>(p2)[0];
-    case 3:
-        if (p1[2] != p2[2]) return false;
-        [[fallthrough]];
-    case 2:
-        return reinterpret_cast<const uint16_t*>(p1)[0] == reinterpret_cast<const uint16_t*>(p2)[0];
-    case 1:
-        if (p1[0] != p2[0]) return false;
-        [[fallthrough]];
-    case 0:
-        break;
+    if (size1 >= 4) {
+        return equal_at(uint32_t(), 0) & equal_at(uint32_t(), size1 - 4);
     }
-
-    return true;
+    if (size1 >= 2) {
+        return equal_at(uint16_t(), 0) & equal_at(uint16_t(), size1 - 2);
+    }
+    return size1 == 0 || p1[0] == p2[0];
 }
 
 /// Check whether two slices are identical.
 inline bool operator==(const Slice& x, const Slice& y) {
-    return x.size == y.size && memcmp(x.data, y.data, x.size);
-    // return memequal(x.data, x.size, y.data, y.size);
+    return memequal(x.data, x.size, y.data, y.size);
 }
 
 /// Check whether two slices are not identical.
@@ -154,12 +104,18 @@ struct SliceInline {
     SliceInline(uint8_t* data_, int32_t size_) {
         memset(this, 0, sizeof(SliceInline));
         size = size_;
+        // up to 12 bytes fill prefix and data, the pointer would overwrite them
         if (size <= 12) {
             memcpy(prefix.data, data_, size_);
         } else {
             memcpy(prefix.data, data_, 4);
+            data.pointer = reinterpret_cast<char*>(data_);
         }
-        data.pointer = reinterpret_cast<char*>(data_);
+    }
+
+    // the size bytes of the string, inline or not
+    const char* bytes() const {
+        return size <= 12 ? reinterpret_cast<const char*>(prefix.data) : data.pointer;
     }
 
     int32_t size;
@@ -174,7 +130,7 @@ struct SliceInline {
         char* pointer;
     } data;
 
-    int compare(const Slice& b) const;
+    int compare(const SliceInline& b) const;
 };
 
 union UnionInt128 {
@@ -182,12 +138,58 @@ union UnionInt128 {
     __int128_t data;
 };
 
+// The 16 bytes of a SliceInline as one integer. The bytes past a string of up to
+// 12 bytes are zero, so two such strings are equal iff their integers are.
+inline __int128_t as_int128(const SliceInline& s) {
+    UnionInt128 u{s};
+    return u.data;
+}
+
+// the size and the prefix
+inline uint64_t head_of(const SliceInline& s) {
+    return static_cast<uint64_t>(as_int128(s));
+}
+
+// One 128-bit compare up to 12 bytes. Longer strings compare their size and
+// prefix first and only the bytes past the prefix after that.
 inline bool operator==(const SliceInline& x, const SliceInline& y) {
-    if (x.size != y.size) return false;
     if (x.size <= 12) {
-        return (x.prefix.i32 == y.prefix.i32) & (x.data.raw_data == y.data.raw_data);
+        return as_int128(x) == as_int128(y);
     }
-    return x.prefix.i32 == y.prefix.i32 && memcmp(x.data.pointer, y.data.pointer, x.size);
+    return head_of(x) == head_of(y) &&
+           memequal(x.data.pointer + 4, x.size - 4, y.data.pointer + 4, y.size - 4);
+}
+
+inline bool operator!=(const SliceInline& x, const SliceInline& y) {
+    return !(x == y);
+}
+
+// The prefixes decide unless they are equal: their bytes in big-endian order
+// compare like memcmp. Strings shorter than 4 bytes are zero padded, a tie on the
+// padding goes on to the whole strings.
+inline int SliceInline::compare(const SliceInline& b) const {
+    uint32_t lhs = __builtin_bswap32(prefix.i32);
+    uint32_t rhs = __builtin_bswap32(b.prefix.i32);
+    if (lhs != rhs) {
+        return lhs < rhs ? -1 : 1;
+    }
+    return memcompare(bytes(), size, b.bytes(), b.size);
+}
+
+inline bool operator<(const SliceInline& lhs, const SliceInline& rhs) {
+    return lhs.compare(rhs) < 0;
+}
+
+inline bool operator<=(const SliceInline& lhs, const SliceInline& rhs) {
+    return lhs.compare(rhs) <= 0;
+}
+
+inline bool operator>(const SliceInline& lhs, const SliceInline& rhs) {
+    return lhs.compare(rhs) > 0;
+}
+
+inline bool operator>=(const SliceInline& lhs, const SliceInline& rhs) {
+    return lhs.compare(rhs) >= 0;
 }
 
 } // namespace vec
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "vec/slice.h"
+
+namespace vec {
+
+// Sorting of columns.
+//
+// radix_sort sorts fixed-width values in place, LSD a byte a pass. The keys are made
+// unsigned first (the sign bit flipped, negative floats inverted), and the passes of
+// bytes that every value shares are skipped: a column of small ints sorts in one or
+// two passes. A column larger than the L2 cache is first split by its top byte (MSD)
+// and the LSD passes sort each bucket in cache. Floats order -inf < ... < -0.0 < 0.0
+// < ... < inf, NaNs go first or last by their sign bit.
+//
+// argsort gives the permutation that sorts a column instead, stable: perm[i] is the
+// row of the i-th smallest key. The other columns of the rows follow with a gather
+// (Vec::gather, FlatBinaryVec::gather).
+//
+// parallel_sort and parallel_argsort split a large column in a run a thread, radix
+// sort the runs and merge them: the ranks of the output are split in a range a
+// thread, the bounds of a range in each run found by a binary search, and each thread
+// merges its parts of the runs with a loser tree. The merge goes to the scratch
+// buffer, the only other memory.
+//
+// NormalizedKeys sorts by several columns (ORDER BY a, b DESC NULLS LAST): every row
+// is encoded as a byte string that compares with memcmp like the row with the
+// columns, then the byte strings are sorted by MSD radix.
+
+// below this, std::sort is faster than the passes of a radix sort
+constexpr size_t RADIX_SORT_MIN_ROWS = 256;
+
+// a thread of parallel_sort sorts at least this many rows
+constexpr size_t PARALLEL_SORT_MIN_ROWS = 1 << 16;
+
+// scratch holds num_rows values
+#define VEC_DECLARE_RADIX_SORT(T)                                                                  \
+    void radix_sort(T* values, size_t num_rows, T* scratch);                                       \
+    void argsort(const T* keys, size_t num_rows, uint32_t* perm);                                  \
+    void parallel_sort(T* values, size_t num_rows, T* scratch, int num_threads);                   \
+    void parallel_argsort(const T* keys, size_t num_rows, uint32_t* perm, int num_threads);
+
+VEC_DECLARE_RADIX_SORT(int32_t)
+VEC_DECLARE_RADIX_SORT(uint32_t)
+VEC_DECLARE_RADIX_SORT(int64_t)
+VEC_DECLARE_RADIX_SORT(uint64_t)
+VEC_DECLARE_RADIX_SORT(float)
+VEC_DECLARE_RADIX_SORT(double)
+
+#undef VEC_DECLARE_RADIX_SORT
+
+template <typename T>
+constexpr bool is_radix_sortable =
+        std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> || std::is_same_v<T, int64_t> ||
+        std::is_same_v<T, uint64_t> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+template <typename T>
+void radix_sort(T* values, size_t num_rows) {
+    std::vector<T> scratch(num_rows);
+    radix_sort(values, num_rows, scratch.data());
+}
+
+template <typename T>
+void parallel_sort(T* values, size_t num_rows, int num_threads) {
+    std::vector<T> scratch(num_rows);
+    parallel_sort(values, num_rows, scratch.data(), num_threads);
+}
+
+// the strings in memcmp order, see NormalizedKeys
+void argsort(const Slice* keys, size_t num_rows, uint32_t* perm);
+
+enum class SortOrder { ASC, DESC };
+
+enum class NullOrder { FIRST, LAST };
+
+class NormalizedKeys {
+public:
+    NormalizedKeys(size_t num_rows) : _num_rows(num_rows) {}
+
+    // The next column of the order, nulls[i] != 0 if row i is null, nulls may be
+    // nullptr. A nullable column takes a byte more a row. The columns are read by
+    // sort(), they must stay valid until then.
+    void add_column(const int32_t* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order);
+    void add_column(const int64_t* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order);
+    void add_column(const __int128* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order);
+    // -0.0 and 0.0 are equal, NaNs are equal and after inf
+    void add_column(const float* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order);
+    void add_column(const double* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order);
+    // The first prefix_size bytes of the strings go in the keys, zero padded. Rows
+    // whose keys tie are sorted again by the whole strings.
+    void add_column(const Slice* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order, size_t prefix_size = 12);
+
+    size_t num_rows() const { return _num_rows; }
+
+    // bytes of the encoded columns of a row
+    size_t key_size() const { return _key_size; }
+
+    // perm[i] is the row of the i-th key in order, the rows of equal keys in order
+    void sort(uint32_t* perm) const;
+
+private:
+    struct StringColumn {
+        const Slice* values;
+        const uint8_t* nulls;
+        SortOrder order;
+        size_t prefix_size;
+        // the bytes of the column in a key, the null byte first
+        size_t offset;
+        size_t end;
+    };
+
+    // writes a column to its bytes of every row of keys, stride bytes a row
+    using Encoder = std::function<void(uint8_t* keys, size_t stride)>;
+
+    template <typename T>
+    void _add_fixed(const T* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order);
+
+    // Rows [begin, end) of the sorted keys agree on the bytes before the end of string
+    // column k. The rows whose strings tie on the prefix are sorted again.
+    void _sort_ties(const uint8_t* keys, size_t stride, uint32_t* perm, size_t begin,
+                    size_t end, size_t k) const;
+
+    // the order of two sorted keys, lhs and rhs the rows, from string column k on
+    bool _less(const uint8_t* lhs_key, uint32_t lhs, const uint8_t* rhs_key, uint32_t rhs,
+               size_t k) const;
+
+    size_t _num_rows;
+    size_t _key_size = 0;
+    std::vector<Encoder> _encoders;
+    std::vector<StringColumn> _strings;
+};
+
+} // namespace vec
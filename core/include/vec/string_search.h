@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vec/binary_vec.h"
+#include "vec/bit_vec.h"
+#include "vec/slice.h"
+
+namespace vec {
+
+// String predicates of the flat layout: LIKE 'abc%', LIKE '%abc', LIKE '%abc%' and
+// IN ('a', 'b', ...). rows are rows of a FlatBinaryVec (see FlatBinaryVec::view) and
+// bit i of words is set iff row i matches, like compare_bits.
+
+void starts_with(const FlatBinaryView& rows, const Slice& prefix, uint64_t* words);
+
+void ends_with(const FlatBinaryView& rows, const Slice& suffix, uint64_t* words);
+
+// The bytes of all the rows are searched as one buffer, a match that fits in a row
+// sets its bit and the rest of the row is skipped. The search is dispatched (see
+// cpu_dispatch.h): the SSE4.2 version compares 16 positions with the first 16 bytes
+// of the needle at a time (pcmpestrm, the bytes may hold zeros), the AVX2 and AVX-512
+// versions compare the first and the last byte of the needle at 32 or 64 positions.
+// Only the positions where both match are compared with the whole needle.
+void contains(const FlatBinaryView& rows, const Slice& needle, uint64_t* words);
+
+// The strings of an IN list, copied, built once for all the batches of a query.
+class StringSet {
+public:
+    StringSet(const std::vector<Slice>& values);
+
+    size_t size() const { return _values.size(); }
+
+    bool contains(const Slice& value) const;
+
+    // bit i is set iff row i is one of the strings
+    void contains(const FlatBinaryView& rows, uint64_t* words) const;
+
+private:
+    // _slots[hash_key_sampled() >> _shift] is 1 + the index of a string in _values,
+    // 0 if empty, probed linearly up to _mask
+    std::vector<uint32_t> _slots;
+    uint32_t _mask;
+    int _shift;
+    // bit min(size, 63) is set if there is a string of that size, most rows of a
+    // column are rejected here without a hash
+    uint64_t _sizes = 0;
+    FlatBinaryVec _values;
+};
+
+// the same predicates over all the rows of a column
+
+inline BitVec starts_with(const FlatBinaryVec& col, const Slice& prefix) {
+    BitVec bits(col.size());
+    starts_with(col.view(0, col.size()), prefix, bits.words());
+    return bits;
+}
+
+inline BitVec ends_with(const FlatBinaryVec& col, const Slice& suffix) {
+    BitVec bits(col.size());
+    ends_with(col.view(0, col.size()), suffix, bits.words());
+    return bits;
+}
+
+inline BitVec contains(const FlatBinaryVec& col, const Slice& needle) {
+    BitVec bits(col.size());
+    contains(col.view(0, col.size()), needle, bits.words());
+    return bits;
+}
+
+inline BitVec contains(const FlatBinaryVec& col, const StringSet& set) {
+    BitVec bits(col.size());
+    set.contains(col.view(0, col.size()), bits.words());
+    return bits;
+}
+
+} // namespace vec
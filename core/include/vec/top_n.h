@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vec/binary_vec.h"
+#include "vec/bit_vec.h"
+#include "vec/slice.h"
+#include "vec/sort.h"
+
+namespace vec {
+
+// ORDER BY x [DESC] LIMIT k over the batches of a column.
+//
+// The k first rows in order are kept in a heap whose top is the last of them, the
+// threshold: a row has to come before it to get in. Once the heap is full, a batch is
+// compared with the threshold by compare_bits (SIMD for int32/int64/float/double and
+// the inline strings) a chunk of rows at a time, and only the rows that pass go to
+// the heap. As the threshold tightens, fewer rows pass: over a large column almost
+// all of them are dropped by the compare.
+//
+// Equal values are in the order of their rows, a row of a later batch does not take
+// the place of an equal one. NaNs are not ordered, as with std::sort.
+
+// rows a compare_bits call
+constexpr size_t TOP_N_CHUNK_ROWS = 4096;
+
+template <typename T>
+class TopN {
+public:
+    struct Entry {
+        T value;
+        // the row number over all the batches
+        uint64_t row;
+    };
+
+    TopN(size_t limit, SortOrder order = SortOrder::ASC) : _limit(limit), _order(order) {
+        _heap.reserve(limit);
+    }
+
+    size_t limit() const { return _limit; }
+
+    // the rows seen so far
+    uint64_t num_rows() const { return _num_rows; }
+
+    bool full() const { return _heap.size() == _limit; }
+
+    // the value a row has to come before to be kept, once full()
+    const T& threshold() const { return _heap.front().value; }
+
+    void add(const T* values, size_t num_rows) {
+        size_t i = 0;
+        for (; i < num_rows && !full(); ++i) {
+            _heap.push_back({values[i], _num_rows + i});
+            std::push_heap(_heap.begin(), _heap.end(), Before{_order});
+        }
+        if (_limit == 0) {
+            i = num_rows;
+        }
+        const CompareOp op = _order == SortOrder::ASC ? CompareOp::LT : CompareOp::GT;
+        uint64_t words[TOP_N_CHUNK_ROWS / 64];
+        for (; i < num_rows; i += TOP_N_CHUNK_ROWS) {
+            size_t chunk = std::min(num_rows - i, TOP_N_CHUNK_ROWS);
+            compare_bits(op, values + i, threshold(), chunk, words);
+            const size_t num_words = BitVec::words_for(chunk);
+            for (size_t w = 0; w < num_words; ++w) {
+                for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                    size_t j = i + w * 64 + __builtin_ctzll(word);
+                    // the threshold may be tighter than at the compare
+                    _push({values[j], _num_rows + j});
+                }
+            }
+        }
+        _num_rows += num_rows;
+    }
+
+    // the kept rows in order
+    std::vector<Entry> sorted() const {
+        std::vector<Entry> entries = _heap;
+        std::sort_heap(entries.begin(), entries.end(), Before{_order});
+        return entries;
+    }
+
+private:
+    // lhs comes before rhs, the heap keeps the last one on top
+    struct Before {
+        SortOrder order;
+        bool operator()(const Entry& lhs, const Entry& rhs) const {
+            if (lhs.value != rhs.value) {
+                return order == SortOrder::ASC ? lhs.value < rhs.value : lhs.value > rhs.value;
+            }
+            return lhs.row < rhs.row;
+        }
+    };
+
+    void _push(const Entry& entry) {
+        if (!Before{_order}(entry, _heap.front())) {
+            return;
+        }
+        std::pop_heap(_heap.begin(), _heap.end(), Before{_order});
+        _heap.back() = entry;
+        std::push_heap(_heap.begin(), _heap.end(), Before{_order});
+    }
+
+    size_t _limit;
+    SortOrder _order;
+    uint64_t _num_rows = 0;
+    std::vector<Entry> _heap;
+};
+
+// TopN of strings, the kept ones are copied. The rows of the inline layout are
+// compared with the threshold by compare_bits, the 4 byte prefixes first, the flat
+// ones a row at a time.
+class StringTopN {
+public:
+    struct Entry {
+        std::string value;
+        uint64_t row;
+    };
+
+    StringTopN(size_t limit, SortOrder order = SortOrder::ASC);
+
+    size_t limit() const { return _limit; }
+
+    uint64_t num_rows() const { return _num_rows; }
+
+    bool full() const { return _heap.size() == _limit; }
+
+    Slice threshold() const {
+        return Slice(_heap.front().value.data(), _heap.front().value.size());
+    }
+
+    void add(const FlatBinaryView& rows);
+
+    void add(const InlineBinaryView& rows);
+
+    std::vector<Entry> sorted() const;
+
+private:
+    // pushes the first rows of a batch until the heap is full, returns the next row
+    template <typename Rows>
+    size_t _fill(const Rows& rows);
+
+    // the row goes in if it comes before the threshold
+    void _push(const Slice& value, uint64_t row);
+
+    size_t _limit;
+    SortOrder _order;
+    uint64_t _num_rows = 0;
+    std::vector<Entry> _heap;
+};
+
+} // namespace vec
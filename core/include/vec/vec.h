@@ -5,61 +5,83 @@
 #include <cstring>
 #include <functional>
 #include <new>
+#include <type_traits>
 
+#include "vec/bit_vec.h"
+#include "vec/filter.h"
+#include "vec/kernels.h"
+#include "vec/sort.h"
 #include "vec/vec_iterator.h"
 
 #ifndef VEC_ASSERT_TRUE
 #define VEC_ASSERT_TRUE assert
 #endif
 
+#include "vec/vec_expr.h"
+
 namespace vec {
 
-template <typename T>
-class Vec {
+// Allocator is a static allocation policy, see vec/allocator.h
+template <typename T, typename Allocator>
+class Vec : public VecExpr<Vec<T, Allocator>> {
 public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
     Vec() : _capacity(0), _len(0), _data(nullptr){};
 
     Vec(int len) : _capacity(len), _len(len) {
-        _data = new (std::nothrow) T[_len];
+        _data = Allocator::template allocate<T>(_len);
         memset(_data, 0, sizeof(T) * _len);
     }
 
+    // take the ownership of data, it must come from Allocator
     Vec(int len, T* data) : _capacity(len), _len(len), _data(data) {}
 
     Vec(int capacity, int len, T* data) : _capacity(capacity), _len(len), _data(data) {}
 
-    ~Vec() { delete[] _data; };
+    ~Vec() { Allocator::deallocate(_data, _capacity); };
 
-    Vec(const Vec<T>& other) {
+    Vec(const Vec& other) {
         _capacity = other.len();
         _len = other.len();
-        _data = new (std::nothrow) T[_capacity];
-        memcpy(_data, other._data, sizeof(T) * _len);
+        _data = Allocator::template allocate<T>(_capacity);
+        if (_len > 0) {
+            memcpy(_data, other._data, sizeof(T) * _len);
+        }
     }
 
-    Vec<T>& operator=(const Vec<T>& other) {
-        _capacity = other.len();
+    Vec& operator=(const Vec& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if (_capacity < other.len()) {
+            Allocator::deallocate(_data, _capacity);
+            _capacity = other.len();
+            _data = Allocator::template allocate<T>(_capacity);
+        }
         _len = other.len();
-        _data = new (std::nothrow) T[_capacity];
-        memcpy(_data, other._data, sizeof(T) * _len);
+        if (_len > 0) {
+            memcpy(_data, other._data, sizeof(T) * _len);
+        }
         return *this;
     }
 
-    Vec<T>& operator=(const T& other) {
+    Vec& operator=(const T& other) {
         for (int i = 0; i < _len; ++i) {
             this->data()[i] = other;
         }
         return *this;
     }
 
-    Vec<T>& operator=(Vec<T>&& other) {
+    Vec& operator=(Vec&& other) {
         std::swap(_len, other._len);
         std::swap(_capacity, other._capacity);
         std::swap(_data, other._data);
         return *this;
     }
 
-    Vec(Vec<T>&& other) {
+    Vec(Vec&& other) {
         _len = 0;
         _capacity = 0;
         _data = nullptr;
@@ -68,6 +90,33 @@ public:
         std::swap(_data, other._data);
     }
 
+    // evaluate a lazy expression (eg: `Vec<int> r = a + b * c - d;`) in a single pass
+    template <typename E>
+    Vec(const VecExpr<E>& expr) : _capacity(expr.len()), _len(expr.len()) {
+        _data = Allocator::template allocate<T>(_len);
+        _eval(expr.self());
+    }
+
+    template <typename E>
+    Vec& operator=(const VecExpr<E>& expr) {
+        int len = expr.len();
+        if (_capacity < len) {
+            // the expression may still read from the old buffer
+            T* old_data = _data;
+            _data = Allocator::template allocate<T>(len);
+            _len = len;
+            _eval(expr.self());
+            Allocator::deallocate(old_data, _capacity);
+            _capacity = len;
+        } else {
+            // every element only depends on the same position of its operands,
+            // so evaluating in place is safe even if `this` appears in the expression
+            _len = len;
+            _eval(expr.self());
+        }
+        return *this;
+    }
+
     int len() const { return _len; }
 
     T* data() const { return _data; }
@@ -76,67 +125,34 @@ public:
 
     T* data() { return _data; }
 
-    Vec<T> operator-() {
-        T* inv_data_start = new (std::nothrow) T[_len];
-        memcpy(inv_data_start, _data, sizeof(T) * _len);
-        T* inv_data_end = inv_data_start + _len;
-        T* cur = inv_data_start;
-        while (cur++ < inv_data_end) *cur = -*cur;
-        return Vec(_len, inv_data_start);
-    }
-
-#define VEC_OPERATE(opt)                              \
-    VEC_ASSERT_TRUE(other.len() == _len);             \
-    Vec<T> vec;                                       \
-    vec._len = _len;                                  \
-    vec._data = new (std::nothrow) T[_len];           \
-    for (int i = 0; i < _len; i++) {                  \
-        vec.data()[i] = _data[i] opt other.data()[i]; \
-    }                                                 \
-    return vec;
-
-    template <typename U>
-    Vec<T> operator+(const Vec<U>& other) {
-        VEC_OPERATE(+)
-    }
-
-    template <typename U>
-    Vec<T> operator-(const Vec<U>& other) {
-        VEC_OPERATE(-)
-    }
-    template <typename U>
-    Vec<T> operator*(const Vec<U>& other) {
-        VEC_OPERATE(*)
-    }
-    template <typename U>
-    Vec<T> operator/(const Vec<U>& other) {
-        VEC_OPERATE(/)
-    }
+    // operator+, operator-, operator*, operator/ and unary operator- are lazy,
+    // see vec/vec_expr.h
 
-#define VEC_ASSIGN_OPERATOR(opt)          \
-    VEC_ASSERT_TRUE(_len == other.len()); \
-    for (int i = 0; i < _len; i++) {      \
-        _data[i] opt other.data()[i];     \
-    }                                     \
+#define VEC_ASSIGN_OPERATOR(opt)                                       \
+    VEC_ASSERT_TRUE(_len == other.len());                              \
+    const vec_expr_node_t<E> rhs = VecExprNode<E>::make(other.self()); \
+    for (int i = 0; i < _len; i++) {                                   \
+        _data[i] opt rhs[i];                                           \
+    }                                                                  \
     return *this;
 
-    template <typename U>
-    Vec<T>& operator+=(const Vec<U>& other) {
+    template <typename E>
+    Vec& operator+=(const VecExpr<E>& other) {
         VEC_ASSIGN_OPERATOR(+=)
     }
 
-    template <typename U>
-    Vec<T>& operator-=(const Vec<U>& other) {
+    template <typename E>
+    Vec& operator-=(const VecExpr<E>& other) {
         VEC_ASSIGN_OPERATOR(-=)
     }
 
-    template <typename U>
-    Vec<T>& operator*=(const Vec<U>& other) {
+    template <typename E>
+    Vec& operator*=(const VecExpr<E>& other) {
         VEC_ASSIGN_OPERATOR(*=)
     }
 
-    template <typename U>
-    Vec<T>& operator/=(const Vec<U>& other) {
+    template <typename E>
+    Vec& operator/=(const VecExpr<E>& other) {
         VEC_ASSIGN_OPERATOR(/=)
     }
 #define VEC_ASSIGN_OPERATOR_WITH_CONST(opt) \
@@ -145,85 +161,85 @@ public:
     }                                       \
     return *this;
 
-    template <typename U>
-    Vec<T> operator+=(const U& other) {
+    template <typename U, typename = std::enable_if_t<!is_vec_expr_v<U>>>
+    Vec& operator+=(const U& other) {
         VEC_ASSIGN_OPERATOR_WITH_CONST(+=)
     }
 
-    template <typename U>
-    Vec<T> operator-=(const U& other) {
+    template <typename U, typename = std::enable_if_t<!is_vec_expr_v<U>>>
+    Vec& operator-=(const U& other) {
         VEC_ASSIGN_OPERATOR_WITH_CONST(-=)
     }
 
-    template <typename U>
-    Vec<T> operator*=(const U& other) {
+    template <typename U, typename = std::enable_if_t<!is_vec_expr_v<U>>>
+    Vec& operator*=(const U& other) {
         VEC_ASSIGN_OPERATOR_WITH_CONST(*=)
     }
 
-    template <typename U>
-    Vec<T> operator/=(const U& other) {
+    template <typename U, typename = std::enable_if_t<!is_vec_expr_v<U>>>
+    Vec& operator/=(const U& other) {
         VEC_ASSIGN_OPERATOR_WITH_CONST(/=)
     }
 
 #define VEC_COMPARE(opt)                              \
     VEC_ASSERT_TRUE(_len == other.len());             \
-    Vec<R> vec(_len);                                 \
+    Vec<R, Allocator> vec(_len);                      \
     for (int i = 0; i < _len; i++) {                  \
         vec.data()[i] = _data[i] opt other.data()[i]; \
     }                                                 \
     return vec;
 
-    template <typename U, typename R = bool>
-    Vec<R> operator>(const Vec<U>& other) {
+    template <typename U, typename A, typename R = bool>
+    Vec<R, Allocator> operator>(const Vec<U, A>& other) {
         VEC_COMPARE(>);
     }
-    template <typename U, typename R = bool>
-    Vec<R> operator<(const Vec<U>& other) {
+    template <typename U, typename A, typename R = bool>
+    Vec<R, Allocator> operator<(const Vec<U, A>& other) {
         VEC_COMPARE(<);
     }
-    template <typename U, typename R = bool>
-    Vec<R> operator==(const Vec<U>& other) {
+    template <typename U, typename A, typename R = bool>
+    Vec<R, Allocator> operator==(const Vec<U, A>& other) {
         VEC_COMPARE(==);
     }
-    template <typename U, typename R = bool>
-    Vec<R> operator!=(const Vec<U>& other) {
+    template <typename U, typename A, typename R = bool>
+    Vec<R, Allocator> operator!=(const Vec<U, A>& other) {
         VEC_COMPARE(!=);
     }
-    template <typename U, typename R = bool>
-    Vec<R> operator>=(const Vec<U>& other) {
+    template <typename U, typename A, typename R = bool>
+    Vec<R, Allocator> operator>=(const Vec<U, A>& other) {
         VEC_COMPARE(>=);
     }
-    template <typename U, typename R = bool>
-    Vec<R> operator<=(const Vec<U>& other) {
+    template <typename U, typename A, typename R = bool>
+    Vec<R, Allocator> operator<=(const Vec<U, A>& other) {
         VEC_COMPARE(<=);
     }
 
 #define VEC_COMPARE_LITERAL(opt)            \
-    Vec<R> vec(_len);                       \
+    Vec<R, Allocator> vec(_len);            \
     for (int i = 0; i < _len; i++) {        \
         vec.data()[i] = _data[i] opt other; \
     }                                       \
     return vec;
 
     template <typename U, typename R = bool>
-    Vec<R> operator>(const U& other) {
+    Vec<R, Allocator> operator>(const U& other) {
         VEC_COMPARE_LITERAL(>)
     }
 
     template <typename U, typename R = bool>
-    Vec<R> operator<(const U& other) {
+    Vec<R, Allocator> operator<(const U& other) {
         VEC_COMPARE_LITERAL(<)
     }
     template <typename U, typename R = bool>
-    Vec<R> operator==(const U& other) {
+    Vec<R, Allocator> operator==(const U& other) {
         VEC_COMPARE_LITERAL(==)
     }
     template <typename U, typename R = bool>
-    Vec<R> operator<=(const U& other) {
+    Vec<R, Allocator> operator<=(const U& other) {
         VEC_COMPARE_LITERAL(<=)
     }
     template <typename U, typename R = bool>
-    Vec<R> operator>=(const U& other) {
+    Vec<R, Allocator> operator>=(const U& other) {
         VEC_COMPARE_LITERAL(>=)
     }
 
@@ -231,9 +247,11 @@ public:
         VEC_ASSERT_TRUE(len >= 0);
         if (_capacity < len) {
             T* old_data = _data;
-            _data = new (std::nothrow) T[len];
-            memcpy(_data, old_data, sizeof(T) * _len);
-            delete[] old_data;
+            _data = Allocator::template allocate<T>(len);
+            if (_len > 0) {
+                memcpy(_data, old_data, sizeof(T) * _len);
+            }
+            Allocator::deallocate(old_data, _capacity);
             _capacity = len;
         }
     }
@@ -248,16 +266,82 @@ public:
         return _data[index];
     }
 
-    // TODO: optimization here
-    Vec<T> operator[](const Vec<bool>& selector) const {
+    template <typename A>
+    Vec operator[](const Vec<bool, A>& selector) const {
         VEC_ASSERT_TRUE(selector.len() == _len);
-        int select_capcity = _len;
-        int select_len = 0;
-        T* data = new (std::nothrow) T[select_capcity];
-        for (int i = 0; i < _len; ++i) {
-            if (selector[i]) data[select_len++] = _data[i];
+        const auto* selection = reinterpret_cast<const uint8_t*>(selector.data());
+        int select_len = count_nonzero(selection, _len);
+        if (select_len == 0) {
+            return Vec();
+        }
+        if (select_len == _len) {
+            return *this;
+        }
+        // the filter kernel stores whole SIMD registers past the last selected row
+        int select_capacity = select_len + (FILTER_DST_PADDING + sizeof(T) - 1) / sizeof(T);
+        T* data = Allocator::template allocate<T>(select_capacity);
+        vec::filter(selection, _data, _len, data);
+        return Vec(select_capacity, select_len, data);
+    }
+
+    // in-place version of operator[](selector), keeps the buffer and allocates nothing
+    template <typename A>
+    void filter(const Vec<bool, A>& selector) {
+        VEC_ASSERT_TRUE(selector.len() == _len);
+        _len = vec::filter(reinterpret_cast<const uint8_t*>(selector.data()), _data, _len, _data);
+    }
+
+    // selection with one bit per row
+    Vec operator[](const BitVec& selector) const {
+        VEC_ASSERT_TRUE(selector.len() == _len);
+        int select_len = selector.count();
+        if (select_len == 0) {
+            return Vec();
         }
-        return Vec<T>(select_capcity, select_len, data);
+        if (select_len == _len) {
+            return *this;
+        }
+        int select_capacity = select_len + (FILTER_DST_PADDING + sizeof(T) - 1) / sizeof(T);
+        T* data = Allocator::template allocate<T>(select_capacity);
+        vec::filter_bits(selector.words(), _data, _len, data);
+        return Vec(select_capacity, select_len, data);
+    }
+
+    void filter(const BitVec& selector) {
+        VEC_ASSERT_TRUE(selector.len() == _len);
+        _len = vec::filter_bits(selector.words(), _data, _len, _data);
+    }
+
+    // row i of the result is row indices[i], every index below len(): a join
+    // materializing the rows of its matches, a permutation from argsort
+    Vec gather(const uint32_t* indices, int num_rows) const {
+        VEC_ASSERT_TRUE(num_rows >= 0);
+        T* data = Allocator::template allocate<T>(num_rows);
+        vec::gather(static_cast<const T*>(_data), indices, num_rows, data);
+        return Vec(num_rows, data);
+    }
+
+    // predicate straight to a bitmap: bit i is (*this)[i] op value, compared on the
+    // values, a literal out of the range of T gives all or no rows
+    template <typename U>
+    BitVec compare_bits(CompareOp op, const U& value) const {
+        T narrowed;
+        bool constant = false;
+        if (!narrow_compare_literal(&op, value, &narrowed, &constant)) {
+            return BitVec(_len, constant);
+        }
+        BitVec bits(_len);
+        vec::compare_bits(op, static_cast<const T*>(_data), narrowed, _len, bits.words());
+        return bits;
+    }
+
+    template <typename A>
+    BitVec compare_bits(CompareOp op, const Vec<T, A>& other) const {
+        VEC_ASSERT_TRUE(other.len() == _len);
+        BitVec bits(_len);
+        vec::compare_bits(op, static_cast<const T*>(_data), static_cast<const T*>(other.data()),
+                          _len, bits.words());
+        return bits;
     }
 
     void set(const T& value, int index) {
@@ -279,8 +363,8 @@ public:
     }
 
     template <class U>
-    Vec<U> transform(std::function<U(T&)>& func) const {
-        Vec<U> vec(_len);
+    Vec<U, Allocator> transform(std::function<U(T&)>& func) const {
+        Vec<U, Allocator> vec(_len);
         for (int i = 0; i < _len; ++i) {
             vec.data()[i] = func(_data[i]);
         }
@@ -288,8 +372,8 @@ public:
     }
 
     template <typename OP>
-    Vec<T> vec_transform() const {
-        Vec<T> vec(_len);
+    Vec vec_transform() const {
+        Vec vec(_len);
         for (int i = 0; i < _len; ++i) {
             vec.data()[i] = OP::apply(_data[i]);
         }
@@ -298,14 +382,30 @@ public:
 
     template<typename Trans>
     Vec vec_transform(Trans&& trans) {
-        Vec<T> vec(_len);
+        Vec vec(_len);
         for (int i = 0; i < _len; ++i) {
             vec[i] = trans(_data[i]);
         }
         return vec;
     }
 
-    void sort() { std::sort(_data, _data + _len); }
+    // a radix sort for ints and floats, see vec/sort.h
+    void sort() {
+        if constexpr (is_radix_sortable<T>) {
+            radix_sort(_data, static_cast<size_t>(_len));
+        } else {
+            std::sort(_data, _data + _len);
+        }
+    }
+
+    // with num_threads threads when there are enough rows, see vec/sort.h
+    void sort(int num_threads) {
+        if constexpr (is_radix_sortable<T>) {
+            parallel_sort(_data, static_cast<size_t>(_len), num_threads);
+        } else {
+            std::sort(_data, _data + _len);
+        }
+    }
 
     void push_back(const T& t) {
         if (_len == _capacity) {
@@ -316,10 +416,29 @@ public:
 
     void clear() { _len = 0; }
 
+    // the rows past the old len are zero
+    void resize(int len) {
+        reserve(len);
+        if (len > _len) {
+            memset(_data + _len, 0, sizeof(T) * (len - _len));
+        }
+        _len = len;
+    }
+
     VecIterator<T> begin() { return VecIterator<T>(_data); }
     VecIterator<T> end() { return VecIterator<T>(_data + _len); }
 
 private:
+    template <typename E>
+    void _eval(const E& expr) {
+        const vec_expr_node_t<E> node = VecExprNode<E>::make(expr);
+        // not __restrict: _data may be a leaf of expr too (a = a + b)
+        T* data = _data;
+        for (int i = 0; i < _len; ++i) {
+            data[i] = node[i];
+        }
+    }
+
     int _capacity;
     int _len;
     T* _data;
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+
+#include "vec/allocator.h"
+
+#ifndef VEC_ASSERT_TRUE
+#define VEC_ASSERT_TRUE assert
+#endif
+
+namespace vec {
+
+template <typename T, typename Allocator = NewAllocator>
+class Vec;
+
+// CRTP base of everything that may appear in a lazily evaluated Vec expression.
+// `a + b * c - d` builds a tree of lightweight nodes; nothing is computed until the
+// tree is assigned to a Vec, which then runs one fused loop over all operands.
+// the Allocator of the leftmost Vec of an expression
+template <typename E>
+struct VecExprAllocator;
+
+template <typename E>
+struct VecExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    int len() const { return self().len(); }
+
+    // materialize the expression into a new Vec, by default with the allocator of its
+    // leftmost Vec: an expression over arena vectors stays in the arena
+    template <typename Allocator = typename VecExprAllocator<E>::type>
+    auto eval() const {
+        return Vec<typename E::value_type, Allocator>(self());
+    }
+};
+
+template <typename E>
+constexpr bool is_vec_expr_v = std::is_base_of_v<VecExpr<E>, E>;
+
+// Vec operands are captured as a raw pointer, so the fused loop reads the buffers
+// directly and stays auto-vectorizable.
+template <typename T>
+class VecExprLeaf {
+public:
+    using value_type = T;
+
+    VecExprLeaf(const T* data, int len) : _data(data), _len(len) {}
+
+    int len() const { return _len; }
+
+    const T& operator[](int i) const { return _data[i]; }
+
+private:
+    const T* _data;
+    int _len;
+};
+
+// how an operand is stored inside a node: Vec by leaf, sub-expressions by value
+template <typename E>
+struct VecExprNode {
+    using type = E;
+    static const E& make(const E& expr) { return expr; }
+};
+
+template <typename T, typename Allocator>
+struct VecExprNode<Vec<T, Allocator>> {
+    using type = VecExprLeaf<T>;
+    static type make(const Vec<T, Allocator>& vec) { return type(vec.data(), vec.len()); }
+};
+
+template <typename E>
+using vec_expr_node_t = typename VecExprNode<E>::type;
+
+// the result of a binary node has the type of its left operand, same as the eager
+// operators it replaces
+template <typename OP, typename L, typename R>
+class BinaryVecExpr : public VecExpr<BinaryVecExpr<OP, L, R>> {
+public:
+    using value_type = typename vec_expr_node_t<L>::value_type;
+
+    BinaryVecExpr(const L& lhs, const R& rhs)
+            : _lhs(VecExprNode<L>::make(lhs)), _rhs(VecExprNode<R>::make(rhs)) {}
+
+    int len() const { return _lhs.len(); }
+
+    value_type operator[](int i) const {
+        return static_cast<value_type>(OP::apply(_lhs[i], _rhs[i]));
+    }
+
+private:
+    vec_expr_node_t<L> _lhs;
+    vec_expr_node_t<R> _rhs;
+};
+
+template <typename OP, typename E>
+class UnaryVecExpr : public VecExpr<UnaryVecExpr<OP, E>> {
+public:
+    using value_type = typename vec_expr_node_t<E>::value_type;
+
+    explicit UnaryVecExpr(const E& expr) : _expr(VecExprNode<E>::make(expr)) {}
+
+    int len() const { return _expr.len(); }
+
+    value_type operator[](int i) const { return static_cast<value_type>(OP::apply(_expr[i])); }
+
+private:
+    vec_expr_node_t<E> _expr;
+};
+
+template <typename T, typename Allocator>
+struct VecExprAllocator<Vec<T, Allocator>> {
+    using type = Allocator;
+};
+
+template <typename OP, typename L, typename R>
+struct VecExprAllocator<BinaryVecExpr<OP, L, R>> {
+    using type = typename VecExprAllocator<L>::type;
+};
+
+template <typename OP, typename E>
+struct VecExprAllocator<UnaryVecExpr<OP, E>> {
+    using type = typename VecExprAllocator<E>::type;
+};
+
+#define VEC_EXPR_BINARY_OP(name, opt)                               \
+    struct name {                                                   \
+        template <typename A, typename B>                           \
+        static auto apply(const A& a, const B& b) {                 \
+            return a opt b;                                         \
+        }                                                           \
+    };                                                              \
+                                                                    \
+    template <typename L, typename R>                               \
+    BinaryVecExpr<name, L, R> operator opt(const VecExpr<L>& lhs,   \
+                                           const VecExpr<R>& rhs) { \
+        VEC_ASSERT_TRUE(lhs.len() == rhs.len());                    \
+        return BinaryVecExpr<name, L, R>(lhs.self(), rhs.self());   \
+    }
+
+VEC_EXPR_BINARY_OP(VecAddOp, +)
+VEC_EXPR_BINARY_OP(VecSubOp, -)
+VEC_EXPR_BINARY_OP(VecMulOp, *)
+VEC_EXPR_BINARY_OP(VecDivOp, /)
+
+#undef VEC_EXPR_BINARY_OP
+
+struct VecNegOp {
+    template <typename A>
+    static auto apply(const A& a) {
+        return -a;
+    }
+};
+
+template <typename E>
+UnaryVecExpr<VecNegOp, E> operator-(const VecExpr<E>& expr) {
+    return UnaryVecExpr<VecNegOp, E>(expr.self());
+}
+
+} // namespace vec
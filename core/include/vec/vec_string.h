@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <string>
@@ -113,6 +114,18 @@ public:
 
     void clear() { _data.clear(); }
 
+    void sort() { std::sort(_data.begin(), _data.end()); }
+
+    // perm[i] is the index of the i-th string in order, see vec/sort.h
+    void argsort(uint32_t* perm) const {
+        std::vector<Slice> slices;
+        slices.reserve(_data.size());
+        for (const auto& s : _data) {
+            slices.emplace_back(s.data(), s.size());
+        }
+        vec::argsort(slices.data(), slices.size(), perm);
+    }
+
     // TODO: compare, function, iterator
 
 private:
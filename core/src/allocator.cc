@@ -0,0 +1,68 @@
+#include "vec/allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace vec {
+
+ChunkArena& ChunkArena::thread_local_arena() {
+    static thread_local ChunkArena arena;
+    return arena;
+}
+
+void* ChunkArena::allocate_slow(size_t bytes) {
+    // move on to the next chunk that is big enough, chunks skipped here stay
+    // unused until the next reset(). _current only moves once a chunk is found,
+    // a failed allocation leaves the arena as it was
+    size_t next = _chunks.empty() ? 0 : _current + 1;
+    while (next < _chunks.size() && _chunks[next].size < bytes) {
+        ++next;
+    }
+    if (next == _chunks.size()) {
+        size_t size = std::max(_chunk_size, bytes);
+        auto* data = static_cast<uint8_t*>(std::aligned_alloc(ALIGNMENT, size));
+        if (data == nullptr) {
+            return nullptr;
+        }
+        _chunks.push_back({data, size});
+        _reserved_bytes += size;
+    }
+    _current = next;
+    Chunk& chunk = _chunks[_current];
+    _cursor = chunk.data + bytes;
+    _end = chunk.data + chunk.size;
+    return chunk.data;
+}
+
+void ChunkArena::reset() {
+    _current = 0;
+    if (_chunks.empty()) {
+        _cursor = _end = nullptr;
+    } else {
+        _cursor = _chunks[0].data;
+        _end = _chunks[0].data + _chunks[0].size;
+    }
+}
+
+void ChunkArena::release() {
+    for (auto& chunk : _chunks) {
+        std::free(chunk.data);
+    }
+    _chunks.clear();
+    _current = 0;
+    _cursor = _end = nullptr;
+    _reserved_bytes = 0;
+}
+
+size_t ChunkArena::used_bytes() const {
+    if (_chunks.empty()) {
+        return 0;
+    }
+    size_t used = 0;
+    for (size_t i = 0; i < _current; ++i) {
+        used += _chunks[i].size;
+    }
+    return used + (_cursor - _chunks[_current].data);
+}
+
+} // namespace vec
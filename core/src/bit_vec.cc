@@ -0,0 +1,614 @@
+#include "vec/bit_vec.h"
+
+#include <immintrin.h>
+
+#include <type_traits>
+
+#include "vec/cpu_dispatch.h"
+#include "vec/slice.h"
+
+namespace vec {
+
+namespace {
+
+// ------------------------------------------------------------------------------------
+// count
+
+size_t count_bits_scalar(const uint64_t* words, size_t num_words) {
+    size_t cnt = 0;
+    for (size_t i = 0; i < num_words; ++i) {
+        cnt += __builtin_popcountll(words[i]);
+    }
+    return cnt;
+}
+
+// same loop, with the popcnt instruction instead of the libgcc fallback
+VEC_TARGET_SSE42 size_t count_bits_sse42(const uint64_t* words, size_t num_words) {
+    size_t cnt = 0;
+    for (size_t i = 0; i < num_words; ++i) {
+        cnt += _mm_popcnt_u64(words[i]);
+    }
+    return cnt;
+}
+
+VEC_TARGET_AVX512_VBMI2 size_t count_bits_avx512_vbmi2(const uint64_t* words, size_t num_words) {
+    __m512i sum = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= num_words; i += 8) {
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_loadu_si512(words + i)));
+    }
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512(lanes, sum);
+    size_t cnt = count_bits_sse42(words + i, num_words - i);
+    for (uint64_t lane : lanes) {
+        cnt += lane;
+    }
+    return cnt;
+}
+
+// ------------------------------------------------------------------------------------
+// pack / unpack
+
+void pack_bits_scalar(const uint8_t* bytes, size_t num_rows, uint64_t* words) {
+    for (size_t begin = 0; begin < num_rows; begin += 64) {
+        size_t end = std::min(begin + 64, num_rows);
+        uint64_t word = 0;
+        for (size_t i = begin; i < end; ++i) {
+            word |= uint64_t(bytes[i] != 0) << (i - begin);
+        }
+        words[begin / 64] = word;
+    }
+}
+
+VEC_TARGET_AVX2 void pack_bits_avx2(const uint8_t* bytes, size_t num_rows, uint64_t* words) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 64 <= num_rows; i += 64) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i + 32));
+        uint32_t lo_zeros = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero));
+        uint32_t hi_zeros = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero));
+        words[i / 64] = ~(lo_zeros | uint64_t(hi_zeros) << 32);
+    }
+    pack_bits_scalar(bytes + i, num_rows - i, words + i / 64);
+}
+
+VEC_TARGET_AVX512 void pack_bits_avx512(const uint8_t* bytes, size_t num_rows, uint64_t* words) {
+    size_t i = 0;
+    for (; i + 64 <= num_rows; i += 64) {
+        __m512i v = _mm512_loadu_si512(bytes + i);
+        words[i / 64] = _mm512_test_epi8_mask(v, v);
+    }
+    if (i < num_rows) {
+        __m512i v = _mm512_maskz_loadu_epi8(_bzhi_u64(~uint64_t(0), num_rows - i), bytes + i);
+        words[i / 64] = _mm512_test_epi8_mask(v, v);
+    }
+}
+
+void unpack_bits_scalar(const uint64_t* words, size_t num_rows, uint8_t* bytes) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        bytes[i] = (words[i / 64] >> (i % 64)) & 1;
+    }
+}
+
+// byte j of a 32 rows block takes byte j / 8 of the mask and keeps bit j % 8
+VEC_TARGET_AVX2 void unpack_bits_avx2(const uint64_t* words, size_t num_rows, uint8_t* bytes) {
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,  //
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i bit = _mm256_set1_epi64x(0x8040201008040201);
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 32 <= num_rows; i += 32) {
+        uint32_t mask = words[i / 64] >> (i % 64);
+        __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(mask), spread);
+        v = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(v, bit), bit), one);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes + i), v);
+    }
+    for (; i < num_rows; ++i) {
+        bytes[i] = (words[i / 64] >> (i % 64)) & 1;
+    }
+}
+
+VEC_TARGET_AVX512 void unpack_bits_avx512(const uint64_t* words, size_t num_rows,
+                                          uint8_t* bytes) {
+    const __m512i one = _mm512_set1_epi8(1);
+    for (size_t i = 0; i < num_rows; i += 64) {
+        __mmask64 store = _bzhi_u64(~uint64_t(0), std::min<size_t>(64, num_rows - i));
+        _mm512_mask_storeu_epi8(bytes + i, store, _mm512_maskz_mov_epi8(words[i / 64], one));
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// compare: one register of rows at a time, LANES bits of mask each
+
+template <typename T>
+struct Avx2Compare;
+
+template <>
+struct Avx2Compare<int32_t> {
+    static constexpr int LANES = 8;
+    VEC_TARGET_AVX2 static __m256i load(const int32_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    VEC_TARGET_AVX2 static __m256i set1(int32_t v) { return _mm256_set1_epi32(v); }
+    VEC_TARGET_AVX2 static uint32_t eq(__m256i a, __m256i b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    }
+    VEC_TARGET_AVX2 static uint32_t gt(__m256i a, __m256i b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b)));
+    }
+};
+
+template <>
+struct Avx2Compare<int64_t> {
+    static constexpr int LANES = 4;
+    VEC_TARGET_AVX2 static __m256i load(const int64_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    VEC_TARGET_AVX2 static __m256i set1(int64_t v) { return _mm256_set1_epi64x(v); }
+    VEC_TARGET_AVX2 static uint32_t eq(__m256i a, __m256i b) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)));
+    }
+    VEC_TARGET_AVX2 static uint32_t gt(__m256i a, __m256i b) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, b)));
+    }
+};
+
+// integers only have eq and gt, the other operators swap or negate them
+template <CompareOp OP, typename T>
+VEC_TARGET_AVX2 inline uint32_t compare_avx2(__m256i a, __m256i b) {
+    using C = Avx2Compare<T>;
+    constexpr uint32_t ALL = (1u << C::LANES) - 1;
+    if constexpr (OP == CompareOp::EQ) {
+        return C::eq(a, b);
+    } else if constexpr (OP == CompareOp::NE) {
+        return ~C::eq(a, b) & ALL;
+    } else if constexpr (OP == CompareOp::GT) {
+        return C::gt(a, b);
+    } else if constexpr (OP == CompareOp::LE) {
+        return ~C::gt(a, b) & ALL;
+    } else if constexpr (OP == CompareOp::LT) {
+        return C::gt(b, a);
+    } else {
+        return ~C::gt(b, a) & ALL;
+    }
+}
+
+// ordered predicates except NE, the same NaN results as the C++ operators
+template <CompareOp OP>
+constexpr int float_predicate() {
+    switch (OP) {
+    case CompareOp::EQ:
+        return _CMP_EQ_OQ;
+    case CompareOp::NE:
+        return _CMP_NEQ_UQ;
+    case CompareOp::LT:
+        return _CMP_LT_OQ;
+    case CompareOp::LE:
+        return _CMP_LE_OQ;
+    case CompareOp::GT:
+        return _CMP_GT_OQ;
+    case CompareOp::GE:
+        return _CMP_GE_OQ;
+    }
+    return _CMP_EQ_OQ;
+}
+
+template <>
+struct Avx2Compare<float> {
+    static constexpr int LANES = 8;
+    VEC_TARGET_AVX2 static __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+    VEC_TARGET_AVX2 static __m256 set1(float v) { return _mm256_set1_ps(v); }
+};
+
+template <>
+struct Avx2Compare<double> {
+    static constexpr int LANES = 4;
+    VEC_TARGET_AVX2 static __m256d load(const double* p) { return _mm256_loadu_pd(p); }
+    VEC_TARGET_AVX2 static __m256d set1(double v) { return _mm256_set1_pd(v); }
+};
+
+template <CompareOp OP, typename T>
+VEC_TARGET_AVX2 inline uint32_t compare_avx2(__m256 a, __m256 b) {
+    constexpr int PRED = float_predicate<OP>();
+    return _mm256_movemask_ps(_mm256_cmp_ps(a, b, PRED));
+}
+
+template <CompareOp OP, typename T>
+VEC_TARGET_AVX2 inline uint32_t compare_avx2(__m256d a, __m256d b) {
+    constexpr int PRED = float_predicate<OP>();
+    return _mm256_movemask_pd(_mm256_cmp_pd(a, b, PRED));
+}
+
+template <CompareOp OP, bool COLUMN, typename T>
+VEC_TARGET_AVX2 void compare_bits_avx2(const T* lhs, const T* rhs, size_t num_rows,
+                                       uint64_t* words) {
+    using C = Avx2Compare<T>;
+    size_t num_full_words = num_rows / 64;
+    if constexpr (!COLUMN) {
+        const auto value = C::set1(rhs[0]);
+        for (size_t w = 0; w < num_full_words; ++w) {
+            uint64_t word = 0;
+            for (int k = 0; k < 64; k += C::LANES) {
+                word |= uint64_t(compare_avx2<OP, T>(C::load(lhs + w * 64 + k), value)) << k;
+            }
+            words[w] = word;
+        }
+    } else {
+        for (size_t w = 0; w < num_full_words; ++w) {
+            uint64_t word = 0;
+            for (int k = 0; k < 64; k += C::LANES) {
+                size_t i = w * 64 + k;
+                word |= uint64_t(compare_avx2<OP, T>(C::load(lhs + i), C::load(rhs + i))) << k;
+            }
+            words[w] = word;
+        }
+    }
+    size_t done = num_full_words * 64;
+    compare_bits_scalar<OP, COLUMN>(lhs + done, COLUMN ? rhs + done : rhs, num_rows - done,
+                                    words + num_full_words);
+}
+
+template <typename T>
+struct Avx512Compare;
+
+template <>
+struct Avx512Compare<int32_t> {
+    static constexpr int LANES = 16;
+    VEC_TARGET_AVX512 static __m512i load(const int32_t* p) { return _mm512_loadu_si512(p); }
+    VEC_TARGET_AVX512 static __m512i set1(int32_t v) { return _mm512_set1_epi32(v); }
+    template <int PRED>
+    VEC_TARGET_AVX512 static uint64_t compare(__m512i a, __m512i b) {
+        return _mm512_cmp_epi32_mask(a, b, PRED);
+    }
+};
+
+template <>
+struct Avx512Compare<int64_t> {
+    static constexpr int LANES = 8;
+    VEC_TARGET_AVX512 static __m512i load(const int64_t* p) { return _mm512_loadu_si512(p); }
+    VEC_TARGET_AVX512 static __m512i set1(int64_t v) { return _mm512_set1_epi64(v); }
+    template <int PRED>
+    VEC_TARGET_AVX512 static uint64_t compare(__m512i a, __m512i b) {
+        return _mm512_cmp_epi64_mask(a, b, PRED);
+    }
+};
+
+template <>
+struct Avx512Compare<float> {
+    static constexpr int LANES = 16;
+    VEC_TARGET_AVX512 static __m512 load(const float* p) { return _mm512_loadu_ps(p); }
+    VEC_TARGET_AVX512 static __m512 set1(float v) { return _mm512_set1_ps(v); }
+    template <int PRED>
+    VEC_TARGET_AVX512 static uint64_t compare(__m512 a, __m512 b) {
+        return _mm512_cmp_ps_mask(a, b, PRED);
+    }
+};
+
+template <>
+struct Avx512Compare<double> {
+    static constexpr int LANES = 8;
+    VEC_TARGET_AVX512 static __m512d load(const double* p) { return _mm512_loadu_pd(p); }
+    VEC_TARGET_AVX512 static __m512d set1(double v) { return _mm512_set1_pd(v); }
+    template <int PRED>
+    VEC_TARGET_AVX512 static uint64_t compare(__m512d a, __m512d b) {
+        return _mm512_cmp_pd_mask(a, b, PRED);
+    }
+};
+
+template <CompareOp OP, typename T>
+constexpr int avx512_predicate() {
+    if constexpr (std::is_floating_point_v<T>) {
+        return float_predicate<OP>();
+    } else {
+        switch (OP) {
+        case CompareOp::EQ:
+            return _MM_CMPINT_EQ;
+        case CompareOp::NE:
+            return _MM_CMPINT_NE;
+        case CompareOp::LT:
+            return _MM_CMPINT_LT;
+        case CompareOp::LE:
+            return _MM_CMPINT_LE;
+        case CompareOp::GT:
+            return _MM_CMPINT_NLE;
+        case CompareOp::GE:
+            return _MM_CMPINT_NLT;
+        }
+        return _MM_CMPINT_EQ;
+    }
+}
+
+template <CompareOp OP, bool COLUMN, typename T>
+VEC_TARGET_AVX512 void compare_bits_avx512(const T* lhs, const T* rhs, size_t num_rows,
+                                           uint64_t* words) {
+    using C = Avx512Compare<T>;
+    constexpr int PRED = avx512_predicate<OP, T>();
+    size_t num_full_words = num_rows / 64;
+    if constexpr (!COLUMN) {
+        const auto value = C::set1(rhs[0]);
+        for (size_t w = 0; w < num_full_words; ++w) {
+            uint64_t word = 0;
+            for (int k = 0; k < 64; k += C::LANES) {
+                word |= C::template compare<PRED>(C::load(lhs + w * 64 + k), value) << k;
+            }
+            words[w] = word;
+        }
+    } else {
+        for (size_t w = 0; w < num_full_words; ++w) {
+            uint64_t word = 0;
+            for (int k = 0; k < 64; k += C::LANES) {
+                size_t i = w * 64 + k;
+                word |= C::template compare<PRED>(C::load(lhs + i), C::load(rhs + i)) << k;
+            }
+            words[w] = word;
+        }
+    }
+    size_t done = num_full_words * 64;
+    compare_bits_scalar<OP, COLUMN>(lhs + done, COLUMN ? rhs + done : rhs, num_rows - done,
+                                    words + num_full_words);
+}
+
+// ------------------------------------------------------------------------------------
+// compare of int128 rows (decimals)
+//
+// No instruction compares 128-bit integers: the high qwords compare signed and, where
+// they are equal, the low ones unsigned. The qwords of 8 rows are split into a
+// register of low and one of high halves.
+
+template <CompareOp OP>
+VEC_TARGET_AVX512 inline __mmask8 compare_int128_avx512(__m512i lhs_lo, __m512i lhs_hi,
+                                                        __m512i rhs_lo, __m512i rhs_hi) {
+    __mmask8 high_equal = _mm512_cmpeq_epi64_mask(lhs_hi, rhs_hi);
+    if constexpr (OP == CompareOp::EQ || OP == CompareOp::NE) {
+        __mmask8 equal = high_equal & _mm512_cmpeq_epi64_mask(lhs_lo, rhs_lo);
+        return OP == CompareOp::EQ ? equal : __mmask8(~equal);
+    } else {
+        constexpr CompareOp STRICT =
+                OP == CompareOp::LT || OP == CompareOp::LE ? CompareOp::LT : CompareOp::GT;
+        constexpr int STRICT_PRED = avx512_predicate<STRICT, int64_t>();
+        constexpr int PRED = avx512_predicate<OP, int64_t>();
+        return _mm512_cmp_epi64_mask(lhs_hi, rhs_hi, STRICT_PRED) |
+               (high_equal & _mm512_cmp_epu64_mask(lhs_lo, rhs_lo, PRED));
+    }
+}
+
+template <CompareOp OP, bool COLUMN>
+VEC_TARGET_AVX512 void compare_int128_avx512(const __int128* lhs, const __int128* rhs,
+                                             size_t num_rows, uint64_t* words) {
+    const __m512i lo_index = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i hi_index = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    const __int128 value = COLUMN ? 0 : rhs[0];
+    const __m512i value_lo = _mm512_set1_epi64(static_cast<int64_t>(value));
+    const __m512i value_hi = _mm512_set1_epi64(static_cast<int64_t>(value >> 64));
+    size_t num_full_words = num_rows / 64;
+    for (size_t w = 0; w < num_full_words; ++w) {
+        uint64_t word = 0;
+        for (int k = 0; k < 64; k += 8) {
+            size_t i = w * 64 + k;
+            __m512i a = _mm512_loadu_si512(lhs + i);
+            __m512i b = _mm512_loadu_si512(lhs + i + 4);
+            __m512i lhs_lo = _mm512_permutex2var_epi64(a, lo_index, b);
+            __m512i lhs_hi = _mm512_permutex2var_epi64(a, hi_index, b);
+            __mmask8 m;
+            if constexpr (COLUMN) {
+                __m512i c = _mm512_loadu_si512(rhs + i);
+                __m512i d = _mm512_loadu_si512(rhs + i + 4);
+                m = compare_int128_avx512<OP>(lhs_lo, lhs_hi,
+                                              _mm512_permutex2var_epi64(c, lo_index, d),
+                                              _mm512_permutex2var_epi64(c, hi_index, d));
+            } else {
+                m = compare_int128_avx512<OP>(lhs_lo, lhs_hi, value_lo, value_hi);
+            }
+            word |= uint64_t(m) << k;
+        }
+        words[w] = word;
+    }
+    size_t done = num_full_words * 64;
+    compare_bits_scalar<OP, COLUMN>(lhs + done, COLUMN ? rhs + done : rhs, num_rows - done,
+                                    words + num_full_words);
+}
+
+// ------------------------------------------------------------------------------------
+// string equality: rows of the inline layout with a constant
+//
+// A row is two qwords, the size with the prefix and the rest of the bytes or the
+// pointer. Up to 12 bytes a row is equal iff both qwords are. Past that only the
+// first qword is compared, the rows it matches have the same size and prefix and
+// the bytes after the prefix are checked one row at a time.
+
+// the rows of word that also match the bytes of a long value
+inline uint64_t refine_long(const SliceInline* rows, const SliceInline& value, uint64_t word) {
+    uint64_t res = word;
+    while (word != 0) {
+        int k = __builtin_ctzll(word);
+        word &= word - 1;
+        const char* bytes = rows[k].data.pointer + 4;
+        if (!memequal(bytes, value.size - 4, value.data.pointer + 4, value.size - 4)) {
+            res &= ~(uint64_t(1) << k);
+        }
+    }
+    return res;
+}
+
+// both qwords of the two rows of a register equal to v, as all ones qwords
+VEC_TARGET_AVX2 inline __m256d equal_rows_avx2(const SliceInline* rows, __m256i v,
+                                               __m256i ignore) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows));
+    __m256d eq = _mm256_castsi256_pd(_mm256_or_si256(_mm256_cmpeq_epi64(a, v), ignore));
+    return _mm256_and_pd(eq, _mm256_permute_pd(eq, 0b0101));
+}
+
+// two rows a register, row k of 4 has bits 2k and 2k + 1 of the qword mask. No pext:
+// the AVX2 kernels run on Zen1/Zen2 (see cpu_dispatch.cc).
+template <bool NE>
+VEC_TARGET_AVX2 void equal_inline_avx2(const SliceInline* lhs, const SliceInline* rhs,
+                                       size_t num_rows, uint64_t* words) {
+    const SliceInline& value = rhs[0];
+    const bool is_long = value.size > 12;
+    const __m256i v =
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs)));
+    // the second qwords of long strings are pointers, they always match
+    const __m256i ignore = is_long ? _mm256_setr_epi64x(0, -1, 0, -1) : _mm256_setzero_si256();
+    size_t num_full_words = num_rows / 64;
+    for (size_t w = 0; w < num_full_words; ++w) {
+        const SliceInline* rows = lhs + w * 64;
+        uint64_t word = 0;
+        for (int k = 0; k < 64; k += 4) {
+            uint32_t m = _mm256_movemask_pd(equal_rows_avx2(rows + k, v, ignore)) |
+                         _mm256_movemask_pd(equal_rows_avx2(rows + k + 2, v, ignore)) << 4;
+            // the even bits, one a row
+            m &= 0x55;
+            m = (m | m >> 1) & 0x33;
+            m = (m | m >> 2) & 0x0F;
+            word |= uint64_t(m) << k;
+        }
+        if (is_long) {
+            word = refine_long(rows, value, word);
+        }
+        words[w] = NE ? ~word : word;
+    }
+    size_t done = num_full_words * 64;
+    compare_bits_scalar<NE ? CompareOp::NE : CompareOp::EQ, false>(
+            lhs + done, rhs, num_rows - done, words + num_full_words);
+}
+
+// the first and second qwords of 8 rows gathered into a register each
+template <bool NE>
+VEC_TARGET_AVX512 void equal_inline_avx512(const SliceInline* lhs, const SliceInline* rhs,
+                                           size_t num_rows, uint64_t* words) {
+    const SliceInline& value = rhs[0];
+    const bool is_long = value.size > 12;
+    const __m512i first_index = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i second_index = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    const __m512i first = _mm512_set1_epi64(head_of(value));
+    const __m512i second = _mm512_set1_epi64(value.data.raw_data);
+    const __mmask8 ignore = is_long ? 0xFF : 0;
+    size_t num_full_words = num_rows / 64;
+    for (size_t w = 0; w < num_full_words; ++w) {
+        const SliceInline* rows = lhs + w * 64;
+        uint64_t word = 0;
+        for (int k = 0; k < 64; k += 8) {
+            __m512i a = _mm512_loadu_si512(rows + k);
+            __m512i b = _mm512_loadu_si512(rows + k + 4);
+            __mmask8 m = _mm512_cmpeq_epi64_mask(_mm512_permutex2var_epi64(a, first_index, b),
+                                                 first);
+            m &= _mm512_cmpeq_epi64_mask(_mm512_permutex2var_epi64(a, second_index, b), second) |
+                 ignore;
+            word |= uint64_t(m) << k;
+        }
+        if (is_long) {
+            word = refine_long(rows, value, word);
+        }
+        words[w] = NE ? ~word : word;
+    }
+    size_t done = num_full_words * 64;
+    compare_bits_scalar<NE ? CompareOp::NE : CompareOp::EQ, false>(
+            lhs + done, rhs, num_rows - done, words + num_full_words);
+}
+
+// ------------------------------------------------------------------------------------
+// dispatch
+
+using CountBitsFn = size_t (*)(const uint64_t*, size_t);
+using PackBitsFn = void (*)(const uint8_t*, size_t, uint64_t*);
+using UnpackBitsFn = void (*)(const uint64_t*, size_t, uint8_t*);
+
+template <typename T>
+using CompareBitsFn = void (*)(const T*, const T*, size_t, uint64_t*);
+
+constexpr KernelTable<CountBitsFn> count_bits_kernels(count_bits_scalar, count_bits_sse42, nullptr,
+                                                      nullptr, count_bits_avx512_vbmi2);
+
+constexpr KernelTable<PackBitsFn> pack_bits_kernels(pack_bits_scalar, nullptr, pack_bits_avx2,
+                                                    pack_bits_avx512, nullptr);
+
+constexpr KernelTable<UnpackBitsFn> unpack_bits_kernels(unpack_bits_scalar, nullptr,
+                                                        unpack_bits_avx2, unpack_bits_avx512,
+                                                        nullptr);
+
+template <CompareOp OP, bool COLUMN, typename T>
+constexpr KernelTable<CompareBitsFn<T>> compare_bits_kernels(compare_bits_scalar<OP, COLUMN, T>,
+                                                             nullptr,
+                                                             compare_bits_avx2<OP, COLUMN, T>,
+                                                             compare_bits_avx512<OP, COLUMN, T>,
+                                                             nullptr);
+
+template <CompareOp OP, bool COLUMN>
+constexpr KernelTable<CompareBitsFn<__int128>> compare_bits_kernels<OP, COLUMN, __int128>(
+        compare_bits_scalar<OP, COLUMN, __int128>, nullptr, nullptr,
+        compare_int128_avx512<OP, COLUMN>, nullptr);
+
+template <bool NE>
+constexpr KernelTable<CompareBitsFn<SliceInline>> equal_inline_kernels(
+        compare_bits_scalar<NE ? CompareOp::NE : CompareOp::EQ, false, SliceInline>, nullptr,
+        equal_inline_avx2<NE>, equal_inline_avx512<NE>, nullptr);
+
+template <bool COLUMN, typename T>
+void compare_bits_dispatch(CompareOp op, const T* lhs, const T* rhs, size_t num_rows,
+                           uint64_t* words) {
+    switch (op) {
+    case CompareOp::EQ:
+        return compare_bits_kernels<CompareOp::EQ, COLUMN, T>.get()(lhs, rhs, num_rows, words);
+    case CompareOp::NE:
+        return compare_bits_kernels<CompareOp::NE, COLUMN, T>.get()(lhs, rhs, num_rows, words);
+    case CompareOp::LT:
+        return compare_bits_kernels<CompareOp::LT, COLUMN, T>.get()(lhs, rhs, num_rows, words);
+    case CompareOp::LE:
+        return compare_bits_kernels<CompareOp::LE, COLUMN, T>.get()(lhs, rhs, num_rows, words);
+    case CompareOp::GT:
+        return compare_bits_kernels<CompareOp::GT, COLUMN, T>.get()(lhs, rhs, num_rows, words);
+    case CompareOp::GE:
+        return compare_bits_kernels<CompareOp::GE, COLUMN, T>.get()(lhs, rhs, num_rows, words);
+    }
+}
+
+} // namespace
+
+size_t count_bits(const uint64_t* words, size_t num_words) {
+    return count_bits_kernels.get()(words, num_words);
+}
+
+void pack_bits(const uint8_t* bytes, size_t num_rows, uint64_t* words) {
+    pack_bits_kernels.get()(bytes, num_rows, words);
+}
+
+void unpack_bits(const uint64_t* words, size_t num_rows, uint8_t* bytes) {
+    unpack_bits_kernels.get()(words, num_rows, bytes);
+}
+
+#define VEC_DEFINE_COMPARE_BITS(T)                                                             \
+    void compare_bits(CompareOp op, const T* lhs, T rhs, size_t num_rows, uint64_t* words) {   \
+        compare_bits_dispatch<false>(op, lhs, &rhs, num_rows, words);                          \
+    }                                                                                          \
+    void compare_bits(CompareOp op, const T* lhs, const T* rhs, size_t num_rows,               \
+                      uint64_t* words) {                                                       \
+        compare_bits_dispatch<true>(op, lhs, rhs, num_rows, words);                            \
+    }
+
+VEC_DEFINE_COMPARE_BITS(int32_t)
+VEC_DEFINE_COMPARE_BITS(int64_t)
+VEC_DEFINE_COMPARE_BITS(float)
+VEC_DEFINE_COMPARE_BITS(double)
+VEC_DEFINE_COMPARE_BITS(__int128)
+
+#undef VEC_DEFINE_COMPARE_BITS
+
+void compare_bits(CompareOp op, const SliceInline* lhs, const SliceInline& rhs, size_t num_rows,
+                  uint64_t* words) {
+    switch (op) {
+    case CompareOp::EQ:
+        return equal_inline_kernels<false>.get()(lhs, &rhs, num_rows, words);
+    case CompareOp::NE:
+        return equal_inline_kernels<true>.get()(lhs, &rhs, num_rows, words);
+    default:
+        return compare_bits_scalar<false>(op, lhs, &rhs, num_rows, words);
+    }
+}
+
+void compare_bits(CompareOp op, const SliceInline* lhs, const SliceInline* rhs, size_t num_rows,
+                  uint64_t* words) {
+    compare_bits_scalar<true>(op, lhs, rhs, num_rows, words);
+}
+
+} // namespace vec
@@ -0,0 +1,169 @@
+#include "vec/chunk.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace vec {
+
+int Schema::index_of(const std::string& name) const {
+    for (size_t i = 0; i < _fields.size(); ++i) {
+        if (_fields[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+Selection::Selection(BitVec bits)
+        : _kind(Kind::BITMAP), _num_rows(bits.len()), _count(bits.count()), _bits(std::move(bits)) {
+    VEC_ASSERT_TRUE(_num_rows <= MAX_ROWS);
+}
+
+Selection::Selection(size_t num_rows, std::vector<uint16_t> indices)
+        : _kind(Kind::INDICES),
+          _num_rows(num_rows),
+          _count(indices.size()),
+          _indices(std::move(indices)) {
+    VEC_ASSERT_TRUE(num_rows <= MAX_ROWS);
+    VEC_ASSERT_TRUE(std::is_sorted(_indices.begin(), _indices.end()));
+    VEC_ASSERT_TRUE(_indices.empty() || _indices.back() < num_rows);
+}
+
+BitVec Selection::to_bits() const {
+    switch (_kind) {
+    case Kind::ALL:
+        return BitVec(_num_rows, true);
+    case Kind::BITMAP:
+        return _bits;
+    case Kind::INDICES:
+        break;
+    }
+    BitVec bits(_num_rows);
+    uint64_t* words = bits.words();
+    for (uint16_t i : _indices) {
+        words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    return bits;
+}
+
+std::vector<uint16_t> Selection::to_indices() const {
+    if (_kind == Kind::INDICES) {
+        return _indices;
+    }
+    std::vector<uint16_t> indices(_count);
+    size_t cnt = 0;
+    for_each([&](size_t i) { indices[cnt++] = static_cast<uint16_t>(i); });
+    return indices;
+}
+
+void Selection::intersect(const BitVec& selector) {
+    VEC_ASSERT_TRUE(static_cast<size_t>(selector.len()) == _num_rows);
+    switch (_kind) {
+    case Kind::ALL:
+        _kind = Kind::BITMAP;
+        _bits = selector;
+        _count = _bits.count();
+        return;
+    case Kind::BITMAP:
+        _bits &= selector;
+        _count = _bits.count();
+        return;
+    case Kind::INDICES:
+        break;
+    }
+    const uint64_t* words = selector.words();
+    size_t cnt = 0;
+    for (uint16_t i : _indices) {
+        _indices[cnt] = i;
+        cnt += (words[i / 64] >> (i % 64)) & 1;
+    }
+    _indices.resize(cnt);
+    _count = cnt;
+}
+
+// the row numbers of FlatBinaryVec::gather
+static std::vector<uint32_t> gather_indices(const Selection& selection) {
+    std::vector<uint32_t> indices(selection.count());
+    size_t cnt = 0;
+    selection.for_each([&](size_t i) { indices[cnt++] = static_cast<uint32_t>(i); });
+    return indices;
+}
+
+void BinaryColumn::filter(const Selection& selection) {
+    switch (selection.kind()) {
+    case Selection::Kind::ALL:
+        return;
+    case Selection::Kind::BITMAP:
+        _data.filter(selection.bits());
+        return;
+    case Selection::Kind::INDICES:
+        break;
+    }
+    std::vector<uint32_t> indices = gather_indices(selection);
+    _data = _data.gather(indices.data(), indices.size());
+}
+
+ColumnPtr BinaryColumn::select(const Selection& selection) const {
+    if (selection.all()) {
+        return clone();
+    }
+    std::vector<uint32_t> indices = gather_indices(selection);
+    return std::make_shared<BinaryColumn>(_data.gather(indices.data(), indices.size()));
+}
+
+Chunk::Chunk(Schema schema, std::vector<ColumnPtr> columns)
+        : _schema(std::move(schema)), _columns(std::move(columns)) {
+    VEC_ASSERT_TRUE(_schema.num_fields() == _columns.size());
+    size_t num_rows = _columns.empty() ? 0 : _columns[0]->size();
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        VEC_ASSERT_TRUE(_columns[i]->type() == _schema.field(i).type);
+        VEC_ASSERT_TRUE(_columns[i]->size() == num_rows);
+    }
+    _selection = Selection(num_rows);
+}
+
+void Chunk::add_column(Field field, ColumnPtr column) {
+    VEC_ASSERT_TRUE(column->type() == field.type);
+    if (_columns.empty()) {
+        _selection = Selection(column->size());
+    }
+    VEC_ASSERT_TRUE(column->size() == num_physical_rows());
+    _schema.add_field(std::move(field));
+    _columns.push_back(std::move(column));
+}
+
+void Chunk::filter(const BitVec& selector) {
+    _selection.intersect(selector);
+    size_t count = _selection.count();
+    size_t num_rows = _selection.num_rows();
+    bool to_indices = _selection.kind() == Selection::Kind::BITMAP &&
+                      count * SELECTION_INDICES_RATIO < num_rows;
+    if (to_indices) {
+        // a gather of the few rows left is cheaper than a filter over all of them
+        _selection = Selection(num_rows, _selection.to_indices());
+    }
+    if (count * SELECTION_COMPACT_RATIO < num_rows) {
+        materialize();
+    }
+}
+
+void Chunk::set_selection(Selection selection) {
+    VEC_ASSERT_TRUE(selection.num_rows() == num_physical_rows());
+    _selection = std::move(selection);
+}
+
+void Chunk::materialize() {
+    if (_selection.all()) {
+        return;
+    }
+    for (auto& column : _columns) {
+        if (column.use_count() > 1) {
+            column = column->select(_selection);
+        } else {
+            column->filter(_selection);
+        }
+    }
+    _selection = Selection(_selection.count());
+}
+
+} // namespace vec
@@ -0,0 +1,139 @@
+#include "vec/cpu_dispatch.h"
+
+#include <cpuid.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace vec {
+
+namespace {
+
+uint64_t xgetbv0() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+CpuInfo detect() {
+    CpuInfo info;
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        return info;
+    }
+    // "AuthenticAMD"
+    info.amd = ebx == signature_AMD_ebx && edx == signature_AMD_edx && ecx == signature_AMD_ecx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return info;
+    }
+    info.sse42 = ecx & bit_SSE4_2;
+    info.popcnt = ecx & bit_POPCNT;
+    info.fma = ecx & bit_FMA;
+    bool osxsave = ecx & bit_OSXSAVE;
+    // XMM|YMM state, and opmask|ZMM_Hi256|Hi16_ZMM state
+    uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    bool os_avx = (xcr0 & 0x06) == 0x06;
+    bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return info;
+    }
+    info.bmi2 = ebx & bit_BMI2;
+    info.avx2 = os_avx && (ebx & bit_AVX2);
+    info.fma = os_avx && info.fma;
+    if (os_avx512) {
+        info.avx512f = ebx & bit_AVX512F;
+        info.avx512dq = ebx & bit_AVX512DQ;
+        info.avx512cd = ebx & bit_AVX512CD;
+        info.avx512bw = ebx & bit_AVX512BW;
+        info.avx512vl = ebx & bit_AVX512VL;
+        info.avx512vbmi = ecx & bit_AVX512VBMI;
+        info.avx512vbmi2 = ecx & bit_AVX512VBMI2;
+        info.avx512vpopcntdq = ecx & bit_AVX512VPOPCNTDQ;
+    }
+    return info;
+}
+
+bool parse_level(const char* name, SimdLevel* level) {
+    for (int i = 0; i < NUM_SIMD_LEVELS; ++i) {
+        if (strcasecmp(name, simd_level_name(static_cast<SimdLevel>(i))) == 0) {
+            *level = static_cast<SimdLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// -1 until the first kernel call
+std::atomic<int> active_level{-1};
+
+int init_level() {
+    SimdLevel level = CpuInfo::host().max_level();
+    SimdLevel cap;
+    const char* env = getenv("VEC_SIMD_LEVEL");
+    if (env != nullptr && parse_level(env, &cap)) {
+        level = std::min(level, cap);
+    }
+    int expected = -1;
+    active_level.compare_exchange_strong(expected, static_cast<int>(level));
+    return active_level.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SCALAR:
+        return "scalar";
+    case SimdLevel::SSE42:
+        return "sse42";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    case SimdLevel::AVX512_VBMI2:
+        return "avx512_vbmi2";
+    }
+    return "unknown";
+}
+
+const CpuInfo& CpuInfo::host() {
+    static const CpuInfo info = detect();
+    return info;
+}
+
+SimdLevel CpuInfo::max_level() const {
+    bool avx512 = avx512f && avx512bw && avx512vl && avx512dq && avx512cd;
+    if (avx512 && avx512vbmi && avx512vbmi2 && avx512vpopcntdq) {
+        return SimdLevel::AVX512_VBMI2;
+    }
+    if (avx512) {
+        return SimdLevel::AVX512;
+    }
+    // Zen1/Zen2 have AVX2 with slow microcoded pdep/pext, the AVX2 kernels do not use them
+    if (avx2 && bmi2 && fma && popcnt) {
+        return SimdLevel::AVX2;
+    }
+    if (sse42 && popcnt) {
+        return SimdLevel::SSE42;
+    }
+    return SimdLevel::SCALAR;
+}
+
+SimdLevel simd_level() {
+    int level = active_level.load(std::memory_order_relaxed);
+    if (__builtin_expect(level < 0, 0)) {
+        level = init_level();
+    }
+    return static_cast<SimdLevel>(level);
+}
+
+void set_simd_level(SimdLevel level) {
+    level = std::min(level, CpuInfo::host().max_level());
+    active_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+} // namespace vec
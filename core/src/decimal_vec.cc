@@ -0,0 +1,342 @@
+#include "vec/decimal_vec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "vec/kernels.h"
+
+namespace vec {
+
+namespace {
+
+using u128 = unsigned __int128;
+
+constexpr __int128 INT128_MAX_VALUE = static_cast<__int128>(~u128(0) >> 1);
+constexpr __int128 INT128_MIN_VALUE = -INT128_MAX_VALUE - 1;
+
+struct Pow10 {
+    constexpr Pow10() : values() {
+        __int128 value = 1;
+        for (int i = 0; i <= DecimalVec::MAX_PRECISION; ++i) {
+            values[i] = value;
+            if (i < DecimalVec::MAX_PRECISION) {
+                value *= 10;
+            }
+        }
+    }
+    __int128 values[DecimalVec::MAX_PRECISION + 1];
+};
+
+constexpr Pow10 pow10{};
+
+// a buffer every row of which is written next
+template <typename T>
+Vec<T> uninitialized(int num_rows) {
+    return Vec<T>(num_rows, NewAllocator::allocate<T>(num_rows));
+}
+
+// the rows of nulls that are null in src too
+void or_nulls(const NullableVec<__int128>& src, uint8_t* __restrict nulls) {
+    const uint8_t* __restrict src_nulls = src.null_data();
+    if (src_nulls == nullptr) {
+        return;
+    }
+    for (int i = 0; i < src.len(); ++i) {
+        nulls[i] |= src_nulls[i];
+    }
+}
+
+// values with the null rows of nulls, nullptr if there is none
+NullableVec<__int128> with_nulls(Vec<__int128> data, const uint8_t* nulls) {
+    if (nulls == nullptr) {
+        return NullableVec<__int128>(std::move(data));
+    }
+    Vec<uint8_t> null_map = uninitialized<uint8_t>(data.len());
+    if (data.len() > 0) {
+        memcpy(null_map.data(), nulls, data.len());
+    }
+    return NullableVec<__int128>(std::move(data), std::move(null_map));
+}
+
+// the products wrap instead of overflowing, the rows that do are null anyway
+inline __int128 wrapping_mul(__int128 a, __int128 b) {
+    return static_cast<__int128>(u128(a) * u128(b));
+}
+
+// ------------------------------------------------------------------------------------
+// rescale
+//
+// A division by 10^k is a call to __divti3 for int128, a multiply and shifts for an
+// int64 divided by a constant. The values of DECIMAL(18) and below fit int64, the
+// division of a column of them is one of scale_down_int64<K>.
+
+// v / divisor, the half away from zero, for an int64 or int128 v
+template <typename T>
+inline T div_round(T v, T divisor) {
+    T quotient = v / divisor;
+    T remainder = v % divisor;
+    T magnitude = remainder < 0 ? -remainder : remainder;
+    // 2 * |remainder| >= divisor without overflowing the largest divisors
+    T away = magnitude >= divisor - magnitude;
+    return quotient + (v < 0 ? -away : away);
+}
+
+template <int K>
+void scale_down_int64(const __int128* __restrict src, int num_rows, __int128* __restrict dst) {
+    constexpr int64_t divisor = static_cast<int64_t>(pow10.values[K]);
+    for (int i = 0; i < num_rows; ++i) {
+        dst[i] = div_round(static_cast<int64_t>(src[i]), divisor);
+    }
+}
+
+using ScaleDownFn = void (*)(const __int128*, int, __int128*);
+
+// indexed by K, 10^18 is the largest power of 10 of an int64
+constexpr ScaleDownFn scale_down_int64_fns[] = {
+        nullptr,              scale_down_int64<1>,  scale_down_int64<2>,  scale_down_int64<3>,
+        scale_down_int64<4>,  scale_down_int64<5>,  scale_down_int64<6>,  scale_down_int64<7>,
+        scale_down_int64<8>,  scale_down_int64<9>,  scale_down_int64<10>, scale_down_int64<11>,
+        scale_down_int64<12>, scale_down_int64<13>, scale_down_int64<14>, scale_down_int64<15>,
+        scale_down_int64<16>, scale_down_int64<17>, scale_down_int64<18>};
+
+constexpr int MAX_INT64_SCALE_DOWN = 18;
+
+void scale_down_int128(const __int128* __restrict src, __int128 divisor, int num_rows,
+                       __int128* __restrict dst) {
+    for (int i = 0; i < num_rows; ++i) {
+        dst[i] = div_round(src[i], divisor);
+    }
+}
+
+// every value is a sign extended int64
+bool fits_int64(const __int128* values, int num_rows) {
+    uint64_t wide = 0;
+    for (int i = 0; i < num_rows; ++i) {
+        wide |= static_cast<uint64_t>(values[i] >> 64) ^
+                static_cast<uint64_t>(static_cast<int64_t>(values[i]) >> 63);
+    }
+    return wide == 0;
+}
+
+// ------------------------------------------------------------------------------------
+// add / sub
+
+// dst[i] = lhs[i] * f OP rhs[i] or lhs[i] OP rhs[i] * f, as SCALED is 1 or 2 (0: no
+// factor). The result has at most MAX_PRECISION digits.
+template <bool SUB, int SCALED>
+void add_rows(const __int128* __restrict lhs, const __int128* __restrict rhs, __int128 factor,
+              int num_rows, __int128* __restrict dst) {
+    for (int i = 0; i < num_rows; ++i) {
+        __int128 a = SCALED == 1 ? lhs[i] * factor : lhs[i];
+        __int128 b = SCALED == 2 ? rhs[i] * factor : rhs[i];
+        dst[i] = SUB ? a - b : a + b;
+    }
+}
+
+// add_rows of a result type capped at MAX_PRECISION digits, the rows past it are null
+template <bool SUB>
+void add_rows_checked(const __int128* lhs, const __int128* rhs, __int128 lhs_factor,
+                      __int128 rhs_factor, int num_rows, __int128* dst, uint8_t* nulls) {
+    const __int128 max_value = pow10.values[DecimalVec::MAX_PRECISION] - 1;
+    for (int i = 0; i < num_rows; ++i) {
+        __int128 a, b, res;
+        bool overflow = __builtin_mul_overflow(lhs[i], lhs_factor, &a);
+        overflow |= __builtin_mul_overflow(rhs[i], rhs_factor, &b);
+        overflow |= SUB ? __builtin_sub_overflow(a, b, &res)
+                        : __builtin_add_overflow(a, b, &res);
+        overflow |= res > max_value || res < -max_value;
+        dst[i] = res;
+        nulls[i] |= overflow;
+    }
+}
+
+} // namespace
+
+DecimalVec::DecimalVec(int precision, int scale) : DecimalVec(precision, scale, {}) {}
+
+DecimalVec::DecimalVec(int precision, int scale, NullableVec<__int128> values)
+        : _precision(precision), _scale(scale), _values(std::move(values)) {
+    VEC_ASSERT_TRUE(precision >= 1 && precision <= MAX_PRECISION);
+    VEC_ASSERT_TRUE(scale >= 0 && scale <= precision);
+}
+
+DecimalVec DecimalVec::decode(int precision, int scale, const uint8_t* src, int binsz,
+                              int num_rows, const uint8_t* nulls) {
+    Vec<__int128> data = uninitialized<__int128>(num_rows);
+    if (nulls == nullptr) {
+        decode_be_int128(src, binsz, num_rows, data.data());
+        return DecimalVec(precision, scale, NullableVec<__int128>(std::move(data)));
+    }
+    decode_be_int128_nullable(src, nulls, binsz, num_rows, data.data());
+    return DecimalVec(precision, scale, with_nulls(std::move(data), nulls));
+}
+
+std::string DecimalVec::to_string(int index) const {
+    if (is_null(index)) {
+        return "NULL";
+    }
+    __int128 value = _values[index];
+    u128 magnitude = value < 0 ? -u128(value) : u128(value);
+    // the digits from the lowest, at least one before the point
+    std::string digits;
+    do {
+        digits.push_back('0' + static_cast<int>(magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+    while (digits.size() <= size_t(_scale)) {
+        digits.push_back('0');
+    }
+    std::string res = value < 0 ? "-" : "";
+    for (size_t i = digits.size(); i-- > 0;) {
+        res.push_back(digits[i]);
+        if (i == size_t(_scale) && _scale > 0) {
+            res.push_back('.');
+        }
+    }
+    return res;
+}
+
+DecimalVec DecimalVec::rescale(int scale) const {
+    VEC_ASSERT_TRUE(scale >= 0 && scale <= MAX_PRECISION);
+    if (scale == _scale) {
+        return *this;
+    }
+    int num_rows = len();
+    const __int128* __restrict src = _values.data().data();
+    Vec<__int128> data = uninitialized<__int128>(num_rows);
+    __int128* __restrict dst = data.data();
+    if (scale < _scale) {
+        int k = _scale - scale;
+        if (k <= MAX_INT64_SCALE_DOWN && fits_int64(src, num_rows)) {
+            scale_down_int64_fns[k](src, num_rows, dst);
+        } else {
+            scale_down_int128(src, pow10.values[k], num_rows, dst);
+        }
+        return DecimalVec(_precision - k + 1, scale,
+                          with_nulls(std::move(data), _values.null_data()));
+    }
+    int k = scale - _scale;
+    const __int128 factor = pow10.values[k];
+    if (_precision + k <= MAX_PRECISION) {
+        for (int i = 0; i < num_rows; ++i) {
+            dst[i] = src[i] * factor;
+        }
+        return DecimalVec(_precision + k, scale,
+                          with_nulls(std::move(data), _values.null_data()));
+    }
+    // the values of more than MAX_PRECISION - k digits overflow
+    const __int128 bound = pow10.values[MAX_PRECISION - k];
+    Vec<uint8_t> nulls(num_rows);
+    or_nulls(_values, nulls.data());
+    uint8_t* __restrict overflow = nulls.data();
+    for (int i = 0; i < num_rows; ++i) {
+        overflow[i] |= src[i] >= bound || src[i] <= -bound;
+        dst[i] = wrapping_mul(src[i], factor);
+    }
+    return DecimalVec(MAX_PRECISION, scale,
+                      NullableVec<__int128>(std::move(data), std::move(nulls)));
+}
+
+template <bool SUB>
+DecimalVec DecimalVec::_add(const DecimalVec& other) const {
+    VEC_ASSERT_TRUE(len() == other.len());
+    int num_rows = len();
+    int scale = std::max(_scale, other._scale);
+    int digits = std::max(_precision - _scale, other._precision - other._scale) + scale + 1;
+    const __int128* lhs = _values.data().data();
+    const __int128* rhs = other._values.data().data();
+    __int128 lhs_factor = pow10.values[scale - _scale];
+    __int128 rhs_factor = pow10.values[scale - other._scale];
+    Vec<__int128> data = uninitialized<__int128>(num_rows);
+    if (digits > MAX_PRECISION) {
+        Vec<uint8_t> nulls(num_rows);
+        or_nulls(_values, nulls.data());
+        or_nulls(other._values, nulls.data());
+        add_rows_checked<SUB>(lhs, rhs, lhs_factor, rhs_factor, num_rows, data.data(),
+                              nulls.data());
+        return DecimalVec(MAX_PRECISION, scale,
+                          NullableVec<__int128>(std::move(data), std::move(nulls)));
+    }
+    if (lhs_factor > 1) {
+        add_rows<SUB, 1>(lhs, rhs, lhs_factor, num_rows, data.data());
+    } else if (rhs_factor > 1) {
+        add_rows<SUB, 2>(lhs, rhs, rhs_factor, num_rows, data.data());
+    } else {
+        add_rows<SUB, 0>(lhs, rhs, 1, num_rows, data.data());
+    }
+    if (!has_null() && !other.has_null()) {
+        return DecimalVec(digits, scale, NullableVec<__int128>(std::move(data)));
+    }
+    Vec<uint8_t> nulls(num_rows);
+    or_nulls(_values, nulls.data());
+    or_nulls(other._values, nulls.data());
+    return DecimalVec(digits, scale, NullableVec<__int128>(std::move(data), std::move(nulls)));
+}
+
+DecimalVec DecimalVec::operator+(const DecimalVec& other) const {
+    return _add<false>(other);
+}
+
+DecimalVec DecimalVec::operator-(const DecimalVec& other) const {
+    return _add<true>(other);
+}
+
+Vec<__int128> DecimalVec::_upscaled(int scale) const {
+    VEC_ASSERT_TRUE(scale >= _scale);
+    int num_rows = len();
+    const __int128* __restrict src = _values.data().data();
+    Vec<__int128> res = uninitialized<__int128>(num_rows);
+    __int128* __restrict dst = res.data();
+    const __int128 factor = pow10.values[scale - _scale];
+    const __int128 bound = INT128_MAX_VALUE / factor;
+    for (int i = 0; i < num_rows; ++i) {
+        __int128 v = src[i];
+        __int128 scaled = wrapping_mul(v, factor);
+        dst[i] = v > bound ? INT128_MAX_VALUE : v < -bound ? INT128_MIN_VALUE : scaled;
+    }
+    return res;
+}
+
+BitVec DecimalVec::compare_bits(CompareOp op, const DecimalVec& other) const {
+    VEC_ASSERT_TRUE(len() == other.len());
+    BitVec bits(len());
+    if (_scale == other._scale) {
+        vec::compare_bits(op, _values.data().data(), other._values.data().data(), len(),
+                          bits.words());
+    } else if (_scale < other._scale) {
+        vec::compare_bits(op, _upscaled(other._scale).data(), other._values.data().data(),
+                          len(), bits.words());
+    } else {
+        vec::compare_bits(op, _values.data().data(), other._upscaled(_scale).data(), len(),
+                          bits.words());
+    }
+    if (has_null()) {
+        bits.and_not(_values.null_bits());
+    }
+    if (other.has_null()) {
+        bits.and_not(other._values.null_bits());
+    }
+    return bits;
+}
+
+BitVec DecimalVec::compare_bits(CompareOp op, __int128 value, int scale) const {
+    VEC_ASSERT_TRUE(scale >= 0 && scale <= MAX_PRECISION);
+    BitVec bits(len());
+    if (scale <= _scale) {
+        // the constant at the scale of the column, saturated like _upscaled()
+        __int128 factor = pow10.values[_scale - scale];
+        __int128 bound = INT128_MAX_VALUE / factor;
+        value = value > bound ? INT128_MAX_VALUE
+                              : value < -bound ? INT128_MIN_VALUE : value * factor;
+        vec::compare_bits(op, _values.data().data(), value, len(), bits.words());
+    } else {
+        vec::compare_bits(op, _upscaled(scale).data(), value, len(), bits.words());
+    }
+    if (has_null()) {
+        bits.and_not(_values.null_bits());
+    }
+    return bits;
+}
+
+} // namespace vec
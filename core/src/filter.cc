@@ -0,0 +1,439 @@
+#include "vec/filter.h"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#include "vec/cpu_dispatch.h"
+
+namespace vec {
+
+namespace {
+
+template <typename T>
+inline void copy_row(T* dst, const T* src) {
+    memcpy(dst, src, sizeof(T));
+}
+
+template <typename T>
+inline size_t filter_tail(const uint8_t* selection, const T* data, size_t i, size_t num_rows,
+                          T* dst, size_t cnt) {
+    for (; i < num_rows; ++i) {
+        if (selection[i]) copy_row(dst + cnt++, data + i);
+    }
+    return cnt;
+}
+
+// copy the rows of a partially selected block, one bit per row in mask
+template <typename T>
+inline size_t filter_by_mask(uint64_t mask, const T* data, T* dst, size_t cnt) {
+    while (mask) {
+        copy_row(dst + cnt++, data + __builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+    return cnt;
+}
+
+// ------------------------------------------------------------------------------------
+// scalar: 8 selection bytes per step
+
+template <typename T>
+size_t filter_scalar(const uint8_t* selection, const T* data, size_t num_rows, T* dst) {
+    constexpr uint64_t LOW7 = 0x7F7F7F7F7F7F7F7FULL;
+    constexpr uint64_t HIGH = 0x8080808080808080ULL;
+    size_t cnt = 0;
+    size_t i = 0;
+    for (; i + 8 <= num_rows; i += 8) {
+        uint64_t word;
+        memcpy(&word, selection + i, sizeof(word));
+        // the high bit of every non-zero byte
+        uint64_t nonzero = (((word & LOW7) + LOW7) | word) & HIGH;
+        if (nonzero == 0) {
+            continue;
+        }
+        if (nonzero == HIGH) {
+            if (dst + cnt != data + i) memmove(dst + cnt, data + i, 8 * sizeof(T));
+            cnt += 8;
+            continue;
+        }
+        while (nonzero) {
+            copy_row(dst + cnt++, data + i + (__builtin_ctzll(nonzero) >> 3));
+            nonzero &= nonzero - 1;
+        }
+    }
+    return filter_tail(selection, data, i, num_rows, dst, cnt);
+}
+
+size_t count_nonzero_scalar(const uint8_t* selection, size_t num_rows) {
+    size_t cnt = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        cnt += selection[i] != 0;
+    }
+    return cnt;
+}
+
+// ------------------------------------------------------------------------------------
+// SSE2: 16 selection bytes per step, whole blocks are skipped or copied
+
+template <typename T>
+size_t filter_sse2(const uint8_t* selection, const T* data, size_t num_rows, T* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t cnt = 0;
+    size_t i = 0;
+    for (; i + 16 <= num_rows; i += 16) {
+        __m128i sel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(selection + i));
+        uint32_t mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(sel, zero)) & 0xFFFF;
+        if (mask == 0) {
+            continue;
+        }
+        if (mask == 0xFFFF) {
+            if (dst + cnt != data + i) memmove(dst + cnt, data + i, 16 * sizeof(T));
+            cnt += 16;
+            continue;
+        }
+        cnt = filter_by_mask(mask, data + i, dst, cnt);
+    }
+    return filter_tail(selection, data, i, num_rows, dst, cnt);
+}
+
+size_t count_nonzero_sse2(const uint8_t* selection, size_t num_rows) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t zeros = 0;
+    size_t i = 0;
+    for (; i + 16 <= num_rows; i += 16) {
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(selection + i)), zero));
+        zeros += __builtin_popcount(mask);
+    }
+    return i - zeros + count_nonzero_scalar(selection + i, num_rows - i);
+}
+
+// ------------------------------------------------------------------------------------
+// AVX2: 32 selection bytes per step
+
+VEC_TARGET_AVX2 inline uint32_t nonzero_mask_avx2(const uint8_t* selection) {
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(selection)),
+            _mm256_setzero_si256())));
+}
+
+// 1 and 2 bytes rows: bit scan the partially selected blocks
+template <typename T>
+VEC_TARGET_AVX2 size_t filter_avx2(const uint8_t* selection, const T* data, size_t num_rows,
+                                   T* dst) {
+    size_t cnt = 0;
+    size_t i = 0;
+    for (; i + 32 <= num_rows; i += 32) {
+        uint32_t mask = nonzero_mask_avx2(selection + i);
+        if (mask == 0) {
+            continue;
+        }
+        if (mask == 0xFFFFFFFF) {
+            if (dst + cnt != data + i) memmove(dst + cnt, data + i, 32 * sizeof(T));
+            cnt += 32;
+            continue;
+        }
+        cnt = filter_by_mask(mask, data + i, dst, cnt);
+    }
+    return filter_tail(selection, data, i, num_rows, dst, cnt);
+}
+
+// vpermd indices that move the selected lanes to the front, one byte per index
+// for 8 x 32-bit lanes, or per 32-bit half of 4 x 64-bit lanes
+template <int LANES>
+struct CompressLUT {
+    static constexpr int NUM_MASKS = 1 << LANES;
+    constexpr CompressLUT() : indices() {
+        constexpr int words = 8 / LANES;
+        for (int mask = 0; mask < NUM_MASKS; ++mask) {
+            uint64_t packed = 0;
+            int pos = 0;
+            for (int lane = 0; lane < LANES; ++lane) {
+                if (mask & (1 << lane)) {
+                    for (int w = 0; w < words; ++w) {
+                        packed |= uint64_t(lane * words + w) << (8 * pos++);
+                    }
+                }
+            }
+            indices[mask] = packed;
+        }
+    }
+    uint64_t indices[NUM_MASKS];
+};
+
+template <int LANES>
+constexpr CompressLUT<LANES> compress_lut{};
+
+template <int LANES>
+VEC_TARGET_AVX2 inline __m256i compress_avx2(__m256i values, uint32_t mask) {
+    __m256i perm = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(compress_lut<LANES>.indices[mask]));
+    return _mm256_permutevar8x32_epi32(values, perm);
+}
+
+// branch-free permute of every 8/4 rows through the LUT
+template <typename T, int ROWS>
+VEC_TARGET_AVX2 inline size_t compress_rows_avx2(uint64_t mask, const T* data, T* dst,
+                                                 size_t cnt) {
+    constexpr int LANES = 32 / sizeof(T);
+    for (int k = 0; k < ROWS; k += LANES) {
+        uint32_t m = (mask >> k) & ((1u << LANES) - 1);
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + k));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + cnt), compress_avx2<LANES>(values, m));
+        cnt += _mm_popcnt_u32(m);
+    }
+    return cnt;
+}
+
+// 4 and 8 bytes rows
+template <typename T>
+VEC_TARGET_AVX2 size_t filter_avx2_permute(const uint8_t* selection, const T* data,
+                                           size_t num_rows, T* dst) {
+    size_t cnt = 0;
+    size_t i = 0;
+    for (; i + 32 <= num_rows; i += 32) {
+        uint32_t mask = nonzero_mask_avx2(selection + i);
+        if (mask == 0) {
+            continue;
+        }
+        if (mask == 0xFFFFFFFF) {
+            if (dst + cnt != data + i) memmove(dst + cnt, data + i, 32 * sizeof(T));
+            cnt += 32;
+            continue;
+        }
+        cnt = compress_rows_avx2<T, 32>(mask, data + i, dst, cnt);
+    }
+    return filter_tail(selection, data, i, num_rows, dst, cnt);
+}
+
+VEC_TARGET_AVX2 size_t count_nonzero_avx2(const uint8_t* selection, size_t num_rows) {
+    size_t cnt = 0;
+    size_t i = 0;
+    for (; i + 32 <= num_rows; i += 32) {
+        cnt += _mm_popcnt_u32(nonzero_mask_avx2(selection + i));
+    }
+    return cnt + count_nonzero_scalar(selection + i, num_rows - i);
+}
+
+// ------------------------------------------------------------------------------------
+// AVX-512: compress the selected lanes of a whole register, 64 selection bytes per step.
+// 32/64-bit lanes need AVX512F, 8/16-bit lanes need VBMI2 (Icelake and later, Zen4)
+
+template <typename T>
+VEC_TARGET_AVX512_VBMI2 inline __m512i compress_avx512_vbmi2(uint64_t mask, __m512i values) {
+    if constexpr (sizeof(T) == 1) {
+        return _mm512_maskz_compress_epi8(mask, values);
+    } else {
+        return _mm512_maskz_compress_epi16(static_cast<__mmask32>(mask), values);
+    }
+}
+
+template <typename T>
+VEC_TARGET_AVX512 inline __m512i compress_avx512(uint64_t mask, __m512i values) {
+    if constexpr (sizeof(T) == 4) {
+        return _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), values);
+    } else {
+        return _mm512_maskz_compress_epi64(static_cast<__mmask8>(mask), values);
+    }
+}
+
+// the selected rows of 64 rows
+template <typename T>
+VEC_TARGET_AVX512 inline size_t compress_rows_avx512(uint64_t mask, const T* data, T* dst,
+                                                     size_t cnt) {
+    constexpr int LANES = 64 / sizeof(T);
+    for (int k = 0; k < 64; k += LANES) {
+        uint64_t m = (mask >> k) & ((uint64_t(1) << LANES) - 1);
+        _mm512_storeu_si512(dst + cnt, compress_avx512<T>(m, _mm512_loadu_si512(data + k)));
+        cnt += _mm_popcnt_u64(m);
+    }
+    return cnt;
+}
+
+template <typename T>
+VEC_TARGET_AVX512_VBMI2 inline size_t compress_rows_avx512_vbmi2(uint64_t mask, const T* data,
+                                                                 T* dst, size_t cnt) {
+    constexpr int LANES = 64 / sizeof(T);
+    for (int k = 0; k < 64; k += LANES) {
+        uint64_t m = LANES == 64 ? mask : (mask >> k) & ((uint64_t(1) << LANES) - 1);
+        _mm512_storeu_si512(dst + cnt, compress_avx512_vbmi2<T>(m, _mm512_loadu_si512(data + k)));
+        cnt += _mm_popcnt_u64(m);
+    }
+    return cnt;
+}
+
+#define VEC_FILTER_AVX512_BODY(COMPRESS_ROWS)                                        \
+    size_t cnt = 0;                                                                  \
+    size_t i = 0;                                                                    \
+    for (; i + 64 <= num_rows; i += 64) {                                            \
+        __m512i sel = _mm512_loadu_si512(selection + i);                             \
+        uint64_t mask = _mm512_test_epi8_mask(sel, sel);                             \
+        if (mask == 0) {                                                             \
+            continue;                                                                \
+        }                                                                            \
+        if (mask == ~uint64_t(0)) {                                                  \
+            if (dst + cnt != data + i) memmove(dst + cnt, data + i, 64 * sizeof(T)); \
+            cnt += 64;                                                               \
+            continue;                                                                \
+        }                                                                            \
+        cnt = COMPRESS_ROWS<T>(mask, data + i, dst, cnt);                            \
+    }                                                                                \
+    return filter_tail(selection, data, i, num_rows, dst, cnt);
+
+template <typename T>
+VEC_TARGET_AVX512 size_t filter_avx512(const uint8_t* selection, const T* data, size_t num_rows,
+                                       T* dst) {
+    VEC_FILTER_AVX512_BODY(compress_rows_avx512)
+}
+
+template <typename T>
+VEC_TARGET_AVX512_VBMI2 size_t filter_avx512_vbmi2(const uint8_t* selection, const T* data,
+                                                   size_t num_rows, T* dst) {
+    VEC_FILTER_AVX512_BODY(compress_rows_avx512_vbmi2)
+}
+
+#undef VEC_FILTER_AVX512_BODY
+
+VEC_TARGET_AVX512 size_t count_nonzero_avx512(const uint8_t* selection, size_t num_rows) {
+    size_t cnt = 0;
+    size_t i = 0;
+    for (; i + 64 <= num_rows; i += 64) {
+        __m512i sel = _mm512_loadu_si512(selection + i);
+        cnt += _mm_popcnt_u64(_mm512_test_epi8_mask(sel, sel));
+    }
+    return cnt + count_nonzero_scalar(selection + i, num_rows - i);
+}
+
+// ------------------------------------------------------------------------------------
+// bitmap selection (BitVec): a word already is the mask of 64 rows. The last
+// partial word is bit scanned, the bits past the last row are zero.
+
+template <typename T>
+inline size_t compress_rows_scalar(uint64_t mask, const T* data, T* dst, size_t cnt) {
+    return filter_by_mask(mask, data, dst, cnt);
+}
+
+template <typename T>
+VEC_TARGET_AVX2 inline size_t compress_rows_avx2_64(uint64_t mask, const T* data, T* dst,
+                                                    size_t cnt) {
+    return compress_rows_avx2<T, 64>(mask, data, dst, cnt);
+}
+
+#define VEC_FILTER_BITS_BODY(COMPRESS_ROWS)                                                \
+    size_t cnt = 0;                                                                        \
+    size_t num_full_words = num_rows / 64;                                                 \
+    for (size_t w = 0; w < num_full_words; ++w) {                                          \
+        uint64_t mask = words[w];                                                          \
+        const T* block = data + w * 64;                                                    \
+        if (mask == 0) {                                                                   \
+            continue;                                                                      \
+        }                                                                                  \
+        if (mask == ~uint64_t(0)) {                                                        \
+            if (dst + cnt != block) memmove(dst + cnt, block, 64 * sizeof(T));             \
+            cnt += 64;                                                                     \
+            continue;                                                                      \
+        }                                                                                  \
+        cnt = COMPRESS_ROWS<T>(mask, block, dst, cnt);                                     \
+    }                                                                                      \
+    if (num_full_words * 64 < num_rows) {                                                  \
+        cnt = filter_by_mask(words[num_full_words], data + num_full_words * 64, dst, cnt); \
+    }                                                                                      \
+    return cnt;
+
+template <typename T>
+size_t filter_bits_scalar(const uint64_t* words, const T* data, size_t num_rows, T* dst) {
+    VEC_FILTER_BITS_BODY(compress_rows_scalar)
+}
+
+template <typename T>
+VEC_TARGET_AVX2 size_t filter_bits_avx2(const uint64_t* words, const T* data, size_t num_rows,
+                                        T* dst) {
+    VEC_FILTER_BITS_BODY(compress_rows_avx2_64)
+}
+
+template <typename T>
+VEC_TARGET_AVX512 size_t filter_bits_avx512(const uint64_t* words, const T* data,
+                                            size_t num_rows, T* dst) {
+    VEC_FILTER_BITS_BODY(compress_rows_avx512)
+}
+
+template <typename T>
+VEC_TARGET_AVX512_VBMI2 size_t filter_bits_avx512_vbmi2(const uint64_t* words, const T* data,
+                                                        size_t num_rows, T* dst) {
+    VEC_FILTER_BITS_BODY(compress_rows_avx512_vbmi2)
+}
+
+#undef VEC_FILTER_BITS_BODY
+
+// ------------------------------------------------------------------------------------
+// dispatch
+
+template <typename T>
+using FilterFn = size_t (*)(const uint8_t*, const T*, size_t, T*);
+
+using CountFn = size_t (*)(const uint8_t*, size_t);
+
+// 1 and 2 bytes rows only get a compress instruction with VBMI2
+template <typename T>
+constexpr KernelTable<FilterFn<T>> make_filter_kernels() {
+    if constexpr (sizeof(T) <= 2) {
+        return {filter_scalar<T>, filter_sse2<T>, filter_avx2<T>, nullptr, filter_avx512_vbmi2<T>};
+    } else {
+        return {filter_scalar<T>, filter_sse2<T>, filter_avx2_permute<T>, filter_avx512<T>,
+                nullptr};
+    }
+}
+
+template <typename T>
+constexpr KernelTable<FilterFn<T>> filter_kernels = make_filter_kernels<T>();
+
+template <typename T>
+using FilterBitsFn = size_t (*)(const uint64_t*, const T*, size_t, T*);
+
+template <typename T>
+constexpr KernelTable<FilterBitsFn<T>> make_filter_bits_kernels() {
+    if constexpr (sizeof(T) <= 2) {
+        return {filter_bits_scalar<T>, nullptr, nullptr, nullptr, filter_bits_avx512_vbmi2<T>};
+    } else {
+        return {filter_bits_scalar<T>, nullptr, filter_bits_avx2<T>, filter_bits_avx512<T>,
+                nullptr};
+    }
+}
+
+template <typename T>
+constexpr KernelTable<FilterBitsFn<T>> filter_bits_kernels = make_filter_bits_kernels<T>();
+
+constexpr KernelTable<CountFn> count_nonzero_kernels(count_nonzero_scalar, count_nonzero_sse2,
+                                                     count_nonzero_avx2, count_nonzero_avx512,
+                                                     nullptr);
+
+} // namespace
+
+size_t count_nonzero(const uint8_t* selection, size_t num_rows) {
+    return count_nonzero_kernels.get()(selection, num_rows);
+}
+
+#define VEC_DEFINE_FILTER(name, T)                                                  \
+    size_t name(const uint8_t* selection, const T* data, size_t num_rows, T* dst) { \
+        return filter_kernels<T>.get()(selection, data, num_rows, dst);             \
+    }
+
+VEC_DEFINE_FILTER(filter_u8, uint8_t)
+VEC_DEFINE_FILTER(filter_u16, uint16_t)
+VEC_DEFINE_FILTER(filter_u32, uint32_t)
+VEC_DEFINE_FILTER(filter_u64, uint64_t)
+
+#undef VEC_DEFINE_FILTER
+
+#define VEC_DEFINE_FILTER_BITS(name, T)                                              \
+    size_t name(const uint64_t* selection, const T* data, size_t num_rows, T* dst) { \
+        return filter_bits_kernels<T>.get()(selection, data, num_rows, dst);         \
+    }
+
+VEC_DEFINE_FILTER_BITS(filter_bits_u8, uint8_t)
+VEC_DEFINE_FILTER_BITS(filter_bits_u16, uint16_t)
+VEC_DEFINE_FILTER_BITS(filter_bits_u32, uint32_t)
+VEC_DEFINE_FILTER_BITS(filter_bits_u64, uint64_t)
+
+#undef VEC_DEFINE_FILTER_BITS
+
+} // namespace vec
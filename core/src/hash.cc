@@ -0,0 +1,478 @@
+#include "vec/hash.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "vec/cpu_dispatch.h"
+
+namespace vec {
+
+namespace {
+
+// ------------------------------------------------------------------------------------
+// one row
+
+constexpr uint32_t FNV_PRIME = 0x01000193;
+
+inline uint32_t fnv1a_u32(uint32_t key, uint32_t hash) {
+    for (int i = 0; i < 4; ++i) {
+        hash = (hash ^ (key & 0xFF)) * FNV_PRIME;
+        key >>= 8;
+    }
+    return hash;
+}
+
+inline uint32_t fnv1a_bytes(const uint8_t* data, size_t size, uint32_t hash) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+constexpr uint32_t MURMUR_C1 = 0xCC9E2D51;
+constexpr uint32_t MURMUR_C2 = 0x1B873593;
+
+inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+inline uint32_t murmur_key(uint32_t key) {
+    return rotl32(key * MURMUR_C1, 15) * MURMUR_C2;
+}
+
+inline uint32_t murmur_block(uint32_t hash, uint32_t key) {
+    return rotl32(hash ^ murmur_key(key), 13) * 5 + 0xE6546B64;
+}
+
+inline uint32_t murmur_fmix(uint32_t hash) {
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    return hash ^ (hash >> 16);
+}
+
+inline uint32_t murmur3_bytes(const uint8_t* data, size_t size, uint32_t hash) {
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        uint32_t key;
+        memcpy(&key, data + i, 4);
+        hash = murmur_block(hash, key);
+    }
+    // byte loads, a memcpy of a variable size is a call
+    uint32_t key = 0;
+    switch (size - i) {
+    case 3:
+        key |= data[i + 2] << 16;
+        [[fallthrough]];
+    case 2:
+        key |= data[i + 1] << 8;
+        [[fallthrough]];
+    case 1:
+        key |= data[i];
+        hash ^= murmur_key(key);
+    }
+    return murmur_fmix(hash ^ static_cast<uint32_t>(size));
+}
+
+// reflected Castagnoli polynomial, a byte at a time: the same crc as the instruction
+struct Crc32cTable {
+    uint32_t entries[256];
+
+    constexpr Crc32cTable() : entries() {
+        for (uint32_t byte = 0; byte < 256; ++byte) {
+            uint32_t crc = byte;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (crc & 1 ? 0x82F63B78 : 0);
+            }
+            entries[byte] = crc;
+        }
+    }
+};
+
+constexpr Crc32cTable CRC32C_TABLE;
+
+inline uint32_t crc32c_bytes_scalar(const uint8_t* data, size_t size, uint32_t crc) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = CRC32C_TABLE.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+VEC_TARGET_SSE42 inline uint32_t crc32c_bytes_sse42(const uint8_t* data, size_t size,
+                                                   uint32_t crc) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        crc = _mm_crc32_u64(crc, word);
+    }
+    for (; i < size; ++i) {
+        crc = _mm_crc32_u8(crc, data[i]);
+    }
+    return crc;
+}
+
+template <HashFunc F>
+inline uint32_t hash_bytes_scalar(const uint8_t* data, size_t size, uint32_t seed) {
+    if constexpr (F == HashFunc::FNV1A) {
+        return fnv1a_bytes(data, size, seed);
+    } else if constexpr (F == HashFunc::CRC32C) {
+        return crc32c_bytes_scalar(data, size, seed);
+    } else {
+        return murmur3_bytes(data, size, seed);
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// integer columns
+
+template <HashFunc F, typename T>
+void hash_ints_scalar(const T* keys, size_t num_rows, uint32_t* hashes) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        auto key = static_cast<std::make_unsigned_t<T>>(keys[i]);
+        uint32_t lo = static_cast<uint32_t>(key);
+        uint32_t hash = hashes[i];
+        if constexpr (F == HashFunc::FNV1A) {
+            hash = fnv1a_u32(lo, hash);
+            if constexpr (sizeof(T) == 8) {
+                hash = fnv1a_u32(static_cast<uint32_t>(key >> 32), hash);
+            }
+        } else if constexpr (F == HashFunc::CRC32C) {
+            hash = crc32c_bytes_scalar(reinterpret_cast<const uint8_t*>(keys + i), sizeof(T),
+                                       hash);
+        } else {
+            hash = murmur_block(hash, lo);
+            if constexpr (sizeof(T) == 8) {
+                hash = murmur_block(hash, static_cast<uint32_t>(key >> 32));
+            }
+            hash = murmur_fmix(hash ^ sizeof(T));
+        }
+        hashes[i] = hash;
+    }
+}
+
+// independent rows, the 3 cycle latency of crc32 overlaps across rows
+template <typename T>
+VEC_TARGET_SSE42 void crc32c_ints_sse42(const T* keys, size_t num_rows, uint32_t* hashes) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        if constexpr (sizeof(T) == 4) {
+            hashes[i] = _mm_crc32_u32(hashes[i], static_cast<uint32_t>(keys[i]));
+        } else {
+            hashes[i] = _mm_crc32_u64(hashes[i], static_cast<uint64_t>(keys[i]));
+        }
+    }
+}
+
+// The vector versions hash 32-bit lanes: an int64 row is split into the vector of
+// its low halves and the vector of its high halves, hashed one after the other.
+
+VEC_TARGET_AVX2 inline __m256i fnv1a_avx2(__m256i hash, __m256i key) {
+    const __m256i prime = _mm256_set1_epi32(FNV_PRIME);
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    for (int i = 0; i < 4; ++i) {
+        hash = _mm256_mullo_epi32(_mm256_xor_si256(hash, _mm256_and_si256(key, byte)), prime);
+        key = _mm256_srli_epi32(key, 8);
+    }
+    return hash;
+}
+
+template <int R>
+VEC_TARGET_AVX2 inline __m256i rotl_avx2(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi32(x, R), _mm256_srli_epi32(x, 32 - R));
+}
+
+VEC_TARGET_AVX2 inline __m256i murmur_block_avx2(__m256i hash, __m256i key) {
+    key = _mm256_mullo_epi32(key, _mm256_set1_epi32(MURMUR_C1));
+    key = _mm256_mullo_epi32(rotl_avx2<15>(key), _mm256_set1_epi32(MURMUR_C2));
+    hash = rotl_avx2<13>(_mm256_xor_si256(hash, key));
+    return _mm256_add_epi32(_mm256_mullo_epi32(hash, _mm256_set1_epi32(5)),
+                            _mm256_set1_epi32(0xE6546B64));
+}
+
+VEC_TARGET_AVX2 inline __m256i murmur_fmix_avx2(__m256i hash, uint32_t size) {
+    hash = _mm256_xor_si256(hash, _mm256_set1_epi32(size));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(0x85EBCA6B));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 13));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(0xC2B2AE35));
+    return _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+}
+
+template <HashFunc F, typename T>
+VEC_TARGET_AVX2 void hash_ints_avx2(const T* keys, size_t num_rows, uint32_t* hashes) {
+    // even then odd 32-bit halves
+    const __m256i halves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    size_t i = 0;
+    for (; i + 8 <= num_rows; i += 8) {
+        __m256i hash = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i));
+        __m256i lo, hi;
+        if constexpr (sizeof(T) == 4) {
+            lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        } else {
+            __m256i a = _mm256_permutevar8x32_epi32(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), halves);
+            __m256i b = _mm256_permutevar8x32_epi32(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i + 4)), halves);
+            lo = _mm256_permute2x128_si256(a, b, 0x20);
+            hi = _mm256_permute2x128_si256(a, b, 0x31);
+        }
+        if constexpr (F == HashFunc::FNV1A) {
+            hash = fnv1a_avx2(hash, lo);
+            if constexpr (sizeof(T) == 8) {
+                hash = fnv1a_avx2(hash, hi);
+            }
+        } else {
+            hash = murmur_block_avx2(hash, lo);
+            if constexpr (sizeof(T) == 8) {
+                hash = murmur_block_avx2(hash, hi);
+            }
+            hash = murmur_fmix_avx2(hash, sizeof(T));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + i), hash);
+    }
+    hash_ints_scalar<F>(keys + i, num_rows - i, hashes + i);
+}
+
+// the masked shifts and rotates do not leave the pass-through register undefined,
+// gcc 12 warns about the unmasked ones
+VEC_TARGET_AVX512 inline __m512i fnv1a_avx512(__m512i hash, __m512i key) {
+    const __m512i prime = _mm512_set1_epi32(FNV_PRIME);
+    const __m512i byte = _mm512_set1_epi32(0xFF);
+    for (int i = 0; i < 4; ++i) {
+        hash = _mm512_mullo_epi32(_mm512_xor_si512(hash, _mm512_and_si512(key, byte)), prime);
+        key = _mm512_maskz_srli_epi32(0xFFFF, key, 8);
+    }
+    return hash;
+}
+
+VEC_TARGET_AVX512 inline __m512i murmur_block_avx512(__m512i hash, __m512i key) {
+    key = _mm512_mullo_epi32(key, _mm512_set1_epi32(MURMUR_C1));
+    key = _mm512_mullo_epi32(_mm512_maskz_rol_epi32(0xFFFF, key, 15),
+                             _mm512_set1_epi32(MURMUR_C2));
+    hash = _mm512_maskz_rol_epi32(0xFFFF, _mm512_xor_si512(hash, key), 13);
+    return _mm512_add_epi32(_mm512_mullo_epi32(hash, _mm512_set1_epi32(5)),
+                            _mm512_set1_epi32(0xE6546B64));
+}
+
+VEC_TARGET_AVX512 inline __m512i murmur_fmix_avx512(__m512i hash, uint32_t size) {
+    hash = _mm512_xor_si512(hash, _mm512_set1_epi32(size));
+    hash = _mm512_xor_si512(hash, _mm512_maskz_srli_epi32(0xFFFF, hash, 16));
+    hash = _mm512_mullo_epi32(hash, _mm512_set1_epi32(0x85EBCA6B));
+    hash = _mm512_xor_si512(hash, _mm512_maskz_srli_epi32(0xFFFF, hash, 13));
+    hash = _mm512_mullo_epi32(hash, _mm512_set1_epi32(0xC2B2AE35));
+    return _mm512_xor_si512(hash, _mm512_maskz_srli_epi32(0xFFFF, hash, 16));
+}
+
+template <HashFunc F, typename T>
+VEC_TARGET_AVX512 void hash_ints_avx512(const T* keys, size_t num_rows, uint32_t* hashes) {
+    // the even and the odd 32-bit halves of two vectors
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26,
+                                           28, 30);
+    const __m512i odd = _mm512_add_epi32(even, _mm512_set1_epi32(1));
+    size_t i = 0;
+    for (; i + 16 <= num_rows; i += 16) {
+        __m512i hash = _mm512_loadu_si512(hashes + i);
+        __m512i lo, hi;
+        if constexpr (sizeof(T) == 4) {
+            lo = _mm512_loadu_si512(keys + i);
+        } else {
+            __m512i a = _mm512_loadu_si512(keys + i);
+            __m512i b = _mm512_loadu_si512(keys + i + 8);
+            lo = _mm512_permutex2var_epi32(a, even, b);
+            hi = _mm512_permutex2var_epi32(a, odd, b);
+        }
+        if constexpr (F == HashFunc::FNV1A) {
+            hash = fnv1a_avx512(hash, lo);
+            if constexpr (sizeof(T) == 8) {
+                hash = fnv1a_avx512(hash, hi);
+            }
+        } else {
+            hash = murmur_block_avx512(hash, lo);
+            if constexpr (sizeof(T) == 8) {
+                hash = murmur_block_avx512(hash, hi);
+            }
+            hash = murmur_fmix_avx512(hash, sizeof(T));
+        }
+        _mm512_storeu_si512(hashes + i, hash);
+    }
+    hash_ints_scalar<F>(keys + i, num_rows - i, hashes + i);
+}
+
+// ------------------------------------------------------------------------------------
+// string columns, a row at a time
+
+struct SliceRows {
+    const Slice* slices;
+
+    Slice operator[](size_t i) const { return slices[i]; }
+};
+
+struct FlatRows {
+    const uint32_t* offsets;
+    const uint8_t* bytes;
+
+    Slice operator[](size_t i) const {
+        return Slice(reinterpret_cast<const char*>(bytes) + offsets[i],
+                     offsets[i + 1] - offsets[i]);
+    }
+};
+
+struct InlineRows {
+    const SliceInline* slices;
+
+    Slice operator[](size_t i) const { return Slice(slices[i].bytes(), slices[i].size); }
+};
+
+template <HashFunc F, typename Rows>
+void hash_strings_scalar(const Rows& rows, size_t num_rows, uint32_t* hashes) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        Slice row = rows[i];
+        hashes[i] = hash_bytes_scalar<F>(reinterpret_cast<const uint8_t*>(row.data), row.size,
+                                         hashes[i]);
+    }
+}
+
+template <typename Rows>
+VEC_TARGET_SSE42 void crc32c_strings_sse42(const Rows& rows, size_t num_rows, uint32_t* hashes) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        Slice row = rows[i];
+        hashes[i] = crc32c_bytes_sse42(reinterpret_cast<const uint8_t*>(row.data), row.size,
+                                       hashes[i]);
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// dispatch
+
+template <typename T>
+using HashIntsFn = void (*)(const T*, size_t, uint32_t*);
+
+template <typename Rows>
+using HashStringsFn = void (*)(const Rows&, size_t, uint32_t*);
+
+using HashBytesFn = uint32_t (*)(const uint8_t*, size_t, uint32_t);
+
+template <typename T>
+constexpr KernelTable<HashIntsFn<T>> fnv1a_ints_kernels(
+        hash_ints_scalar<HashFunc::FNV1A, T>, nullptr, hash_ints_avx2<HashFunc::FNV1A, T>,
+        hash_ints_avx512<HashFunc::FNV1A, T>, nullptr);
+
+template <typename T>
+constexpr KernelTable<HashIntsFn<T>> crc32c_ints_kernels(hash_ints_scalar<HashFunc::CRC32C, T>,
+                                                         crc32c_ints_sse42<T>, nullptr, nullptr,
+                                                         nullptr);
+
+template <typename T>
+constexpr KernelTable<HashIntsFn<T>> murmur3_ints_kernels(
+        hash_ints_scalar<HashFunc::MURMUR3, T>, nullptr, hash_ints_avx2<HashFunc::MURMUR3, T>,
+        hash_ints_avx512<HashFunc::MURMUR3, T>, nullptr);
+
+template <typename Rows>
+constexpr KernelTable<HashStringsFn<Rows>> crc32c_strings_kernels(
+        hash_strings_scalar<HashFunc::CRC32C, Rows>, crc32c_strings_sse42<Rows>, nullptr, nullptr,
+        nullptr);
+
+constexpr KernelTable<HashBytesFn> crc32c_bytes_kernels(hash_bytes_scalar<HashFunc::CRC32C>,
+                                                        crc32c_bytes_sse42, nullptr, nullptr,
+                                                        nullptr);
+
+template <typename T>
+void hash_ints(HashFunc func, const T* keys, size_t num_rows, uint32_t* hashes) {
+    switch (func) {
+    case HashFunc::FNV1A:
+        fnv1a_ints_kernels<T>.get()(keys, num_rows, hashes);
+        break;
+    case HashFunc::CRC32C:
+        crc32c_ints_kernels<T>.get()(keys, num_rows, hashes);
+        break;
+    case HashFunc::MURMUR3:
+        murmur3_ints_kernels<T>.get()(keys, num_rows, hashes);
+        break;
+    }
+}
+
+// FNV1A and MURMUR3 have no vector version for strings: the rows have their own sizes
+template <typename Rows>
+void hash_strings(HashFunc func, const Rows& rows, size_t num_rows, uint32_t* hashes) {
+    switch (func) {
+    case HashFunc::FNV1A:
+        hash_strings_scalar<HashFunc::FNV1A>(rows, num_rows, hashes);
+        break;
+    case HashFunc::CRC32C:
+        crc32c_strings_kernels<Rows>.get()(rows, num_rows, hashes);
+        break;
+    case HashFunc::MURMUR3:
+        hash_strings_scalar<HashFunc::MURMUR3>(rows, num_rows, hashes);
+        break;
+    }
+}
+
+} // namespace
+
+void hash_combine(HashFunc func, const int32_t* keys, size_t num_rows, uint32_t* hashes) {
+    hash_ints(func, keys, num_rows, hashes);
+}
+
+void hash_combine(HashFunc func, const int64_t* keys, size_t num_rows, uint32_t* hashes) {
+    hash_ints(func, keys, num_rows, hashes);
+}
+
+void hash_combine(HashFunc func, const Slice* keys, size_t num_rows, uint32_t* hashes) {
+    hash_strings(func, SliceRows{keys}, num_rows, hashes);
+}
+
+void hash_combine(HashFunc func, const FlatBinaryVec& keys, uint32_t* hashes) {
+    hash_strings(func, FlatRows{keys.offsets(), keys.bytes()}, keys.size(), hashes);
+}
+
+void hash_combine(HashFunc func, const InlineBinaryVec& keys, uint32_t* hashes) {
+    hash_strings(func, InlineRows{keys.slices()}, keys.size(), hashes);
+}
+
+// the seeds fill the output first, a batch stays in L1 for the hash pass
+void hash_column(HashFunc func, const int32_t* keys, size_t num_rows, uint32_t seed,
+                 uint32_t* hashes) {
+    std::fill(hashes, hashes + num_rows, seed);
+    hash_combine(func, keys, num_rows, hashes);
+}
+
+void hash_column(HashFunc func, const int64_t* keys, size_t num_rows, uint32_t seed,
+                 uint32_t* hashes) {
+    std::fill(hashes, hashes + num_rows, seed);
+    hash_combine(func, keys, num_rows, hashes);
+}
+
+void hash_column(HashFunc func, const Slice* keys, size_t num_rows, uint32_t seed,
+                 uint32_t* hashes) {
+    std::fill(hashes, hashes + num_rows, seed);
+    hash_combine(func, keys, num_rows, hashes);
+}
+
+void hash_column(HashFunc func, const FlatBinaryVec& keys, uint32_t seed, uint32_t* hashes) {
+    std::fill(hashes, hashes + keys.size(), seed);
+    hash_combine(func, keys, hashes);
+}
+
+void hash_column(HashFunc func, const InlineBinaryVec& keys, uint32_t seed, uint32_t* hashes) {
+    std::fill(hashes, hashes + keys.size(), seed);
+    hash_combine(func, keys, hashes);
+}
+
+uint32_t hash_bytes(HashFunc func, const void* data, size_t size, uint32_t seed) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    switch (func) {
+    case HashFunc::FNV1A:
+        return fnv1a_bytes(bytes, size, seed);
+    case HashFunc::CRC32C:
+        return crc32c_bytes_kernels.get()(bytes, size, seed);
+    case HashFunc::MURMUR3:
+        return murmur3_bytes(bytes, size, seed);
+    }
+    return seed;
+}
+
+} // namespace vec
@@ -0,0 +1,647 @@
+#include "vec/join_hash_table.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "vec/cpu_dispatch.h"
+#include "vec/hash.h"
+
+namespace vec {
+
+namespace {
+
+// ------------------------------------------------------------------------------------
+// hash
+
+// the buckets are the top bits of hash_key()
+inline uint32_t bucket_of(uint32_t hash, int shift) {
+    return hash >> shift;
+}
+
+// the top bits of another multiplier, independent of the buckets of a partition
+constexpr uint32_t PARTITION_MUL = 0x85EBCA6B;
+
+inline uint32_t partition_of(uint32_t hash, int bits) {
+    return bits == 0 ? 0 : (hash * PARTITION_MUL) >> (32 - bits);
+}
+
+inline bool key_equal(int32_t lhs, int32_t rhs) {
+    return lhs == rhs;
+}
+
+inline bool key_equal(int64_t lhs, int64_t rhs) {
+    return lhs == rhs;
+}
+
+inline bool key_equal(const Slice& lhs, const Slice& rhs) {
+    return memequal(lhs.data, lhs.size, rhs.data, rhs.size);
+}
+
+// ------------------------------------------------------------------------------------
+// probe kernels
+//
+// start: rows [0, num_rows) with their first build row, the rows of an empty
+// bucket are dropped. round: continue the round at *pos, stop at the end of the
+// round or when capacity is reached.
+
+template <typename K>
+struct TableView {
+    const uint32_t* first;
+    const uint32_t* next;
+    const K* keys;
+    const uint32_t* hashes;
+    int shift;
+    // see PROBE_PREFETCH_MIN_BYTES
+    bool prefetch;
+};
+
+// A round already has the loads of all its rows independent of each other, but the
+// out-of-order window only spans a few rows of a kernel, and past the L2 every row
+// of a round waits on its own miss. A table of more than PROBE_PREFETCH_MIN_BYTES
+// prefetches what the row PROBE_PREFETCH_DISTANCE ahead in the round reads (its
+// bucket in start, its build row in a round) so that the misses of that many rows
+// overlap, see NonPartitioned of bench_join_hash_table.cpp.
+constexpr size_t PROBE_PREFETCH_MIN_BYTES = 2 << 20;
+constexpr size_t PROBE_PREFETCH_DISTANCE = 32;
+
+template <typename K>
+__attribute__((always_inline)) inline void prefetch_buckets(const TableView<K>& table,
+                                                            const K* keys,
+                                                            const uint32_t* hashes,
+                                                            size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t hash = hashes != nullptr ? hashes[i] : hash_key(keys[i]);
+        __builtin_prefetch(&table.first[bucket_of(hash, table.shift)]);
+    }
+}
+
+template <typename K>
+__attribute__((always_inline)) inline void prefetch_chains(const TableView<K>& table,
+                                                           const uint32_t* chains, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        __builtin_prefetch(&table.keys[chains[i]]);
+        __builtin_prefetch(&table.next[chains[i]]);
+        if constexpr (std::is_same_v<K, Slice>) {
+            __builtin_prefetch(&table.hashes[chains[i]]);
+        }
+    }
+}
+
+struct RoundState {
+    uint32_t* rows;
+    uint32_t* chains;
+    size_t pos;
+    size_t len;
+    size_t out;
+};
+
+template <typename K>
+size_t start_scalar(const TableView<K>& table, const K* keys, const uint32_t* hashes,
+                    size_t num_rows, uint32_t* rows, uint32_t* chains) {
+    size_t out = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (table.prefetch && i + PROBE_PREFETCH_DISTANCE < num_rows) {
+            size_t ahead = i + PROBE_PREFETCH_DISTANCE;
+            prefetch_buckets(table, keys, hashes, ahead, ahead + 1);
+        }
+        uint32_t hash = hashes != nullptr ? hashes[i] : hash_key(keys[i]);
+        uint32_t chain = table.first[bucket_of(hash, table.shift)];
+        rows[out] = i;
+        chains[out] = chain;
+        out += chain != 0;
+    }
+    return out;
+}
+
+// one build row for each row of the round, the Slice bytes are only compared
+// when the hashes are
+template <typename K>
+size_t round_scalar(const TableView<K>& table, const K* keys, const uint32_t* hashes,
+                    RoundState* state, uint32_t* probe_rids, uint32_t* build_rids,
+                    size_t capacity) {
+    size_t cnt = 0;
+    size_t pos = state->pos;
+    size_t out = state->out;
+    for (; pos < state->len && cnt < capacity; ++pos) {
+        if (table.prefetch && pos + PROBE_PREFETCH_DISTANCE < state->len) {
+            prefetch_chains(table, state->chains + pos + PROBE_PREFETCH_DISTANCE, 1);
+        }
+        uint32_t row = state->rows[pos];
+        uint32_t chain = state->chains[pos];
+        bool match = (hashes == nullptr || hashes[row] == table.hashes[chain]) &&
+                     key_equal(keys[row], table.keys[chain]);
+        probe_rids[cnt] = row;
+        build_rids[cnt] = chain - 1;
+        cnt += match;
+        uint32_t next = table.next[chain];
+        state->rows[out] = row;
+        state->chains[out] = next;
+        out += next != 0;
+    }
+    state->pos = pos;
+    state->out = out;
+    return cnt;
+}
+
+// 8 x 32 bits permutes moving the lanes of a mask to the front
+struct CompressLUT {
+    constexpr CompressLUT() : indices() {
+        for (int mask = 0; mask < 256; ++mask) {
+            uint64_t packed = 0;
+            int pos = 0;
+            for (int lane = 0; lane < 8; ++lane) {
+                if (mask & (1 << lane)) packed |= uint64_t(lane) << (8 * pos++);
+            }
+            indices[mask] = packed;
+        }
+    }
+    uint64_t indices[256];
+};
+
+constexpr CompressLUT compress_lut{};
+
+VEC_TARGET_AVX2 inline void compress_store_avx2(uint32_t* dst, __m256i values, uint32_t mask) {
+    __m256i perm = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(compress_lut.indices[mask]));
+    __m256i compressed = _mm256_permutevar8x32_epi32(values, perm);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), compressed);
+}
+
+VEC_TARGET_AVX2 inline __m256i gather_u32_avx2(const uint32_t* base, __m256i indices) {
+    return _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), indices, 4);
+}
+
+VEC_TARGET_AVX2 inline uint32_t nonzero_avx2(__m256i values) {
+    __m256i zero = _mm256_cmpeq_epi32(values, _mm256_setzero_si256());
+    return ~_mm256_movemask_ps(_mm256_castsi256_ps(zero)) & 0xFF;
+}
+
+// hash_key() of 8 keys before its multiply
+template <typename K>
+VEC_TARGET_AVX2 inline __m256i hash_avx2(const K* keys) {
+    if constexpr (sizeof(K) == 4) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+    } else {
+        // the low half of k ^ (k >> 32) of every key, packed
+        const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + 4));
+        lo = _mm256_permutevar8x32_epi32(_mm256_xor_si256(lo, _mm256_srli_epi64(lo, 32)),
+                                         low_halves);
+        hi = _mm256_permutevar8x32_epi32(_mm256_xor_si256(hi, _mm256_srli_epi64(hi, 32)),
+                                         low_halves);
+        return _mm256_inserti128_si256(lo, _mm256_castsi256_si128(hi), 1);
+    }
+}
+
+// lane i is set if probe_keys[rows[i]] == build_keys[chains[i]]
+template <typename K>
+VEC_TARGET_AVX2 inline uint32_t equal_keys_avx2(const K* probe_keys, __m256i rows,
+                                                const K* build_keys, __m256i chains) {
+    if constexpr (sizeof(K) == 4) {
+        auto* probe_base = reinterpret_cast<const int*>(probe_keys);
+        auto* build_base = reinterpret_cast<const int*>(build_keys);
+        __m256i lhs = _mm256_i32gather_epi32(probe_base, rows, 4);
+        __m256i rhs = _mm256_i32gather_epi32(build_base, chains, 4);
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lhs, rhs)));
+    } else {
+        auto* probe_base = reinterpret_cast<const long long*>(probe_keys);
+        auto* build_base = reinterpret_cast<const long long*>(build_keys);
+        uint32_t mask = 0;
+        for (int half = 0; half < 2; ++half) {
+            __m128i row_half =
+                    half ? _mm256_extracti128_si256(rows, 1) : _mm256_castsi256_si128(rows);
+            __m128i chain_half =
+                    half ? _mm256_extracti128_si256(chains, 1) : _mm256_castsi256_si128(chains);
+            __m256i lhs = _mm256_i32gather_epi64(probe_base, row_half, 8);
+            __m256i rhs = _mm256_i32gather_epi64(build_base, chain_half, 8);
+            __m256i equal = _mm256_cmpeq_epi64(lhs, rhs);
+            mask |= _mm256_movemask_pd(_mm256_castsi256_pd(equal)) << (4 * half);
+        }
+        return mask;
+    }
+}
+
+template <typename K>
+VEC_TARGET_AVX2 size_t start_avx2(const TableView<K>& table, const K* keys,
+                                  const uint32_t* hashes, size_t num_rows, uint32_t* rows,
+                                  uint32_t* chains) {
+    const __m128i shift = _mm_cvtsi32_si128(table.shift);
+    const __m256i mul = _mm256_set1_epi32(HASH_KEY_MUL);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t out = 0;
+    size_t i = 0;
+    for (; i + 8 <= num_rows; i += 8) {
+        if (table.prefetch && i + PROBE_PREFETCH_DISTANCE + 8 <= num_rows) {
+            size_t ahead = i + PROBE_PREFETCH_DISTANCE;
+            prefetch_buckets(table, keys, hashes, ahead, ahead + 8);
+        }
+        __m256i bucket = _mm256_srl_epi32(_mm256_mullo_epi32(hash_avx2(keys + i), mul), shift);
+        __m256i chain = gather_u32_avx2(table.first, bucket);
+        uint32_t mask = nonzero_avx2(chain);
+        compress_store_avx2(rows + out, _mm256_add_epi32(_mm256_set1_epi32(i), lanes), mask);
+        compress_store_avx2(chains + out, chain, mask);
+        out += _mm_popcnt_u32(mask);
+    }
+    // the last rows, rows + out is still behind row i (hashes are Slice only)
+    size_t tail = start_scalar(table, keys + i, hashes, num_rows - i, rows + out, chains + out);
+    for (size_t j = out; j < out + tail; ++j) {
+        rows[j] += i;
+    }
+    return out + tail;
+}
+
+template <typename K>
+VEC_TARGET_AVX2 size_t round_avx2(const TableView<K>& table, const K* keys,
+                                  const uint32_t* hashes, RoundState* state, uint32_t* probe_rids,
+                                  uint32_t* build_rids, size_t capacity) {
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t cnt = 0;
+    size_t pos = state->pos;
+    size_t out = state->out;
+    // every row matches at most once per round: 8 lanes of room is enough
+    for (; pos + 8 <= state->len && cnt + 8 <= capacity; pos += 8) {
+        if (table.prefetch && pos + PROBE_PREFETCH_DISTANCE + 8 <= state->len) {
+            prefetch_chains(table, state->chains + pos + PROBE_PREFETCH_DISTANCE, 8);
+        }
+        __m256i rows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state->rows + pos));
+        __m256i chains = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state->chains + pos));
+        uint32_t match = equal_keys_avx2(keys, rows, table.keys, chains);
+        compress_store_avx2(probe_rids + cnt, rows, match);
+        compress_store_avx2(build_rids + cnt, _mm256_sub_epi32(chains, one), match);
+        cnt += _mm_popcnt_u32(match);
+
+        __m256i next = gather_u32_avx2(table.next, chains);
+        uint32_t more = nonzero_avx2(next);
+        compress_store_avx2(state->rows + out, rows, more);
+        compress_store_avx2(state->chains + out, next, more);
+        out += _mm_popcnt_u32(more);
+    }
+    state->pos = pos;
+    state->out = out;
+    return cnt + round_scalar(table, keys, hashes, state, probe_rids + cnt, build_rids + cnt,
+                              capacity - cnt);
+}
+
+// The AVX-512 kernels use the masked forms of the intrinsics, gcc 12 warns about
+// the undefined pass-through register of the others.
+VEC_TARGET_AVX512 inline __m512i gather_u32_avx512(const uint32_t* base, __m512i indices) {
+    return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, indices, base, 4);
+}
+
+VEC_TARGET_AVX512 inline void compress_store_avx512(uint32_t* dst, __m512i values,
+                                                    __mmask16 mask) {
+    _mm512_storeu_si512(dst, _mm512_maskz_compress_epi32(mask, values));
+}
+
+template <typename K>
+VEC_TARGET_AVX512 inline __m512i hash_avx512(const K* keys) {
+    if constexpr (sizeof(K) == 4) {
+        return _mm512_loadu_si512(keys);
+    } else {
+        __m512i lo = _mm512_loadu_si512(keys);
+        __m512i hi = _mm512_loadu_si512(keys + 8);
+        lo = _mm512_xor_si512(lo, _mm512_maskz_srli_epi64(0xFF, lo, 32));
+        hi = _mm512_xor_si512(hi, _mm512_maskz_srli_epi64(0xFF, hi, 32));
+        __m256i lo_hash = _mm512_maskz_cvtepi64_epi32(0xFF, lo);
+        __m256i hi_hash = _mm512_maskz_cvtepi64_epi32(0xFF, hi);
+        __m512i hash = _mm512_maskz_inserti64x4(0xFF, _mm512_setzero_si512(), lo_hash, 0);
+        return _mm512_maskz_inserti64x4(0xFF, hash, hi_hash, 1);
+    }
+}
+
+// the 64-bit values at the lower or upper 8 indices
+template <int HALF, typename T>
+VEC_TARGET_AVX512 inline __m512i gather_u64_avx512(const T* base, __m512i indices) {
+    __m256i half = _mm512_maskz_extracti64x4_epi64(0xF, indices, HALF);
+    return _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xFF, half, base, 8);
+}
+
+template <typename K>
+VEC_TARGET_AVX512 inline __mmask16 equal_keys_avx512(const K* probe_keys, __m512i rows,
+                                                     const K* build_keys, __m512i chains) {
+    if constexpr (sizeof(K) == 4) {
+        __m512i zero = _mm512_setzero_si512();
+        __m512i lhs = _mm512_mask_i32gather_epi32(zero, 0xFFFF, rows, probe_keys, 4);
+        __m512i rhs = _mm512_mask_i32gather_epi32(zero, 0xFFFF, chains, build_keys, 4);
+        return _mm512_cmpeq_epi32_mask(lhs, rhs);
+    } else {
+        __mmask16 lo = _mm512_cmpeq_epi64_mask(gather_u64_avx512<0>(probe_keys, rows),
+                                               gather_u64_avx512<0>(build_keys, chains));
+        __mmask16 hi = _mm512_cmpeq_epi64_mask(gather_u64_avx512<1>(probe_keys, rows),
+                                               gather_u64_avx512<1>(build_keys, chains));
+        return lo | (hi << 8);
+    }
+}
+
+template <typename K>
+VEC_TARGET_AVX512 size_t start_avx512(const TableView<K>& table, const K* keys,
+                                      const uint32_t* hashes, size_t num_rows, uint32_t* rows,
+                                      uint32_t* chains) {
+    const __m128i shift = _mm_cvtsi32_si128(table.shift);
+    const __m512i mul = _mm512_set1_epi32(HASH_KEY_MUL);
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t out = 0;
+    size_t i = 0;
+    for (; i + 16 <= num_rows; i += 16) {
+        if (table.prefetch && i + PROBE_PREFETCH_DISTANCE + 16 <= num_rows) {
+            size_t ahead = i + PROBE_PREFETCH_DISTANCE;
+            prefetch_buckets(table, keys, hashes, ahead, ahead + 16);
+        }
+        __m512i hash = _mm512_mullo_epi32(hash_avx512(keys + i), mul);
+        __m512i bucket = _mm512_maskz_srl_epi32(0xFFFF, hash, shift);
+        __m512i chain = gather_u32_avx512(table.first, bucket);
+        __mmask16 mask = _mm512_test_epi32_mask(chain, chain);
+        compress_store_avx512(rows + out, _mm512_add_epi32(_mm512_set1_epi32(i), lanes), mask);
+        compress_store_avx512(chains + out, chain, mask);
+        out += _mm_popcnt_u32(mask);
+    }
+    size_t tail = start_scalar(table, keys + i, hashes, num_rows - i, rows + out, chains + out);
+    for (size_t j = out; j < out + tail; ++j) {
+        rows[j] += i;
+    }
+    return out + tail;
+}
+
+template <typename K>
+VEC_TARGET_AVX512 size_t round_avx512(const TableView<K>& table, const K* keys,
+                                      const uint32_t* hashes, RoundState* state,
+                                      uint32_t* probe_rids, uint32_t* build_rids,
+                                      size_t capacity) {
+    const __m512i one = _mm512_set1_epi32(1);
+    size_t cnt = 0;
+    size_t pos = state->pos;
+    size_t out = state->out;
+    for (; pos + 16 <= state->len && cnt + 16 <= capacity; pos += 16) {
+        if (table.prefetch && pos + PROBE_PREFETCH_DISTANCE + 16 <= state->len) {
+            prefetch_chains(table, state->chains + pos + PROBE_PREFETCH_DISTANCE, 16);
+        }
+        __m512i rows = _mm512_loadu_si512(state->rows + pos);
+        __m512i chains = _mm512_loadu_si512(state->chains + pos);
+        __mmask16 match = equal_keys_avx512(keys, rows, table.keys, chains);
+        compress_store_avx512(probe_rids + cnt, rows, match);
+        compress_store_avx512(build_rids + cnt, _mm512_sub_epi32(chains, one), match);
+        cnt += _mm_popcnt_u32(match);
+
+        __m512i next = gather_u32_avx512(table.next, chains);
+        __mmask16 more = _mm512_test_epi32_mask(next, next);
+        compress_store_avx512(state->rows + out, rows, more);
+        compress_store_avx512(state->chains + out, next, more);
+        out += _mm_popcnt_u32(more);
+    }
+    state->pos = pos;
+    state->out = out;
+    return cnt + round_scalar(table, keys, hashes, state, probe_rids + cnt, build_rids + cnt,
+                              capacity - cnt);
+}
+
+// ------------------------------------------------------------------------------------
+// dispatch
+
+template <typename K>
+using StartFn = size_t (*)(const TableView<K>&, const K*, const uint32_t*, size_t, uint32_t*,
+                           uint32_t*);
+
+template <typename K>
+using RoundFn = size_t (*)(const TableView<K>&, const K*, const uint32_t*, RoundState*,
+                           uint32_t*, uint32_t*, size_t);
+
+template <typename K>
+struct ProbeKernels {
+    KernelTable<StartFn<K>> start;
+    KernelTable<RoundFn<K>> round;
+};
+
+template <typename K>
+constexpr ProbeKernels<K> make_probe_kernels() {
+    if constexpr (std::is_same_v<K, Slice>) {
+        return {{start_scalar<K>, nullptr, nullptr, nullptr, nullptr},
+                {round_scalar<K>, nullptr, nullptr, nullptr, nullptr}};
+    } else {
+        return {{start_scalar<K>, nullptr, start_avx2<K>, start_avx512<K>, nullptr},
+                {round_scalar<K>, nullptr, round_avx2<K>, round_avx512<K>, nullptr}};
+    }
+}
+
+template <typename K>
+constexpr ProbeKernels<K> probe_kernels = make_probe_kernels<K>();
+
+// vpgather is microcoded on Zen and no faster than scalar loads there
+inline SimdLevel probe_level() {
+    return CpuInfo::host().amd ? SimdLevel::SCALAR : simd_level();
+}
+
+} // namespace
+
+template <typename K>
+void JoinHashTable<K>::build(const K* keys, size_t num_rows) {
+    assert(num_rows < (size_t(1) << 31));
+    // at least 2 buckets, at most one row per bucket on average
+    int bits = 1;
+    while ((size_t(1) << bits) < num_rows) {
+        ++bits;
+    }
+    _shift = 32 - bits;
+    _first.assign(size_t(1) << bits, 0);
+    _next.resize(num_rows + 1);
+    _keys.resize(num_rows + 1);
+    if constexpr (std::is_same_v<K, Slice>) {
+        _hashes.resize(num_rows + 1);
+    }
+    size_t table_bytes = (_first.size() + _next.size() + _hashes.size()) * sizeof(uint32_t) +
+                         _keys.size() * sizeof(K);
+    _prefetch = table_bytes > PROBE_PREFETCH_MIN_BYTES;
+    for (size_t i = 0; i < num_rows; ++i) {
+        uint32_t row = i + 1;
+        uint32_t hash = hash_key(keys[i]);
+        uint32_t bucket = bucket_of(hash, _shift);
+        _keys[row] = keys[i];
+        if constexpr (std::is_same_v<K, Slice>) {
+            _hashes[row] = hash;
+        }
+        _next[row] = _first[bucket];
+        _first[bucket] = row;
+    }
+}
+
+template <typename K>
+void JoinHashTable<K>::start_probe(const K* keys, size_t num_rows, Probe* probe) const {
+    assert(num_rows < (size_t(1) << 31));
+    probe->_keys = keys;
+    const uint32_t* hashes = nullptr;
+    if constexpr (std::is_same_v<K, Slice>) {
+        probe->_hashes.resize(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            probe->_hashes[i] = hash_key(keys[i]);
+        }
+        hashes = probe->_hashes.data();
+    }
+    // the vector kernels store whole registers
+    probe->_rows.resize(num_rows + 16);
+    probe->_chains.resize(num_rows + 16);
+    TableView<K> table{_first.data(), _next.data(), _keys.data(), _hashes.data(), _shift,
+                       _prefetch};
+    probe->_len = probe_kernels<K>.start[probe_level()](table, keys, hashes, num_rows,
+                                                        probe->_rows.data(),
+                                                        probe->_chains.data());
+    probe->_pos = 0;
+    probe->_out = 0;
+}
+
+template <typename K>
+size_t JoinHashTable<K>::probe(Probe* probe, uint32_t* probe_rids, uint32_t* build_rids,
+                               size_t capacity) const {
+    TableView<K> table{_first.data(), _next.data(), _keys.data(), _hashes.data(), _shift,
+                       _prefetch};
+    const uint32_t* hashes = probe->_hashes.empty() ? nullptr : probe->_hashes.data();
+    auto round = probe_kernels<K>.round[probe_level()];
+    RoundState state{probe->_rows.data(), probe->_chains.data(), probe->_pos, probe->_len,
+                     probe->_out};
+    size_t cnt = 0;
+    while (cnt < capacity) {
+        if (state.pos == state.len) {
+            // the next round goes over the rows that moved on
+            if (state.out == 0) break;
+            state.len = state.out;
+            state.pos = state.out = 0;
+        }
+        cnt += round(table, probe->_keys, hashes, &state, probe_rids + cnt, build_rids + cnt,
+                     capacity - cnt);
+    }
+    probe->_pos = state.pos;
+    probe->_len = state.len;
+    probe->_out = state.out;
+    return cnt;
+}
+
+// ------------------------------------------------------------------------------------
+// radix partitioning
+
+namespace {
+
+// tuples per write-combining buffer, the row ids fill one cache line
+constexpr size_t WC_TUPLES = 16;
+
+template <typename K>
+struct alignas(64) WriteCombiningBuffer {
+    K keys[WC_TUPLES];
+    uint32_t rids[WC_TUPLES];
+};
+
+// No partitioning below a table of the size of a core's share of the LLC, a
+// partition's table about half of a server L2 above. A single pass only: past
+// 2^10 partitions the scatter writes to more pages than the TLB covers and costs
+// more than the misses it saves (bench_join_hash_table.cpp), a larger build side
+// gets larger partitions.
+constexpr size_t SINGLE_TABLE_BYTES = 4 << 20;
+constexpr size_t PARTITION_BYTES = 1 << 20;
+constexpr int MAX_RADIX_BITS = 10;
+
+template <typename K>
+int pick_radix_bits(size_t num_rows) {
+    // key, next and about one first entry per row
+    size_t row_bytes = sizeof(K) + 8 + (std::is_same_v<K, Slice> ? 4 : 0);
+    if (num_rows * row_bytes <= SINGLE_TABLE_BYTES) {
+        return 0;
+    }
+    size_t rows_per_partition = PARTITION_BYTES / row_bytes;
+    int bits = 1;
+    while (bits < MAX_RADIX_BITS && (num_rows >> bits) > rows_per_partition) {
+        ++bits;
+    }
+    return bits;
+}
+
+} // namespace
+
+template <typename K>
+void radix_partition(const K* keys, size_t num_rows, int bits, RadixPartitions<K>* out) {
+    assert(num_rows < (size_t(1) << 32));
+    assert(bits >= 0 && bits <= 16);
+    size_t fanout = size_t(1) << bits;
+    out->keys.resize(num_rows);
+    out->rids.resize(num_rows);
+    out->offsets.assign(fanout + 1, 0);
+    K* dst_keys = out->keys.data();
+    uint32_t* dst_rids = out->rids.data();
+    if (bits == 0) {
+        std::copy(keys, keys + num_rows, dst_keys);
+        for (size_t i = 0; i < num_rows; ++i) {
+            dst_rids[i] = i;
+        }
+        out->offsets[1] = num_rows;
+        return;
+    }
+
+    // histogram, the partition of each row is kept for the scatter
+    std::vector<uint16_t> parts(num_rows);
+    uint32_t* offsets = out->offsets.data();
+    for (size_t i = 0; i < num_rows; ++i) {
+        parts[i] = partition_of(hash_key(keys[i]), bits);
+        ++offsets[parts[i] + 1];
+    }
+    for (size_t p = 0; p < fanout; ++p) {
+        offsets[p + 1] += offsets[p];
+    }
+
+    // scatter, a full buffer is flushed as a whole line
+    std::vector<WriteCombiningBuffer<K>> buffers(fanout);
+    std::vector<uint32_t> cursors(offsets, offsets + fanout);
+    std::vector<uint8_t> fills(fanout, 0);
+    for (size_t i = 0; i < num_rows; ++i) {
+        uint32_t p = parts[i];
+        WriteCombiningBuffer<K>& buffer = buffers[p];
+        uint32_t slot = fills[p];
+        buffer.keys[slot] = keys[i];
+        buffer.rids[slot] = i;
+        if (++slot == WC_TUPLES) {
+            std::copy(buffer.keys, buffer.keys + WC_TUPLES, dst_keys + cursors[p]);
+            memcpy(dst_rids + cursors[p], buffer.rids, sizeof(buffer.rids));
+            cursors[p] += WC_TUPLES;
+            slot = 0;
+        }
+        fills[p] = slot;
+    }
+    for (size_t p = 0; p < fanout; ++p) {
+        std::copy(buffers[p].keys, buffers[p].keys + fills[p], dst_keys + cursors[p]);
+        std::copy(buffers[p].rids, buffers[p].rids + fills[p], dst_rids + cursors[p]);
+    }
+}
+
+template <typename K>
+void PartitionedJoin<K>::build(const K* keys, size_t num_rows) {
+    _num_rows = num_rows;
+    _bits = _radix_bits > 0 ? _radix_bits : pick_radix_bits<K>(num_rows);
+    if (_bits == 0) {
+        _build_side = RadixPartitions<K>();
+        _tables.resize(1);
+        _tables[0].build(keys, num_rows);
+        return;
+    }
+    radix_partition(keys, num_rows, _bits, &_build_side);
+    _tables.resize(_build_side.num_partitions());
+    for (size_t p = 0; p < _tables.size(); ++p) {
+        uint32_t begin = _build_side.offsets[p];
+        _tables[p].build(_build_side.keys.data() + begin, _build_side.offsets[p + 1] - begin);
+    }
+    // the tables have their own copy
+    _build_side.keys = std::vector<K>();
+}
+
+template class JoinHashTable<int32_t>;
+template class JoinHashTable<int64_t>;
+template class JoinHashTable<Slice>;
+
+template void radix_partition(const int32_t*, size_t, int, RadixPartitions<int32_t>*);
+template void radix_partition(const int64_t*, size_t, int, RadixPartitions<int64_t>*);
+template void radix_partition(const Slice*, size_t, int, RadixPartitions<Slice>*);
+
+template class PartitionedJoin<int32_t>;
+template class PartitionedJoin<int64_t>;
+template class PartitionedJoin<Slice>;
+
+} // namespace vec
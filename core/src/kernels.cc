@@ -0,0 +1,595 @@
+#include "vec/kernels.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "vec/cpu_dispatch.h"
+#include "vec/filter.h"
+
+namespace vec {
+
+namespace {
+
+// ------------------------------------------------------------------------------------
+// memequal
+
+bool memequal_scalar(const char* p1, const char* p2, size_t size) {
+    return size == 0 || memcmp(p1, p2, size) == 0;
+}
+
+VEC_TARGET_SSE42 inline bool equal_16(const char* p1, const char* p2) {
+    __m128i diff = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2)));
+    return _mm_testz_si128(diff, diff);
+}
+
+// the last block overlaps the previous one instead of a byte by byte tail
+VEC_TARGET_SSE42 bool memequal_sse42(const char* p1, const char* p2, size_t size) {
+    if (size < 16) {
+        return memequal_scalar(p1, p2, size);
+    }
+    for (size_t i = 0; i + 16 < size; i += 16) {
+        if (!equal_16(p1 + i, p2 + i)) return false;
+    }
+    return equal_16(p1 + size - 16, p2 + size - 16);
+}
+
+VEC_TARGET_AVX2 inline bool equal_32(const char* p1, const char* p2) {
+    __m256i diff = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p1)),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p2)));
+    return _mm256_testz_si256(diff, diff);
+}
+
+VEC_TARGET_AVX2 bool memequal_avx2(const char* p1, const char* p2, size_t size) {
+    if (size < 32) {
+        return memequal_sse42(p1, p2, size);
+    }
+    for (size_t i = 0; i + 32 < size; i += 32) {
+        if (!equal_32(p1 + i, p2 + i)) return false;
+    }
+    return equal_32(p1 + size - 32, p2 + size - 32);
+}
+
+// masked loads do not touch the bytes past the end
+VEC_TARGET_AVX512 bool memequal_avx512(const char* p1, const char* p2, size_t size) {
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        if (_mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p1 + i), _mm512_loadu_si512(p2 + i))) {
+            return false;
+        }
+    }
+    if (i == size) {
+        return true;
+    }
+    __mmask64 mask = _bzhi_u64(~uint64_t(0), size - i);
+    return _mm512_cmpneq_epi8_mask(_mm512_maskz_loadu_epi8(mask, p1 + i),
+                                   _mm512_maskz_loadu_epi8(mask, p2 + i)) == 0;
+}
+
+// ------------------------------------------------------------------------------------
+// gather
+
+template <typename T>
+void gather_scalar(const T* src, const uint32_t* indices, size_t num_rows, T* dst) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        dst[i] = src[indices[i]];
+    }
+}
+
+VEC_TARGET_AVX2 void gather_u32_avx2(const uint32_t* src, const uint32_t* indices,
+                                     size_t num_rows, uint32_t* dst) {
+    size_t i = 0;
+    for (; i + 8 <= num_rows; i += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), index, 4));
+    }
+    gather_scalar(src, indices + i, num_rows - i, dst + i);
+}
+
+VEC_TARGET_AVX2 void gather_u64_avx2(const uint64_t* src, const uint32_t* indices,
+                                     size_t num_rows, uint64_t* dst) {
+    size_t i = 0;
+    for (; i + 4 <= num_rows; i += 4) {
+        __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+        _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(dst + i),
+                _mm256_i32gather_epi64(reinterpret_cast<const long long*>(src), index, 8));
+    }
+    gather_scalar(src, indices + i, num_rows - i, dst + i);
+}
+
+// the masked forms do not leave the pass-through register undefined, gcc 12 warns
+// about the unmasked ones
+VEC_TARGET_AVX512 void gather_u32_avx512(const uint32_t* src, const uint32_t* indices,
+                                         size_t num_rows, uint32_t* dst) {
+    size_t i = 0;
+    for (; i + 16 <= num_rows; i += 16) {
+        __m512i index = _mm512_loadu_si512(indices + i);
+        _mm512_storeu_si512(dst + i, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF,
+                                                                  index, src, 4));
+    }
+    gather_scalar(src, indices + i, num_rows - i, dst + i);
+}
+
+VEC_TARGET_AVX512 void gather_u64_avx512(const uint64_t* src, const uint32_t* indices,
+                                         size_t num_rows, uint64_t* dst) {
+    size_t i = 0;
+    for (; i + 8 <= num_rows; i += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+        _mm512_storeu_si512(dst + i, _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xFF,
+                                                                  index, src, 8));
+    }
+    gather_scalar(src, indices + i, num_rows - i, dst + i);
+}
+
+// ------------------------------------------------------------------------------------
+// histogram
+
+// 4 copies of the counters so that repeated keys do not wait on each other's
+// store to load forwarding, as long as the copies stay in L1
+constexpr uint32_t REPLICATED_MAX_BUCKETS = 1024;
+
+__attribute__((always_inline)) inline void histogram_impl(const uint32_t* __restrict keys,
+                                                          size_t num_keys, uint32_t num_buckets,
+                                                          uint32_t* __restrict counts) {
+    if (num_buckets > REPLICATED_MAX_BUCKETS || num_keys < num_buckets) {
+        for (size_t i = 0; i < num_keys; ++i) {
+            counts[keys[i]]++;
+        }
+        return;
+    }
+    uint32_t replicas[4][REPLICATED_MAX_BUCKETS];
+    for (auto& replica : replicas) {
+        memset(replica, 0, num_buckets * sizeof(uint32_t));
+    }
+    size_t i = 0;
+    for (; i + 4 <= num_keys; i += 4) {
+        replicas[0][keys[i + 0]]++;
+        replicas[1][keys[i + 1]]++;
+        replicas[2][keys[i + 2]]++;
+        replicas[3][keys[i + 3]]++;
+    }
+    for (; i < num_keys; ++i) {
+        replicas[0][keys[i]]++;
+    }
+    for (uint32_t k = 0; k < num_buckets; ++k) {
+        counts[k] += replicas[0][k] + replicas[1][k] + replicas[2][k] + replicas[3][k];
+    }
+}
+
+// the same loops, the vector versions only widen the clear and the final sum.
+// gather/scatter with conflict detection was slower than the replicated counters.
+void histogram_scalar(const uint32_t* keys, size_t num_keys, uint32_t num_buckets,
+                      uint32_t* counts) {
+    histogram_impl(keys, num_keys, num_buckets, counts);
+}
+
+VEC_TARGET_AVX2 void histogram_avx2(const uint32_t* keys, size_t num_keys, uint32_t num_buckets,
+                                    uint32_t* counts) {
+    histogram_impl(keys, num_keys, num_buckets, counts);
+}
+
+VEC_TARGET_AVX512 void histogram_avx512(const uint32_t* keys, size_t num_keys,
+                                        uint32_t num_buckets, uint32_t* counts) {
+    histogram_impl(keys, num_keys, num_buckets, counts);
+}
+
+// ------------------------------------------------------------------------------------
+// big-endian decode
+
+inline unsigned __int128 bswap_128(unsigned __int128 value) {
+    return static_cast<unsigned __int128>(__builtin_bswap64(static_cast<uint64_t>(value >> 64))) |
+           (static_cast<unsigned __int128>(__builtin_bswap64(static_cast<uint64_t>(value))) << 64);
+}
+
+template <int BINSZ>
+inline __int128 decode_be_row(const uint8_t* src) {
+    uint8_t bytes[16] = {};
+    memcpy(bytes, src, BINSZ);
+    unsigned __int128 value;
+    memcpy(&value, bytes, sizeof(value));
+    // the row ends up in the high bytes, the arithmetic shift extends its sign
+    return static_cast<__int128>(bswap_128(value)) >> ((16 - BINSZ) * 8);
+}
+
+template <int BINSZ>
+void decode_scalar(const uint8_t* src, size_t num_rows, __int128* dst) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        dst[i] = decode_be_row<BINSZ>(src + i * BINSZ);
+    }
+}
+
+// pshufb indices: the row bytes reversed, then zeros. sign picks the most
+// significant byte of the row for the bytes above it.
+template <int BINSZ>
+struct BeShuffle {
+    constexpr BeShuffle() : bytes(), sign() {
+        for (int i = 0; i < 16; ++i) {
+            bytes[i] = i < BINSZ ? BINSZ - 1 - i : 0x80;
+            sign[i] = i < BINSZ ? 0x80 : 0;
+        }
+    }
+    alignas(16) uint8_t bytes[16];
+    alignas(16) uint8_t sign[16];
+};
+
+template <int BINSZ>
+constexpr BeShuffle<BINSZ> be_shuffle{};
+
+// rows whose 16 bytes load stays inside the num_rows * BINSZ bytes of src
+template <int BINSZ>
+inline size_t rows_with_full_load(size_t num_rows) {
+    return num_rows * BINSZ >= 16 ? (num_rows * BINSZ - 16) / BINSZ + 1 : 0;
+}
+
+template <int BINSZ>
+VEC_TARGET_SSE42 inline __m128i decode_be_sse42(__m128i raw, __m128i bytes, __m128i sign) {
+    __m128i value = _mm_shuffle_epi8(raw, bytes);
+    if constexpr (BINSZ < 16) {
+        value = _mm_or_si128(value,
+                             _mm_cmpgt_epi8(_mm_setzero_si128(), _mm_shuffle_epi8(raw, sign)));
+    }
+    return value;
+}
+
+template <int BINSZ>
+VEC_TARGET_SSE42 void decode_sse42(const uint8_t* src, size_t num_rows, __int128* dst) {
+    const __m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(be_shuffle<BINSZ>.bytes));
+    const __m128i sign = _mm_load_si128(reinterpret_cast<const __m128i*>(be_shuffle<BINSZ>.sign));
+    size_t safe_rows = rows_with_full_load<BINSZ>(num_rows);
+    size_t i = 0;
+    for (; i < safe_rows; ++i) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * BINSZ));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         decode_be_sse42<BINSZ>(raw, bytes, sign));
+    }
+    decode_scalar<BINSZ>(src + i * BINSZ, num_rows - i, dst + i);
+}
+
+// two rows per register, one in each 128-bit lane
+template <int BINSZ>
+VEC_TARGET_AVX2 void decode_avx2(const uint8_t* src, size_t num_rows, __int128* dst) {
+    const __m256i bytes = _mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(be_shuffle<BINSZ>.bytes)));
+    const __m256i sign = _mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(be_shuffle<BINSZ>.sign)));
+    size_t safe_rows = rows_with_full_load<BINSZ>(num_rows);
+    size_t i = 0;
+    for (; i + 2 <= safe_rows; i += 2) {
+        const uint8_t* row = src + i * BINSZ;
+        __m256i raw = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + BINSZ)), 1);
+        __m256i value = _mm256_shuffle_epi8(raw, bytes);
+        if constexpr (BINSZ < 16) {
+            value = _mm256_or_si256(value, _mm256_cmpgt_epi8(_mm256_setzero_si256(),
+                                                             _mm256_shuffle_epi8(raw, sign)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), value);
+    }
+    decode_sse42<BINSZ>(src + i * BINSZ, num_rows - i, dst + i);
+}
+
+// vpermb indices of 4 rows, the bytes above a row take its most significant byte
+template <int BINSZ>
+struct BePermute {
+    constexpr BePermute() : indices(), value_mask(0) {
+        for (int row = 0; row < 4; ++row) {
+            for (int k = 0; k < 16; ++k) {
+                bool is_value = k < BINSZ;
+                indices[row * 16 + k] = row * BINSZ + (is_value ? BINSZ - 1 - k : 0);
+                value_mask |= uint64_t(is_value) << (row * 16 + k);
+            }
+        }
+    }
+    alignas(64) uint8_t indices[64];
+    uint64_t value_mask;
+};
+
+template <int BINSZ>
+constexpr BePermute<BINSZ> be_permute{};
+
+template <int BINSZ>
+VEC_TARGET_AVX512_VBMI2 inline __m512i decode_be_avx512_vbmi2(__m512i raw, __m512i indices,
+                                                              __mmask64 sign_mask) {
+    __m512i value = _mm512_maskz_permutexvar_epi8(~uint64_t(0), indices, raw);
+    if constexpr (BINSZ < 16) {
+        __m512i extended = _mm512_movm_epi8(_mm512_movepi8_mask(value));
+        value = _mm512_mask_mov_epi8(value, sign_mask, extended);
+    }
+    return value;
+}
+
+// 4 rows per register, masked loads and stores handle the tail
+template <int BINSZ>
+VEC_TARGET_AVX512_VBMI2 void decode_avx512_vbmi2(const uint8_t* src, size_t num_rows,
+                                                 __int128* dst) {
+    const __m512i indices = _mm512_load_si512(be_permute<BINSZ>.indices);
+    const __mmask64 sign_mask = ~be_permute<BINSZ>.value_mask;
+    for (size_t i = 0; i < num_rows; i += 4) {
+        size_t rows = std::min<size_t>(4, num_rows - i);
+        __m512i raw = _mm512_maskz_loadu_epi8(_bzhi_u64(~uint64_t(0), rows * BINSZ),
+                                              src + i * BINSZ);
+        _mm512_mask_storeu_epi8(dst + i, _bzhi_u64(~uint64_t(0), rows * 16),
+                                decode_be_avx512_vbmi2<BINSZ>(raw, indices, sign_mask));
+    }
+}
+
+// The nullable versions decode every row at its place, src holds the non-null rows
+// and moves past a non-null row only. A null row decodes ZERO_ROW.
+alignas(16) constexpr uint8_t ZERO_ROW[16] = {};
+
+template <int BINSZ>
+void decode_nullable_scalar(const uint8_t* src, const uint8_t* nulls, size_t num_rows,
+                            __int128* dst) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        const uint8_t* row = nulls[i] ? ZERO_ROW : src;
+        src += nulls[i] ? 0 : BINSZ;
+        dst[i] = decode_be_row<BINSZ>(row);
+    }
+}
+
+template <int BINSZ>
+VEC_TARGET_SSE42 void decode_nullable_sse42(const uint8_t* src, const uint8_t* nulls,
+                                            size_t num_rows, __int128* dst) {
+    const __m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(be_shuffle<BINSZ>.bytes));
+    const __m128i sign = _mm_load_si128(reinterpret_cast<const __m128i*>(be_shuffle<BINSZ>.sign));
+    // the 16 bytes load of a row stays inside the bytes of the non-null rows
+    const uint8_t* end = src + count_zero(nulls, num_rows) * BINSZ;
+    size_t i = 0;
+    for (; i < num_rows && src + 16 <= end; ++i) {
+        const uint8_t* row = nulls[i] ? ZERO_ROW : src;
+        src += nulls[i] ? 0 : BINSZ;
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         decode_be_sse42<BINSZ>(raw, bytes, sign));
+    }
+    decode_nullable_scalar<BINSZ>(src, nulls + i, num_rows - i, dst + i);
+}
+
+// vpexpandb puts the bytes of the non-null rows of a register at their row, the
+// null rows are zero
+template <int BINSZ>
+struct BeExpand {
+    constexpr BeExpand() : masks() {
+        for (int rows = 0; rows < 16; ++rows) {
+            for (int row = 0; row < 4; ++row) {
+                if (rows & (1 << row)) {
+                    masks[rows] |= ((uint64_t(1) << BINSZ) - 1) << (row * BINSZ);
+                }
+            }
+        }
+    }
+    uint64_t masks[16];
+};
+
+template <int BINSZ>
+constexpr BeExpand<BINSZ> be_expand{};
+
+// 16 null bytes to a mask, then 4 rows per register: the expand load reads the bytes
+// of the non-null rows only
+template <int BINSZ>
+VEC_TARGET_AVX512_VBMI2 void decode_nullable_avx512_vbmi2(const uint8_t* src, const uint8_t* nulls,
+                                                          size_t num_rows, __int128* dst) {
+    const __m512i indices = _mm512_load_si512(be_permute<BINSZ>.indices);
+    const __mmask64 sign_mask = ~be_permute<BINSZ>.value_mask;
+    for (size_t i = 0; i < num_rows; i += 16) {
+        size_t rows = std::min<size_t>(16, num_rows - i);
+        __mmask16 in_range = _bzhi_u32(~uint32_t(0), rows);
+        __m128i bytes = _mm_maskz_loadu_epi8(in_range, nulls + i);
+        uint32_t not_null = _mm_mask_cmpeq_epi8_mask(in_range, bytes, _mm_setzero_si128());
+        for (size_t k = 0; k < rows; k += 4, not_null >>= 4) {
+            uint32_t group = not_null & 0xF;
+            __m512i raw = _mm512_maskz_expandloadu_epi8(be_expand<BINSZ>.masks[group], src);
+            src += __builtin_popcount(group) * BINSZ;
+            _mm512_mask_storeu_epi8(dst + i + k,
+                                    _bzhi_u64(~uint64_t(0), std::min<size_t>(4, rows - k) * 16),
+                                    decode_be_avx512_vbmi2<BINSZ>(raw, indices, sign_mask));
+        }
+    }
+}
+
+using DecodeFn = void (*)(const uint8_t*, size_t, __int128*);
+
+#define VEC_FOR_EACH_BINSZ(FUNC)                                                               \
+    FUNC<1>, FUNC<2>, FUNC<3>, FUNC<4>, FUNC<5>, FUNC<6>, FUNC<7>, FUNC<8>, FUNC<9>, FUNC<10>, \
+            FUNC<11>, FUNC<12>, FUNC<13>, FUNC<14>, FUNC<15>, FUNC<16>
+
+constexpr DecodeFn decode_scalar_fns[] = {VEC_FOR_EACH_BINSZ(decode_scalar)};
+constexpr DecodeFn decode_sse42_fns[] = {VEC_FOR_EACH_BINSZ(decode_sse42)};
+constexpr DecodeFn decode_avx2_fns[] = {VEC_FOR_EACH_BINSZ(decode_avx2)};
+constexpr DecodeFn decode_avx512_vbmi2_fns[] = {VEC_FOR_EACH_BINSZ(decode_avx512_vbmi2)};
+
+using DecodeNullableFn = void (*)(const uint8_t*, const uint8_t*, size_t, __int128*);
+
+constexpr DecodeNullableFn decode_nullable_scalar_fns[] = {
+        VEC_FOR_EACH_BINSZ(decode_nullable_scalar)};
+constexpr DecodeNullableFn decode_nullable_sse42_fns[] = {
+        VEC_FOR_EACH_BINSZ(decode_nullable_sse42)};
+constexpr DecodeNullableFn decode_nullable_avx512_vbmi2_fns[] = {
+        VEC_FOR_EACH_BINSZ(decode_nullable_avx512_vbmi2)};
+
+#undef VEC_FOR_EACH_BINSZ
+
+// ------------------------------------------------------------------------------------
+// null masking
+
+template <typename T>
+void zero_nulls_scalar(const uint8_t* nulls, size_t num_rows, T* data) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        data[i] &= T(0) - T(nulls[i] == 0);
+    }
+}
+
+// all ones for the non-null rows of a register, the null bytes widened to the row size
+template <typename T>
+VEC_TARGET_AVX2 inline __m256i not_null_avx2(const uint8_t* nulls) {
+    if constexpr (sizeof(T) == 1) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nulls));
+        return _mm256_cmpeq_epi8(bytes, _mm256_setzero_si256());
+    } else if constexpr (sizeof(T) == 2) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nulls));
+        return _mm256_cvtepi8_epi16(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+    } else if constexpr (sizeof(T) == 4) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(nulls));
+        return _mm256_cvtepi8_epi32(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+    } else {
+        uint32_t word;
+        memcpy(&word, nulls, sizeof(word));
+        __m128i bytes = _mm_cvtsi32_si128(word);
+        return _mm256_cvtepi8_epi64(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+    }
+}
+
+template <typename T>
+VEC_TARGET_AVX2 void zero_nulls_avx2(const uint8_t* nulls, size_t num_rows, T* data) {
+    constexpr size_t LANES = 32 / sizeof(T);
+    size_t i = 0;
+    for (; i + LANES <= num_rows; i += LANES) {
+        auto* p = reinterpret_cast<__m256i*>(data + i);
+        __m256i values = _mm256_and_si256(_mm256_loadu_si256(p), not_null_avx2<T>(nulls + i));
+        _mm256_storeu_si256(p, values);
+    }
+    zero_nulls_scalar(nulls + i, num_rows - i, data + i);
+}
+
+template <typename T>
+VEC_TARGET_AVX512 inline void store_zero_avx512(T* dst, uint64_t mask) {
+    const __m512i zero = _mm512_setzero_si512();
+    if constexpr (sizeof(T) == 1) {
+        _mm512_mask_storeu_epi8(dst, mask, zero);
+    } else if constexpr (sizeof(T) == 2) {
+        _mm512_mask_storeu_epi16(dst, static_cast<__mmask32>(mask), zero);
+    } else if constexpr (sizeof(T) == 4) {
+        _mm512_mask_storeu_epi32(dst, static_cast<__mmask16>(mask), zero);
+    } else if constexpr (sizeof(T) == 8) {
+        _mm512_mask_storeu_epi64(dst, static_cast<__mmask8>(mask), zero);
+    } else {
+        // both qwords of a row
+        _mm512_mask_storeu_epi64(dst, static_cast<__mmask8>(_pdep_u64(mask, 0x55) * 3), zero);
+    }
+}
+
+// 64 null bytes to one mask, then a masked store of zeros to the null rows only:
+// the values are never loaded and a block without null is skipped
+template <typename T>
+VEC_TARGET_AVX512 void zero_nulls_avx512(const uint8_t* nulls, size_t num_rows, T* data) {
+    constexpr size_t LANES = 64 / sizeof(T);
+    for (size_t i = 0; i < num_rows; i += 64) {
+        __mmask64 rows = _bzhi_u64(~uint64_t(0), std::min<size_t>(64, num_rows - i));
+        __m512i bytes = _mm512_maskz_loadu_epi8(rows, nulls + i);
+        uint64_t null_rows = _mm512_test_epi8_mask(bytes, bytes);
+        if constexpr (LANES == 64) {
+            if (null_rows != 0) store_zero_avx512(data + i, null_rows);
+        } else {
+            for (size_t k = 0; null_rows != 0; k += LANES, null_rows >>= LANES) {
+                uint64_t mask = null_rows & ((uint64_t(1) << LANES) - 1);
+                if (mask != 0) store_zero_avx512(data + i + k, mask);
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// dispatch
+
+using MemequalFn = bool (*)(const char*, const char*, size_t);
+
+template <typename T>
+using GatherFn = void (*)(const T*, const uint32_t*, size_t, T*);
+
+using HistogramFn = void (*)(const uint32_t*, size_t, uint32_t, uint32_t*);
+
+template <typename T>
+using ZeroNullsFn = void (*)(const uint8_t*, size_t, T*);
+
+constexpr KernelTable<MemequalFn> memequal_kernels(memequal_scalar, memequal_sse42, memequal_avx2,
+                                                   memequal_avx512, nullptr);
+
+constexpr KernelTable<GatherFn<uint32_t>> gather_u32_kernels(gather_scalar<uint32_t>, nullptr,
+                                                             gather_u32_avx2, gather_u32_avx512,
+                                                             nullptr);
+
+constexpr KernelTable<GatherFn<uint64_t>> gather_u64_kernels(gather_scalar<uint64_t>, nullptr,
+                                                             gather_u64_avx2, gather_u64_avx512,
+                                                             nullptr);
+
+constexpr KernelTable<HistogramFn> histogram_kernels(histogram_scalar, nullptr, histogram_avx2,
+                                                     histogram_avx512, nullptr);
+
+template <typename T>
+constexpr KernelTable<ZeroNullsFn<T>> zero_nulls_kernels(zero_nulls_scalar<T>, nullptr,
+                                                         zero_nulls_avx2<T>, zero_nulls_avx512<T>,
+                                                         nullptr);
+
+// not_null_avx2 has no 16 bytes rows
+constexpr KernelTable<ZeroNullsFn<unsigned __int128>> zero_nulls_u128_kernels(
+        zero_nulls_scalar<unsigned __int128>, nullptr, nullptr,
+        zero_nulls_avx512<unsigned __int128>, nullptr);
+
+// one version per row size
+constexpr KernelTable<const DecodeFn*> decode_kernels(decode_scalar_fns, decode_sse42_fns,
+                                                      decode_avx2_fns, nullptr,
+                                                      decode_avx512_vbmi2_fns);
+
+constexpr KernelTable<const DecodeNullableFn*> decode_nullable_kernels(
+        decode_nullable_scalar_fns, decode_nullable_sse42_fns, nullptr, nullptr,
+        decode_nullable_avx512_vbmi2_fns);
+
+} // namespace
+
+bool memequal(const char* p1, const char* p2, size_t size) {
+    return memequal_kernels.get()(p1, p2, size);
+}
+
+// vpgather is microcoded on Zen and no faster than scalar loads there
+void gather_u32(const uint32_t* src, const uint32_t* indices, size_t num_rows, uint32_t* dst) {
+    auto fn = CpuInfo::host().amd ? gather_scalar<uint32_t> : gather_u32_kernels.get();
+    fn(src, indices, num_rows, dst);
+}
+
+void gather_u64(const uint64_t* src, const uint32_t* indices, size_t num_rows, uint64_t* dst) {
+    auto fn = CpuInfo::host().amd ? gather_scalar<uint64_t> : gather_u64_kernels.get();
+    fn(src, indices, num_rows, dst);
+}
+
+void histogram(const uint32_t* keys, size_t num_keys, uint32_t num_buckets, uint32_t* counts) {
+    histogram_kernels.get()(keys, num_keys, num_buckets, counts);
+}
+
+#define VEC_DEFINE_ZERO_NULLS(name, T)                          \
+    void name(const uint8_t* nulls, size_t num_rows, T* data) { \
+        zero_nulls_kernels<T>.get()(nulls, num_rows, data);     \
+    }
+
+VEC_DEFINE_ZERO_NULLS(zero_nulls_u8, uint8_t)
+VEC_DEFINE_ZERO_NULLS(zero_nulls_u16, uint16_t)
+VEC_DEFINE_ZERO_NULLS(zero_nulls_u32, uint32_t)
+VEC_DEFINE_ZERO_NULLS(zero_nulls_u64, uint64_t)
+
+void zero_nulls_u128(const uint8_t* nulls, size_t num_rows, unsigned __int128* data) {
+    zero_nulls_u128_kernels.get()(nulls, num_rows, data);
+}
+
+#undef VEC_DEFINE_ZERO_NULLS
+
+void decode_be_int128(const uint8_t* src, int binsz, size_t num_rows, __int128* dst) {
+    assert(binsz >= 1 && binsz <= 16);
+    decode_kernels.get()[binsz - 1](src, num_rows, dst);
+}
+
+void decode_be_int128_nullable(const uint8_t* src, const uint8_t* nulls, int binsz,
+                               size_t num_rows, __int128* dst) {
+    assert(binsz >= 1 && binsz <= 16);
+    if (count_zero(nulls, num_rows) == num_rows) {
+        decode_kernels.get()[binsz - 1](src, num_rows, dst);
+        return;
+    }
+    decode_nullable_kernels.get()[binsz - 1](src, nulls, num_rows, dst);
+}
+
+} // namespace vec
@@ -0,0 +1,729 @@
+#include "vec/sort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+namespace vec {
+
+namespace {
+
+// ------------------------------------------------------------------------------------
+// radix keys: unsigned integers in the order of the values
+
+template <typename T>
+struct RadixKey;
+
+template <>
+struct RadixKey<int32_t> {
+    using U = uint32_t;
+};
+
+template <>
+struct RadixKey<uint32_t> {
+    using U = uint32_t;
+};
+
+template <>
+struct RadixKey<float> {
+    using U = uint32_t;
+};
+
+template <>
+struct RadixKey<int64_t> {
+    using U = uint64_t;
+};
+
+template <>
+struct RadixKey<uint64_t> {
+    using U = uint64_t;
+};
+
+template <>
+struct RadixKey<double> {
+    using U = uint64_t;
+};
+
+template <typename T>
+inline typename RadixKey<T>::U to_radix(T value) {
+    using U = typename RadixKey<T>::U;
+    constexpr U SIGN = U(1) << (sizeof(U) * 8 - 1);
+    if constexpr (std::is_floating_point_v<T>) {
+        U bits;
+        memcpy(&bits, &value, sizeof(bits));
+        // a negative float is larger as its bits are smaller
+        return bits & SIGN ? ~bits : bits | SIGN;
+    } else if constexpr (std::is_signed_v<T>) {
+        return U(value) ^ SIGN;
+    } else {
+        return value;
+    }
+}
+
+template <typename T>
+struct RadixLess {
+    bool operator()(T lhs, T rhs) const { return to_radix(lhs) < to_radix(rhs); }
+};
+
+// counts[b][x] is the number of keys whose byte b is x, one pass for all the bytes
+template <typename U, typename Key>
+void radix_histograms(size_t num_rows, Key key, size_t (*counts)[256]) {
+    memset(counts, 0, sizeof(size_t) * 256 * sizeof(U));
+    for (size_t i = 0; i < num_rows; ++i) {
+        U k = key(i);
+        for (size_t b = 0; b < sizeof(U); ++b) {
+            counts[b][(k >> (b * 8)) & 0xFF]++;
+        }
+    }
+}
+
+// LSD passes from src to dst and back, key(x) is the radix key of an element. The
+// passes of a byte that every key shares are skipped. Returns the buffer that holds
+// the sorted elements.
+template <typename U, typename E, typename Key>
+E* radix_passes(E* src, E* dst, size_t num_rows, size_t (*counts)[256], Key key) {
+    U first = key(src[0]);
+    for (size_t b = 0; b < sizeof(U); ++b) {
+        size_t* count = counts[b];
+        size_t shift = b * 8;
+        if (count[(first >> shift) & 0xFF] == num_rows) {
+            continue;
+        }
+        size_t offsets[256];
+        size_t sum = 0;
+        for (int x = 0; x < 256; ++x) {
+            offsets[x] = sum;
+            sum += count[x];
+        }
+        for (size_t i = 0; i < num_rows; ++i) {
+            dst[offsets[(key(src[i]) >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+    return src;
+}
+
+// LSD passes scatter each element to one of 256 places of the whole column, fine
+// while the column and its scratch fit in the L2 cache
+constexpr size_t LSD_MAX_BYTES = 512 * 1024;
+
+// Sorts entries by key(entry), stable, scratch holds num_rows entries. A larger column
+// is first split by its highest byte that differs (MSD), then each bucket is sorted
+// while it is in cache.
+template <typename U, typename E, typename Key>
+void radix_sort_entries(E* entries, E* scratch, size_t num_rows, Key key) {
+    if (num_rows < RADIX_SORT_MIN_ROWS) {
+        std::stable_sort(entries, entries + num_rows,
+                         [key](const E& lhs, const E& rhs) { return key(lhs) < key(rhs); });
+        return;
+    }
+    size_t counts[sizeof(U)][256];
+    radix_histograms<U>(num_rows, [entries, key](size_t i) { return key(entries[i]); }, counts);
+    if (num_rows * sizeof(E) <= LSD_MAX_BYTES) {
+        E* sorted = radix_passes<U>(entries, scratch, num_rows, counts, key);
+        if (sorted != entries) {
+            memcpy(entries, sorted, num_rows * sizeof(E));
+        }
+        return;
+    }
+    const U first = key(entries[0]);
+    int b = sizeof(U) - 1;
+    while (b >= 0 && counts[b][(first >> (b * 8)) & 0xFF] == num_rows) {
+        --b;
+    }
+    if (b < 0) {
+        return;
+    }
+    const size_t shift = b * 8;
+    size_t offsets[256];
+    size_t sum = 0;
+    for (int x = 0; x < 256; ++x) {
+        offsets[x] = sum;
+        sum += counts[b][x];
+    }
+    for (size_t i = 0; i < num_rows; ++i) {
+        scratch[offsets[(key(entries[i]) >> shift) & 0xFF]++] = entries[i];
+    }
+    // offsets[x] is the end of bucket x now
+    size_t begin = 0;
+    for (int x = 0; x < 256; ++x) {
+        size_t end = offsets[x];
+        if (end > begin) {
+            radix_sort_entries<U>(scratch + begin, entries + begin, end - begin, key);
+            memcpy(entries + begin, scratch + begin, (end - begin) * sizeof(E));
+        }
+        begin = end;
+    }
+}
+
+template <typename T>
+void radix_sort_impl(T* values, size_t num_rows, T* scratch) {
+    using U = typename RadixKey<T>::U;
+    if (num_rows < RADIX_SORT_MIN_ROWS) {
+        std::sort(values, values + num_rows, RadixLess<T>());
+        return;
+    }
+    radix_sort_entries<U>(values, scratch, num_rows, [](T value) { return to_radix(value); });
+}
+
+// the keys move with their rows
+template <typename U>
+struct KeyRow {
+    U key;
+    uint32_t row;
+};
+
+template <typename T>
+void argsort_impl(const T* keys, size_t num_rows, uint32_t* perm) {
+    using U = typename RadixKey<T>::U;
+    std::vector<KeyRow<U>> entries(num_rows);
+    std::vector<KeyRow<U>> scratch(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        entries[i] = {to_radix(keys[i]), static_cast<uint32_t>(i)};
+    }
+    radix_sort_entries<U>(entries.data(), scratch.data(), num_rows,
+                          [](const KeyRow<U>& entry) { return entry.key; });
+    for (size_t i = 0; i < num_rows; ++i) {
+        perm[i] = entries[i].row;
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// parallel sort: runs sorted by a thread each, then merged by a thread an output range
+
+// fn(t) for t in [0, num_threads), the last one on the calling thread
+template <typename Fn>
+void parallel_for(int num_threads, Fn fn) {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (int t = 0; t < num_threads - 1; ++t) {
+        threads.emplace_back(fn, t);
+    }
+    fn(num_threads - 1);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// a sorted run of entries
+template <typename E>
+struct Run {
+    const E* begin;
+    const E* end;
+};
+
+// Splits sorted runs at rank: pos[i] entries of run i go before it, the rest after,
+// and the entries before are the rank smallest. Equal keys are taken from the
+// earlier runs first, as a stable sort of the runs one after another would order
+// them. A binary search for the key of the entry at rank, by its count in all runs.
+template <typename U, typename E, typename Key>
+std::vector<size_t> split_runs(const std::vector<Run<E>>& runs, size_t rank, Key key) {
+    auto count = [&runs, key](U value, bool upper) {
+        size_t n = 0;
+        for (const auto& run : runs) {
+            auto less = [key](const E& entry, U v) { return key(entry) < v; };
+            auto greater = [key](U v, const E& entry) { return v < key(entry); };
+            n += (upper ? std::upper_bound(run.begin, run.end, value, greater)
+                        : std::lower_bound(run.begin, run.end, value, less)) -
+                 run.begin;
+        }
+        return n;
+    };
+    // the smallest value with at least rank entries <= it
+    U lo = 0;
+    U hi = ~U(0);
+    while (lo < hi) {
+        U mid = lo + (hi - lo) / 2;
+        if (count(mid, true) >= rank) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    std::vector<size_t> pos(runs.size());
+    size_t need = rank;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        auto less = [key](const E& entry, U v) { return key(entry) < v; };
+        pos[i] = std::lower_bound(runs[i].begin, runs[i].end, lo, less) - runs[i].begin;
+        need -= pos[i];
+    }
+    for (size_t i = 0; i < runs.size() && need > 0; ++i) {
+        auto greater = [key](U v, const E& entry) { return v < key(entry); };
+        size_t equal = std::upper_bound(runs[i].begin + pos[i], runs[i].end, lo, greater) -
+                       (runs[i].begin + pos[i]);
+        size_t take = std::min(need, equal);
+        pos[i] += take;
+        need -= take;
+    }
+    return pos;
+}
+
+// K-way merge of sorted runs to out with a loser tree: each inner node holds the
+// run that lost the match below it, an entry out replays the matches on the path of
+// its run only, log K compares. Ties go to the earlier run.
+template <typename U, typename E, typename Key>
+void merge_runs(std::vector<Run<E>> runs, E* out, Key key) {
+    const size_t k = runs.size();
+    size_t leaves = 1;
+    while (leaves < k) {
+        leaves *= 2;
+    }
+    // a run past k or at its end loses to every other
+    auto wins = [&runs, k, key](size_t a, size_t b) {
+        bool a_done = a >= k || runs[a].begin == runs[a].end;
+        bool b_done = b >= k || runs[b].begin == runs[b].end;
+        if (a_done || b_done) {
+            return !a_done || (b_done && a < b);
+        }
+        U ka = key(*runs[a].begin);
+        U kb = key(*runs[b].begin);
+        return ka < kb || (ka == kb && a < b);
+    };
+    // tree[0] is the winner, the first matches played bottom up
+    std::vector<size_t> tree(leaves);
+    std::vector<size_t> winners(2 * leaves);
+    for (size_t i = 0; i < leaves; ++i) {
+        winners[leaves + i] = i;
+    }
+    for (size_t node = leaves - 1; node >= 1; --node) {
+        size_t l = winners[2 * node];
+        size_t r = winners[2 * node + 1];
+        bool left = wins(l, r);
+        winners[node] = left ? l : r;
+        tree[node] = left ? r : l;
+    }
+    tree[0] = winners[1];
+    size_t total = 0;
+    for (const auto& run : runs) {
+        total += run.end - run.begin;
+    }
+    for (size_t i = 0; i < total; ++i) {
+        size_t winner = tree[0];
+        out[i] = *runs[winner].begin++;
+        for (size_t node = (winner + leaves) / 2; node >= 1; node /= 2) {
+            if (wins(tree[node], winner)) {
+                std::swap(tree[node], winner);
+            }
+        }
+        tree[0] = winner;
+    }
+}
+
+// Sorts entries with num_threads threads to scratch, entries are left in runs.
+// Thread t sorts run t of entries, then merges the rank range t of all the runs.
+template <typename U, typename E, typename Key>
+void parallel_sort_entries(E* entries, E* scratch, size_t num_rows, int num_threads, Key key) {
+    std::vector<size_t> bounds(num_threads + 1);
+    for (int t = 0; t <= num_threads; ++t) {
+        bounds[t] = num_rows * t / num_threads;
+    }
+    parallel_for(num_threads, [&](int t) {
+        radix_sort_entries<U>(entries + bounds[t], scratch + bounds[t], bounds[t + 1] - bounds[t],
+                              key);
+    });
+    std::vector<Run<E>> runs;
+    for (int t = 0; t < num_threads; ++t) {
+        runs.push_back({entries + bounds[t], entries + bounds[t + 1]});
+    }
+    parallel_for(num_threads, [&](int t) {
+        std::vector<size_t> begin = split_runs<U>(runs, bounds[t], key);
+        std::vector<size_t> end = split_runs<U>(runs, bounds[t + 1], key);
+        std::vector<Run<E>> parts;
+        for (int i = 0; i < num_threads; ++i) {
+            parts.push_back({runs[i].begin + begin[i], runs[i].begin + end[i]});
+        }
+        merge_runs<U>(std::move(parts), scratch + bounds[t], key);
+    });
+}
+
+// threads for num_rows, each one sorts a run of at least PARALLEL_SORT_MIN_ROWS
+int sort_threads(size_t num_rows, int num_threads) {
+    return static_cast<int>(
+            std::max<size_t>(1, std::min<size_t>(num_threads, num_rows / PARALLEL_SORT_MIN_ROWS)));
+}
+
+template <typename T>
+void parallel_sort_impl(T* values, size_t num_rows, T* scratch, int num_threads) {
+    using U = typename RadixKey<T>::U;
+    num_threads = sort_threads(num_rows, num_threads);
+    if (num_threads == 1) {
+        radix_sort_impl(values, num_rows, scratch);
+        return;
+    }
+    parallel_sort_entries<U>(values, scratch, num_rows, num_threads,
+                             [](T value) { return to_radix(value); });
+    parallel_for(num_threads, [&](int t) {
+        size_t begin = num_rows * t / num_threads;
+        size_t end = num_rows * (t + 1) / num_threads;
+        memcpy(values + begin, scratch + begin, (end - begin) * sizeof(T));
+    });
+}
+
+template <typename T>
+void parallel_argsort_impl(const T* keys, size_t num_rows, uint32_t* perm, int num_threads) {
+    using U = typename RadixKey<T>::U;
+    num_threads = sort_threads(num_rows, num_threads);
+    if (num_threads == 1) {
+        argsort_impl(keys, num_rows, perm);
+        return;
+    }
+    std::vector<KeyRow<U>> entries(num_rows);
+    std::vector<KeyRow<U>> scratch(num_rows);
+    parallel_for(num_threads, [&](int t) {
+        for (size_t i = num_rows * t / num_threads; i < num_rows * (t + 1) / num_threads; ++i) {
+            entries[i] = {to_radix(keys[i]), static_cast<uint32_t>(i)};
+        }
+    });
+    parallel_sort_entries<U>(entries.data(), scratch.data(), num_rows, num_threads,
+                             [](const KeyRow<U>& entry) { return entry.key; });
+    parallel_for(num_threads, [&](int t) {
+        for (size_t i = num_rows * t / num_threads; i < num_rows * (t + 1) / num_threads; ++i) {
+            perm[i] = scratch[i].row;
+        }
+    });
+}
+
+// ------------------------------------------------------------------------------------
+// normalized keys
+
+inline uint32_t to_big_endian(uint32_t value) {
+    return __builtin_bswap32(value);
+}
+
+inline uint64_t to_big_endian(uint64_t value) {
+    return __builtin_bswap64(value);
+}
+
+inline unsigned __int128 to_big_endian(unsigned __int128 value) {
+    return static_cast<unsigned __int128>(__builtin_bswap64(static_cast<uint64_t>(value))) << 64 |
+           __builtin_bswap64(static_cast<uint64_t>(value >> 64));
+}
+
+template <typename T>
+struct NormalizedKey {
+    using U = typename RadixKey<T>::U;
+    static U encode(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (value != value) {
+                return ~U(0);
+            }
+            // -0.0 as 0.0
+            return to_radix<T>(value == 0 ? T(0) : value);
+        } else {
+            return to_radix(value);
+        }
+    }
+};
+
+template <>
+struct NormalizedKey<__int128> {
+    using U = unsigned __int128;
+    static U encode(__int128 value) { return U(value) ^ (U(1) << 127); }
+};
+
+// one byte of null flag for a nullable column, then the big-endian key of the value,
+// inverted for DESC. A null row has a zero value.
+template <typename T>
+void encode_fixed(const T* values, const uint8_t* nulls, SortOrder order, NullOrder null_order,
+                  size_t num_rows, uint8_t* keys, size_t stride) {
+    using U = typename NormalizedKey<T>::U;
+    const U invert = order == SortOrder::DESC ? ~U(0) : U(0);
+    const uint8_t null_byte = null_order == NullOrder::FIRST ? 0 : 1;
+    for (size_t i = 0; i < num_rows; ++i) {
+        uint8_t* key = keys + i * stride;
+        if (nulls != nullptr) {
+            *key++ = nulls[i] ? null_byte : 1 - null_byte;
+            if (nulls[i]) {
+                memset(key, 0, sizeof(U));
+                continue;
+            }
+        }
+        U k = to_big_endian(U(NormalizedKey<T>::encode(values[i]) ^ invert));
+        memcpy(key, &k, sizeof(U));
+    }
+}
+
+void encode_strings(const Slice* values, const uint8_t* nulls, SortOrder order,
+                    NullOrder null_order, size_t prefix_size, size_t num_rows, uint8_t* keys,
+                    size_t stride) {
+    const uint8_t invert = order == SortOrder::DESC ? 0xFF : 0;
+    const uint8_t null_byte = null_order == NullOrder::FIRST ? 0 : 1;
+    for (size_t i = 0; i < num_rows; ++i) {
+        uint8_t* key = keys + i * stride;
+        if (nulls != nullptr) {
+            *key++ = nulls[i] ? null_byte : 1 - null_byte;
+            if (nulls[i]) {
+                memset(key, 0, prefix_size);
+                continue;
+            }
+        }
+        size_t size = std::min(values[i].size, prefix_size);
+        if (size > 0) {
+            memcpy(key, values[i].data, size);
+        }
+        memset(key + size, 0, prefix_size - size);
+        if (invert) {
+            for (size_t j = 0; j < prefix_size; ++j) {
+                key[j] ^= invert;
+            }
+        }
+    }
+}
+
+// buckets of at most this many rows are sorted by insertion
+constexpr size_t INSERTION_SORT_ROWS = 24;
+
+// the rows agree on the bytes before depth, tmp holds a row
+void insertion_sort(uint8_t* rows, size_t num_rows, size_t stride, size_t key_size,
+                    size_t depth, uint8_t* tmp) {
+    for (size_t i = 1; i < num_rows; ++i) {
+        uint8_t* row = rows + i * stride;
+        if (memcmp(row - stride + depth, row + depth, key_size - depth) <= 0) {
+            continue;
+        }
+        memcpy(tmp, row, stride);
+        size_t j = i;
+        while (j > 0 &&
+               memcmp(rows + (j - 1) * stride + depth, tmp + depth, key_size - depth) > 0) {
+            memcpy(rows + j * stride, rows + (j - 1) * stride, stride);
+            --j;
+        }
+        memcpy(rows + j * stride, tmp, stride);
+    }
+}
+
+// MSD radix sort of rows of stride bytes by their first key_size bytes, stable. The
+// rows agree on the bytes before depth. A distribution goes through scratch and is
+// copied back, the buckets are sorted on by the next byte.
+void msd_radix_sort(uint8_t* rows, uint8_t* scratch, size_t num_rows, size_t stride,
+                    size_t key_size, size_t depth) {
+    if (num_rows <= INSERTION_SORT_ROWS) {
+        if (depth < key_size) {
+            insertion_sort(rows, num_rows, stride, key_size, depth, scratch);
+        }
+        return;
+    }
+    size_t counts[256];
+    // a byte that every row shares does not split them
+    for (; depth < key_size; ++depth) {
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < num_rows; ++i) {
+            counts[rows[i * stride + depth]]++;
+        }
+        if (counts[rows[depth]] != num_rows) {
+            break;
+        }
+    }
+    if (depth == key_size) {
+        return;
+    }
+    size_t offsets[256];
+    size_t sum = 0;
+    for (int x = 0; x < 256; ++x) {
+        offsets[x] = sum;
+        sum += counts[x];
+    }
+    for (size_t i = 0; i < num_rows; ++i) {
+        const uint8_t* row = rows + i * stride;
+        memcpy(scratch + offsets[row[depth]]++ * stride, row, stride);
+    }
+    memcpy(rows, scratch, num_rows * stride);
+    size_t begin = 0;
+    for (int x = 0; x < 256; ++x) {
+        if (counts[x] > 1) {
+            msd_radix_sort(rows + begin * stride, scratch + begin * stride, counts[x], stride,
+                           key_size, depth + 1);
+        }
+        begin += counts[x];
+    }
+}
+
+// fn(begin, end) of each run of rows in [begin, end) that agree on their first size bytes
+template <typename Fn>
+void for_each_run(const uint8_t* rows, size_t stride, size_t begin, size_t end, size_t size,
+                  Fn fn) {
+    while (begin < end) {
+        size_t run_end = begin + 1;
+        while (run_end < end && memcmp(rows + begin * stride, rows + run_end * stride, size) == 0) {
+            ++run_end;
+        }
+        fn(begin, run_end);
+        begin = run_end;
+    }
+}
+
+} // namespace
+
+#define VEC_DEFINE_RADIX_SORT(T)                                                                   \
+    void radix_sort(T* values, size_t num_rows, T* scratch) {                                      \
+        radix_sort_impl(values, num_rows, scratch);                                                \
+    }                                                                                              \
+    void argsort(const T* keys, size_t num_rows, uint32_t* perm) {                                 \
+        argsort_impl(keys, num_rows, perm);                                                        \
+    }                                                                                              \
+    void parallel_sort(T* values, size_t num_rows, T* scratch, int num_threads) {                  \
+        parallel_sort_impl(values, num_rows, scratch, num_threads);                                \
+    }                                                                                              \
+    void parallel_argsort(const T* keys, size_t num_rows, uint32_t* perm, int num_threads) {       \
+        parallel_argsort_impl(keys, num_rows, perm, num_threads);                                  \
+    }
+
+VEC_DEFINE_RADIX_SORT(int32_t)
+VEC_DEFINE_RADIX_SORT(uint32_t)
+VEC_DEFINE_RADIX_SORT(int64_t)
+VEC_DEFINE_RADIX_SORT(uint64_t)
+VEC_DEFINE_RADIX_SORT(float)
+VEC_DEFINE_RADIX_SORT(double)
+
+#undef VEC_DEFINE_RADIX_SORT
+
+void argsort(const Slice* keys, size_t num_rows, uint32_t* perm) {
+    NormalizedKeys sort_keys(num_rows);
+    sort_keys.add_column(keys, nullptr, SortOrder::ASC, NullOrder::FIRST);
+    sort_keys.sort(perm);
+}
+
+template <typename T>
+void NormalizedKeys::_add_fixed(const T* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order) {
+    size_t offset = _key_size;
+    size_t num_rows = _num_rows;
+    _key_size += sizeof(typename NormalizedKey<T>::U) + (nulls != nullptr);
+    _encoders.emplace_back([=](uint8_t* keys, size_t stride) {
+        encode_fixed(values, nulls, order, null_order, num_rows, keys + offset, stride);
+    });
+}
+
+void NormalizedKeys::add_column(const int32_t* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order) {
+    _add_fixed(values, nulls, order, null_order);
+}
+
+void NormalizedKeys::add_column(const int64_t* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order) {
+    _add_fixed(values, nulls, order, null_order);
+}
+
+void NormalizedKeys::add_column(const __int128* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order) {
+    _add_fixed(values, nulls, order, null_order);
+}
+
+void NormalizedKeys::add_column(const float* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order) {
+    _add_fixed(values, nulls, order, null_order);
+}
+
+void NormalizedKeys::add_column(const double* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order) {
+    _add_fixed(values, nulls, order, null_order);
+}
+
+void NormalizedKeys::add_column(const Slice* values, const uint8_t* nulls, SortOrder order,
+                                NullOrder null_order, size_t prefix_size) {
+    size_t offset = _key_size;
+    size_t num_rows = _num_rows;
+    _key_size += prefix_size + (nulls != nullptr);
+    _encoders.emplace_back([=](uint8_t* keys, size_t stride) {
+        encode_strings(values, nulls, order, null_order, prefix_size, num_rows, keys + offset,
+                       stride);
+    });
+    _strings.push_back({values, nulls, order, prefix_size, offset, _key_size});
+}
+
+// The keys of a row are followed by its index. Sorted by the keys only, the
+// distributions are stable and the index of equal keys stays in order.
+void NormalizedKeys::sort(uint32_t* perm) const {
+    const size_t stride = _key_size + sizeof(uint32_t);
+    std::vector<uint8_t> keys(_num_rows * stride);
+    std::vector<uint8_t> scratch(std::max<size_t>(_num_rows, 1) * stride);
+    for (const auto& encoder : _encoders) {
+        encoder(keys.data(), stride);
+    }
+    for (size_t i = 0; i < _num_rows; ++i) {
+        uint32_t row = i;
+        memcpy(keys.data() + i * stride + _key_size, &row, sizeof(row));
+    }
+    msd_radix_sort(keys.data(), scratch.data(), _num_rows, stride, _key_size, 0);
+    for (size_t i = 0; i < _num_rows; ++i) {
+        memcpy(perm + i, keys.data() + i * stride + _key_size, sizeof(uint32_t));
+    }
+    if (!_strings.empty()) {
+        for_each_run(keys.data(), stride, 0, _num_rows, _strings[0].end,
+                     [&](size_t begin, size_t end) {
+                         _sort_ties(keys.data(), stride, perm, begin, end, 0);
+                     });
+    }
+}
+
+// The prefixes decide the order of a run if its strings are null, or if they are
+// all shorter than the prefix and of the same size: then equal prefixes are equal
+// strings. Else the zero padding or the cut may hide the order, and the run is sorted
+// by comparisons of the whole strings. That is rare for a prefix that fits most of
+// the strings, and the runs are small.
+void NormalizedKeys::_sort_ties(const uint8_t* keys, size_t stride, uint32_t* perm,
+                                size_t begin, size_t end, size_t k) const {
+    if (end - begin < 2) {
+        return;
+    }
+    const StringColumn& column = _strings[k];
+    bool decided = true;
+    if (column.nulls == nullptr || !column.nulls[perm[begin]]) {
+        size_t size = column.values[perm[begin]].size;
+        for (size_t i = begin; i < end && decided; ++i) {
+            size_t row_size = column.values[perm[i]].size;
+            decided = row_size < column.prefix_size && row_size == size;
+        }
+    }
+    if (decided) {
+        if (k + 1 < _strings.size()) {
+            for_each_run(keys, stride, begin, end, _strings[k + 1].end,
+                         [&](size_t run_begin, size_t run_end) {
+                             _sort_ties(keys, stride, perm, run_begin, run_end, k + 1);
+                         });
+        }
+        return;
+    }
+    // the positions of the run in the sorted keys, then the rows in the new order
+    std::vector<uint32_t> positions(end - begin);
+    std::iota(positions.begin(), positions.end(), begin);
+    std::stable_sort(positions.begin(), positions.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return _less(keys + lhs * stride, perm[lhs], keys + rhs * stride, perm[rhs], k);
+    });
+    std::vector<uint32_t> rows(end - begin);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] = perm[positions[i]];
+    }
+    std::copy(rows.begin(), rows.end(), perm + begin);
+}
+
+bool NormalizedKeys::_less(const uint8_t* lhs_key, uint32_t lhs, const uint8_t* rhs_key,
+                           uint32_t rhs, size_t k) const {
+    // the bytes before pos are equal
+    size_t pos = _strings[k].offset;
+    for (; k < _strings.size(); ++k) {
+        const StringColumn& column = _strings[k];
+        int res = memcmp(lhs_key + pos, rhs_key + pos, column.offset - pos);
+        if (res != 0) {
+            return res < 0;
+        }
+        pos = column.end;
+        if (column.nulls != nullptr) {
+            if (column.nulls[lhs] != column.nulls[rhs]) {
+                return lhs_key[column.offset] < rhs_key[column.offset];
+            }
+            if (column.nulls[lhs]) {
+                continue;
+            }
+        }
+        res = column.values[lhs].compare(column.values[rhs]);
+        if (res != 0) {
+            return column.order == SortOrder::ASC ? res < 0 : res > 0;
+        }
+    }
+    return memcmp(lhs_key + pos, rhs_key + pos, _key_size - pos) < 0;
+}
+
+} // namespace vec
@@ -0,0 +1,219 @@
+#include "vec/string_search.h"
+
+#include <immintrin.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "vec/cpu_dispatch.h"
+#include "vec/hash.h"
+
+namespace vec {
+
+namespace {
+
+// words = match(data, size) of every row
+template <typename Match>
+void match_rows(const FlatBinaryView& rows, uint64_t* words, Match match) {
+    const uint32_t* offsets = rows.offsets();
+    const char* bytes = reinterpret_cast<const char*>(rows.bytes());
+    for (size_t begin = 0; begin < rows.size(); begin += 64) {
+        size_t end = std::min(begin + 64, rows.size());
+        uint64_t word = 0;
+        for (size_t i = begin; i < end; ++i) {
+            word |= uint64_t(match(bytes + offsets[i], offsets[i + 1] - offsets[i])) << (i - begin);
+        }
+        words[begin / 64] = word;
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// contains: candidate positions
+//
+// masks gets a bit for each of num_positions (a multiple of 64) positions of bytes,
+// set if the needle may start there. The bits are a superset of the matches, the
+// first and the last byte or the first 16 bytes match. bytes holds num_positions +
+// size - 1 bytes, size is at least 1.
+
+// memchr of the first byte, vectorized by the libc
+void candidates_scalar(const uint8_t* bytes, size_t num_positions, const uint8_t* needle,
+                       size_t size, uint64_t* masks) {
+    std::fill(masks, masks + num_positions / 64, 0);
+    const uint8_t* end = bytes + num_positions;
+    const uint8_t* p = bytes;
+    while ((p = static_cast<const uint8_t*>(memchr(p, needle[0], end - p))) != nullptr) {
+        if (p[size - 1] == needle[size - 1]) {
+            size_t j = p - bytes;
+            masks[j / 64] |= uint64_t(1) << (j % 64);
+        }
+        ++p;
+    }
+}
+
+// the needle is compared in order at each position, a needle that runs past the end
+// of the 16 bytes is a candidate as far as it goes
+VEC_TARGET_SSE42 void candidates_sse42(const uint8_t* bytes, size_t num_positions,
+                                       const uint8_t* needle, size_t size, uint64_t* masks) {
+    constexpr int MODE = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED | _SIDD_BIT_MASK;
+    uint8_t head[16] = {};
+    int head_size = std::min<size_t>(size, 16);
+    memcpy(head, needle, head_size);
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(head));
+    for (size_t w = 0; w < num_positions / 64; ++w) {
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 16) {
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + w * 64 + j));
+            uint64_t m = _mm_cvtsi128_si32(_mm_cmpestrm(a, head_size, b, 16, MODE)) & 0xFFFF;
+            mask |= m << j;
+        }
+        masks[w] = mask;
+    }
+}
+
+VEC_TARGET_AVX2 void candidates_avx2(const uint8_t* bytes, size_t num_positions,
+                                     const uint8_t* needle, size_t size, uint64_t* masks) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[size - 1]);
+    for (size_t w = 0; w < num_positions / 64; ++w) {
+        uint64_t mask = 0;
+        for (int j = 0; j < 64; j += 32) {
+            const uint8_t* p = bytes + w * 64 + j;
+            __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + size - 1));
+            __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last));
+            mask |= uint64_t(uint32_t(_mm256_movemask_epi8(eq))) << j;
+        }
+        masks[w] = mask;
+    }
+}
+
+VEC_TARGET_AVX512 void candidates_avx512(const uint8_t* bytes, size_t num_positions,
+                                         const uint8_t* needle, size_t size, uint64_t* masks) {
+    const __m512i first = _mm512_set1_epi8(needle[0]);
+    const __m512i last = _mm512_set1_epi8(needle[size - 1]);
+    for (size_t w = 0; w < num_positions / 64; ++w) {
+        const uint8_t* p = bytes + w * 64;
+        __mmask64 f = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p), first);
+        masks[w] = _mm512_mask_cmpeq_epi8_mask(f, _mm512_loadu_si512(p + size - 1), last);
+    }
+}
+
+using CandidatesFn = void (*)(const uint8_t*, size_t, const uint8_t*, size_t, uint64_t*);
+
+constexpr KernelTable<CandidatesFn> candidates_kernels(candidates_scalar, candidates_sse42,
+                                                       candidates_avx2, candidates_avx512,
+                                                       nullptr);
+
+// positions a kernel call
+constexpr size_t SEARCH_CHUNK = 4096;
+
+} // namespace
+
+void starts_with(const FlatBinaryView& rows, const Slice& prefix, uint64_t* words) {
+    match_rows(rows, words, [&prefix](const char* data, size_t size) {
+        return size >= prefix.size && memequal(data, prefix.size, prefix.data, prefix.size);
+    });
+}
+
+void ends_with(const FlatBinaryView& rows, const Slice& suffix, uint64_t* words) {
+    match_rows(rows, words, [&suffix](const char* data, size_t size) {
+        return size >= suffix.size &&
+               memequal(data + size - suffix.size, suffix.size, suffix.data, suffix.size);
+    });
+}
+
+void contains(const FlatBinaryView& rows, const Slice& needle, uint64_t* words) {
+    size_t num_rows = rows.size();
+    if (needle.size == 0) {
+        match_rows(rows, words, [](const char*, size_t) { return true; });
+        return;
+    }
+    std::fill(words, words + BitVec::words_for(num_rows), 0);
+    const uint32_t* offsets = rows.offsets();
+    const uint8_t* bytes = rows.bytes();
+    const auto* n = reinterpret_cast<const uint8_t*>(needle.data);
+    const size_t size = needle.size;
+    CandidatesFn candidates = candidates_kernels.get();
+    uint64_t masks[SEARCH_CHUNK / 64];
+
+    // every position before pos is searched, the rows before row are done and the
+    // positions before skip are in a row that matched already
+    size_t pos = offsets[0];
+    const size_t end = offsets[num_rows];
+    size_t row = 0;
+    size_t skip = 0;
+    while (end - pos >= size + 63) {
+        size_t num_positions = std::min((end - pos - size + 1) / 64 * 64, SEARCH_CHUNK);
+        candidates(bytes + pos, num_positions, n, size, masks);
+        for (size_t w = 0; w < num_positions / 64; ++w) {
+            uint64_t mask = masks[w];
+            while (mask != 0) {
+                size_t p = pos + w * 64 + __builtin_ctzll(mask);
+                mask &= mask - 1;
+                if (p < skip) {
+                    continue;
+                }
+                while (offsets[row + 1] <= p) {
+                    ++row;
+                }
+                if (p + size <= offsets[row + 1] &&
+                    memequal(reinterpret_cast<const char*>(bytes + p), size,
+                             reinterpret_cast<const char*>(n), size)) {
+                    words[row / 64] |= uint64_t(1) << (row % 64);
+                    skip = offsets[row + 1];
+                }
+            }
+        }
+        pos = std::max(pos + num_positions, skip);
+    }
+    // less than 64 positions left, the rest of the rows from pos on
+    for (size_t i = row; i < num_rows; ++i) {
+        size_t begin = std::max<size_t>(pos, offsets[i]);
+        if (begin >= skip && begin + size <= offsets[i + 1] &&
+            memmem(bytes + begin, offsets[i + 1] - begin, n, size) != nullptr) {
+            words[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
+
+StringSet::StringSet(const std::vector<Slice>& values) {
+    int num_bits = 3;
+    while ((size_t(1) << num_bits) < values.size() * 2) {
+        ++num_bits;
+    }
+    _slots.assign(size_t(1) << num_bits, 0);
+    _mask = _slots.size() - 1;
+    _shift = 32 - num_bits;
+    for (const auto& value : values) {
+        if (contains(value)) {
+            continue;
+        }
+        uint32_t slot = hash_key_sampled(value) >> _shift;
+        while (_slots[slot] != 0) {
+            slot = (slot + 1) & _mask;
+        }
+        _values.append(value);
+        _slots[slot] = _values.size();
+        _sizes |= uint64_t(1) << std::min<size_t>(value.size, 63);
+    }
+}
+
+bool StringSet::contains(const Slice& value) const {
+    if (((_sizes >> std::min<size_t>(value.size, 63)) & 1) == 0) {
+        return false;
+    }
+    uint32_t slot = hash_key_sampled(value) >> _shift;
+    for (; _slots[slot] != 0; slot = (slot + 1) & _mask) {
+        if (_values.get_slice(_slots[slot] - 1) == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StringSet::contains(const FlatBinaryView& rows, uint64_t* words) const {
+    match_rows(rows, words,
+               [this](const char* data, size_t size) { return contains(Slice(data, size)); });
+}
+
+} // namespace vec
@@ -0,0 +1,100 @@
+#include "vec/top_n.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vec {
+
+namespace {
+
+// lhs comes before rhs
+struct Before {
+    SortOrder order;
+    bool operator()(const StringTopN::Entry& lhs, const StringTopN::Entry& rhs) const {
+        int res = memcompare(lhs.value.data(), lhs.value.size(), rhs.value.data(),
+                             rhs.value.size());
+        if (res != 0) {
+            return order == SortOrder::ASC ? res < 0 : res > 0;
+        }
+        return lhs.row < rhs.row;
+    }
+};
+
+inline Slice row_slice(const FlatBinaryView& rows, size_t i) {
+    return rows.get_slice(i);
+}
+
+// the bytes of a short row are in the row of the view, not in a copy
+inline Slice row_slice(const InlineBinaryView& rows, size_t i) {
+    const SliceInline& row = rows.slices()[i];
+    return Slice(row.bytes(), row.size);
+}
+
+} // namespace
+
+StringTopN::StringTopN(size_t limit, SortOrder order) : _limit(limit), _order(order) {
+    _heap.reserve(limit);
+}
+
+template <typename Rows>
+size_t StringTopN::_fill(const Rows& rows) {
+    size_t i = 0;
+    for (; i < rows.size() && !full(); ++i) {
+        Slice value = row_slice(rows, i);
+        _heap.push_back({std::string(value.data, value.size), _num_rows + i});
+        std::push_heap(_heap.begin(), _heap.end(), Before{_order});
+    }
+    return _limit == 0 ? rows.size() : i;
+}
+
+void StringTopN::_push(const Slice& value, uint64_t row) {
+    const Entry& top = _heap.front();
+    int res = memcompare(value.data, value.size, top.value.data(), top.value.size());
+    // an equal value of a later row stays out
+    if (_order == SortOrder::ASC ? res >= 0 : res <= 0) {
+        return;
+    }
+    std::pop_heap(_heap.begin(), _heap.end(), Before{_order});
+    // the string of the dropped row keeps its memory
+    _heap.back().value.assign(value.data, value.size);
+    _heap.back().row = row;
+    std::push_heap(_heap.begin(), _heap.end(), Before{_order});
+}
+
+void StringTopN::add(const FlatBinaryView& rows) {
+    size_t i = _fill(rows);
+    // a memcmp with the threshold a row, as cheap as a compare kernel of the layout
+    for (; i < rows.size(); ++i) {
+        _push(row_slice(rows, i), _num_rows + i);
+    }
+    _num_rows += rows.size();
+}
+
+void StringTopN::add(const InlineBinaryView& rows) {
+    size_t i = _fill(rows);
+    const CompareOp op = _order == SortOrder::ASC ? CompareOp::LT : CompareOp::GT;
+    uint64_t words[TOP_N_CHUNK_ROWS / 64];
+    for (; i < rows.size(); i += TOP_N_CHUNK_ROWS) {
+        size_t chunk = std::min(rows.size() - i, TOP_N_CHUNK_ROWS);
+        // the threshold as a row of the layout, its bytes do not move until _push
+        Slice value = threshold();
+        SliceInline bound(value.data, value.size);
+        compare_bits(op, rows.slices() + i, bound, chunk, words);
+        const size_t num_words = BitVec::words_for(chunk);
+        for (size_t w = 0; w < num_words; ++w) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                size_t j = i + w * 64 + __builtin_ctzll(word);
+                _push(row_slice(rows, j), _num_rows + j);
+            }
+        }
+    }
+    _num_rows += rows.size();
+}
+
+std::vector<StringTopN::Entry> StringTopN::sorted() const {
+    std::vector<Entry> entries = _heap;
+    std::sort_heap(entries.begin(), entries.end(), Before{_order});
+    return entries;
+}
+
+} // namespace vec
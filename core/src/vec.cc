@@ -1,46 +1,352 @@
 #include "vec/vec.h"
 
+#include <algorithm>
+#include <cassert>
+
 #include "vec/binary_vec.h"
 
 namespace vec {
 
+namespace {
+
+// the first buffer of long strings, the next ones double up to MAX_BUFFER_BYTES
+constexpr size_t MIN_BUFFER_BYTES = 4096;
+constexpr size_t MAX_BUFFER_BYTES = 1 << 20;
+
+// A gather out of a vector larger than GATHER_PREFETCH_MIN_BYTES, about the L2 of a
+// core, prefetches the row GATHER_PREFETCH_DISTANCE rows ahead. The bytes of a row
+// are a load that waits on the load of its offset or SliceInline, a chain the
+// out-of-order core does not overlap by itself across rows. See bench_gather.cpp.
+constexpr size_t GATHER_PREFETCH_MIN_BYTES = 1 << 20;
+constexpr size_t GATHER_PREFETCH_DISTANCE = 16;
+
+// the rows of a gather that prefetch the row GATHER_PREFETCH_DISTANCE ahead, [0, end)
+inline size_t gather_prefetch_end(size_t src_bytes, size_t num_rows) {
+    if (src_bytes <= GATHER_PREFETCH_MIN_BYTES || num_rows <= GATHER_PREFETCH_DISTANCE) {
+        return 0;
+    }
+    return num_rows - GATHER_PREFETCH_DISTANCE;
+}
+
+inline bool bit_of(const uint64_t* words, size_t i) {
+    return (words[i / 64] >> (i % 64)) & 1;
+}
+
+// Compacts the selected rows of offsets/bytes, returns their number. A run of
+// consecutive selected rows is one memmove.
+template <typename Selected>
+size_t filter_flat(uint32_t* offsets, uint8_t* bytes, size_t num_rows, Selected selected) {
+    size_t cnt = 0;
+    // the pending run [run_begin, run_end) of the input goes to dst
+    uint32_t dst = 0;
+    uint32_t run_begin = 0;
+    uint32_t run_end = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (!selected(i)) {
+            continue;
+        }
+        // read before offsets[cnt + 1] is written, as long as every row is selected
+        // they are the same entry with the same value
+        uint32_t begin = offsets[i];
+        uint32_t end = offsets[i + 1];
+        if (begin != run_end) {
+            memmove(bytes + dst, bytes + run_begin, run_end - run_begin);
+            dst += run_end - run_begin;
+            run_begin = begin;
+        }
+        run_end = end;
+        offsets[++cnt] = dst + (run_end - run_begin);
+    }
+    // no byte for empty strings, bytes may be null
+    if (run_end > run_begin) {
+        memmove(bytes + dst, bytes + run_begin, run_end - run_begin);
+    }
+    return cnt;
+}
+
+template <CompareOp OP, typename Rhs>
+void compare_flat(const FlatBinaryVec& lhs, Rhs rhs, uint64_t* words) {
+    for (size_t begin = 0; begin < lhs.size(); begin += 64) {
+        size_t end = std::min(begin + 64, lhs.size());
+        uint64_t word = 0;
+        for (size_t i = begin; i < end; ++i) {
+            word |= uint64_t(compare_op<OP>(lhs.get_slice(i), rhs(i))) << (i - begin);
+        }
+        words[begin / 64] = word;
+    }
+}
+
+// rhs(i) is the slice row i compares with
+template <typename Rhs>
+BitVec compare_flat(CompareOp op, const FlatBinaryVec& lhs, Rhs rhs) {
+    BitVec bits(lhs.size());
+    switch (op) {
+    case CompareOp::EQ:
+        compare_flat<CompareOp::EQ>(lhs, rhs, bits.words());
+        break;
+    case CompareOp::NE:
+        compare_flat<CompareOp::NE>(lhs, rhs, bits.words());
+        break;
+    case CompareOp::LT:
+        compare_flat<CompareOp::LT>(lhs, rhs, bits.words());
+        break;
+    case CompareOp::LE:
+        compare_flat<CompareOp::LE>(lhs, rhs, bits.words());
+        break;
+    case CompareOp::GT:
+        compare_flat<CompareOp::GT>(lhs, rhs, bits.words());
+        break;
+    case CompareOp::GE:
+        compare_flat<CompareOp::GE>(lhs, rhs, bits.words());
+        break;
+    }
+    return bits;
+}
+
+} // namespace
+
 void FlatBinaryVec::build_strings(const std::vector<Slice>& slices) {
+    clear();
     size_t buffer_size = 0;
-    for (size_t i = 0; i < slices.size(); ++i) {
-        buffer_size += slices[i].size;
+    for (const auto& s : slices) {
+        buffer_size += s.size;
     }
-    _offsets.reserve(slices.size());
-    _bytes.reserve(buffer_size);
+    reserve(slices.size(), buffer_size);
+    append_batch(slices.data(), slices.size());
+}
 
-    for (const auto& s : slices) {
-        const uint8_t* const p = reinterpret_cast<uint8_t*>(s.data);
-        _bytes.insert(_bytes.end(), p, p + s.size);
-        _offsets.emplace_back(_bytes.size());
+void FlatBinaryVec::append(const Slice& slice) {
+    const auto* p = reinterpret_cast<const uint8_t*>(slice.data);
+    _bytes.insert(_bytes.end(), p, p + slice.size);
+    _offsets.push_back(_bytes.size());
+}
+
+// sized once, a vector insert a row costs more than the copy of a short string
+void FlatBinaryVec::append_batch(const Slice* slices, size_t num_rows) {
+    size_t num_bytes = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        num_bytes += slices[i].size;
+    }
+    size_t row = size();
+    uint32_t offset = _bytes.size();
+    _offsets.resize(row + 1 + num_rows);
+    _bytes.resize(offset + num_bytes);
+    uint32_t* offsets = _offsets.data() + row + 1;
+    uint8_t* bytes = _bytes.data();
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (slices[i].size > 0) {
+            memcpy(bytes + offset, slices[i].data, slices[i].size);
+        }
+        offset += slices[i].size;
+        offsets[i] = offset;
+    }
+}
+
+void FlatBinaryVec::append_batch(const FlatBinaryView& rows) {
+    if (rows.size() == 0) {
+        return;
+    }
+    const uint32_t* offsets = rows.offsets();
+    uint32_t base = _bytes.size();
+    _bytes.insert(_bytes.end(), rows.bytes() + offsets[0], rows.bytes() + offsets[rows.size()]);
+    for (size_t i = 1; i <= rows.size(); ++i) {
+        _offsets.push_back(base + offsets[i] - offsets[0]);
     }
 }
 
+void FlatBinaryVec::reserve(size_t num_rows, size_t num_bytes) {
+    _offsets.reserve(num_rows + 1);
+    _bytes.reserve(num_bytes);
+}
+
+void FlatBinaryVec::clear() {
+    _offsets.resize(1);
+    _bytes.clear();
+}
+
+void FlatBinaryVec::_filter(const uint8_t* selection) {
+    size_t cnt = filter_flat(_offsets.data(), _bytes.data(), size(),
+                             [selection](size_t i) { return selection[i] != 0; });
+    _offsets.resize(cnt + 1);
+    _bytes.resize(_offsets.back());
+}
+
+void FlatBinaryVec::filter(const BitVec& selector) {
+    VEC_ASSERT_TRUE(selector.len() == static_cast<int>(size()));
+    const uint64_t* words = selector.words();
+    size_t cnt = filter_flat(_offsets.data(), _bytes.data(), size(),
+                             [words](size_t i) { return bit_of(words, i); });
+    _offsets.resize(cnt + 1);
+    _bytes.resize(_offsets.back());
+}
+
+BitVec FlatBinaryVec::compare_bits(CompareOp op, const Slice& value) const {
+    return compare_flat(op, *this, [&value](size_t) { return value; });
+}
+
+BitVec FlatBinaryVec::compare_bits(CompareOp op, const FlatBinaryVec& rhs) const {
+    VEC_ASSERT_TRUE(rhs.size() == size());
+    return compare_flat(op, *this, [&rhs](size_t i) { return rhs.get_slice(i); });
+}
+
+// Two passes: the sizes of the rows, then their bytes. The offsets of a large vector
+// are prefetched ahead in the first, the bytes in the second.
+FlatBinaryVec FlatBinaryVec::gather(const uint32_t* indices, size_t num_rows) const {
+    FlatBinaryVec res(_bytes.get_allocator().arena());
+    size_t prefetch_end = gather_prefetch_end(byte_size(), num_rows);
+    size_t num_bytes = 0;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i < prefetch_end) {
+            __builtin_prefetch(&_offsets[indices[i + GATHER_PREFETCH_DISTANCE]]);
+        }
+        num_bytes += _offsets[indices[i] + 1] - _offsets[indices[i]];
+    }
+    res.reserve(num_rows, num_bytes);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i < prefetch_end) {
+            __builtin_prefetch(&_bytes[_offsets[indices[i + GATHER_PREFETCH_DISTANCE]]]);
+        }
+        res.append(get_slice(indices[i]));
+    }
+    return res;
+}
+
+InlineBinaryVec FlatBinaryVec::to_inline() const {
+    InlineBinaryVec res(_bytes.get_allocator().arena());
+    res.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        res.append(get_slice(i));
+    }
+    return res;
+}
+
 void InlineBinaryVec::build_strings(const std::vector<Slice>& slices) {
+    clear();
     size_t buffer_size = 0;
-    for (size_t i = 0; i < slices.size(); ++i) {
-        // buffer_size += slices[i].size >= 12 ? slices[i].size : 0;
-        buffer_size += slices[i].size;
+    for (const auto& s : slices) {
+        buffer_size += s.size > 12 ? s.size : 0;
     }
     _datas.reserve(slices.size());
-    _bytes.reserve(buffer_size);
-    auto* data = _bytes.data();
-    int32_t offset = 0;
-
-    for (size_t i = 0; i < slices.size(); ++i) {
-        const auto& s = slices[i];
-        uint8_t* p = reinterpret_cast<uint8_t*>(s.data);
-        if (s.size <= 12) {
-            _datas.emplace_back(p, s.size);
+    // one buffer for all the long strings
+    if (buffer_size > 0) {
+        _buffers.emplace_back(ArenaStlAllocator<uint8_t>(_arena));
+        _buffers.back().reserve(buffer_size);
+    }
+    append_batch(slices.data(), slices.size());
+}
+
+char* InlineBinaryVec::_copy_bytes(const char* data, size_t size) {
+    if (_buffers.empty() || _buffers.back().capacity() - _buffers.back().size() < size) {
+        size_t capacity = _buffers.empty() ? MIN_BUFFER_BYTES
+                                           : std::min(_buffers.back().capacity() * 2,
+                                                      MAX_BUFFER_BYTES);
+        _buffers.emplace_back(ArenaStlAllocator<uint8_t>(_arena));
+        _buffers.back().reserve(std::max(capacity, size));
+    }
+    auto& buffer = _buffers.back();
+    // within the capacity, the buffer does not move
+    size_t offset = buffer.size();
+    buffer.insert(buffer.end(), data, data + size);
+    return reinterpret_cast<char*>(buffer.data() + offset);
+}
+
+void InlineBinaryVec::append(const Slice& slice) {
+    char* data = slice.size <= 12 ? slice.data : _copy_bytes(slice.data, slice.size);
+    _datas.emplace_back(data, slice.size);
+}
+
+void InlineBinaryVec::append_batch(const Slice* slices, size_t num_rows) {
+    for (size_t i = 0; i < num_rows; ++i) {
+        append(slices[i]);
+    }
+}
+
+void InlineBinaryVec::append_batch(const InlineBinaryView& rows) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const SliceInline& row = rows.slices()[i];
+        if (row.size <= 12) {
+            _datas.push_back(row);
         } else {
-            _bytes.insert(_bytes.end(), p, p + s.size);
-            _datas.emplace_back(data + offset, s.size);
-            offset += s.size;
+            append(Slice(row.bytes(), row.size));
         }
     }
 }
 
-} // namespace vec
\ No newline at end of file
+void InlineBinaryVec::clear() {
+    _datas.clear();
+    _buffers.clear();
+}
+
+void InlineBinaryVec::filter(const BitVec& selector) {
+    VEC_ASSERT_TRUE(selector.len() == static_cast<int>(size()));
+    _datas.resize(vec::filter_bits(selector.words(), _datas.data(), size(), _datas.data()));
+}
+
+BitVec InlineBinaryVec::compare_bits(CompareOp op, const Slice& value) const {
+    BitVec bits(size());
+    vec::compare_bits(op, slices(), SliceInline(value.data, value.size), size(), bits.words());
+    return bits;
+}
+
+BitVec InlineBinaryVec::compare_bits(CompareOp op, const InlineBinaryVec& rhs) const {
+    VEC_ASSERT_TRUE(rhs.size() == size());
+    BitVec bits(size());
+    vec::compare_bits(op, slices(), rhs.slices(), size(), bits.words());
+    return bits;
+}
+
+// The row GATHER_PREFETCH_DISTANCE ahead of a large vector is prefetched, and the
+// bytes of a long string once its row is in cache, half as far ahead.
+InlineBinaryVec InlineBinaryVec::gather(const uint32_t* indices, size_t num_rows) const {
+    InlineBinaryVec res(_arena);
+    res.reserve(num_rows);
+    const size_t prefetch_end = gather_prefetch_end(byte_size(), num_rows);
+    constexpr size_t BYTES_DISTANCE = GATHER_PREFETCH_DISTANCE / 2;
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i < prefetch_end) {
+            __builtin_prefetch(&_datas[indices[i + GATHER_PREFETCH_DISTANCE]]);
+            const SliceInline& ahead = _datas[indices[i + BYTES_DISTANCE]];
+            if (ahead.size > 12) {
+                __builtin_prefetch(ahead.bytes());
+            }
+        }
+        const SliceInline& row = _datas[indices[i]];
+        if (row.size <= 12) {
+            res._datas.push_back(row);
+        } else {
+            res.append(Slice(row.bytes(), row.size));
+        }
+    }
+    return res;
+}
+
+size_t InlineBinaryVec::byte_size() const {
+    size_t size = _datas.size() * sizeof(SliceInline);
+    for (const auto& buffer : _buffers) {
+        size += buffer.size();
+    }
+    return size;
+}
+
+size_t InlineBinaryVec::capacity_bytes() const {
+    size_t size = _datas.capacity() * sizeof(SliceInline);
+    for (const auto& buffer : _buffers) {
+        size += buffer.capacity();
+    }
+    return size;
+}
+
+FlatBinaryVec InlineBinaryVec::to_flat() const {
+    FlatBinaryVec res(_arena);
+    size_t num_bytes = 0;
+    for (const auto& row : _datas) {
+        num_bytes += row.size;
+    }
+    res.reserve(size(), num_bytes);
+    for (const auto& row : _datas) {
+        res.append(Slice(row.bytes(), row.size));
+    }
+    return res;
+}
+
+} // namespace vec
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include "ring_buffer.h"
 
@@ -61,6 +63,110 @@ void bench_queue(const char* name, Args&&... args) {
     std::cerr << name << " costs:" << runtime / 1e6 << "s" << std::endl;
 }
 
+// benchmark for SPSCQueue: a failed try_push/try_pop is the full/empty check, and
+// batch_size > 1 moves the items through try_push_n/try_pop_n
+template <class ThreadBindType = ThreadBind>
+void bench_spsc(const char* name, size_t capacity, size_t batch_size) {
+    SPSCQueue<size_t> queue(capacity);
+    auto start = std::chrono::steady_clock::now();
+    std::thread pop_thread([&queue, batch_size]() {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(ThreadBindType::consumer_id, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        std::vector<size_t> values(batch_size);
+        int64_t cnt = 0;
+        size_t last = 0;
+        while (cnt != MAXN) {
+            size_t n = batch_size == 1 ? queue.try_pop(values.data())
+                                       : queue.try_pop_n(values.data(), batch_size);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < n; ++i) {
+                assert(values[i] > last);
+                last = values[i];
+            }
+            cnt += n;
+        }
+    });
+    std::thread push_thread([&queue, batch_size]() {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(ThreadBindType::producer_id, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        std::vector<size_t> values(batch_size);
+        for (int64_t i = 1; i <= MAXN;) {
+            size_t n = std::min<int64_t>(batch_size, MAXN - i + 1);
+            size_t pushed;
+            if (batch_size == 1) {
+                pushed = queue.try_push(i);
+            } else {
+                for (size_t j = 0; j < n; ++j) {
+                    values[j] = i + j;
+                }
+                pushed = queue.try_push_n(values.data(), n);
+            }
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+            i += pushed;
+        }
+    });
+    push_thread.join();
+    pop_thread.join();
+    auto finish = std::chrono::steady_clock::now();
+    auto runtime = std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+    std::cerr << name << " costs:" << runtime / 1e6 << "s" << std::endl;
+}
+
+constexpr int64_t MPMC_MAXN = int64_t(1e7);
+
+// benchmark for MPMC: MPMC_MAXN values in all, spread over the producers, popped by
+// whichever consumer comes first, as the fan in of an exchange
+template <class QueueType, class... Args>
+void bench_mpmc(const char* name, int num_producers, int num_consumers, Args&&... args) {
+    QueueType queue(std::forward<Args>(args)...);
+    std::atomic<int64_t> num_popped{0};
+    std::atomic<int64_t> sum{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < num_producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int64_t i = 1 + p; i <= MPMC_MAXN;) {
+                if (queue.try_push(i)) {
+                    i += num_producers;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < num_consumers; ++c) {
+        threads.emplace_back([&]() {
+            int64_t local_sum = 0;
+            size_t value;
+            while (num_popped.load(std::memory_order_relaxed) < MPMC_MAXN) {
+                if (queue.try_pop(&value)) {
+                    local_sum += value;
+                    num_popped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            sum += local_sum;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto finish = std::chrono::steady_clock::now();
+    auto runtime = std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+    assert(sum == MPMC_MAXN * (MPMC_MAXN + 1) / 2);
+    std::cerr << name << " " << num_producers << "x" << num_consumers
+              << " costs:" << runtime / 1e6 << "s" << std::endl;
+}
+
 int main() {
     // benchmark on Intel(R) Xeon(R) Platinum 8269CY CPU @ 2.50GHz (104 CPUS)
     // 11.3099s
@@ -77,6 +183,35 @@ int main() {
     bench_queue<LockFreeRingBufferV3<1024, 60, 120>>("LockFreeRingBufferV4");
     // 0.815
     bench_queue<LockFreeRingBufferV3<1024, 60, 120>, SingleThreadBind>("single thread");
+    // on Intel(R) Xeon(R) Processor (AVX-512 VBMI2) (1 CPU): V1 1.08, V2 1.29, V3 1.30,
+    // V4 1.04, single thread 1.38
+    // 0.98
+    bench_spsc("SPSCQueue", 1024, 1);
+    // 0.64
+    bench_spsc("SPSCQueue batch 64", 1024, 64);
+    // With a single CPU the two threads take turns and the cache lines of the indices
+    // never move, the cached indices only save the loads: 5-25% over V1-V4. Batches
+    // of 64 store each index once per batch and are 1.6x faster than one at a time.
+    // Where the threads run on two cores the V1-V4 loads of the other thread's index
+    // miss for every item, the cached copies only when the queue looks full or empty.
+
+    // N producers x M consumers, on Intel(R) Xeon(R) Processor (AVX-512 VBMI2) (1 CPU)
+    //                   1x1     4x1     4x4     8x8
+    // spin lock       0.480   0.507   0.506   0.632
+    // std::mutex      0.817   0.844   0.886   0.930
+    // MPMC            0.548   0.594   0.600   0.704
+    // with a single CPU only one thread runs at a time and the lock is never contended,
+    // the spin lock is ahead by its one uncontended CAS a value against the two of the
+    // queue. The MPMC queue does not serialize the producers with the consumers and
+    // pays off where they run in parallel.
+    for (auto [num_producers, num_consumers] : {std::pair{1, 1}, {4, 1}, {4, 4}, {8, 8}}) {
+        bench_mpmc<MutexedRingBuffer<spinlock>>("spin lock buffer", num_producers,
+                                                num_consumers, 1023);
+        bench_mpmc<MutexedRingBuffer<std::mutex>>("std::mutex lock buffer", num_producers,
+                                                  num_consumers, 1023);
+        bench_mpmc<MPMCBoundedQueue<size_t>>("MPMCBoundedQueue", num_producers, num_consumers,
+                                             1024);
+    }
 
     return 0;
 }
\ No newline at end of file
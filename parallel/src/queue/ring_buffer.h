@@ -1,9 +1,22 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <new>
+
+// the L1 line size the compiler tunes for, the queues are not part of an ABI
+#ifdef __cpp_lib_hardware_interference_size
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+#pragma GCC diagnostic pop
+#else
+constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
 
 class RingBuffer {
 public:
@@ -112,11 +125,13 @@ public:
         return (_end + 1 & (_capacity - 1)) == _start;
     }
 
+    // the checks are under the lock too: between a check outside of it and the lock
+    // another producer may fill the last slot, another consumer take the last value
     bool try_push(size_t val) {
+        std::lock_guard guard(_mutex);
         if (is_full()) {
             return false;
         }
-        std::lock_guard guard(_mutex);
         _datas[_end] = val;
         _end++;
         _end &= _capacity - 1;
@@ -124,10 +139,10 @@ public:
     }
 
     bool try_pop(size_t* val) {
+        std::lock_guard guard(_mutex);
         if (empty()) {
             return false;
         }
-        std::lock_guard guard(_mutex);
         *val = _datas[_start];
         _start++;
         _start &= _capacity - 1;
@@ -289,3 +304,202 @@ private:
     char padding2[len_padding2];
     std::unique_ptr<size_t[]> _datas;
 };
+
+// lock-free SPSC over T, as in https://rigtorp.se/ringbuffer/
+//
+// The V1-V3 buffers above load both indices for every item, the one of the other
+// thread too, which moves its cache line over each time. Here the producer keeps a
+// copy of the read index and the consumer one of the write index, and only reload the
+// real one when the copy says full or empty: with a queue that is neither, an item
+// costs a store of the own index. Each index sits on a cache line with the copy its
+// thread reads, apart from the other thread's. The indices count up without wrapping,
+// all the capacity slots are used.
+//
+// try_push_n/try_pop_n move as many items as fit with a single store of the index.
+template <typename T>
+class SPSCQueue {
+public:
+    SPSCQueue(size_t capacity) : _mask(capacity - 1), _slots(std::make_unique<T[]>(capacity)) {
+        assert(capacity >= 1 && (capacity & (capacity - 1)) == 0);
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    size_t capacity() const { return _mask + 1; }
+
+    // a guess while the other thread pushes or pops
+    bool empty() const {
+        return _read_idx.load(std::memory_order_relaxed) ==
+               _write_idx.load(std::memory_order_relaxed);
+    }
+    bool is_full() const {
+        return _write_idx.load(std::memory_order_relaxed) -
+                       _read_idx.load(std::memory_order_relaxed) ==
+               capacity();
+    }
+
+    // producer only
+    bool try_push(T val) {
+        const size_t write_idx = _write_idx.load(std::memory_order_relaxed);
+        if (write_idx - _read_idx_cache == capacity()) {
+            _read_idx_cache = _read_idx.load(std::memory_order_acquire);
+            if (write_idx - _read_idx_cache == capacity()) {
+                return false;
+            }
+        }
+        _slots[write_idx & _mask] = std::move(val);
+        _write_idx.store(write_idx + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer only, pushes the first of the n values that fit, returns how many
+    size_t try_push_n(const T* vals, size_t n) {
+        const size_t write_idx = _write_idx.load(std::memory_order_relaxed);
+        if (write_idx - _read_idx_cache + n > capacity()) {
+            _read_idx_cache = _read_idx.load(std::memory_order_acquire);
+        }
+        n = std::min(n, capacity() - (write_idx - _read_idx_cache));
+        for (size_t i = 0; i < n; ++i) {
+            _slots[(write_idx + i) & _mask] = vals[i];
+        }
+        if (n > 0) {
+            _write_idx.store(write_idx + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    // consumer only
+    bool try_pop(T* val) {
+        const size_t read_idx = _read_idx.load(std::memory_order_relaxed);
+        if (read_idx == _write_idx_cache) {
+            _write_idx_cache = _write_idx.load(std::memory_order_acquire);
+            if (read_idx == _write_idx_cache) {
+                return false;
+            }
+        }
+        *val = std::move(_slots[read_idx & _mask]);
+        _read_idx.store(read_idx + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, pops up to n values, returns how many
+    size_t try_pop_n(T* vals, size_t n) {
+        const size_t read_idx = _read_idx.load(std::memory_order_relaxed);
+        if (_write_idx_cache - read_idx < n) {
+            _write_idx_cache = _write_idx.load(std::memory_order_acquire);
+        }
+        n = std::min(n, _write_idx_cache - read_idx);
+        for (size_t i = 0; i < n; ++i) {
+            vals[i] = std::move(_slots[(read_idx + i) & _mask]);
+        }
+        if (n > 0) {
+            _read_idx.store(read_idx + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+private:
+    const size_t _mask;
+    std::unique_ptr<T[]> _slots;
+    // written by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _write_idx{0};
+    size_t _read_idx_cache = 0;
+    // written by the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _read_idx{0};
+    size_t _write_idx_cache = 0;
+};
+
+// lock-free MPMC bounded queue, as in
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// Every cell has a sequence number: the position a producer may write it at, or the
+// position + 1 a consumer may read it at once written. A producer claims the position
+// by a CAS on _enqueue_pos, writes the value and publishes it by the release store of
+// the sequence; a consumer does the same with _dequeue_pos and hands the cell back to
+// the producers of the next lap. The producers and the consumers do not share a
+// counter, and a thread only waits on the other side when the queue is full or empty.
+// A cell takes a cache line of its own, the neighbouring cells are written by
+// different threads.
+template <typename T>
+class MPMCBoundedQueue {
+public:
+    MPMCBoundedQueue(size_t capacity)
+            : _mask(capacity - 1), _cells(std::make_unique<Cell[]>(capacity)) {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+        for (size_t i = 0; i < capacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // a guess while other threads push or pop
+    bool empty() const {
+        return _dequeue_pos.load(std::memory_order_relaxed) >=
+               _enqueue_pos.load(std::memory_order_relaxed);
+    }
+    bool is_full() const {
+        return _enqueue_pos.load(std::memory_order_relaxed) -
+                       _dequeue_pos.load(std::memory_order_relaxed) >
+               _mask;
+    }
+
+    bool try_push(const T& val) {
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the consumer of the last lap has not read it yet
+                return false;
+            } else {
+                // another producer took the position
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = val;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T* val) {
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // not written yet
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        *val = std::move(cell->data);
+        cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    const size_t _mask;
+    std::unique_ptr<Cell[]> _cells;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _enqueue_pos{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _dequeue_pos{0};
+};
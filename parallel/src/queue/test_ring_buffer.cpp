@@ -1,5 +1,8 @@
+#include <atomic>
 #include <queue>
 #include <random>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -37,3 +40,153 @@ TEST(RingBufferTest, insert) {
         }
     }
 }
+
+TEST(MPMCBoundedQueueTest, FullAndEmpty) {
+    MPMCBoundedQueue<std::string> queue(4);
+    std::string value;
+    ASSERT_FALSE(queue.try_pop(&value));
+    for (int lap = 0; lap < 3; ++lap) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(queue.try_push(std::to_string(lap * 4 + i)));
+        }
+        ASSERT_TRUE(queue.is_full());
+        ASSERT_FALSE(queue.try_push("x"));
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(queue.try_pop(&value));
+            ASSERT_EQ(value, std::to_string(lap * 4 + i));
+        }
+        ASSERT_TRUE(queue.empty());
+        ASSERT_FALSE(queue.try_pop(&value));
+    }
+}
+
+// every value is popped once, and in the order of its producer
+template <class QueueType>
+void test_producers_consumers(QueueType& queue, int num_producers, int num_consumers) {
+    constexpr int64_t num_values = 100000;
+    std::vector<std::atomic<int>> popped(num_producers * num_values);
+    std::atomic<int64_t> num_popped{0};
+    std::atomic<bool> in_order{true};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < num_producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int64_t i = 0; i < num_values;) {
+                if (queue.try_push(p * num_values + i)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < num_consumers; ++c) {
+        threads.emplace_back([&]() {
+            std::vector<int64_t> last(num_producers, -1);
+            size_t value;
+            while (num_popped.load() < num_producers * num_values) {
+                if (queue.try_pop(&value)) {
+                    popped[value]++;
+                    num_popped++;
+                    int64_t producer = value / num_values;
+                    if (int64_t(value) <= last[producer]) {
+                        in_order = false;
+                    }
+                    last[producer] = value;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(in_order.load());
+    for (size_t i = 0; i < popped.size(); ++i) {
+        ASSERT_EQ(popped[i].load(), 1) << i;
+    }
+}
+
+TEST(MPMCBoundedQueueTest, ProducersConsumers) {
+    for (auto [num_producers, num_consumers] : {std::pair{1, 1}, {4, 1}, {1, 4}, {4, 4}}) {
+        MPMCBoundedQueue<size_t> queue(64);
+        test_producers_consumers(queue, num_producers, num_consumers);
+    }
+}
+
+TEST(MutexedRingBufferTest, ProducersConsumers) {
+    MutexedRingBuffer<spinlock> queue(63);
+    test_producers_consumers(queue, 4, 4);
+}
+
+TEST(SPSCQueueTest, FullAndEmpty) {
+    SPSCQueue<std::string> queue(4);
+    std::string value;
+    ASSERT_FALSE(queue.try_pop(&value));
+    for (int lap = 0; lap < 3; ++lap) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(queue.try_push(std::to_string(lap * 4 + i)));
+        }
+        ASSERT_TRUE(queue.is_full());
+        ASSERT_FALSE(queue.try_push("x"));
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(queue.try_pop(&value));
+            ASSERT_EQ(value, std::to_string(lap * 4 + i));
+        }
+        ASSERT_TRUE(queue.empty());
+        ASSERT_FALSE(queue.try_pop(&value));
+    }
+}
+
+TEST(SPSCQueueTest, Batch) {
+    SPSCQueue<int> queue(8);
+    int values[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int popped[10];
+    ASSERT_EQ(queue.try_pop_n(popped, 10), 0);
+    ASSERT_EQ(queue.try_push_n(values, 5), 5);
+    ASSERT_EQ(queue.try_pop_n(popped, 3), 3);
+    // 6 fit, over the end of the slots
+    ASSERT_EQ(queue.try_push_n(values + 5, 5), 5);
+    ASSERT_EQ(queue.try_push_n(values, 10), 1);
+    ASSERT_TRUE(queue.is_full());
+    ASSERT_EQ(queue.try_pop_n(popped + 3, 7), 7);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(popped[i], i);
+    }
+    ASSERT_EQ(queue.try_pop_n(popped, 10), 1);
+    ASSERT_EQ(popped[0], 0);
+    ASSERT_TRUE(queue.empty());
+}
+
+// every value in order, pushed and popped in batches of varying sizes
+TEST(SPSCQueueTest, ProducerConsumer) {
+    constexpr size_t num_values = 1000000;
+    SPSCQueue<size_t> queue(256);
+    std::thread producer([&]() {
+        std::vector<size_t> batch(100);
+        for (size_t i = 0; i < num_values;) {
+            size_t n = std::min(num_values - i, 1 + i % 100);
+            for (size_t j = 0; j < n; ++j) {
+                batch[j] = i + j;
+            }
+            size_t pushed = n == 1 ? queue.try_push(i) : queue.try_push_n(batch.data(), n);
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+            i += pushed;
+        }
+    });
+    std::vector<size_t> batch(64);
+    size_t expect = 0;
+    while (expect < num_values) {
+        size_t n = expect % 2 == 0 ? queue.try_pop_n(batch.data(), 1 + expect % 64)
+                                   : queue.try_pop(batch.data());
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t j = 0; j < n; ++j, ++expect) {
+            ASSERT_EQ(batch[j], expect);
+        }
+    }
+    producer.join();
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "task_scheduler.h"
+#include "vec/vec.h"
+
+constexpr int64_t NUM_ROWS = int64_t(1) << 26;
+constexpr size_t MORSEL_SIZE = 16384;
+constexpr int ROUNDS = 10;
+
+// a filtered sum over a column whose last eighth of rows costs 20x the rest, like the
+// skewed batches of a join with a few hot keys
+int64_t sum_rows(const vec::Vec<int64_t>& values, size_t begin, size_t end) {
+    int64_t sum = 0;
+    for (size_t i = begin; i < end; ++i) {
+        int repeat = i >= NUM_ROWS / 8 * 7 ? 20 : 1;
+        for (int r = 0; r < repeat; ++r) {
+            sum += values[i] % 7 == r % 7 ? values[i] : 0;
+        }
+    }
+    return sum;
+}
+
+template <class Fn>
+void bench(const char* name, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    int64_t result = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        result += fn();
+    }
+    auto finish = std::chrono::steady_clock::now();
+    auto runtime = std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+    std::cerr << name << " costs:" << runtime / 1e6 << "s (" << result << ")" << std::endl;
+}
+
+int main() {
+    const int num_threads = std::max(4u, std::thread::hardware_concurrency());
+    vec::Vec<int64_t> values(NUM_ROWS);
+    for (int64_t i = 0; i < NUM_ROWS; ++i) {
+        values[i] = i * 7919 % 1000003;
+    }
+
+    // benchmark on Intel(R) Xeon(R) Processor (AVX-512 VBMI2), 1 CPU, 4 threads: with a
+    // single CPU the two are even, the scheduler has nobody to balance onto
+    // fork-join with a static partition, as #pragma omp parallel for schedule(static):
+    // the threads of the cheap rows wait at the join for the one of the costly ones
+    // 7.18s
+    bench("static partition", [&]() {
+        std::vector<int64_t> sums(num_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                sums[t] = sum_rows(values, NUM_ROWS * t / num_threads,
+                                   NUM_ROWS * (t + 1) / num_threads);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        int64_t sum = 0;
+        for (int64_t s : sums) {
+            sum += s;
+        }
+        return sum;
+    });
+
+    // 7.50s
+    TaskScheduler scheduler(num_threads, true);
+    bench("work stealing", [&]() {
+        struct alignas(64) Partial {
+            int64_t sum = 0;
+        };
+        std::vector<Partial> partials(scheduler.num_workers());
+        scheduler.parallel_for(0, NUM_ROWS, MORSEL_SIZE, [&](size_t begin, size_t end) {
+            partials[scheduler.worker_id()].sum += sum_rows(values, begin, end);
+        });
+        int64_t sum = 0;
+        for (const auto& partial : partials) {
+            sum += partial.sum;
+        }
+        return sum;
+    });
+
+    return 0;
+}
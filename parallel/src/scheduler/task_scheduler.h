@@ -0,0 +1,371 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Chase-Lev work-stealing deque, as in "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (Le et al., PPoPP 2013). The owner thread pushes and pops at the
+// bottom, the other threads steal from the top; only a pop of the last item and the
+// steals race, through a CAS on top. The array grows when full, the old ones are kept
+// until the deque is destroyed as a thief may still read them. T is copied racily, a
+// pointer or a small trivially copyable value.
+template <typename T>
+class ChaseLevDeque {
+public:
+    ChaseLevDeque(int64_t capacity = 256) {
+        assert((capacity & (capacity - 1)) == 0);
+        _arrays.push_back(std::make_unique<Array>(capacity));
+        _array.store(_arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(T value) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        Array* a = _array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = _grow(a, t, b);
+        }
+        a->put(b, value);
+        // the release fence of the paper, as a release store the thieves acquire
+        _bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only, the last pushed item
+    bool pop(T* value) {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = _array.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        if (t > b) {
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        *value = a->get(b);
+        if (t == b) {
+            // the last item, a thief may take it first
+            bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread, the oldest item
+    bool steal(T* value) {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Array* a = _array.load(std::memory_order_acquire);
+        *value = a->get(t);
+        return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    }
+
+    // a guess while other threads push or steal
+    bool empty() const {
+        return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        Array(int64_t capacity_)
+                : capacity(capacity_), slots(std::make_unique<std::atomic<T>[]>(capacity_)) {}
+
+        T get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t i, T value) {
+            slots[i & (capacity - 1)].store(value, std::memory_order_relaxed);
+        }
+
+        const int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array* _grow(Array* a, int64_t top, int64_t bottom) {
+        _arrays.push_back(std::make_unique<Array>(a->capacity * 2));
+        Array* grown = _arrays.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            grown->put(i, a->get(i));
+        }
+        _array.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    // top and bottom are written by different threads
+    alignas(64) std::atomic<int64_t> _top{0};
+    alignas(64) std::atomic<int64_t> _bottom{0};
+    std::atomic<Array*> _array;
+    // owner only
+    std::vector<std::unique_ptr<Array>> _arrays;
+};
+
+class TaskScheduler;
+
+// The tasks spawned for a piece of work, wait() returns when they are all done. A
+// worker that waits runs tasks meanwhile, so a task may spawn and wait on a group of
+// its own (nested parallel_for) without blocking a worker. Any other thread sleeps.
+class TaskGroup {
+public:
+    TaskGroup(TaskScheduler* scheduler) : _scheduler(scheduler) {}
+
+    ~TaskGroup() { assert(_pending.load() == 0); }
+
+    void spawn(std::function<void()> fn);
+
+    void wait();
+
+private:
+    friend class TaskScheduler;
+
+    // a task of the group is done, under the mutex: a waiter that sees no task
+    // pending takes the mutex once before it returns and frees the group
+    void _done() {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _cond.notify_all();
+        }
+    }
+
+    TaskScheduler* _scheduler;
+    std::atomic<int64_t> _pending{0};
+    std::mutex _mutex;
+    std::condition_variable _cond;
+};
+
+// A pool of worker threads with a Chase-Lev deque each. A worker runs the tasks of
+// its own deque newest first (the cache is warm), then the tasks submitted from
+// outside the pool, then steals the oldest task of a random other worker: the largest
+// piece of work left. An idle worker spins a while, then sleeps until a task comes.
+//
+// Tasks are of batch granularity: parallel_for hands out morsels of rows by splitting
+// the range in halves, the one half pushed for the thieves and the other one split
+// on. A worker that is done early steals the half of a slow one instead of waiting at
+// a barrier, skewed morsels are spread over the pool.
+class TaskScheduler {
+public:
+    // pin_workers binds worker i to the CPU i % the CPUs of the host
+    explicit TaskScheduler(int num_workers = std::thread::hardware_concurrency(),
+                           bool pin_workers = false)
+            : _num_workers(num_workers) {
+        assert(num_workers > 0);
+        for (int i = 0; i < num_workers; ++i) {
+            _deques.push_back(std::make_unique<ChaseLevDeque<Task*>>());
+        }
+        for (int i = 0; i < num_workers; ++i) {
+            _workers.emplace_back([this, i, pin_workers]() {
+                if (pin_workers) {
+                    cpu_set_t cpuset;
+                    CPU_ZERO(&cpuset);
+                    CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &cpuset);
+                    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+                }
+                _run_worker(i);
+            });
+        }
+    }
+
+    ~TaskScheduler() {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _stopped = true;
+        }
+        _cond.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    int num_workers() const { return _num_workers; }
+
+    // The number of the calling worker of this pool, -1 for any other thread. Tasks
+    // run on the workers only: per-worker state (partial aggregates, hash table
+    // partitions) of num_workers() slots is not shared by two running tasks.
+    int worker_id() const { return tls_worker().scheduler == this ? tls_worker().id : -1; }
+
+    // fn(morsel_begin, morsel_end) for the morsels of [begin, end), of morsel_size
+    // rows but the last one, in parallel on the workers. Returns when all are done.
+    template <typename Fn>
+    void parallel_for(size_t begin, size_t end, size_t morsel_size, const Fn& fn) {
+        TaskGroup group(this);
+        if (worker_id() < 0) {
+            group.spawn([&]() { _split(group, begin, end, morsel_size, fn); });
+        } else {
+            _split(group, begin, end, morsel_size, fn);
+        }
+        group.wait();
+    }
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group;
+    };
+
+    struct WorkerId {
+        const TaskScheduler* scheduler = nullptr;
+        int id = -1;
+    };
+
+    static WorkerId& tls_worker() {
+        static thread_local WorkerId worker;
+        return worker;
+    }
+
+    // the calling thread runs [begin, end) morsel by morsel, pushing the upper half of
+    // what is left while there are more than one
+    template <typename Fn>
+    void _split(TaskGroup& group, size_t begin, size_t end, size_t morsel_size, const Fn& fn) {
+        while (end - begin > morsel_size) {
+            size_t num_morsels = (end - begin + morsel_size - 1) / morsel_size;
+            size_t mid = begin + num_morsels / 2 * morsel_size;
+            group.spawn([this, &group, mid, end, morsel_size, &fn]() {
+                _split(group, mid, end, morsel_size, fn);
+            });
+            end = mid;
+        }
+        if (begin < end) {
+            fn(begin, end);
+        }
+    }
+
+    void _submit(Task* task) {
+        const WorkerId& worker = tls_worker();
+        if (worker.scheduler == this) {
+            _deques[worker.id]->push(task);
+        } else {
+            std::lock_guard<std::mutex> guard(_injection_mutex);
+            _injection.push_back(task);
+        }
+        _num_queued.fetch_add(1);
+        if (_num_sleeping.load() > 0) {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _cond.notify_one();
+        }
+    }
+
+    // a task of the own deque, the injection queue or another worker
+    Task* _find_task(int id, std::minstd_rand& random) {
+        Task* task = nullptr;
+        if (_deques[id]->pop(&task)) {
+            return _take(task);
+        }
+        if (_num_queued.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> guard(_injection_mutex);
+            if (!_injection.empty()) {
+                task = _injection.front();
+                _injection.pop_front();
+                return _take(task);
+            }
+        }
+        int start = random() % _num_workers;
+        for (int i = 0; i < _num_workers; ++i) {
+            int victim = (start + i) % _num_workers;
+            if (victim != id && _deques[victim]->steal(&task)) {
+                return _take(task);
+            }
+        }
+        return nullptr;
+    }
+
+    Task* _take(Task* task) {
+        _num_queued.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    static void _run(Task* task) {
+        task->fn();
+        task->group->_done();
+        delete task;
+    }
+
+    void _run_worker(int id) {
+        tls_worker() = {this, id};
+        std::minstd_rand random(id + 1);
+        constexpr int SPINS = 64;
+        while (true) {
+            for (int spin = 0; spin < SPINS; ++spin) {
+                Task* task = _find_task(id, random);
+                if (task != nullptr) {
+                    _run(task);
+                    spin = -1;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            _num_sleeping.fetch_add(1);
+            // a task queued before the increment is seen here, one queued after it
+            // sees the sleeper and notifies
+            _cond.wait(lock, [this]() { return _stopped || _num_queued.load() > 0; });
+            _num_sleeping.fetch_sub(1);
+            if (_stopped) {
+                return;
+            }
+        }
+    }
+
+    const int _num_workers;
+    std::vector<std::unique_ptr<ChaseLevDeque<Task*>>> _deques;
+    std::vector<std::thread> _workers;
+
+    // tasks submitted from outside the pool
+    std::mutex _injection_mutex;
+    std::deque<Task*> _injection;
+
+    // tasks in the deques and the injection queue
+    std::atomic<int64_t> _num_queued{0};
+    std::atomic<int> _num_sleeping{0};
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _stopped = false;
+};
+
+inline void TaskGroup::spawn(std::function<void()> fn) {
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    _scheduler->_submit(new TaskScheduler::Task{std::move(fn), this});
+}
+
+inline void TaskGroup::wait() {
+    int id = _scheduler->worker_id();
+    if (id < 0) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cond.wait(lock, [this]() { return _pending.load(std::memory_order_acquire) == 0; });
+        return;
+    }
+    std::minstd_rand random(id + 1);
+    while (_pending.load(std::memory_order_acquire) > 0) {
+        TaskScheduler::Task* task = _scheduler->_find_task(id, random);
+        if (task != nullptr) {
+            TaskScheduler::_run(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    std::lock_guard<std::mutex> guard(_mutex);
+}
@@ -0,0 +1,149 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "task_scheduler.h"
+#include "vec/vec.h"
+
+// the owner pushes and pops while thieves steal, every item is taken once; a small
+// capacity makes the array grow under the thieves
+TEST(ChaseLevDequeTest, PushPopSteal) {
+    constexpr int num_items = 200000;
+    ChaseLevDeque<int> deque(4);
+    std::vector<std::atomic<int>> taken(num_items);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&]() {
+            int value;
+            while (!done.load() || !deque.empty()) {
+                if (deque.steal(&value)) {
+                    taken[value]++;
+                }
+            }
+        });
+    }
+    int value;
+    for (int i = 0; i < num_items; ++i) {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(&value)) {
+            taken[value]++;
+        }
+    }
+    while (deque.pop(&value)) {
+        taken[value]++;
+    }
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    for (int i = 0; i < num_items; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << i;
+    }
+}
+
+TEST(TaskSchedulerTest, ParallelFor) {
+    TaskScheduler scheduler(4);
+    for (size_t num_rows : {0, 1, 1000, 100000}) {
+        for (size_t morsel_size : {1, 7, 1024}) {
+            std::vector<std::atomic<int>> seen(num_rows);
+            scheduler.parallel_for(0, num_rows, morsel_size, [&](size_t begin, size_t end) {
+                ASSERT_LE(end - begin, morsel_size);
+                for (size_t i = begin; i < end; ++i) {
+                    seen[i]++;
+                }
+            });
+            for (size_t i = 0; i < num_rows; ++i) {
+                ASSERT_EQ(seen[i].load(), 1) << num_rows << " " << morsel_size;
+            }
+        }
+    }
+}
+
+// SUM over a Vec column with a partial sum a worker, the last morsels 100x slower
+TEST(TaskSchedulerTest, Aggregation) {
+    TaskScheduler scheduler(4);
+    vec::Vec<int64_t> values(1 << 20);
+    for (int i = 0; i < values.len(); ++i) {
+        values[i] = i % 1000;
+    }
+    struct alignas(64) Partial {
+        int64_t sum = 0;
+    };
+    std::vector<Partial> partials(scheduler.num_workers());
+    scheduler.parallel_for(0, values.len(), 4096, [&](size_t begin, size_t end) {
+        int repeat = begin >= static_cast<size_t>(values.len()) * 15 / 16 ? 100 : 1;
+        int64_t sum = 0;
+        for (int r = 0; r < repeat; ++r) {
+            sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                sum += values[i];
+            }
+        }
+        int id = scheduler.worker_id();
+        ASSERT_GE(id, 0);
+        partials[id].sum += sum;
+    });
+    int64_t total = 0;
+    for (const auto& partial : partials) {
+        total += partial.sum;
+    }
+    int64_t expect = 0;
+    for (int i = 0; i < values.len(); ++i) {
+        expect += values[i];
+    }
+    ASSERT_EQ(total, expect);
+}
+
+TEST(TaskSchedulerTest, Nested) {
+    TaskScheduler scheduler(3);
+    std::atomic<int64_t> sum{0};
+    scheduler.parallel_for(0, 64, 1, [&](size_t outer, size_t) {
+        scheduler.parallel_for(0, 1000, 10, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                sum += outer * 1000 + i;
+            }
+        });
+    });
+    ASSERT_EQ(sum.load(), int64_t(64000) * 63999 / 2);
+}
+
+// queries of their own threads on one pool
+TEST(TaskSchedulerTest, ConcurrentCallers) {
+    TaskScheduler scheduler(4);
+    std::vector<std::thread> callers;
+    std::vector<int64_t> sums(8);
+    for (int c = 0; c < 8; ++c) {
+        callers.emplace_back([&, c]() {
+            for (int round = 0; round < 20; ++round) {
+                std::atomic<int64_t> sum{0};
+                scheduler.parallel_for(0, 10000, 100, [&](size_t begin, size_t end) {
+                    int64_t s = 0;
+                    for (size_t i = begin; i < end; ++i) {
+                        s += i;
+                    }
+                    sum += s;
+                });
+                sums[c] += sum.load();
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    for (int64_t sum : sums) {
+        ASSERT_EQ(sum, int64_t(20) * 10000 * 9999 / 2);
+    }
+}
+
+TEST(TaskSchedulerTest, TaskGroup) {
+    TaskScheduler scheduler(2, true);
+    std::atomic<int> count{0};
+    TaskGroup group(&scheduler);
+    for (int i = 0; i < 1000; ++i) {
+        group.spawn([&]() { count++; });
+    }
+    group.wait();
+    ASSERT_EQ(count.load(), 1000);
+}
@@ -156,4 +156,141 @@ BENCHMARK_TEMPLATE(InlineBinaryCmpBench, Generate_FIXED_x<16, true>);
 BENCHMARK_TEMPLATE(InlineBinaryCmpBench, Generate_FIXED_x<128>);
 BENCHMARK_TEMPLATE(InlineBinaryCmpBench, Generate_FIXED_x<128, true>);
 
+// equality of a whole column with a constant into a bitmap
+template <class Col, class StringGen>
+static void CompareBitsBench(benchmark::State& state) {
+    StringGen gen;
+    Col vec;
+    std::vector<Slice> slices;
+    Generate::build(batch_size, slices, gen);
+    vec.build_strings(slices);
+    for (auto _ : state) {
+        BitVec bits = vec.compare_bits(CompareOp::EQ, gen());
+        benchmark::DoNotOptimize(bits.words());
+    }
+}
+
+template <class StringGen>
+constexpr void (*FlatBinaryCmpBitsBench)(benchmark::State& state) =
+        &CompareBitsBench<vec::FlatBinaryVec, StringGen>;
+
+template <class StringGen>
+constexpr void (*InlineBinaryCmpBitsBench)(benchmark::State& state) =
+        &CompareBitsBench<vec::InlineBinaryVec, StringGen>;
+
+BENCHMARK_TEMPLATE(FlatBinaryCmpBitsBench, Generate_SSB_SHIP_MODE);
+BENCHMARK_TEMPLATE(FlatBinaryCmpBitsBench, Generate_Date_Str);
+BENCHMARK_TEMPLATE(FlatBinaryCmpBitsBench, Generate_FIXED_x<12, true>);
+BENCHMARK_TEMPLATE(FlatBinaryCmpBitsBench, Generate_FIXED_x<16, true>);
+BENCHMARK_TEMPLATE(FlatBinaryCmpBitsBench, Generate_FIXED_x<128>);
+BENCHMARK_TEMPLATE(FlatBinaryCmpBitsBench, Generate_FIXED_x<128, true>);
+
+BENCHMARK_TEMPLATE(InlineBinaryCmpBitsBench, Generate_SSB_SHIP_MODE);
+BENCHMARK_TEMPLATE(InlineBinaryCmpBitsBench, Generate_Date_Str);
+BENCHMARK_TEMPLATE(InlineBinaryCmpBitsBench, Generate_FIXED_x<12, true>);
+BENCHMARK_TEMPLATE(InlineBinaryCmpBitsBench, Generate_FIXED_x<16, true>);
+BENCHMARK_TEMPLATE(InlineBinaryCmpBitsBench, Generate_FIXED_x<128>);
+BENCHMARK_TEMPLATE(InlineBinaryCmpBitsBench, Generate_FIXED_x<128, true>);
+
+// in-place filter keeping a random half of the rows
+template <class Col, class StringGen>
+static void FilterBench(benchmark::State& state) {
+    StringGen gen;
+    std::vector<Slice> slices;
+    Generate::build(batch_size, slices, gen);
+    Vec<bool> selector(batch_size);
+    for (int i = 0; i < batch_size; ++i) {
+        selector[i] = rand() % 2;
+    }
+    Col vec;
+    for (auto _ : state) {
+        state.PauseTiming();
+        vec.build_strings(slices);
+        state.ResumeTiming();
+        vec.filter(selector);
+        benchmark::DoNotOptimize(vec.size());
+    }
+}
+
+template <class StringGen>
+constexpr void (*FlatBinaryFilterBench)(benchmark::State& state) =
+        &FilterBench<vec::FlatBinaryVec, StringGen>;
+
+template <class StringGen>
+constexpr void (*InlineBinaryFilterBench)(benchmark::State& state) =
+        &FilterBench<vec::InlineBinaryVec, StringGen>;
+
+BENCHMARK_TEMPLATE(FlatBinaryFilterBench, Generate_SSB_SHIP_MODE);
+BENCHMARK_TEMPLATE(FlatBinaryFilterBench, Generate_Date_Str);
+BENCHMARK_TEMPLATE(FlatBinaryFilterBench, Generate_FIXED_x<16, true>);
+BENCHMARK_TEMPLATE(FlatBinaryFilterBench, Generate_FIXED_x<128>);
+
+BENCHMARK_TEMPLATE(InlineBinaryFilterBench, Generate_SSB_SHIP_MODE);
+BENCHMARK_TEMPLATE(InlineBinaryFilterBench, Generate_Date_Str);
+BENCHMARK_TEMPLATE(InlineBinaryFilterBench, Generate_FIXED_x<16, true>);
+BENCHMARK_TEMPLATE(InlineBinaryFilterBench, Generate_FIXED_x<128>);
+
 BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark                                                      Time             CPU   Iterations
+// ------------------------------------------------------------------------------------------------
+// FlatBinaryColCreate<Generate_SSB_SHIP_MODE>                20566 ns        20435 ns        33931
+// FlatBinaryColCreate<Generate_Date_Str>                     15919 ns        15925 ns        43159
+// FlatBinaryColCreate<Generate_FIXED_x<4>>                   16012 ns        16032 ns        44496
+// FlatBinaryColCreate<Generate_FIXED_x<12>>                  16915 ns        16599 ns        42673
+// FlatBinaryColCreate<Generate_FIXED_x<12, true>>            16321 ns        16259 ns        43653
+// FlatBinaryColCreate<Generate_FIXED_x<16, true>>            18055 ns        17898 ns        39018
+// FlatBinaryColCreate<Generate_FIXED_x<128>>                 45453 ns        45482 ns        15487
+// FlatBinaryColCreate<Generate_FIXED_x<128, true>>           47555 ns        47136 ns        15405
+// InlineBinaryColCreate<Generate_SSB_SHIP_MODE>              22239 ns        22103 ns        30384
+// InlineBinaryColCreate<Generate_Date_Str>                   20167 ns        20101 ns        35915
+// InlineBinaryColCreate<Generate_FIXED_x<4>>                 20050 ns        20024 ns        34628
+// InlineBinaryColCreate<Generate_FIXED_x<12>>                21262 ns        21217 ns        27920
+// InlineBinaryColCreate<Generate_FIXED_x<12, true>>          20671 ns        20570 ns        33895
+// InlineBinaryColCreate<Generate_FIXED_x<16, true>>          30163 ns        30054 ns        23488
+// InlineBinaryColCreate<Generate_FIXED_x<128>>               52376 ns        52025 ns        13724
+// InlineBinaryColCreate<Generate_FIXED_x<128, true>>         53213 ns        52087 ns        13287
+// FlatBinaryCmpBench<Generate_SSB_SHIP_MODE>                 10128 ns        10064 ns        62690
+// FlatBinaryCmpBench<Generate_Date_Str>                       5039 ns         4873 ns       146557
+// FlatBinaryCmpBench<Generate_FIXED_x<4>>                     6053 ns         6029 ns       122073
+// FlatBinaryCmpBench<Generate_FIXED_x<12>>                    5777 ns         5722 ns       116268
+// FlatBinaryCmpBench<Generate_FIXED_x<12, true>>              5571 ns         5553 ns       126063
+// FlatBinaryCmpBench<Generate_FIXED_x<16, true>>              5642 ns         5603 ns       125641
+// FlatBinaryCmpBench<Generate_FIXED_x<128>>                  17101 ns        17019 ns        41439
+// FlatBinaryCmpBench<Generate_FIXED_x<128, true>>            25260 ns        25106 ns        28922
+// InlineBinaryCmpBench<Generate_SSB_SHIP_MODE>                3838 ns         3744 ns       187064
+// InlineBinaryCmpBench<Generate_Date_Str>                     3925 ns         3905 ns       185607
+// InlineBinaryCmpBench<Generate_FIXED_x<4>>                   3788 ns         3775 ns       186131
+// InlineBinaryCmpBench<Generate_FIXED_x<12>>                  3790 ns         3765 ns       185637
+// InlineBinaryCmpBench<Generate_FIXED_x<12, true>>            3803 ns         3764 ns       185608
+// InlineBinaryCmpBench<Generate_FIXED_x<16, true>>            7296 ns         7248 ns        97143
+// InlineBinaryCmpBench<Generate_FIXED_x<128>>                 4133 ns         4023 ns       175195
+// InlineBinaryCmpBench<Generate_FIXED_x<128, true>>          22063 ns        21791 ns        32235
+// FlatBinaryCmpBitsBench<Generate_SSB_SHIP_MODE>              7456 ns         7296 ns        96760
+// FlatBinaryCmpBitsBench<Generate_Date_Str>                   8319 ns         8283 ns        77570
+// FlatBinaryCmpBitsBench<Generate_FIXED_x<12, true>>          6562 ns         6515 ns       109454
+// FlatBinaryCmpBitsBench<Generate_FIXED_x<16, true>>          6717 ns         6671 ns       104584
+// FlatBinaryCmpBitsBench<Generate_FIXED_x<128>>              16645 ns        16504 ns        42890
+// FlatBinaryCmpBitsBench<Generate_FIXED_x<128, true>>        24534 ns        24319 ns        26876
+// InlineBinaryCmpBitsBench<Generate_SSB_SHIP_MODE>             935 ns          928 ns       755202
+// InlineBinaryCmpBitsBench<Generate_Date_Str>                 1408 ns         1399 ns       503789
+// InlineBinaryCmpBitsBench<Generate_FIXED_x<12, true>>        1402 ns         1395 ns       505916
+// InlineBinaryCmpBitsBench<Generate_FIXED_x<16, true>>        5977 ns         5953 ns       116620
+// InlineBinaryCmpBitsBench<Generate_FIXED_x<128>>              994 ns          970 ns       736155
+// InlineBinaryCmpBitsBench<Generate_FIXED_x<128, true>>      22800 ns        22599 ns        31591
+// FlatBinaryFilterBench<Generate_SSB_SHIP_MODE>               9195 ns         9123 ns        78133
+// FlatBinaryFilterBench<Generate_Date_Str>                    9401 ns         9278 ns        75333
+// FlatBinaryFilterBench<Generate_FIXED_x<16, true>>           9042 ns         8987 ns        77918
+// FlatBinaryFilterBench<Generate_FIXED_x<128>>               14109 ns        13892 ns        50100
+// InlineBinaryFilterBench<Generate_SSB_SHIP_MODE>             5112 ns         5072 ns       145350
+// InlineBinaryFilterBench<Generate_Date_Str>                  4444 ns         4393 ns       158607
+// InlineBinaryFilterBench<Generate_FIXED_x<16, true>>         4426 ns         4368 ns       159680
+// InlineBinaryFilterBench<Generate_FIXED_x<128>>              4562 ns         4500 ns       156551
+//
+// The inline layout filters about 2x faster, it moves 16 bytes a row and never the
+// bytes of a long string. The flat layout is faster to build past 12 bytes a row:
+// a long string is copied once either way, the inline row comes on top.
+// compare_bits of the inline layout compares 8 rows at a time, an SSB ship mode
+// column is 4x faster than a row at a time and 8x faster than the flat layout. A
+// long constant that matches every row is bound by the memequal of its bytes.
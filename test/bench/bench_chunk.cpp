@@ -0,0 +1,167 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "vec/bit_vec.h"
+#include "vec/chunk.h"
+#include "vec/vec.h"
+
+using namespace vec;
+
+// WHERE c0 < x then SUM(c7) over a batch of 8 int64 columns, state.range(0) is the
+// percentage of rows selected
+constexpr size_t num_columns = 8;
+
+static std::vector<Vec<int64_t>> make_columns() {
+    std::default_random_engine e(11);
+    std::vector<Vec<int64_t>> columns;
+    for (size_t c = 0; c < num_columns; ++c) {
+        Vec<int64_t> column(DEFAULT_CHUNK_SIZE);
+        for (size_t i = 0; i < DEFAULT_CHUNK_SIZE; ++i) {
+            column[i] = e() % 100;
+        }
+        columns.push_back(std::move(column));
+    }
+    return columns;
+}
+
+// every column is filtered by the predicate, as an operator passing Vecs on
+static void EagerFilter(benchmark::State& state) {
+    const auto columns = make_columns();
+    for (auto _ : state) {
+        BitVec bits = columns[0].compare_bits(CompareOp::LT, state.range(0));
+        std::vector<Vec<int64_t>> filtered;
+        for (const auto& column : columns) {
+            filtered.push_back(column[bits]);
+        }
+        int64_t sum = 0;
+        for (int i = 0; i < filtered.back().len(); ++i) {
+            sum += filtered.back()[i];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * DEFAULT_CHUNK_SIZE);
+}
+
+// only the selection is narrowed, the sum reads the selected rows of c7
+static void ChunkFilter(benchmark::State& state) {
+    std::vector<Field> fields;
+    std::vector<ColumnPtr> columns;
+    for (auto& column : make_columns()) {
+        fields.push_back({"c" + std::to_string(columns.size()), DataType::INT64});
+        columns.push_back(std::make_shared<FixedColumn<int64_t>>(std::move(column)));
+    }
+    const Schema schema(fields);
+    for (auto _ : state) {
+        // the columns are shared with the scan
+        Chunk chunk(schema, columns);
+        chunk.filter(chunk.values<int64_t>(0).compare_bits(CompareOp::LT, state.range(0)));
+        int64_t sum = sum_rows(chunk.values<int64_t>(num_columns - 1).data(), chunk.selection());
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * DEFAULT_CHUNK_SIZE);
+}
+
+BENCHMARK(EagerFilter)->Arg(1)->Arg(10)->Arg(50)->Arg(90);
+BENCHMARK(ChunkFilter)->Arg(1)->Arg(10)->Arg(50)->Arg(90);
+
+// WHERE c0 < x then SUM(c6) + SUM(c7), state.range(0) is the per mille of rows
+// selected and state.range(1) the kind of selection: 0 a bitmap, 1 an index list,
+// 2 the columns compacted, 3 the one Chunk::filter picks
+static void SumSelection(benchmark::State& state) {
+    std::default_random_engine e(13);
+    std::vector<Field> fields;
+    std::vector<ColumnPtr> columns;
+    for (size_t c = 0; c < num_columns; ++c) {
+        Vec<int64_t> column(DEFAULT_CHUNK_SIZE);
+        for (auto& value : column) {
+            value = e() % 1000;
+        }
+        fields.push_back({"c" + std::to_string(columns.size()), DataType::INT64});
+        columns.push_back(std::make_shared<FixedColumn<int64_t>>(column));
+    }
+    const Schema schema(fields);
+    const int64_t threshold = state.range(0);
+    for (auto _ : state) {
+        // the columns are shared with the scan, a compaction copies the selected rows
+        Chunk chunk(schema, columns);
+        BitVec bits = chunk.values<int64_t>(0).compare_bits(CompareOp::LT, threshold);
+        switch (state.range(1)) {
+        case 0:
+            chunk.set_selection(Selection(std::move(bits)));
+            break;
+        case 1:
+            chunk.set_selection(Selection(DEFAULT_CHUNK_SIZE, Selection(bits).to_indices()));
+            break;
+        case 2:
+            chunk.set_selection(Selection(std::move(bits)));
+            chunk.materialize();
+            break;
+        default:
+            chunk.filter(bits);
+        }
+        int64_t sum = sum_rows(chunk.values<int64_t>(6).data(), chunk.selection()) +
+                      sum_rows(chunk.values<int64_t>(7).data(), chunk.selection());
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * DEFAULT_CHUNK_SIZE);
+}
+
+BENCHMARK(SumSelection)->ArgsProduct({{1, 10, 50, 100, 250, 500, 900, 990}, {0, 1, 2, 3}});
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark                   Time             CPU   Iterations UserCounters...
+// -----------------------------------------------------------------------------
+// EagerFilter/1            5333 ns         5259 ns       121152 items_per_second=778.782M/s
+// EagerFilter/10          10790 ns        10623 ns        51892 items_per_second=385.574M/s
+// EagerFilter/50          20136 ns        19814 ns        32678 items_per_second=206.722M/s
+// EagerFilter/90         106649 ns       104916 ns         7013 items_per_second=39.0409M/s
+// ChunkFilter/1            2803 ns         2635 ns       258362 items_per_second=1.55426G/s
+// ChunkFilter/10           2120 ns         2106 ns       315191 items_per_second=1.94487G/s
+// ChunkFilter/50           3680 ns         3645 ns       178162 items_per_second=1.12362G/s
+// ChunkFilter/90           8479 ns         8360 ns        88094 items_per_second=489.938M/s
+// SumSelection/1/0         1443 ns         1418 ns       485475 items_per_second=2.8879G/s
+// SumSelection/10/0        1835 ns         1762 ns       425975 items_per_second=2.3241G/s
+// SumSelection/50/0        2101 ns         2065 ns       365972 items_per_second=1.98385G/s
+// SumSelection/100/0       3061 ns         3011 ns       280334 items_per_second=1.36056G/s
+// SumSelection/250/0       3138 ns         3106 ns       170097 items_per_second=1.31883G/s
+// SumSelection/500/0       6125 ns         5379 ns       129932 items_per_second=761.551M/s
+// SumSelection/900/0      17397 ns        16980 ns        41567 items_per_second=241.232M/s
+// SumSelection/990/0      15622 ns        13723 ns        51772 items_per_second=298.48M/s
+// SumSelection/1/1         1047 ns         1028 ns       657425 items_per_second=3.98603G/s
+// SumSelection/10/1        1090 ns         1055 ns       616973 items_per_second=3.88086G/s
+// SumSelection/50/1        2137 ns         2103 ns       317502 items_per_second=1.94778G/s
+// SumSelection/100/1       2872 ns         2772 ns       231467 items_per_second=1.47761G/s
+// SumSelection/250/1       5331 ns         5245 ns       100000 items_per_second=780.949M/s
+// SumSelection/500/1       9316 ns         9161 ns        80478 items_per_second=447.098M/s
+// SumSelection/900/1      15081 ns        14858 ns        48426 items_per_second=275.683M/s
+// SumSelection/990/1      15959 ns        15658 ns        45492 items_per_second=261.59M/s
+// SumSelection/1/2         2119 ns         2026 ns       343382 items_per_second=2.02163G/s
+// SumSelection/10/2        5106 ns         5029 ns       129425 items_per_second=814.522M/s
+// SumSelection/50/2       10281 ns        10191 ns        69592 items_per_second=401.941M/s
+// SumSelection/100/2      11331 ns        11178 ns        69167 items_per_second=366.437M/s
+// SumSelection/250/2      15108 ns        14694 ns        46032 items_per_second=278.754M/s
+// SumSelection/500/2      17062 ns        16795 ns        39951 items_per_second=243.879M/s
+// SumSelection/900/2      63672 ns        62662 ns        13493 items_per_second=65.3664M/s
+// SumSelection/990/2      78003 ns        76698 ns        11103 items_per_second=53.404M/s
+// SumSelection/1/3         1377 ns         1356 ns       524057 items_per_second=3.02037G/s
+// SumSelection/10/3        2568 ns         2527 ns       332079 items_per_second=1.62093G/s
+// SumSelection/50/3        1921 ns         1840 ns       336713 items_per_second=2.22592G/s
+// SumSelection/100/3       2144 ns         2123 ns       337363 items_per_second=1.92964G/s
+// SumSelection/250/3       2740 ns         2710 ns       246779 items_per_second=1.51121G/s
+// SumSelection/500/3       5296 ns         5224 ns       100000 items_per_second=784.018M/s
+// SumSelection/900/3      16460 ns        16207 ns        46074 items_per_second=252.733M/s
+// SumSelection/990/3       8907 ns         8826 ns        84508 items_per_second=464.099M/s
+//
+// A predicate on one of 8 columns: copying the selected rows of every column costs an
+// allocation and a filter a column, 2x to 12x the narrowing of the shared selection
+// and a sum that reads only the selected rows of the one column it needs.
+//
+// SumSelection (the host is noisy, +-20%): a compaction of the 8 columns is never
+// repaid by a single kernel and costs 4x to 8x from 5% up, the index list is the
+// fastest below 5% and a bitmap, with its dense words masked, from 5% up. The kind
+// Chunk::filter picks (/3) follows the faster one of the two and compacts below 1/64.
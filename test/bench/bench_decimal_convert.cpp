@@ -10,6 +10,9 @@
 #include <string_view>
 #include <vector>
 
+#include "vec/cpu_dispatch.h"
+#include "vec/decimal_vec.h"
+
 inline unsigned __int128 gbswap_128(unsigned __int128 host_int) {
     return static_cast<unsigned __int128>(bswap_64(static_cast<uint64_t>(host_int >> 64))) |
            (static_cast<unsigned __int128>(bswap_64(static_cast<uint64_t>(host_int))) << 64);
@@ -177,6 +180,91 @@ BENCHMARK(ScalarImpl);
 BENCHMARK(SSEImpl);
 BENCHMARK(SSENullableImpl);
 BENCHMARK(ScalarNullableImpl);
+
+// DecimalVec of 4096 rows: values of 9 digits and state.range(0) bytes, a null map
+// with a tenth of the rows null when state.range(1) is 1
+static std::vector<uint8_t> make_decimal_bytes(int binsz, int num_rows, int shift = 0) {
+    std::default_random_engine e(42);
+    std::vector<uint8_t> bytes(binsz * num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        __int128 value = (int64_t(e() % 1000000000) - 500000000) * (__int128(1) << shift);
+        for (int k = binsz - 1; k >= 0; --k, value >>= 8) {
+            bytes[i * binsz + k] = static_cast<uint8_t>(value);
+        }
+    }
+    return bytes;
+}
+
+static void DecimalDecode(benchmark::State& state) {
+    const int binsz = state.range(0);
+    const auto bytes = make_decimal_bytes(binsz, 4096);
+    std::vector<uint8_t> nulls(4096);
+    for (size_t i = 0; i < nulls.size(); i += 10) {
+        nulls[i] = 1;
+    }
+    for (auto _ : state) {
+        auto column = vec::DecimalVec::decode(18, 2, bytes.data(), binsz, 4096,
+                                              state.range(1) ? nulls.data() : nullptr);
+        benchmark::DoNotOptimize(column.values().data().data());
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+BENCHMARK(DecimalDecode)->ArgsProduct({{8, 12, 16}, {0, 1}});
+
+// values of 9 digits, 28 past DECIMAL(18)
+static vec::DecimalVec make_decimal(int precision, int scale) {
+    const auto bytes = make_decimal_bytes(16, 4096, precision > 18 ? 64 : 0);
+    return vec::DecimalVec::decode(precision, scale, bytes.data(), 16, 4096);
+}
+
+// a + b at the same scale (/0) or with b rescaled from 2 to 4 (/1)
+static void DecimalAdd(benchmark::State& state) {
+    const auto a = make_decimal(18, 4);
+    const auto b = make_decimal(18, state.range(0) ? 2 : 4);
+    for (auto _ : state) {
+        auto sum = a + b;
+        benchmark::DoNotOptimize(sum.values().data().data());
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+BENCHMARK(DecimalAdd)->Arg(0)->Arg(1);
+
+// from scale 6 to state.range(0), values of DECIMAL(18) (/1) or of 28 digits in a
+// DECIMAL(38) (/0)
+static void DecimalRescale(benchmark::State& state) {
+    const auto a = make_decimal(state.range(1) ? 18 : 38, 6);
+    for (auto _ : state) {
+        auto res = a.rescale(state.range(0));
+        benchmark::DoNotOptimize(res.values().data().data());
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+BENCHMARK(DecimalRescale)->ArgsProduct({{2, 8}, {0, 1}});
+
+// WHERE a < 1.00 at state.range(0) the SimdLevel
+static void DecimalCompare(benchmark::State& state) {
+    auto level = static_cast<vec::SimdLevel>(state.range(0));
+    if (level > vec::CpuInfo::host().max_level()) {
+        state.SkipWithError("not supported on this host");
+        return;
+    }
+    vec::set_simd_level(level);
+    const auto a = make_decimal(18, 2);
+    for (auto _ : state) {
+        auto bits = a.compare_bits(vec::CompareOp::LT, 100, 2);
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+    vec::set_simd_level(vec::CpuInfo::host().max_level());
+}
+
+BENCHMARK(DecimalCompare)
+        ->Arg(static_cast<int>(vec::SimdLevel::SCALAR))
+        ->Arg(static_cast<int>(vec::SimdLevel::AVX512));
+
 BENCHMARK_MAIN();
 
 // -------------------------------------------------------------
@@ -185,4 +273,30 @@ BENCHMARK_MAIN();
 // ScalarImpl               4562 ns         4562 ns       153302
 // SSEImpl                  2255 ns         2255 ns       310874
 // SSENullableImpl          2170 ns         2170 ns       323321
-// ScalarNullableImpl       6130 ns         6130 ns       110974
\ No newline at end of file
+// ScalarNullableImpl       6130 ns         6130 ns       110974
+//
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark                   Time             CPU   Iterations UserCounters...
+// -----------------------------------------------------------------------------
+// DecimalDecode/8/0        3647 ns         3492 ns       245682 items_per_second=1.17296G/s
+// DecimalDecode/12/0       3539 ns         3460 ns       187094 items_per_second=1.18394G/s
+// DecimalDecode/16/0       3685 ns         3460 ns       216092 items_per_second=1.18389G/s
+// DecimalDecode/8/1        7848 ns         7669 ns        89858 items_per_second=534.093M/s
+// DecimalDecode/12/1       7613 ns         7441 ns        95499 items_per_second=550.447M/s
+// DecimalDecode/16/1       7297 ns         6980 ns       105216 items_per_second=586.778M/s
+// DecimalAdd/0             7155 ns         7105 ns        96083 items_per_second=576.483M/s
+// DecimalAdd/1             9044 ns         8877 ns        66444 items_per_second=461.418M/s
+// DecimalRescale/2/0     122843 ns       120582 ns         5719 items_per_second=33.9685M/s
+// DecimalRescale/8/0      21247 ns        20797 ns        33172 items_per_second=196.956M/s
+// DecimalRescale/2/1      25838 ns        25196 ns        28726 items_per_second=162.565M/s
+// DecimalRescale/8/1       9343 ns         8975 ns        77508 items_per_second=456.39M/s
+// DecimalCompare/0         7496 ns         7422 ns        94565 items_per_second=551.899M/s
+// DecimalCompare/3         2151 ns         2120 ns       359298 items_per_second=1.93228G/s
+//
+// The host is noisy, +-20%. A null map used to cost a decode of the packed values and a
+// spread of them to their rows, 12.7us to 13.8us: the spread is now in the decode, src
+// moves past the non-null rows only (an expand load of 4 rows with VBMI2), and the
+// masking of the null rows of int128 is a masked store. A rescale down of values that
+// fit an int64 divides by a constant, 4.8x the int128 division (/2/1 against /2/0);
+// a rescale up past 38 digits checks every row for the overflow (/8/0). The int128
+// compare is 3.5x faster with AVX-512 than the scalar loop.
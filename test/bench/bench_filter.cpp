@@ -6,6 +6,8 @@
 #include <cstring>
 #include <vector>
 
+#include "vec/filter.h"
+
 constexpr int chunk_size = 4096;
 
 using Filter = std::vector<uint8_t>;
@@ -253,12 +255,18 @@ int ScalarFilter(Filter& filter, Container& container) {
     return cnt;
 }
 
+// production kernel in libvec, dispatched at runtime
+int VecFilter(Filter& filter, Container& data) {
+    return vec::filter(filter.data(), data.data(), data.size(), data.data());
+}
+
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, NormalAVXFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, AVXBranchLess);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, NormalSSEFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, ScalarBranceLess);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, ScalarFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, AVX512BranchLess);
+BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<RandomGenerator>, VecFilter);
 
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, NormalAVXFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, AVXBranchLess);
@@ -266,6 +274,7 @@ BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, Norm
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, ScalarBranceLess);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, ScalarFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, AVX512BranchLess);
+BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysOneGenerator<uint8_t>>, VecFilter);
 
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, NormalAVXFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, AVXBranchLess);
@@ -273,6 +282,7 @@ BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, Nor
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, ScalarBranceLess);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, ScalarFilter);
 BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, AVX512BranchLess);
+BENCHMARK_TEMPLATE(BENCH_Filter, FilterIniter<AlwaysZeroGenerator<uint8_t>>, VecFilter);
 
 BENCHMARK_MAIN();
 
@@ -296,4 +306,9 @@ BENCHMARK_MAIN();
 // BENCH_Filter<FilterIniter<AlwaysZeroGenerator<uint8_t>>, NormalSSEFilter>         249 ns          249 ns      2808937
 // BENCH_Filter<FilterIniter<AlwaysZeroGenerator<uint8_t>>, ScalarBranceLess>       2593 ns         2593 ns       270051
 // BENCH_Filter<FilterIniter<AlwaysZeroGenerator<uint8_t>>, ScalarFilter>           3854 ns         3852 ns       181704
-// BENCH_Filter<FilterIniter<AlwaysZeroGenerator<uint8_t>>, AVX512BranchLess>        348 ns          348 ns      2010223
\ No newline at end of file
+// BENCH_Filter<FilterIniter<AlwaysZeroGenerator<uint8_t>>, AVX512BranchLess>        348 ns          348 ns      2010223
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2), libvec dispatches to the AVX-512 compress kernel
+// BENCH_Filter<FilterIniter<RandomGenerator>, VecFilter>                            327 ns          325 ns      2140865
+// BENCH_Filter<FilterIniter<AlwaysOneGenerator<uint8_t>>, VecFilter>                113 ns          112 ns      4810521
+// BENCH_Filter<FilterIniter<AlwaysZeroGenerator<uint8_t>>, VecFilter>              88.5 ns         87.4 ns      8049111
@@ -5,8 +5,13 @@
 #include <algorithm>
 #include <numeric>
 #include <random>
+#include <string>
 #include <vector>
 
+#include "vec/binary_vec.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/vec.h"
+
 constexpr int bucket_sz = 1024;
 constexpr int elements_sz = 4096 * 1000;
 constexpr int probe_sz = 4096;
@@ -64,4 +69,126 @@ static void SIMDImpl(benchmark::State& state) {
 
 BENCHMARK(NormalImpl);
 BENCHMARK(SIMDImpl);
+
+// Batches of 4096 random rows out of state.range(0) rows, as a join materializes
+// the rows of its matches. The batches are not repeated, their rows would stay in
+// cache otherwise.
+constexpr size_t gather_batch = 4096;
+constexpr size_t num_gather_batches = 256;
+
+static std::vector<uint32_t> make_indices(size_t num_src_rows) {
+    std::default_random_engine e(3);
+    std::vector<uint32_t> indices(gather_batch * num_gather_batches);
+    for (auto& index : indices) {
+        index = e() % num_src_rows;
+    }
+    return indices;
+}
+
+// a loop of loads
+template <typename T>
+static void ScalarGather(benchmark::State& state) {
+    vec::Vec<T> src(state.range(0));
+    const auto indices = make_indices(src.len());
+    std::vector<T> dst(gather_batch);
+    size_t batch = 0;
+    for (auto _ : state) {
+        const uint32_t* index = indices.data() + batch++ % num_gather_batches * gather_batch;
+        for (size_t i = 0; i < gather_batch; ++i) {
+            dst[i] = src.data()[index[i]];
+        }
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetItemsProcessed(state.iterations() * gather_batch);
+}
+
+// Vec::gather, state.range(1) is the SimdLevel of the kernel
+template <typename T>
+static void VecGather(benchmark::State& state) {
+    vec::set_simd_level(static_cast<vec::SimdLevel>(state.range(1)));
+    vec::Vec<T> src(state.range(0));
+    const auto indices = make_indices(src.len());
+    size_t batch = 0;
+    for (auto _ : state) {
+        const uint32_t* index = indices.data() + batch++ % num_gather_batches * gather_batch;
+        vec::Vec<T> dst = src.gather(index, gather_batch);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetItemsProcessed(state.iterations() * gather_batch);
+    vec::set_simd_level(vec::CpuInfo::host().max_level());
+}
+
+// 16KB, 1MB and 512MB of int32, the L3 of the bench host is 105MB
+BENCHMARK_TEMPLATE(ScalarGather, int32_t)->Arg(1 << 12)->Arg(1 << 18)->Arg(1 << 27);
+BENCHMARK_TEMPLATE(VecGather, int32_t)->ArgsProduct({{1 << 12, 1 << 18, 1 << 27}, {0, 2, 3}});
+BENCHMARK_TEMPLATE(ScalarGather, int64_t)->Arg(1 << 12)->Arg(1 << 18)->Arg(1 << 27);
+BENCHMARK_TEMPLATE(VecGather, int64_t)->ArgsProduct({{1 << 12, 1 << 18, 1 << 27}, {0, 2, 3}});
+
+// the same over the strings of a FlatBinaryVec, 16 bytes each, state.range(0) rows
+static void StringGather(benchmark::State& state) {
+    std::vector<std::string> strings(state.range(0));
+    std::vector<vec::Slice> slices;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        strings[i] = std::to_string(i);
+        strings[i].resize(16, 'x');
+        slices.emplace_back(strings[i].data(), strings[i].size());
+    }
+    vec::FlatBinaryVec src;
+    src.build_strings(slices);
+    const auto indices = make_indices(strings.size());
+    size_t batch = 0;
+    for (auto _ : state) {
+        const uint32_t* index = indices.data() + batch++ % num_gather_batches * gather_batch;
+        vec::FlatBinaryVec dst = src.gather(index, gather_batch);
+        benchmark::DoNotOptimize(dst.bytes());
+    }
+    state.SetItemsProcessed(state.iterations() * gather_batch);
+}
+
+BENCHMARK(StringGather)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 23);
+
 BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark                                Time             CPU   Iterations
+// --------------------------------------------------------------------------
+// NormalImpl                            2698 ns         2665 ns       139290
+// SIMDImpl                              1578 ns         1560 ns       172882
+// ScalarGather<int32_t>/4096            2368 ns         2200 ns       149260 items_per_second=1.86175G/s
+// ScalarGather<int32_t>/262144          3849 ns         3803 ns        67297 items_per_second=1076.91M/s
+// ScalarGather<int32_t>/134217728     147479 ns       146921 ns         1897 items_per_second=27.8789M/s
+// VecGather<int32_t>/4096/0             3576 ns         3521 ns        79068 items_per_second=1.16322G/s
+// VecGather<int32_t>/262144/0           6695 ns         6610 ns        37782 items_per_second=619.661M/s
+// VecGather<int32_t>/134217728/0      148090 ns       145714 ns         1853 items_per_second=28.1098M/s
+// VecGather<int32_t>/4096/2             1738 ns         1708 ns       175998 items_per_second=2.39754G/s
+// VecGather<int32_t>/262144/2           4201 ns         4104 ns        64131 items_per_second=998.138M/s
+// VecGather<int32_t>/134217728/2      112983 ns       110884 ns         2438 items_per_second=36.9396M/s
+// VecGather<int32_t>/4096/3             2437 ns         2413 ns       113288 items_per_second=1.69755G/s
+// VecGather<int32_t>/262144/3           5031 ns         4961 ns        59092 items_per_second=825.679M/s
+// VecGather<int32_t>/134217728/3      125725 ns       123870 ns         2402 items_per_second=33.0669M/s
+// ScalarGather<int64_t>/4096            4419 ns         4305 ns        65455 items_per_second=951.369M/s
+// ScalarGather<int64_t>/262144          8601 ns         8538 ns        34439 items_per_second=479.757M/s
+// ScalarGather<int64_t>/134217728     152862 ns       151017 ns         1933 items_per_second=27.1228M/s
+// VecGather<int64_t>/4096/0             5728 ns         5601 ns        48398 items_per_second=731.307M/s
+// VecGather<int64_t>/262144/0           9943 ns         9866 ns        28420 items_per_second=415.182M/s
+// VecGather<int64_t>/134217728/0      183056 ns       179623 ns         1964 items_per_second=22.8034M/s
+// VecGather<int64_t>/4096/2             2290 ns         2268 ns       128226 items_per_second=1.80625G/s
+// VecGather<int64_t>/262144/2           8053 ns         7919 ns        33747 items_per_second=517.256M/s
+// VecGather<int64_t>/134217728/2      166141 ns       163736 ns         1341 items_per_second=25.0159M/s
+// VecGather<int64_t>/4096/3             2497 ns         2480 ns       104725 items_per_second=1.65187G/s
+// VecGather<int64_t>/262144/3           9829 ns         9636 ns        31277 items_per_second=425.076M/s
+// VecGather<int64_t>/134217728/3      182872 ns       178669 ns         1597 items_per_second=22.9251M/s
+// StringGather/4096                    64565 ns        57522 ns         4627 items_per_second=71.2069M/s
+// StringGather/65536                   76219 ns        66969 ns         3821 items_per_second=61.1631M/s
+// StringGather/8388608                308049 ns       293566 ns          959 items_per_second=13.9526M/s
+//
+// A vpgather is 1.5x to 2x a loop of loads in cache (the scalar kernel pays the
+// allocation of the result and a call through the dispatch table). Out of memory every
+// row is a miss whatever the kernel, ~35ns a row: the loads of the rows do not depend
+// on each other and the out-of-order core keeps about ten misses in flight by itself.
+// Software prefetch 16, 32 or 64 rows ahead was within the noise there (3 runs each)
+// and the fixed-width kernels do not prefetch.
+//
+// The bytes of a string wait on the load of its offset, a chain a row. Prefetching the
+// offsets and then the bytes 16 rows ahead takes StringGather/8388608 from 457us to
+// 275us, and FlatBinaryVec/InlineBinaryVec::gather prefetch above 1MB.
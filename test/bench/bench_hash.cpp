@@ -0,0 +1,208 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vec/binary_vec.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/hash.h"
+
+// hashes of a 4096 row column, state.range(0) is the HashFunc and state.range(1) the
+// SimdLevel
+
+constexpr int chunk_size = 4096;
+
+constexpr uint32_t seed_of(vec::HashFunc func) {
+    return func == vec::HashFunc::FNV1A    ? vec::FNV1A_SEED
+           : func == vec::HashFunc::CRC32C ? vec::CRC32C_SEED
+                                           : vec::MURMUR3_SEED;
+}
+
+template <typename T>
+static void HashInts(benchmark::State& state) {
+    auto func = static_cast<vec::HashFunc>(state.range(0));
+    auto level = static_cast<vec::SimdLevel>(state.range(1));
+    if (level > vec::CpuInfo::host().max_level()) {
+        state.SkipWithError("not supported on this host");
+        return;
+    }
+    vec::set_simd_level(level);
+    std::default_random_engine e(42);
+    std::vector<T> keys(chunk_size);
+    for (auto& key : keys) {
+        key = static_cast<T>(e() * uint64_t(0x9E3779B97F4A7C15));
+    }
+    std::vector<uint32_t> hashes(chunk_size);
+    for (auto _ : state) {
+        vec::hash_column(func, keys.data(), keys.size(), seed_of(func), hashes.data());
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+    vec::set_simd_level(vec::CpuInfo::host().max_level());
+}
+
+static void HashInt32(benchmark::State& state) {
+    HashInts<int32_t>(state);
+}
+
+static void HashInt64(benchmark::State& state) {
+    HashInts<int64_t>(state);
+}
+
+static const std::vector<std::vector<int64_t>> int_args = {
+        {static_cast<int>(vec::HashFunc::FNV1A), static_cast<int>(vec::HashFunc::CRC32C),
+         static_cast<int>(vec::HashFunc::MURMUR3)},
+        {static_cast<int>(vec::SimdLevel::SCALAR), static_cast<int>(vec::SimdLevel::SSE42),
+         static_cast<int>(vec::SimdLevel::AVX2), static_cast<int>(vec::SimdLevel::AVX512)}};
+
+BENCHMARK(HashInt32)->ArgsProduct(int_args);
+BENCHMARK(HashInt64)->ArgsProduct(int_args);
+
+// strings of 4 to 20 bytes, state.range(0) is the HashFunc, state.range(1) the layout
+// (0 Slice, 1 FlatBinaryVec, 2 InlineBinaryVec)
+static void HashStrings(benchmark::State& state) {
+    auto func = static_cast<vec::HashFunc>(state.range(0));
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int> size(4, 20);
+    std::vector<std::string> strings(chunk_size);
+    std::vector<vec::Slice> slices;
+    for (auto& s : strings) {
+        s.resize(size(e));
+        for (auto& c : s) {
+            c = 'a' + e() % 26;
+        }
+        slices.emplace_back(s.data(), s.size());
+    }
+    vec::FlatBinaryVec flat;
+    flat.build_strings(slices);
+    vec::InlineBinaryVec inlined;
+    inlined.build_strings(slices);
+    std::vector<uint32_t> hashes(chunk_size);
+    for (auto _ : state) {
+        if (state.range(1) == 0) {
+            vec::hash_column(func, slices.data(), slices.size(), seed_of(func), hashes.data());
+        } else if (state.range(1) == 1) {
+            vec::hash_column(func, flat, seed_of(func), hashes.data());
+        } else {
+            vec::hash_column(func, inlined, seed_of(func), hashes.data());
+        }
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(HashStrings)
+        ->ArgsProduct({{static_cast<int>(vec::HashFunc::FNV1A),
+                        static_cast<int>(vec::HashFunc::CRC32C),
+                        static_cast<int>(vec::HashFunc::MURMUR3)},
+                       {0, 1, 2}});
+
+// hash_key() of the same columns, the hash tables' hash a row at a time, and
+// hash_key_sampled() of the strings if state.range(0)
+template <typename T>
+static void HashKeys(benchmark::State& state) {
+    std::default_random_engine e(42);
+    std::vector<T> keys(chunk_size);
+    for (auto& key : keys) {
+        key = static_cast<T>(e() * uint64_t(0x9E3779B97F4A7C15));
+    }
+    std::vector<uint32_t> hashes(chunk_size);
+    for (auto _ : state) {
+        for (int i = 0; i < chunk_size; ++i) {
+            hashes[i] = vec::hash_key(keys[i]);
+        }
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+static void HashKeyInt32(benchmark::State& state) {
+    HashKeys<int32_t>(state);
+}
+
+static void HashKeyInt64(benchmark::State& state) {
+    HashKeys<int64_t>(state);
+}
+
+static void HashKeyStrings(benchmark::State& state) {
+    bool sampled = state.range(0);
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int> size(4, 20);
+    std::vector<std::string> strings(chunk_size);
+    std::vector<vec::Slice> slices;
+    for (auto& s : strings) {
+        s.resize(size(e));
+        for (auto& c : s) {
+            c = 'a' + e() % 26;
+        }
+        slices.emplace_back(s.data(), s.size());
+    }
+    std::vector<uint32_t> hashes(chunk_size);
+    for (auto _ : state) {
+        for (int i = 0; i < chunk_size; ++i) {
+            hashes[i] = sampled ? vec::hash_key_sampled(slices[i]) : vec::hash_key(slices[i]);
+        }
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(HashKeyInt32);
+BENCHMARK(HashKeyInt64);
+BENCHMARK(HashKeyStrings)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// --------------------------------------------------------------------------
+// Benchmark                Time             CPU   Iterations UserCounters...
+// --------------------------------------------------------------------------
+// HashInt32/0/0         9033 ns         8955 ns        84352 items_per_second=457.41M/s
+// HashInt32/1/0        10745 ns        10700 ns        64206 items_per_second=382.821M/s
+// HashInt32/2/0         8799 ns         8745 ns        80948 items_per_second=468.388M/s
+// HashInt32/0/1         8275 ns         8083 ns        89384 items_per_second=506.768M/s
+// HashInt32/1/1         2888 ns         2863 ns       237555 items_per_second=1.43057G/s
+// HashInt32/2/1         8975 ns         8889 ns        80929 items_per_second=460.787M/s
+// HashInt32/0/2         1849 ns         1812 ns       373014 items_per_second=2.26108G/s
+// HashInt32/1/2         2499 ns         2486 ns       291436 items_per_second=1.6476G/s
+// HashInt32/2/2         2764 ns         2743 ns       252048 items_per_second=1.49302G/s
+// HashInt32/0/3         1494 ns         1490 ns       470644 items_per_second=2.74892G/s
+// HashInt32/1/3         2853 ns         2845 ns       258241 items_per_second=1.43984G/s
+// HashInt32/2/3         1719 ns         1712 ns       415693 items_per_second=2.39304G/s
+// HashInt64/0/0        17933 ns        17887 ns        38811 items_per_second=228.995M/s
+// HashInt64/1/0        21124 ns        21040 ns        32606 items_per_second=194.678M/s
+// HashInt64/2/0        13233 ns        13156 ns        53151 items_per_second=311.336M/s
+// HashInt64/0/1        17790 ns        17664 ns        37755 items_per_second=231.88M/s
+// HashInt64/1/1         1946 ns         1928 ns       369539 items_per_second=2.12469G/s
+// HashInt64/2/1        13694 ns        13323 ns        48926 items_per_second=307.435M/s
+// HashInt64/0/2         4373 ns         4298 ns       172122 items_per_second=952.922M/s
+// HashInt64/1/2         1928 ns         1903 ns       374166 items_per_second=2.15216G/s
+// HashInt64/2/2         4508 ns         4473 ns       155932 items_per_second=915.781M/s
+// HashInt64/0/3         2791 ns         2767 ns       247760 items_per_second=1.48052G/s
+// HashInt64/1/3         2077 ns         2060 ns       345457 items_per_second=1.98869G/s
+// HashInt64/2/3         2786 ns         2760 ns       254723 items_per_second=1.48396G/s
+// HashStrings/0/0      61083 ns        60423 ns        11077 items_per_second=67.7891M/s
+// HashStrings/1/0      13873 ns        13739 ns        40491 items_per_second=298.14M/s
+// HashStrings/2/0      51497 ns        51150 ns        13554 items_per_second=80.0776M/s
+// HashStrings/0/1      58352 ns        57579 ns        12336 items_per_second=71.1371M/s
+// HashStrings/1/1      12444 ns        12355 ns        53795 items_per_second=331.523M/s
+// HashStrings/2/1      19841 ns        19707 ns        32035 items_per_second=207.85M/s
+// HashStrings/0/2      53710 ns        53279 ns        13475 items_per_second=76.8785M/s
+// HashStrings/1/2      29493 ns        29295 ns        23132 items_per_second=139.819M/s
+// HashStrings/2/2      29929 ns        29611 ns        24090 items_per_second=138.326M/s
+// HashKeyInt32           3100 ns         3072 ns       235916 items_per_second=1.33321G/s
+// HashKeyInt64           3893 ns         3843 ns       185984 items_per_second=1065.82M/s
+// HashKeyStrings/0      56172 ns        55826 ns        12855 items_per_second=73.3703M/s
+// HashKeyStrings/1       9015 ns         8925 ns        99058 items_per_second=458.922M/s
+//
+// The vector versions hash int32 keys 4-5x faster than a row at a time, FNV1A gains
+// the most (a multiply a byte is a long chain per row). The crc32 instruction is the
+// fastest int64 hash without AVX-512. Strings are bound by their varying sizes, the
+// mispredicted loop exits dominate FNV1A and MURMUR3.
+//
+// hash_key() of a row is a single multiply (a fold and a multiply for int64): 3x
+// faster than the scalar hash_column() and close to its SIMD versions, without their
+// pass over a hashes buffer. hash_key_sampled() reads 16 bytes of a string at most and
+// no loop, 6x faster than hash_key() and 1.5x faster than the crc32 instruction.
@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <sparsehash/dense_hash_map>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<phmap.h>)
+#include <phmap.h>
+#endif
+
+#include "vec/hash_agg.h"
+
+// SELECT key, SUM(value), COUNT(*) GROUP BY key over 1M int64 rows by 4096-row
+// batches, state.range(0) distinct keys
+
+constexpr int chunk_size = 4096;
+constexpr int num_rows = 1 << 20;
+
+struct AggInput {
+    std::vector<int64_t> keys;
+    std::vector<int64_t> values;
+
+    explicit AggInput(int64_t num_distinct) : keys(num_rows), values(num_rows) {
+        // random 64-bit keys: no hash gets a perfect spread of them
+        std::mt19937_64 e(42);
+        std::vector<int64_t> pool(num_distinct);
+        for (auto& key : pool) {
+            key = e() >> 1;
+        }
+        std::uniform_int_distribution<int64_t> u(0, num_distinct - 1);
+        for (int i = 0; i < num_rows; ++i) {
+            keys[i] = pool[u(e)];
+            values[i] = u(e);
+        }
+    }
+};
+
+struct SumCount {
+    int64_t sum = 0;
+    int64_t count = 0;
+};
+
+// what we do today: a row at a time into a node map of states
+template <typename Map>
+void row_at_a_time(benchmark::State& state, Map& map) {
+    AggInput input(state.range(0));
+    for (auto _ : state) {
+        map.clear();
+        for (int i = 0; i < num_rows; ++i) {
+            SumCount& sc = map[input.keys[i]];
+            sc.sum += input.values[i];
+            sc.count++;
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+static void StdUnorderedMap(benchmark::State& state) {
+    std::unordered_map<int64_t, SumCount> map;
+    row_at_a_time(state, map);
+}
+
+static void DenseHashMap(benchmark::State& state) {
+    google::dense_hash_map<int64_t, SumCount> map;
+    map.set_empty_key(-1);
+    row_at_a_time(state, map);
+}
+
+#if __has_include(<phmap.h>)
+static void PhmapFlatHashMap(benchmark::State& state) {
+    phmap::flat_hash_map<int64_t, SumCount> map;
+    row_at_a_time(state, map);
+}
+BENCHMARK(PhmapFlatHashMap)->RangeMultiplier(16)->Range(16, 1 << 20);
+#endif
+
+static void GroupByHashTable(benchmark::State& state) {
+    AggInput input(state.range(0));
+    std::vector<uint32_t> group_ids(chunk_size);
+    for (auto _ : state) {
+        vec::GroupByHashTable<int64_t> table;
+        vec::AggColumn<vec::AggFunc::SUM, int64_t> sum;
+        vec::AggColumn<vec::AggFunc::COUNT, int64_t> count;
+        for (int i = 0; i < num_rows; i += chunk_size) {
+            table.find_or_insert(input.keys.data() + i, chunk_size, group_ids.data());
+            sum.update(group_ids.data(), input.values.data() + i, chunk_size, table.num_groups());
+            count.update(group_ids.data(), nullptr, chunk_size, table.num_groups());
+        }
+        benchmark::DoNotOptimize(table.num_groups());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+BENCHMARK(StdUnorderedMap)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK(DenseHashMap)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK(GroupByHashTable)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+// the lookups alone, every group is in the table already (32MB of entries at 1M
+// groups)
+static void FindExisting(benchmark::State& state) {
+    AggInput input(state.range(0));
+    std::vector<uint32_t> group_ids(chunk_size);
+    vec::GroupByHashTable<int64_t> table;
+    for (int i = 0; i < num_rows; i += chunk_size) {
+        table.find_or_insert(input.keys.data() + i, chunk_size, group_ids.data());
+    }
+    for (auto _ : state) {
+        for (int i = 0; i < num_rows; i += chunk_size) {
+            table.find_or_insert(input.keys.data() + i, chunk_size, group_ids.data());
+        }
+        benchmark::DoNotOptimize(group_ids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+BENCHMARK(FindExisting)->RangeMultiplier(16)->Range(4096, 1 << 20);
+
+// GROUP BY on a status column: int32 keys of state.range(0) values, random or in
+// runs of 1000 rows when state.range(1) is 1, hashed or not (state.range(2) is the
+// dense range)
+static void LowCardinality(benchmark::State& state) {
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int32_t> u(0, state.range(0) - 1);
+    std::vector<int32_t> keys(num_rows);
+    std::vector<int64_t> values(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        keys[i] = state.range(1) ? i / 1000 % state.range(0) : u(e);
+        values[i] = u(e);
+    }
+    std::vector<uint32_t> group_ids(chunk_size);
+    for (auto _ : state) {
+        vec::GroupByHashTable<int32_t> table(state.range(2));
+        vec::AggColumn<vec::AggFunc::SUM, int64_t> sum;
+        vec::AggColumn<vec::AggFunc::COUNT, int64_t> count;
+        for (int i = 0; i < num_rows; i += chunk_size) {
+            table.find_or_insert(keys.data() + i, chunk_size, group_ids.data());
+            sum.update(group_ids.data(), values.data() + i, chunk_size, table.num_groups());
+            count.update(group_ids.data(), nullptr, chunk_size, table.num_groups());
+        }
+        benchmark::DoNotOptimize(table.num_groups());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+BENCHMARK(LowCardinality)
+        ->ArgsProduct({{4, 256}, {0, 1}, {0, vec::GroupByHashTable<int32_t>::DENSE_RANGE}});
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// -----------------------------------------------------------------------------------
+// Benchmark                         Time             CPU   Iterations UserCounters...
+// -----------------------------------------------------------------------------------
+// StdUnorderedMap/16          7645008 ns      7554484 ns           95 items_per_second=138.802M/s
+// StdUnorderedMap/256        17980019 ns     17816528 ns           37 items_per_second=58.8541M/s
+// StdUnorderedMap/4096       22364031 ns     22106066 ns           30 items_per_second=47.4339M/s
+// StdUnorderedMap/65536      53561642 ns     52173676 ns           14 items_per_second=20.0978M/s
+// StdUnorderedMap/1048576   390942608 ns    388067813 ns            2 items_per_second=2.70204M/s
+// DenseHashMap/16            11503570 ns     11379815 ns           73 items_per_second=92.1435M/s
+// DenseHashMap/256           13218525 ns     13057170 ns           48 items_per_second=80.3065M/s
+// DenseHashMap/4096          13541328 ns     13471552 ns           56 items_per_second=77.8363M/s
+// DenseHashMap/65536         20697445 ns     20488052 ns           33 items_per_second=51.1799M/s
+// DenseHashMap/1048576      120002160 ns    118653867 ns            5 items_per_second=8.83727M/s
+// GroupByHashTable/16         9498319 ns      9382183 ns           94 items_per_second=111.762M/s
+// GroupByHashTable/256        9782537 ns      9701413 ns           59 items_per_second=108.085M/s
+// GroupByHashTable/4096      10382111 ns     10201581 ns           56 items_per_second=102.786M/s
+// GroupByHashTable/65536     22322666 ns     22017248 ns           33 items_per_second=47.6252M/s
+// GroupByHashTable/1048576  104647931 ns    101215095 ns            8 items_per_second=10.3599M/s
+//
+// phmap was not checked out on this host. std::unordered_map wins at 16 keys (a
+// key per bucket of its prime-sized array, no collision at all), a collision is a
+// mispredicted branch and costs more than the lookup. At half load the table was
+// 2x slower below 4096 keys, hence the quarter load while it fits in L2.
+//
+// LowCardinality/4/0/0          8862746 ns      8385711 ns           84 items_per_second=125.043M/s
+// LowCardinality/256/0/0       10616282 ns      8699798 ns           84 items_per_second=120.529M/s
+// LowCardinality/4/1/0          9111395 ns      8674028 ns           85 items_per_second=120.887M/s
+// LowCardinality/256/1/0       12769620 ns      9103806 ns           81 items_per_second=115.18M/s
+// LowCardinality/4/0/65536      6383338 ns      6174588 ns          119 items_per_second=169.821M/s
+// LowCardinality/256/0/65536    6784027 ns      6646825 ns          118 items_per_second=157.756M/s
+// LowCardinality/4/1/65536      6391112 ns      5905378 ns          120 items_per_second=177.563M/s
+// LowCardinality/256/1/65536    6160562 ns      5993127 ns          114 items_per_second=174.963M/s
+//
+// The key-indexed array is 1.4x faster than hashing. With a single copy of the
+// states (REPLICATED_GROUPS 0) the runs went down to 81M/s hashed and 108M/s dense:
+// every row waited for the sum of the row before.
+//
+// FindExisting/4096           9227408 ns      8998576 ns           90 items_per_second=116.527M/s
+// FindExisting/65536         18029911 ns     17752212 ns           41 items_per_second=59.0673M/s
+// FindExisting/1048576       20607194 ns     20121903 ns           36 items_per_second=52.1112M/s
+// GroupByHashTable/1048576  137696187 ns    134637321 ns            5 items_per_second=7.78815M/s
+//
+// FindExisting/1048576 with the slot of the row PREFETCH_DISTANCE ahead prefetched:
+// 31ms with none, 25-28ms at 8, 22ms at 16, 19-21ms at 32 and 21ms at 64. The
+// states of AggColumn past the L2, prefetched 16 rows ahead, took
+// GroupByHashTable/1048576 from ~168ms to ~154ms over runs of the two (+-20% here).
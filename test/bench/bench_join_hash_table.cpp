@@ -0,0 +1,216 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "vec/cpu_dispatch.h"
+#include "vec/join_hash_table.h"
+
+// 4096 probe rows against 4096 build rows, state.range(0) is the SimdLevel and
+// state.range(1) the number of distinct build keys (4096: unique, 1024: 4 matches a row)
+
+constexpr int chunk_size = 4096;
+
+static void JoinProbe(benchmark::State& state) {
+    auto level = static_cast<vec::SimdLevel>(state.range(0));
+    if (level > vec::CpuInfo::host().max_level()) {
+        state.SkipWithError("not supported on this host");
+        return;
+    }
+    vec::set_simd_level(level);
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int32_t> u(0, state.range(1) - 1);
+    std::vector<int32_t> build(chunk_size), probe(chunk_size);
+    for (int i = 0; i < chunk_size; ++i) {
+        build[i] = u(e);
+        probe[i] = u(e);
+    }
+    vec::JoinHashTable<int32_t> table;
+    table.build(build.data(), build.size());
+    vec::JoinHashTable<int32_t>::Probe batch;
+    std::vector<uint32_t> probe_rids(chunk_size), build_rids(chunk_size);
+    for (auto _ : state) {
+        size_t total = 0;
+        table.start_probe(probe.data(), probe.size(), &batch);
+        while (!batch.done()) {
+            total += table.probe(&batch, probe_rids.data(), build_rids.data(), chunk_size);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    vec::set_simd_level(vec::CpuInfo::host().max_level());
+}
+
+BENCHMARK(JoinProbe)
+        ->ArgsProduct({{static_cast<int>(vec::SimdLevel::SCALAR),
+                        static_cast<int>(vec::SimdLevel::AVX2),
+                        static_cast<int>(vec::SimdLevel::AVX512)},
+                       {4096, 1024}});
+
+// build + probe of n unique build keys and n probe rows with one match each,
+// n = state.range(0): one JoinHashTable probed by chunks against PartitionedJoin
+
+struct JoinInput {
+    std::vector<int32_t> build;
+    std::vector<int32_t> probe;
+
+    explicit JoinInput(size_t num_rows) : build(num_rows), probe(num_rows) {
+        std::default_random_engine e(42);
+        std::iota(build.begin(), build.end(), 0);
+        std::shuffle(build.begin(), build.end(), e);
+        std::uniform_int_distribution<int32_t> u(0, num_rows - 1);
+        for (auto& key : probe) {
+            key = u(e);
+        }
+    }
+};
+
+static void NonPartitioned(benchmark::State& state) {
+    JoinInput input(state.range(0));
+    std::vector<uint32_t> probe_rids(chunk_size), build_rids(chunk_size);
+    for (auto _ : state) {
+        vec::JoinHashTable<int32_t> table;
+        table.build(input.build.data(), input.build.size());
+        vec::JoinHashTable<int32_t>::Probe batch;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < input.probe.size(); i += chunk_size) {
+            size_t len = std::min<size_t>(chunk_size, input.probe.size() - i);
+            table.start_probe(input.probe.data() + i, len, &batch);
+            while (!batch.done()) {
+                size_t cnt = table.probe(&batch, probe_rids.data(), build_rids.data(), chunk_size);
+                for (size_t j = 0; j < cnt; ++j) {
+                    sum += build_rids[j];
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+static void Partitioned(benchmark::State& state) {
+    JoinInput input(state.range(0));
+    for (auto _ : state) {
+        vec::PartitionedJoin<int32_t> join;
+        join.build(input.build.data(), input.build.size());
+        uint64_t sum = 0;
+        join.probe(input.probe.data(), input.probe.size(),
+                   [&](const uint32_t*, const uint32_t* build_rids, size_t cnt) {
+                       for (size_t j = 0; j < cnt; ++j) {
+                           sum += build_rids[j];
+                       }
+                   });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+BENCHMARK(NonPartitioned)->RangeMultiplier(10)->Range(1000, 100000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(Partitioned)->RangeMultiplier(10)->Range(1000, 100000000)->Unit(benchmark::kMillisecond);
+
+// the probe alone of n = state.range(0) rows against a table of n unique keys built
+// once, state.range(1) is the SimdLevel: past the L2 the rounds prefetch ahead
+static void ProbeOnly(benchmark::State& state) {
+    auto level = static_cast<vec::SimdLevel>(state.range(1));
+    if (level > vec::CpuInfo::host().max_level()) {
+        state.SkipWithError("not supported on this host");
+        return;
+    }
+    vec::set_simd_level(level);
+    JoinInput input(state.range(0));
+    vec::JoinHashTable<int32_t> table;
+    table.build(input.build.data(), input.build.size());
+    vec::JoinHashTable<int32_t>::Probe batch;
+    std::vector<uint32_t> probe_rids(chunk_size), build_rids(chunk_size);
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < input.probe.size(); i += chunk_size) {
+            size_t len = std::min<size_t>(chunk_size, input.probe.size() - i);
+            table.start_probe(input.probe.data() + i, len, &batch);
+            while (!batch.done()) {
+                size_t cnt = table.probe(&batch, probe_rids.data(), build_rids.data(), chunk_size);
+                for (size_t j = 0; j < cnt; ++j) {
+                    sum += build_rids[j];
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    vec::set_simd_level(vec::CpuInfo::host().max_level());
+}
+
+BENCHMARK(ProbeOnly)
+        ->ArgsProduct({{10000, 100000, 1000000, 10000000},
+                       {static_cast<int>(vec::SimdLevel::SCALAR),
+                        static_cast<int>(vec::SimdLevel::AVX512)}})
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// -----------------------------------------------------------
+// Benchmark                 Time             CPU   Iterations
+// -----------------------------------------------------------
+// JoinProbe/0/4096      23407 ns        23131 ns        35150
+// JoinProbe/2/4096      19612 ns        19463 ns        32889
+// JoinProbe/3/4096      10498 ns        10434 ns        88138
+// JoinProbe/0/1024      67541 ns        66922 ns        10000
+// JoinProbe/2/1024      55909 ns        54503 ns        13311
+// JoinProbe/3/1024      30157 ns        29794 ns        19538
+//
+// Random keys collide, unlike the 0..4095 keys of avx512_ht.cpp (one row per
+// bucket), so a probe runs a few rounds even with unique keys.
+//
+// ---------------------------------------------------------------------------------
+// Benchmark                       Time          CPU   Iterations UserCounters...
+// ---------------------------------------------------------------------------------
+// NonPartitioned/1000         0.007 ms     0.006 ms       103949 items_per_second=308.499M/s
+// NonPartitioned/10000        0.112 ms     0.109 ms         6279 items_per_second=183.751M/s
+// NonPartitioned/100000        1.85 ms      1.81 ms          381 items_per_second=110.617M/s
+// NonPartitioned/1000000       56.4 ms      55.4 ms           12 items_per_second=36.1101M/s
+// NonPartitioned/10000000      1256 ms      1234 ms            1 items_per_second=16.2059M/s
+// NonPartitioned/100000000    16911 ms     16426 ms            1 items_per_second=12.1755M/s
+// Partitioned/1000            0.009 ms     0.009 ms        86874 items_per_second=220.73M/s
+// Partitioned/10000           0.066 ms     0.064 ms         8843 items_per_second=310.476M/s
+// Partitioned/100000          0.915 ms     0.895 ms          719 items_per_second=223.381M/s
+// Partitioned/1000000          44.6 ms      43.8 ms           17 items_per_second=45.678M/s
+// Partitioned/10000000          735 ms       717 ms            1 items_per_second=27.9091M/s
+// Partitioned/100000000        9693 ms      9534 ms            1 items_per_second=20.9783M/s
+//
+// Up to 100K rows the join is a single table, as the non-partitioned one (the
+// gap is noise, they run the same within 20% alone). From 1M rows (4, 7 and 10
+// radix bits) the partitioned join is 1.2x, 1.7x and 1.7x faster. On this VM the
+// scatter runs at only ~150M rows/s and more than 2^10 partitions were slower at
+// 10M rows; streaming stores were 3x slower than the cached buffers.
+//
+// ProbeOnly, without the prefetch / with it (the table is prefetched past 2MB):
+// ---------------------------------------------------------------------------------
+// Benchmark                       Time          CPU   Iterations UserCounters...
+// ---------------------------------------------------------------------------------
+// ProbeOnly/10000/0           0.067 ms     0.064 ms         9114 items_per_second=155.457M/s
+// ProbeOnly/100000/0           1.08 ms      1.04 ms          557 items_per_second=96.1848M/s
+// ProbeOnly/1000000/0          55.2 ms      54.3 ms           14 items_per_second=18.409M/s
+// ProbeOnly/10000000/0         1218 ms      1203 ms            1 items_per_second=8.31287M/s
+// ProbeOnly/10000/3           0.036 ms     0.035 ms        19117 items_per_second=288.495M/s
+// ProbeOnly/100000/3          0.650 ms     0.605 ms          978 items_per_second=165.328M/s
+// ProbeOnly/1000000/3          30.7 ms      30.0 ms           27 items_per_second=33.3687M/s
+// ProbeOnly/10000000/3         1114 ms      1099 ms            1 items_per_second=9.09554M/s
+//
+// ProbeOnly/10000/0           0.062 ms     0.061 ms        11459 items_per_second=162.694M/s
+// ProbeOnly/100000/0           1.09 ms      1.07 ms          664 items_per_second=93.3743M/s
+// ProbeOnly/1000000/0          26.9 ms      26.6 ms           27 items_per_second=37.558M/s
+// ProbeOnly/10000000/0          946 ms       936 ms            1 items_per_second=10.6833M/s
+// ProbeOnly/10000/3           0.032 ms     0.031 ms        22081 items_per_second=318.503M/s
+// ProbeOnly/100000/3          0.685 ms     0.675 ms         1159 items_per_second=148.099M/s
+// ProbeOnly/1000000/3          26.0 ms      25.2 ms           26 items_per_second=39.7231M/s
+// ProbeOnly/10000000/3         1140 ms      1123 ms            1 items_per_second=8.90644M/s
+//
+// The scalar probe of a 1M row table (12MB) is 1.6x to 2x faster (27 to 34ms over
+// runs), the misses of 32 rows ahead overlap instead of one at a time. The AVX-512
+// rounds gain little: a gather already keeps 16 misses in flight. At 10M rows every
+// row misses the TLB too and the page walks, not the lines, bound the probe (that is
+// what Partitioned is for). A 100K row table fits the L3 and was up to 10% slower
+// prefetched, hence PROBE_PREFETCH_MIN_BYTES.
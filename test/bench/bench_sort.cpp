@@ -0,0 +1,263 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <numeric>
+#include <parallel/algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vec/sort.h"
+
+using namespace vec;
+
+template <typename T>
+static std::vector<T> make_values(size_t num_rows) {
+    std::default_random_engine e(42);
+    std::vector<T> values(num_rows);
+    for (auto& value : values) {
+        if constexpr (std::is_floating_point_v<T>) {
+            value = std::uniform_real_distribution<T>(-1e9, 1e9)(e);
+        } else {
+            value = static_cast<T>(e() * uint64_t(0x9E3779B97F4A7C15));
+        }
+    }
+    return values;
+}
+
+// state.range(0) is the number of rows, the copy of the input is not timed
+template <typename T, typename Sort>
+static void run_sort(benchmark::State& state, Sort sort) {
+    const auto input = make_values<T>(state.range(0));
+    std::vector<T> values;
+    for (auto _ : state) {
+        state.PauseTiming();
+        values = input;
+        state.ResumeTiming();
+        sort(values);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename T>
+static void StdSort(benchmark::State& state) {
+    run_sort<T>(state, [](std::vector<T>& values) { std::sort(values.begin(), values.end()); });
+}
+
+template <typename T>
+static void GnuParallelSort(benchmark::State& state) {
+    run_sort<T>(state, [](std::vector<T>& values) {
+        __gnu_parallel::sort(values.begin(), values.end());
+    });
+}
+
+template <typename T>
+static void RadixSort(benchmark::State& state) {
+    std::vector<T> scratch(state.range(0));
+    run_sort<T>(state, [&scratch](std::vector<T>& values) {
+        radix_sort(values.data(), values.size(), scratch.data());
+    });
+}
+
+BENCHMARK_TEMPLATE(StdSort, int32_t)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(GnuParallelSort, int32_t)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(RadixSort, int32_t)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(StdSort, int64_t)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(GnuParallelSort, int64_t)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(RadixSort, int64_t)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(StdSort, double)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(RadixSort, double)->Arg(1 << 22);
+
+// state.range(0) is the number of threads, 1 to the cores of the host, on 16M int64
+static void ParallelSort(benchmark::State& state) {
+    const auto input = make_values<int64_t>(1 << 24);
+    std::vector<int64_t> values;
+    std::vector<int64_t> scratch(input.size());
+    for (auto _ : state) {
+        state.PauseTiming();
+        values = input;
+        state.ResumeTiming();
+        parallel_sort(values.data(), values.size(), scratch.data(), state.range(0));
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+static void ParallelArgsort(benchmark::State& state) {
+    const auto keys = make_values<int64_t>(1 << 24);
+    std::vector<uint32_t> perm(keys.size());
+    for (auto _ : state) {
+        parallel_argsort(keys.data(), keys.size(), perm.data(), state.range(0));
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void ParallelGnuSort(benchmark::State& state) {
+    const auto input = make_values<int64_t>(1 << 24);
+    std::vector<int64_t> values;
+    omp_set_num_threads(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        values = input;
+        state.ResumeTiming();
+        __gnu_parallel::sort(values.begin(), values.end());
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// 1, 2, 4, ... up to the cores, and at least 4 to see the cost of the merge
+static void Threads(benchmark::internal::Benchmark* b) {
+    int max_threads = std::max<int>(4, std::thread::hardware_concurrency());
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        b->Arg(num_threads);
+    }
+}
+
+BENCHMARK(ParallelSort)->Apply(Threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(ParallelArgsort)->Apply(Threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(ParallelGnuSort)->Apply(Threads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void StableSortPerm(benchmark::State& state) {
+    const auto keys = make_values<int64_t>(state.range(0));
+    std::vector<uint32_t> perm(keys.size());
+    for (auto _ : state) {
+        std::iota(perm.begin(), perm.end(), 0);
+        std::stable_sort(perm.begin(), perm.end(),
+                         [&keys](uint32_t lhs, uint32_t rhs) { return keys[lhs] < keys[rhs]; });
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void Argsort(benchmark::State& state) {
+    const auto keys = make_values<int64_t>(state.range(0));
+    std::vector<uint32_t> perm(keys.size());
+    for (auto _ : state) {
+        argsort(keys.data(), keys.size(), perm.data());
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(StableSortPerm)->Arg(1 << 20);
+BENCHMARK(Argsort)->Arg(1 << 20);
+
+// ORDER BY a DESC, s, d of 1M rows: a of 100 values, s of 10000 strings of 5 to 20
+// bytes, d a double
+struct Rows {
+    Rows(size_t num_rows) : a(num_rows), s(num_rows), d(make_values<double>(num_rows)) {
+        std::default_random_engine e(7);
+        std::vector<std::string> words(10000);
+        for (auto& word : words) {
+            size_t size = 5 + e() % 16;
+            for (size_t i = 0; i < size; ++i) {
+                word.push_back('a' + e() % 26);
+            }
+        }
+        for (size_t i = 0; i < num_rows; ++i) {
+            a[i] = e() % 100;
+            s[i] = words[e() % words.size()];
+        }
+        for (const auto& value : s) {
+            slices.emplace_back(value.data(), value.size());
+        }
+    }
+
+    bool less(uint32_t lhs, uint32_t rhs) const {
+        if (a[lhs] != a[rhs]) {
+            return a[lhs] > a[rhs];
+        }
+        int res = s[lhs].compare(s[rhs]);
+        if (res != 0) {
+            return res < 0;
+        }
+        return d[lhs] < d[rhs];
+    }
+
+    std::vector<int32_t> a;
+    std::vector<std::string> s;
+    std::vector<Slice> slices;
+    std::vector<double> d;
+};
+
+static void MultiColumnStdSort(benchmark::State& state) {
+    Rows rows(state.range(0));
+    std::vector<uint32_t> perm(state.range(0));
+    for (auto _ : state) {
+        std::iota(perm.begin(), perm.end(), 0);
+        std::sort(perm.begin(), perm.end(),
+                  [&rows](uint32_t lhs, uint32_t rhs) { return rows.less(lhs, rhs); });
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void MultiColumnNormalizedKeys(benchmark::State& state) {
+    Rows rows(state.range(0));
+    std::vector<uint32_t> perm(state.range(0));
+    for (auto _ : state) {
+        NormalizedKeys keys(rows.a.size());
+        keys.add_column(rows.a.data(), nullptr, SortOrder::DESC, NullOrder::FIRST);
+        keys.add_column(rows.slices.data(), nullptr, SortOrder::ASC, NullOrder::FIRST);
+        keys.add_column(rows.d.data(), nullptr, SortOrder::ASC, NullOrder::FIRST);
+        keys.sort(perm.data());
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(MultiColumnStdSort)->Arg(1 << 20);
+BENCHMARK(MultiColumnNormalizedKeys)->Arg(1 << 20);
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark                                  Time             CPU   Iterations UserCounters...
+// --------------------------------------------------------------------------------------------
+// StdSort<int32_t>/65536               4130967 ns      4055676 ns          173 items_per_second=16.1591M/s
+// StdSort<int32_t>/4194304           352206020 ns    351264259 ns            2 items_per_second=11.9406M/s
+// GnuParallelSort<int32_t>/65536       4069959 ns      4053002 ns          173 items_per_second=16.1697M/s
+// GnuParallelSort<int32_t>/4194304   354395999 ns    345582177 ns            2 items_per_second=12.1369M/s
+// RadixSort<int32_t>/65536              440810 ns       436711 ns         1604 items_per_second=150.067M/s
+// RadixSort<int32_t>/4194304          62511575 ns     61779732 ns           12 items_per_second=67.8913M/s
+// StdSort<int64_t>/65536               4110628 ns      4077968 ns          172 items_per_second=16.0707M/s
+// StdSort<int64_t>/4194304           355815297 ns    352820052 ns            2 items_per_second=11.8879M/s
+// GnuParallelSort<int64_t>/65536       4073392 ns      4043117 ns          173 items_per_second=16.2093M/s
+// GnuParallelSort<int64_t>/4194304   353938523 ns    350615031 ns            2 items_per_second=11.9627M/s
+// RadixSort<int64_t>/65536              994246 ns       982080 ns          714 items_per_second=66.7318M/s
+// RadixSort<int64_t>/4194304         112033525 ns    111203458 ns            6 items_per_second=37.7174M/s
+// StdSort<double>/4194304            392870774 ns    387822283 ns            2 items_per_second=10.815M/s
+// RadixSort<double>/4194304          143168646 ns    141634081 ns            5 items_per_second=29.6137M/s
+// ParallelSort/1/real_time                 645 ms          638 ms            1 items_per_second=26.0028M/s
+// ParallelSort/2/real_time                 626 ms          312 ms            1 items_per_second=26.7936M/s
+// ParallelSort/4/real_time                 775 ms          193 ms            1 items_per_second=21.6459M/s
+// ParallelArgsort/1/real_time             1299 ms         1289 ms            1 items_per_second=12.9113M/s
+// ParallelArgsort/2/real_time             1411 ms          794 ms            1 items_per_second=11.8881M/s
+// ParallelArgsort/4/real_time             1272 ms          457 ms            1 items_per_second=13.1939M/s
+// ParallelGnuSort/1/real_time             1554 ms         1529 ms            1 items_per_second=10.7968M/s
+// ParallelGnuSort/2/real_time             1647 ms          821 ms            1 items_per_second=10.1847M/s
+// ParallelGnuSort/4/real_time             1641 ms          408 ms            1 items_per_second=10.2216M/s
+// StableSortPerm/1048576             132938272 ns    131597489 ns            5 items_per_second=7.96805M/s
+// Argsort/1048576                     57477706 ns     56043304 ns           12 items_per_second=18.7101M/s
+// MultiColumnStdSort/1048576         505876812 ns    501119167 ns            2 items_per_second=2.09247M/s
+// MultiColumnNormalizedKeys/1048576  233330698 ns    232543551 ns            3 items_per_second=4.50916M/s
+//
+// One core here, so __gnu_parallel::sort is std::sort. The radix sort is 10x faster
+// than std::sort for 64K int32 (two or three passes of the four are needed) and 5.7x
+// for 4M; 4M int64 is 3.1x faster. A plain LSD sort of 4M int64 took 294ms, each of
+// its 8 passes scattered over the whole 32MB column: the MSD split by the top byte
+// keeps the passes of each bucket in L2. argsort is 2.3x faster than a stable_sort of
+// the rows, the normalized keys of a 3 column ORDER BY 2x faster than std::sort with
+// a row comparator.
+//
+// The Parallel* rows sort 16M int64 with 1 to 4 threads on the one core, they show
+// the cost of the split and the merge and not the scaling: at 2 threads the merge
+// costs what the smaller runs save, at 4 the threads contend for the core. With a
+// core a thread, the runs and the merge ranges are sorted and merged independently,
+// the only serial part is the spawn of the threads. On the same core parallel_sort is
+// 2.4x faster than __gnu_parallel::sort.
@@ -0,0 +1,172 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "vec/cpu_dispatch.h"
+#include "vec/string_search.h"
+
+using namespace vec;
+
+constexpr int chunk_size = 4096;
+
+static const std::vector<std::string> domains = {"google", "github",  "wikipedia", "example",
+                                                 "yandex", "twitter", "bing",      "reddit",
+                                                 "amazon", "youtube", "apache",    "mozilla"};
+
+// URLs of 40 to 120 bytes, 1 in 12 of them with "google"
+struct Urls {
+    Urls() {
+        std::default_random_engine e(42);
+        // the slices point into the strings
+        strings.reserve(chunk_size);
+        for (int i = 0; i < chunk_size; ++i) {
+            std::string url = (e() % 4 ? "https://www." : "http://") + domains[e() % 12] + ".com/";
+            size_t size = 40 + e() % 80;
+            while (url.size() < size) {
+                url.push_back(e() % 5 ? 'a' + e() % 26 : '/');
+            }
+            url += e() % 3 ? ".html" : "?q=1";
+            strings.push_back(url);
+            slices.emplace_back(strings.back().data(), strings.back().size());
+        }
+        col.build_strings(slices);
+    }
+
+    std::vector<std::string> strings;
+    std::vector<Slice> slices;
+    FlatBinaryVec col;
+};
+
+// state.range(0) is the SimdLevel
+static void Contains(benchmark::State& state) {
+    auto level = static_cast<SimdLevel>(state.range(0));
+    if (level > CpuInfo::host().max_level()) {
+        state.SkipWithError("not supported on this host");
+        return;
+    }
+    set_simd_level(level);
+    Urls urls;
+    BitVec bits(chunk_size);
+    for (auto _ : state) {
+        contains(urls.col.view(0, chunk_size), Slice("google", 6), bits.words());
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+    set_simd_level(CpuInfo::host().max_level());
+}
+
+BENCHMARK(Contains)->DenseRange(0, static_cast<int>(SimdLevel::AVX512));
+
+// std::string_view::find a row at a time
+static void ContainsRows(benchmark::State& state) {
+    Urls urls;
+    BitVec bits(chunk_size);
+    for (auto _ : state) {
+        for (int i = 0; i < chunk_size; ++i) {
+            Slice row = urls.col.get_slice(i);
+            bits.set(i, std::string_view(row.data, row.size).find("google") != std::string::npos);
+        }
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(ContainsRows);
+
+static void StartsWith(benchmark::State& state) {
+    Urls urls;
+    BitVec bits(chunk_size);
+    for (auto _ : state) {
+        starts_with(urls.col.view(0, chunk_size), Slice("https://www.", 12), bits.words());
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(StartsWith);
+
+static void EndsWith(benchmark::State& state) {
+    Urls urls;
+    BitVec bits(chunk_size);
+    for (auto _ : state) {
+        ends_with(urls.col.view(0, chunk_size), Slice(".html", 5), bits.words());
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(EndsWith);
+
+// IN of 4 domains over a column of domains
+static void InSet(benchmark::State& state) {
+    std::default_random_engine e(42);
+    std::vector<Slice> slices;
+    for (int i = 0; i < chunk_size; ++i) {
+        const auto& domain = domains[e() % domains.size()];
+        slices.emplace_back(domain.data(), domain.size());
+    }
+    FlatBinaryVec col;
+    col.build_strings(slices);
+    StringSet set(std::vector<Slice>(slices.begin(), slices.begin() + 4));
+    BitVec bits(chunk_size);
+    for (auto _ : state) {
+        set.contains(col.view(0, chunk_size), bits.words());
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(InSet);
+
+// the same with std::unordered_set
+static void InUnorderedSet(benchmark::State& state) {
+    std::default_random_engine e(42);
+    std::vector<Slice> slices;
+    for (int i = 0; i < chunk_size; ++i) {
+        const auto& domain = domains[e() % domains.size()];
+        slices.emplace_back(domain.data(), domain.size());
+    }
+    FlatBinaryVec col;
+    col.build_strings(slices);
+    std::unordered_set<std::string_view> set;
+    for (int i = 0; i < 4; ++i) {
+        set.emplace(slices[i].data, slices[i].size);
+    }
+    BitVec bits(chunk_size);
+    for (auto _ : state) {
+        for (int i = 0; i < chunk_size; ++i) {
+            Slice row = col.get_slice(i);
+            bits.set(i, set.count(std::string_view(row.data, row.size)) != 0);
+        }
+        benchmark::DoNotOptimize(bits.words());
+    }
+    state.SetItemsProcessed(state.iterations() * chunk_size);
+}
+
+BENCHMARK(InUnorderedSet);
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark               Time             CPU   Iterations UserCounters...
+// -------------------------------------------------------------------------
+// Contains/0         127579 ns       125183 ns         5786 items_per_second=32.72M/s
+// Contains/1          52209 ns        51962 ns        13413 items_per_second=78.8263M/s
+// Contains/2          18811 ns        18513 ns        37660 items_per_second=221.248M/s
+// Contains/3          14233 ns        14061 ns        50363 items_per_second=291.293M/s
+// ContainsRows       124061 ns       122498 ns         5675 items_per_second=33.4373M/s
+// StartsWith           7763 ns         7693 ns        93924 items_per_second=532.436M/s
+// EndsWith             8800 ns         8766 ns        78189 items_per_second=467.279M/s
+// InSet               17617 ns        17554 ns        34623 items_per_second=233.337M/s
+// InUnorderedSet      38608 ns        38571 ns        17403 items_per_second=106.194M/s
+//
+// contains over 4096 URLs of 40 to 120 bytes: the AVX-512 version is 8.5x faster
+// than std::string_view::find a row at a time and AVX2 6.5x, they read 64 or 32
+// positions a compare and only the first and last byte matches are checked. pcmpestrm
+// has a latency of its own, SSE4.2 is 2.3x faster than the memchr based scalar
+// version. StringSet hashes 16 bytes of a row at most, 2x faster than an
+// std::unordered_set<std::string_view> of the same strings.
@@ -0,0 +1,191 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vec/binary_vec.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/top_n.h"
+
+using namespace vec;
+
+// ORDER BY x LIMIT 100 of 1M random rows, in batches of 4096
+constexpr size_t num_rows = 1 << 20;
+constexpr size_t batch_size = 4096;
+constexpr size_t limit = 100;
+
+static std::vector<int64_t> make_values() {
+    std::default_random_engine e(42);
+    std::vector<int64_t> values(num_rows);
+    for (auto& value : values) {
+        value = static_cast<int64_t>(e() * uint64_t(0x9E3779B97F4A7C15));
+    }
+    return values;
+}
+
+// state.range(0) is the SimdLevel
+static void TopNInt64(benchmark::State& state) {
+    auto level = static_cast<SimdLevel>(state.range(0));
+    if (level > CpuInfo::host().max_level()) {
+        state.SkipWithError("not supported on this host");
+        return;
+    }
+    set_simd_level(level);
+    const auto values = make_values();
+    for (auto _ : state) {
+        TopN<int64_t> top_n(limit);
+        for (size_t begin = 0; begin < num_rows; begin += batch_size) {
+            top_n.add(values.data() + begin, batch_size);
+        }
+        benchmark::DoNotOptimize(top_n.threshold());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+    set_simd_level(CpuInfo::host().max_level());
+}
+
+BENCHMARK(TopNInt64)->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+
+// every row compared with the top of the heap
+static void PriorityQueueInt64(benchmark::State& state) {
+    const auto values = make_values();
+    for (auto _ : state) {
+        std::priority_queue<int64_t> heap;
+        for (int64_t value : values) {
+            if (heap.size() < limit) {
+                heap.push(value);
+            } else if (value < heap.top()) {
+                heap.pop();
+                heap.push(value);
+            }
+        }
+        benchmark::DoNotOptimize(heap.top());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+static void PartialSortInt64(benchmark::State& state) {
+    const auto input = make_values();
+    std::vector<int64_t> values;
+    for (auto _ : state) {
+        state.PauseTiming();
+        values = input;
+        state.ResumeTiming();
+        std::partial_sort(values.begin(), values.begin() + limit, values.end());
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+static void RadixSortInt64(benchmark::State& state) {
+    const auto input = make_values();
+    std::vector<int64_t> values;
+    std::vector<int64_t> scratch(num_rows);
+    for (auto _ : state) {
+        state.PauseTiming();
+        values = input;
+        state.ResumeTiming();
+        radix_sort(values.data(), num_rows, scratch.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+BENCHMARK(PriorityQueueInt64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(PartialSortInt64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(RadixSortInt64)->Unit(benchmark::kMicrosecond);
+
+// URL like strings of 20 to 60 bytes with a common prefix
+struct Strings {
+    Strings() {
+        std::default_random_engine e(7);
+        strings.reserve(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            std::string s = "https://";
+            size_t size = 20 + e() % 40;
+            while (s.size() < size) {
+                s.push_back('a' + e() % 26);
+            }
+            strings.push_back(s);
+            slices.emplace_back(strings.back().data(), strings.back().size());
+        }
+        flat.build_strings(slices);
+        inline_col.build_strings(slices);
+    }
+
+    std::vector<std::string> strings;
+    std::vector<Slice> slices;
+    FlatBinaryVec flat;
+    InlineBinaryVec inline_col;
+};
+
+static void TopNFlatStrings(benchmark::State& state) {
+    Strings strings;
+    for (auto _ : state) {
+        StringTopN top_n(limit);
+        for (size_t begin = 0; begin < num_rows; begin += batch_size) {
+            top_n.add(strings.flat.view(begin, begin + batch_size));
+        }
+        benchmark::DoNotOptimize(top_n.threshold());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+static void TopNInlineStrings(benchmark::State& state) {
+    Strings strings;
+    for (auto _ : state) {
+        StringTopN top_n(limit);
+        for (size_t begin = 0; begin < num_rows; begin += batch_size) {
+            top_n.add(strings.inline_col.view(begin, begin + batch_size));
+        }
+        benchmark::DoNotOptimize(top_n.threshold());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+static void PriorityQueueStrings(benchmark::State& state) {
+    Strings strings;
+    for (auto _ : state) {
+        std::priority_queue<std::string> heap;
+        for (const auto& value : strings.strings) {
+            if (heap.size() < limit) {
+                heap.push(value);
+            } else if (value < heap.top()) {
+                heap.pop();
+                heap.push(value);
+            }
+        }
+        benchmark::DoNotOptimize(heap.top());
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+BENCHMARK(TopNFlatStrings)->Unit(benchmark::kMicrosecond);
+BENCHMARK(TopNInlineStrings)->Unit(benchmark::kMicrosecond);
+BENCHMARK(PriorityQueueStrings)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
+
+// Intel(R) Xeon(R) Processor (AVX-512 VBMI2)
+// Benchmark                     Time             CPU   Iterations UserCounters...
+// -------------------------------------------------------------------------------
+// TopNInt64/0                2198 us         2092 us          321 items_per_second=501.3M/s
+// TopNInt64/1                2061 us         2023 us          328 items_per_second=518.394M/s
+// TopNInt64/2                 657 us          611 us         1092 items_per_second=1.71609G/s
+// TopNInt64/3                 625 us          602 us         1162 items_per_second=1.74133G/s
+// PriorityQueueInt64         1943 us         1842 us          358 items_per_second=569.411M/s
+// PartialSortInt64           1479 us         1356 us          503 items_per_second=773.176M/s
+// RadixSortInt64            51702 us        50796 us           14 items_per_second=20.6428M/s
+// TopNFlatStrings           17138 us        16770 us           44 items_per_second=62.5276M/s
+// TopNInlineStrings         17105 us        17030 us           39 items_per_second=61.5737M/s
+// PriorityQueueStrings      17312 us        17003 us           40 items_per_second=61.6715M/s
+//
+// LIMIT 100 of 1M random int64: once the heap is full, the AVX2 and AVX-512 compares
+// with the threshold drop all but a few hundred rows, 3x faster than a
+// priority_queue that compares every row with its top and 2.2x faster than
+// std::partial_sort. The scalar level builds the bits of the compare first and is
+// 15% slower than the priority_queue. The strings are bound by the reads of their
+// 40MB: all start with "https://", the prefixes of the inline layout do not tell
+// them apart and every row is a memcmp, the three run at the same speed.
@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "vec/vec.h"
+
+using namespace vec;
+
+constexpr int chunk_size = 4096;
+
+struct Context {
+    Context() : a(chunk_size), b(chunk_size), c(chunk_size), d(chunk_size) {
+        std::default_random_engine e;
+        std::uniform_int_distribution<int> u(1, 1024);
+        for (int i = 0; i < chunk_size; ++i) {
+            a[i] = u(e);
+            b[i] = u(e);
+            c[i] = u(e);
+            d[i] = u(e);
+        }
+    }
+    Vec<int> a, b, c, d;
+};
+
+// what `a + b * c - d` used to cost: one full-size temporary per operator
+static void EagerImpl(benchmark::State& state) {
+    Context ctx;
+    for (auto _ : state) {
+        Vec<int> t1 = (ctx.b * ctx.c).eval();
+        Vec<int> t2 = (ctx.a + t1).eval();
+        Vec<int> res = (t2 - ctx.d).eval();
+        benchmark::DoNotOptimize(res.data());
+    }
+}
+
+static void FusedImpl(benchmark::State& state) {
+    Context ctx;
+    for (auto _ : state) {
+        Vec<int> res = ctx.a + ctx.b * ctx.c - ctx.d;
+        benchmark::DoNotOptimize(res.data());
+    }
+}
+
+static void FusedReuseImpl(benchmark::State& state) {
+    Context ctx;
+    Vec<int> res(chunk_size);
+    for (auto _ : state) {
+        res = ctx.a + ctx.b * ctx.c - ctx.d;
+        benchmark::DoNotOptimize(res.data());
+    }
+}
+
+BENCHMARK(EagerImpl);
+BENCHMARK(FusedImpl);
+BENCHMARK(FusedReuseImpl);
+BENCHMARK_MAIN();
+
+// ---------------------------------------------------------
+// Benchmark               Time             CPU   Iterations
+// ---------------------------------------------------------
+// EagerImpl            4287 ns         4176 ns       178189
+// FusedImpl            2928 ns         2772 ns       250368
+// FusedReuseImpl       2743 ns         2710 ns       257382
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "vec/cpu_dispatch.h"
+
+namespace vec {
+
+// Runs check with every kernel version the host supports, then goes back to the
+// level the test started at, so a VEC_SIMD_LEVEL override still applies after it.
+template <typename F>
+void for_each_simd_level(F&& check) {
+    const SimdLevel saved = simd_level();
+    SimdLevel max_level = CpuInfo::host().max_level();
+    for (int level = 0; level <= static_cast<int>(max_level); ++level) {
+        set_simd_level(static_cast<SimdLevel>(level));
+        SCOPED_TRACE(simd_level_name(simd_level()));
+        check();
+    }
+    set_simd_level(saved);
+}
+
+} // namespace vec
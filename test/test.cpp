@@ -109,6 +109,136 @@ TEST(VecBasicTest, IteratorTest) {
     ASSERT_EQ(counter, counter2);
 }
 
+TEST(VecBasicTest, ExprTest) {
+    const int test_vec_length = 4096;
+    Vec<int> a(test_vec_length), b(test_vec_length), c(test_vec_length), d(test_vec_length);
+    for (int i = 0; i < test_vec_length; ++i) {
+        a[i] = i;
+        b[i] = i % 7 + 1;
+        c[i] = 3;
+        d[i] = i % 5;
+    }
+
+    // fused evaluation of a chain
+    Vec<int> r = a + b * c - d;
+    ASSERT_EQ(r.len(), test_vec_length);
+    for (int i = 0; i < test_vec_length; ++i) {
+        ASSERT_EQ(r[i], a[i] + b[i] * c[i] - d[i]);
+    }
+
+    // unary minus and division
+    r = -a / b;
+    for (int i = 0; i < test_vec_length; ++i) {
+        ASSERT_EQ(r[i], -a[i] / b[i]);
+    }
+
+    // assign to an operand of the expression
+    Vec<int> a2 = a;
+    a2 = a2 * a2 + a2;
+    for (int i = 0; i < test_vec_length; ++i) {
+        ASSERT_EQ(a2[i], a[i] * a[i] + a[i]);
+    }
+
+    // compound assignment from an expression
+    Vec<int> acc(test_vec_length);
+    acc += b * c;
+    acc -= d;
+    for (int i = 0; i < test_vec_length; ++i) {
+        ASSERT_EQ(acc[i], b[i] * c[i] - d[i]);
+    }
+
+    // result type follows the left operand like the eager operators did
+    Vec<double> dvec(test_vec_length);
+    dvec = 0.5;
+    Vec<double> mixed = dvec + a;
+    ASSERT_EQ(mixed[10], 10.5);
+    Vec<int> truncated = (a + dvec).eval();
+    ASSERT_EQ(truncated[10], 10);
+
+    // grow the destination buffer
+    Vec<int> small;
+    small = a - d;
+    ASSERT_EQ(small.len(), test_vec_length);
+    ASSERT_EQ(small[4], 0);
+}
+
+TEST(VecBasicTest, ArenaTest) {
+    ChunkArena& arena = ChunkArena::thread_local_arena();
+    arena.reset();
+    const int test_vec_length = 4096;
+    {
+        Vec<int, ArenaAllocator> ivec(test_vec_length);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(ivec.data()) % ChunkArena::ALIGNMENT, 0);
+        ivec += 4;
+        Vec<double, ArenaAllocator> dvec(test_vec_length);
+        dvec = 4.5;
+        dvec += ivec;
+        auto bvec = dvec > ivec;
+        static_assert(std::is_same_v<decltype(bvec), Vec<bool, ArenaAllocator>>);
+        for (int i = 0; i < test_vec_length; i += 10) {
+            dvec[i] *= 1024;
+        }
+        auto selected = dvec[dvec > 1024];
+        ASSERT_EQ(selected.len(), (test_vec_length + 9) / 10);
+
+        Vec<int, ArenaAllocator> sum = ivec + ivec * ivec;
+        ASSERT_EQ(sum[0], 4 + 16);
+        // eval() allocates from the arena of the leftmost operand
+        size_t used = arena.used_bytes();
+        auto evaluated = (ivec - ivec * ivec).eval();
+        static_assert(std::is_same_v<decltype(evaluated), Vec<int, ArenaAllocator>>);
+        ASSERT_EQ(evaluated[0], 4 - 16);
+        ASSERT_GT(arena.used_bytes(), used);
+        auto on_heap = (ivec + ivec).eval<NewAllocator>();
+        static_assert(std::is_same_v<decltype(on_heap), Vec<int>>);
+
+        Vec<int, ArenaAllocator> grow;
+        for (int i = 0; i < test_vec_length; ++i) {
+            grow.push_back(i);
+        }
+        ASSERT_EQ(grow[test_vec_length - 1], test_vec_length - 1);
+        ASSERT_GT(arena.used_bytes(), 0);
+    }
+    // the whole batch goes back at once and the chunks are reused
+    size_t reserved = arena.reserved_bytes();
+    arena.reset();
+    ASSERT_EQ(arena.used_bytes(), 0);
+    {
+        Vec<int, ArenaAllocator> ivec(test_vec_length);
+        ASSERT_EQ(arena.reserved_bytes(), reserved);
+    }
+
+    // the latest allocation can be handed back on its own
+    arena.reset();
+    void* p = arena.allocate(100);
+    arena.deallocate(p, 100);
+    ASSERT_EQ(arena.used_bytes(), 0);
+
+    // allocations larger than a chunk
+    void* large = arena.allocate(ChunkArena::DEFAULT_CHUNK_SIZE * 2);
+    ASSERT_TRUE(large != nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(large) % ChunkArena::ALIGNMENT, 0);
+    arena.reset();
+
+    // a failed allocation leaves the arena usable
+    void* first = arena.allocate(100);
+    size_t used_before = arena.used_bytes();
+    ASSERT_TRUE(arena.allocate(std::numeric_limits<size_t>::max() / 2) == nullptr);
+    ASSERT_EQ(arena.used_bytes(), used_before);
+    void* second = arena.allocate(100);
+    ASSERT_EQ(static_cast<uint8_t*>(second),
+              static_cast<uint8_t*>(first) + ChunkArena::ALIGNMENT * 2);
+    arena.reset();
+
+    ChunkArena local_arena;
+    std::vector<Slice> slices = {Slice("hello", 5), Slice("a long string value", 19)};
+    FlatBinaryVec flat(&local_arena);
+    flat.build_strings(slices);
+    InlineBinaryVec inlined(&local_arena);
+    inlined.build_strings(slices);
+    ASSERT_GT(local_arena.used_bytes(), 0);
+}
+
 TEST(VecBasicTest, StringTest) {
     const char* test_text = "Hello World";
     char tester[4096];
@@ -148,6 +278,20 @@ TEST(VecBasicTest, StringTest) {
 
     std::vector<int> raw;
 }
+
+TEST(VecBasicTest, GatherTest) {
+    Vec<int64_t> src(100);
+    for (int i = 0; i < src.len(); ++i) {
+        src[i] = i * 3;
+    }
+    std::vector<uint32_t> indices = {99, 0, 7, 7, 42};
+    Vec<int64_t> dst = src.gather(indices.data(), indices.size());
+    ASSERT_EQ(dst.len(), 5);
+    for (int i = 0; i < dst.len(); ++i) {
+        ASSERT_EQ(dst[i], indices[i] * 3);
+    }
+    ASSERT_EQ(src.gather(indices.data(), 0).len(), 0);
+}
 } // namespace vec
 
 int main(int argc, char** argv) {
@@ -0,0 +1,350 @@
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/binary_vec.h"
+#include "vec/cpu_dispatch.h"
+
+namespace vec {
+
+using Strings = std::vector<std::string>;
+
+// empty, inlined, 12/13 bytes and long strings
+Strings make_strings(size_t num_rows, uint32_t seed) {
+    std::default_random_engine e(seed);
+    std::uniform_int_distribution<int> size(0, 40);
+    Strings strings;
+    for (size_t i = 0; i < num_rows; ++i) {
+        std::string s = std::to_string(i) + ":";
+        s.resize(i % 5 == 0 ? 12 + i % 2 : size(e), 'a' + i % 26);
+        strings.push_back(s);
+    }
+    return strings;
+}
+
+std::vector<Slice> slices_of(const Strings& strings) {
+    std::vector<Slice> slices;
+    for (const auto& s : strings) {
+        slices.emplace_back(s.data(), s.size());
+    }
+    return slices;
+}
+
+std::string to_string(const Slice& s) {
+    return std::string(s.data, s.size);
+}
+
+std::string to_string(const SliceInline& s) {
+    return std::string(s.bytes(), s.size);
+}
+
+template <typename Col>
+Strings rows_of(const Col& col) {
+    Strings rows;
+    for (size_t i = 0; i < col.size(); ++i) {
+        rows.push_back(to_string(col.get_slice(i)));
+    }
+    return rows;
+}
+
+template <typename Col>
+void check_build_and_append() {
+    Strings strings = make_strings(1000, 42);
+    std::vector<Slice> slices = slices_of(strings);
+
+    Col col;
+    ASSERT_TRUE(col.empty());
+    col.build_strings(slices);
+    ASSERT_EQ(rows_of(col), strings);
+    // rebuilt, not appended
+    col.build_strings(slices);
+    ASSERT_EQ(rows_of(col), strings);
+
+    // row by row: the pointers of the long strings stay valid as buffers are added
+    Col appended;
+    for (const auto& slice : slices) {
+        appended.append(slice);
+    }
+    ASSERT_EQ(rows_of(appended), strings);
+
+    // views of ranges appended in batches
+    Col batches;
+    batches.append_batch(slices.data(), 10);
+    batches.append_batch(col.view(10, 10));
+    batches.append_batch(col.view(10, 500));
+    batches.append_batch(col.view(500, 1000));
+    ASSERT_EQ(rows_of(batches), strings);
+    auto view = col.view(3, 7);
+    ASSERT_EQ(view.size(), 4);
+    ASSERT_EQ(to_string(view.get_slice(0)), strings[3]);
+
+    // the strings of a moved vector keep their bytes
+    Col moved(std::move(batches));
+    ASSERT_EQ(rows_of(moved), strings);
+
+    col.clear();
+    ASSERT_TRUE(col.empty());
+    col.append(Slice("x", 1));
+    ASSERT_EQ(rows_of(col), Strings{"x"});
+}
+
+TEST(BinaryVecTest, FlatBuildAndAppend) {
+    check_build_and_append<FlatBinaryVec>();
+}
+
+TEST(BinaryVecTest, InlineBuildAndAppend) {
+    check_build_and_append<InlineBinaryVec>();
+}
+
+template <typename Col>
+void check_filter_and_gather() {
+    Strings strings = make_strings(300, 7);
+    std::vector<Slice> slices = slices_of(strings);
+    std::default_random_engine e(42);
+    // none, all, every other row, random, a single run in the middle
+    std::vector<std::function<bool(size_t)>> patterns = {
+            [](size_t) { return false; },
+            [](size_t) { return true; },
+            [](size_t i) { return i % 2 == 1; },
+            [&](size_t) { return e() % 3 != 0; },
+            [](size_t i) { return i >= 100 && i < 200; },
+    };
+    for (auto& pattern : patterns) {
+        Vec<bool> selector(strings.size());
+        Strings expect;
+        for (size_t i = 0; i < strings.size(); ++i) {
+            selector[i] = pattern(i);
+            if (selector[i]) {
+                expect.push_back(strings[i]);
+            }
+        }
+        Col col;
+        col.build_strings(slices);
+        col.filter(selector);
+        ASSERT_EQ(rows_of(col), expect);
+
+        Col bits;
+        bits.build_strings(slices);
+        bits.filter(BitVec::from_bytes(reinterpret_cast<const uint8_t*>(selector.data()),
+                                       selector.len()));
+        ASSERT_EQ(rows_of(bits), expect);
+        // a filtered vector still appends
+        bits.append(slices[0]);
+        ASSERT_EQ(rows_of(bits).back(), strings[0]);
+    }
+
+    Col col;
+    col.build_strings(slices);
+    std::vector<uint32_t> indices = {299, 0, 5, 5, 17, 150};
+    Col gathered = col.gather(indices.data(), indices.size());
+    Strings expect;
+    for (uint32_t index : indices) {
+        expect.push_back(strings[index]);
+    }
+    // the long strings are copies, the source can go
+    col.clear();
+    ASSERT_EQ(rows_of(gathered), expect);
+    ASSERT_TRUE(col.gather(indices.data(), 0).empty());
+
+    // a vector of megabytes, the rows ahead are prefetched
+    Strings many = make_strings(100000, 11);
+    Col large;
+    large.build_strings(slices_of(many));
+    indices.resize(5000);
+    for (auto& index : indices) {
+        index = e() % many.size();
+    }
+    Strings expect_large;
+    for (uint32_t index : indices) {
+        expect_large.push_back(many[index]);
+    }
+    ASSERT_EQ(rows_of(large.gather(indices.data(), indices.size())), expect_large);
+}
+
+TEST(BinaryVecTest, FlatFilterAndGather) {
+    check_filter_and_gather<FlatBinaryVec>();
+}
+
+TEST(BinaryVecTest, InlineFilterAndGather) {
+    check_filter_and_gather<InlineBinaryVec>();
+}
+
+TEST(BinaryVecTest, Conversions) {
+    Strings strings = make_strings(500, 3);
+    FlatBinaryVec flat;
+    flat.build_strings(slices_of(strings));
+    InlineBinaryVec inlined = flat.to_inline();
+    ASSERT_EQ(rows_of(inlined), strings);
+    FlatBinaryVec back = inlined.to_flat();
+    ASSERT_EQ(rows_of(back), strings);
+    // inline rows own their long strings
+    flat.clear();
+    ASSERT_EQ(rows_of(inlined), strings);
+}
+
+TEST(BinaryVecTest, ByteSize) {
+    std::string long_string(20, 'y');
+    std::vector<Slice> slices = {Slice("abc", 3), Slice(long_string.data(), 20), Slice("", 0)};
+    FlatBinaryVec flat;
+    ASSERT_EQ(flat.byte_size(), sizeof(uint32_t));
+    flat.build_strings(slices);
+    ASSERT_EQ(flat.byte_size(), 23 + 4 * sizeof(uint32_t));
+    ASSERT_GE(flat.capacity_bytes(), flat.byte_size());
+
+    InlineBinaryVec inlined;
+    ASSERT_EQ(inlined.byte_size(), 0);
+    inlined.build_strings(slices);
+    // only the long string has bytes out of the rows
+    ASSERT_EQ(inlined.byte_size(), 3 * sizeof(SliceInline) + 20);
+    ASSERT_GE(inlined.capacity_bytes(), inlined.byte_size());
+    // the dropped long string stays until clear()
+    Vec<bool> selector(3);
+    selector[0] = true;
+    inlined.filter(selector);
+    ASSERT_EQ(inlined.byte_size(), sizeof(SliceInline) + 20);
+    inlined.clear();
+    ASSERT_EQ(inlined.byte_size(), 0);
+}
+
+TEST(BinaryVecTest, Arena) {
+    ChunkArena arena;
+    Strings strings = make_strings(100, 1);
+    FlatBinaryVec flat(&arena);
+    flat.build_strings(slices_of(strings));
+    size_t used = arena.used_bytes();
+    ASSERT_GT(used, 0);
+    InlineBinaryVec inlined = flat.to_inline();
+    FlatBinaryVec gathered = flat.gather(std::vector<uint32_t>{1, 2}.data(), 2);
+    ASSERT_GT(arena.used_bytes(), used);
+    ASSERT_EQ(rows_of(inlined), strings);
+    ASSERT_EQ(rows_of(gathered), (Strings{strings[1], strings[2]}));
+}
+
+// every size up to 40 and strings that differ in the prefix, at the last byte or
+// only in their size, with bytes above 0x7f and zero bytes
+Strings make_compare_strings() {
+    std::string base = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEF";
+    Strings strings;
+    for (size_t size = 0; size <= 40; ++size) {
+        std::string s = base.substr(0, size);
+        strings.push_back(s);
+        if (size > 0) {
+            s.back() = '\xff';
+            strings.push_back(s);
+            s.back() = '\0';
+            strings.push_back(s);
+            s = base.substr(0, size);
+            s[0] = 'b';
+            strings.push_back(s);
+        }
+    }
+    return strings;
+}
+
+template <typename S>
+S slice_of(std::string& s) {
+    return S(s.data(), s.size());
+}
+
+template <typename S>
+void check_slice_compare() {
+    Strings strings = make_compare_strings();
+    for (auto& a : strings) {
+        for (auto& b : strings) {
+            S x = slice_of<S>(a);
+            S y = slice_of<S>(b);
+            int expect = a.compare(b);
+            ASSERT_EQ(x == y, expect == 0) << a << " " << b;
+            ASSERT_EQ(x != y, expect != 0) << a << " " << b;
+            ASSERT_EQ(x < y, expect < 0) << a << " " << b;
+            ASSERT_EQ(x <= y, expect <= 0) << a << " " << b;
+            ASSERT_EQ(x > y, expect > 0) << a << " " << b;
+            ASSERT_EQ(x >= y, expect >= 0) << a << " " << b;
+        }
+    }
+}
+
+TEST(BinaryVecTest, SliceCompare) {
+    check_slice_compare<Slice>();
+}
+
+TEST(BinaryVecTest, SliceInlineCompare) {
+    check_slice_compare<SliceInline>();
+}
+
+constexpr CompareOp ALL_OPS[] = {CompareOp::EQ, CompareOp::NE, CompareOp::LT,
+                                 CompareOp::LE, CompareOp::GT, CompareOp::GE};
+
+bool compare_strings(CompareOp op, const std::string& a, const std::string& b) {
+    int c = a.compare(b);
+    switch (op) {
+    case CompareOp::EQ:
+        return c == 0;
+    case CompareOp::NE:
+        return c != 0;
+    case CompareOp::LT:
+        return c < 0;
+    case CompareOp::LE:
+        return c <= 0;
+    case CompareOp::GT:
+        return c > 0;
+    case CompareOp::GE:
+        return c >= 0;
+    }
+    return false;
+}
+
+// a column with runs of every string, against each string and against itself
+// reversed, with sizes that leave a tail after the full words
+template <typename Col>
+void check_compare_bits() {
+    Strings values = make_compare_strings();
+    Strings strings;
+    for (size_t i = 0; i < 1000; ++i) {
+        strings.push_back(values[(i / 3 + i % 2) % values.size()]);
+    }
+    Strings reversed(strings.rbegin(), strings.rend());
+    for_each_simd_level([&] {
+        for (size_t num_rows : {0, 63, 64, 129, 1000}) {
+            Strings rows(strings.begin(), strings.begin() + num_rows);
+            Strings rhs_rows(reversed.begin(), reversed.begin() + num_rows);
+            Col col;
+            col.build_strings(slices_of(rows));
+            Col rhs;
+            rhs.build_strings(slices_of(rhs_rows));
+            for (CompareOp op : ALL_OPS) {
+                for (auto& value : values) {
+                    BitVec bits = col.compare_bits(op, Slice(value.data(), value.size()));
+                    ASSERT_EQ(bits.len(), num_rows);
+                    for (size_t i = 0; i < num_rows; ++i) {
+                        ASSERT_EQ(bits[i], compare_strings(op, rows[i], value))
+                                << static_cast<int>(op) << " " << rows[i] << " " << value;
+                    }
+                }
+                BitVec bits = col.compare_bits(op, rhs);
+                for (size_t i = 0; i < num_rows; ++i) {
+                    ASSERT_EQ(bits[i], compare_strings(op, rows[i], rhs_rows[i]));
+                }
+            }
+        }
+    });
+}
+
+TEST(BinaryVecTest, FlatCompareBits) {
+    check_compare_bits<FlatBinaryVec>();
+}
+
+TEST(BinaryVecTest, InlineCompareBits) {
+    check_compare_bits<InlineBinaryVec>();
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,335 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/bit_vec.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/filter.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+const std::vector<int> kLens = {0, 1, 31, 63, 64, 65, 127, 128, 129, 1000, 4099};
+
+std::vector<uint8_t> random_bytes(size_t num_rows, int percent, std::default_random_engine& e) {
+    std::uniform_int_distribution<int> u(0, 99);
+    std::vector<uint8_t> bytes(num_rows);
+    for (auto& b : bytes) {
+        b = u(e) < percent ? 1 + u(e) % 255 : 0;
+    }
+    return bytes;
+}
+
+TEST(BitVecTest, Basic) {
+    for (int len : kLens) {
+        BitVec zeros(len);
+        BitVec ones(len, true);
+        ASSERT_EQ(zeros.count(), 0);
+        ASSERT_TRUE(zeros.none());
+        ASSERT_EQ(ones.count(), len);
+        ASSERT_TRUE(ones.all());
+        ASSERT_EQ((~zeros).count(), len);
+        ASSERT_EQ((~ones).count(), 0);
+        if (len > 0) {
+            ones.set(len - 1, false);
+            ASSERT_FALSE(ones[len - 1]);
+            ASSERT_EQ(ones.count(), len - 1);
+            // the flipped bits past len do not count
+            ASSERT_EQ((~ones).count(), 1);
+        }
+    }
+}
+
+TEST(BitVecTest, Logic) {
+    std::default_random_engine e(42);
+    for (int len : kLens) {
+        auto a_bytes = random_bytes(len, 50, e);
+        auto b_bytes = random_bytes(len, 30, e);
+        BitVec a = BitVec::from_bytes(a_bytes.data(), len);
+        BitVec b = BitVec::from_bytes(b_bytes.data(), len);
+        BitVec a_and = a & b;
+        BitVec a_or = a | b;
+        BitVec a_xor = a ^ b;
+        BitVec a_not = ~a;
+        BitVec a_and_not = a;
+        a_and_not.and_not(b);
+        int expect_count = 0;
+        for (int i = 0; i < len; ++i) {
+            bool x = a_bytes[i], y = b_bytes[i];
+            ASSERT_EQ(a[i], x);
+            ASSERT_EQ(a_and[i], x && y);
+            ASSERT_EQ(a_or[i], x || y);
+            ASSERT_EQ(a_xor[i], x != y);
+            ASSERT_EQ(a_not[i], !x);
+            ASSERT_EQ(a_and_not[i], x && !y);
+            expect_count += x;
+        }
+        ASSERT_EQ(a.count(), expect_count);
+        ASSERT_EQ(a_not.count(), len - expect_count);
+    }
+}
+
+TEST(BitVecTest, PackUnpack) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        for (int len : kLens) {
+            for (int percent : {0, 10, 50, 100}) {
+                auto bytes = random_bytes(len, percent, e);
+                BitVec bits = BitVec::from_bytes(bytes.data(), len);
+                std::vector<uint8_t> unpacked(len);
+                bits.to_bytes(unpacked.data());
+                int expect_count = 0;
+                for (int i = 0; i < len; ++i) {
+                    ASSERT_EQ(unpacked[i], bytes[i] != 0) << len << " rows, at " << i;
+                    expect_count += bytes[i] != 0;
+                }
+                ASSERT_EQ(bits.count(), expect_count);
+                ASSERT_EQ(bits.all(), expect_count == len);
+            }
+        }
+    });
+}
+
+template <typename T>
+void check_compare_bits(std::default_random_engine& e) {
+    std::uniform_int_distribution<int> u(-8, 8);
+    for (int len : kLens) {
+        Vec<T> lhs(len);
+        Vec<T> rhs(len);
+        for (int i = 0; i < len; ++i) {
+            lhs[i] = static_cast<T>(u(e));
+            rhs[i] = static_cast<T>(u(e));
+        }
+        if constexpr (sizeof(T) == 16) {
+            // high halves equal or not, low halves past 2^63
+            for (int i = 0; i < len; ++i) {
+                lhs[i] = lhs[i] * (T(1) << 62) + u(e);
+                rhs[i] = rhs[i] * (T(1) << 62) + u(e);
+            }
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            // only NE holds with NaN
+            for (int i = 0; i < len; i += 7) {
+                lhs[i] = std::numeric_limits<T>::quiet_NaN();
+            }
+        }
+        for (CompareOp op : {CompareOp::EQ, CompareOp::NE, CompareOp::LT, CompareOp::LE,
+                             CompareOp::GT, CompareOp::GE}) {
+            BitVec literal = lhs.compare_bits(op, 3);
+            BitVec column = lhs.compare_bits(op, rhs);
+            ASSERT_EQ(literal.len(), len);
+            for (int i = 0; i < len; ++i) {
+                T a = lhs[i], b = rhs[i];
+                bool expect_literal, expect_column;
+                switch (op) {
+                case CompareOp::EQ:
+                    expect_literal = a == T(3), expect_column = a == b;
+                    break;
+                case CompareOp::NE:
+                    expect_literal = a != T(3), expect_column = a != b;
+                    break;
+                case CompareOp::LT:
+                    expect_literal = a < T(3), expect_column = a < b;
+                    break;
+                case CompareOp::LE:
+                    expect_literal = a <= T(3), expect_column = a <= b;
+                    break;
+                case CompareOp::GT:
+                    expect_literal = a > T(3), expect_column = a > b;
+                    break;
+                default:
+                    expect_literal = a >= T(3), expect_column = a >= b;
+                    break;
+                }
+                ASSERT_EQ(literal[i], expect_literal)
+                        << "op " << static_cast<int>(op) << ", " << len << " rows, at " << i;
+                ASSERT_EQ(column[i], expect_column)
+                        << "op " << static_cast<int>(op) << ", " << len << " rows, at " << i;
+            }
+            // bits past len stay zero
+            ASSERT_EQ(literal.count() + (~literal).count(), len);
+            ASSERT_EQ(column.count() + (~column).count(), len);
+        }
+    }
+}
+
+TEST(BitVecTest, CompareBits) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        check_compare_bits<int32_t>(e);
+        check_compare_bits<int64_t>(e);
+        check_compare_bits<float>(e);
+        check_compare_bits<double>(e);
+        check_compare_bits<__int128>(e);
+        // no SIMD kernel
+        check_compare_bits<int16_t>(e);
+    });
+}
+
+// the literal is compared on its value, long double holds both sides exactly
+template <typename T, typename U>
+void check_compare_literal(const std::vector<T>& values, U literal) {
+    Vec<T> vec(values.size());
+    std::copy(values.begin(), values.end(), vec.data());
+    for (CompareOp op : {CompareOp::EQ, CompareOp::NE, CompareOp::LT, CompareOp::LE,
+                         CompareOp::GT, CompareOp::GE}) {
+        BitVec bits = vec.compare_bits(op, literal);
+        for (size_t i = 0; i < values.size(); ++i) {
+            long double a = values[i], b = literal;
+            bool expect;
+            switch (op) {
+            case CompareOp::EQ:
+                expect = a == b;
+                break;
+            case CompareOp::NE:
+                expect = a != b;
+                break;
+            case CompareOp::LT:
+                expect = a < b;
+                break;
+            case CompareOp::LE:
+                expect = a <= b;
+                break;
+            case CompareOp::GT:
+                expect = a > b;
+                break;
+            default:
+                expect = a >= b;
+                break;
+            }
+            ASSERT_EQ(bits[i], expect) << "op " << static_cast<int>(op) << ", literal " << b
+                                       << ", row " << a;
+        }
+        ASSERT_EQ(bits.count() + (~bits).count(), static_cast<int>(values.size()));
+    }
+}
+
+TEST(BitVecTest, CompareBitsLiteralRange) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for_each_simd_level([&] {
+        std::vector<int8_t> int8s;
+        for (int v = -128; v < 128; ++v) {
+            int8s.push_back(v);
+        }
+        check_compare_literal(int8s, 300);
+        check_compare_literal(int8s, -300);
+        check_compare_literal(int8s, 127);
+        check_compare_literal(int8s, -128);
+        check_compare_literal(int8s, 2.5);
+        check_compare_literal(int8s, -2.5);
+        check_compare_literal(int8s, 1e30);
+        check_compare_literal(int8s, nan);
+        check_compare_literal(int8s, std::numeric_limits<uint64_t>::max());
+
+        std::vector<uint32_t> uint32s = {0, 1, 2, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFE, 0xFFFFFFFF};
+        check_compare_literal(uint32s, -1);
+        check_compare_literal(uint32s, -0.5);
+        check_compare_literal(uint32s, int64_t(1) << 32);
+        check_compare_literal(uint32s, 0xFFFFFFFFu);
+
+        std::vector<int32_t> int32s(100);
+        for (int i = 0; i < 100; ++i) {
+            int32s[i] = (i - 50) * 40000000;
+        }
+        int32s[0] = std::numeric_limits<int32_t>::min();
+        int32s[99] = std::numeric_limits<int32_t>::max();
+        check_compare_literal(int32s, int64_t(3000000000));
+        check_compare_literal(int32s, int64_t(-3000000000));
+        check_compare_literal(int32s, 40000000.5);
+        check_compare_literal(int32s, -40000000.5);
+        check_compare_literal(int32s, 2147483648.0);
+
+        std::vector<int64_t> int64s = {std::numeric_limits<int64_t>::min(), -1, 0, 1,
+                                       std::numeric_limits<int64_t>::max()};
+        check_compare_literal(int64s, 9.3e18);
+        check_compare_literal(int64s, -9.3e18);
+        check_compare_literal(int64s, -9223372036854775808.0);
+        check_compare_literal(int64s, std::numeric_limits<uint64_t>::max());
+
+        const float inf = std::numeric_limits<float>::infinity();
+        std::vector<float> floats = {-inf, -1e30f, 0.0f, 0.1f, std::nextafter(0.1f, 1.0f),
+                                     std::nextafter(0.1f, 0.0f), 1.0f, 1e30f, inf,
+                                     std::numeric_limits<float>::quiet_NaN()};
+        check_compare_literal(floats, 0.1);
+        check_compare_literal(floats, 1.0);
+        check_compare_literal(floats, 1e300);
+        check_compare_literal(floats, -1e300);
+        check_compare_literal(floats, nan);
+    });
+}
+
+template <typename T>
+void check_filter_bits(std::default_random_engine& e) {
+    for (int len : kLens) {
+        for (int percent : {0, 5, 50, 95, 100}) {
+            auto bytes = random_bytes(len, percent, e);
+            BitVec bits = BitVec::from_bytes(bytes.data(), len);
+            std::vector<T> data(len);
+            std::vector<T> expect;
+            for (int i = 0; i < len; ++i) {
+                data[i] = static_cast<T>(e());
+                if (bytes[i]) expect.push_back(data[i]);
+            }
+
+            std::vector<T> dst(len + FILTER_DST_PADDING / sizeof(T));
+            size_t cnt = filter_bits(bits.words(), data.data(), len, dst.data());
+            dst.resize(cnt);
+            ASSERT_EQ(dst, expect) << len << " rows, " << percent << "%";
+
+            // in place
+            cnt = filter_bits(bits.words(), data.data(), len, data.data());
+            data.resize(cnt);
+            ASSERT_EQ(data, expect) << len << " rows, " << percent << "%, in place";
+        }
+    }
+}
+
+TEST(BitVecTest, FilterBits) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        check_filter_bits<uint8_t>(e);
+        check_filter_bits<uint16_t>(e);
+        check_filter_bits<uint32_t>(e);
+        check_filter_bits<uint64_t>(e);
+        check_filter_bits<double>(e);
+    });
+}
+
+TEST(BitVecTest, VecSelection) {
+    for_each_simd_level([] {
+        for (int len : kLens) {
+            Vec<int64_t> vec(len);
+            for (int i = 0; i < len; ++i) {
+                vec[i] = i;
+            }
+            // even and below len / 2, a conjunction of two predicates
+            Vec<int64_t> parity(len);
+            for (int i = 0; i < len; ++i) {
+                parity[i] = i % 2;
+            }
+            BitVec selector = vec.compare_bits(CompareOp::LT, len / 2) &
+                              parity.compare_bits(CompareOp::EQ, 0);
+            Vec<int64_t> selected = vec[selector];
+            ASSERT_EQ(selected.len(), selector.count());
+            for (int i = 0; i < selected.len(); ++i) {
+                ASSERT_EQ(selected[i], 2 * i);
+            }
+            vec.filter(selector);
+            ASSERT_EQ(vec.len(), selected.len());
+            for (int i = 0; i < vec.len(); ++i) {
+                ASSERT_EQ(vec[i], 2 * i);
+            }
+        }
+    });
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
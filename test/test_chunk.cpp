@@ -0,0 +1,205 @@
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vec/binary_vec.h"
+#include "vec/chunk.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// a chunk of an int64 column a, a double column b = a / 2 and a string column s, the
+// string of a
+static Chunk make_chunk(size_t num_rows) {
+    std::default_random_engine e(5);
+    Vec<int64_t> a(num_rows);
+    Vec<double> b(num_rows);
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < num_rows; ++i) {
+        a[i] = e() % 1000;
+        b[i] = a[i] / 2.0;
+        strings.push_back(std::to_string(a[i]));
+    }
+    std::vector<Slice> slices;
+    for (const auto& s : strings) {
+        slices.emplace_back(s.data(), s.size());
+    }
+    FlatBinaryVec s;
+    s.build_strings(slices);
+    Schema schema({{"a", DataType::INT64}, {"b", DataType::DOUBLE}, {"s", DataType::STRING}});
+    return Chunk(schema, {std::make_shared<FixedColumn<int64_t>>(std::move(a)),
+                          std::make_shared<FixedColumn<double>>(std::move(b)),
+                          std::make_shared<BinaryColumn>(std::move(s))});
+}
+
+// the selected rows agree with each other: b is a / 2 and s the string of a
+static void check_rows(const Chunk& chunk, const std::vector<int64_t>& expect) {
+    std::vector<int64_t> rows;
+    chunk.selection().for_each([&](size_t i) {
+        int64_t a = chunk.values<int64_t>(0)[i];
+        ASSERT_EQ(chunk.values<double>(1)[i], a / 2.0);
+        Slice s = chunk.strings(2).get_slice(i);
+        ASSERT_EQ(std::string(s.data, s.size), std::to_string(a));
+        rows.push_back(a);
+    });
+    ASSERT_EQ(rows, expect);
+    ASSERT_EQ(chunk.num_rows(), expect.size());
+}
+
+TEST(ChunkTest, Schema) {
+    Chunk chunk = make_chunk(100);
+    ASSERT_EQ(chunk.num_columns(), 3);
+    ASSERT_EQ(chunk.num_rows(), 100);
+    ASSERT_EQ(chunk.schema().index_of("b"), 1);
+    ASSERT_EQ(chunk.schema().index_of("c"), -1);
+    Vec<int32_t> c(100);
+    chunk.add_column({"c", DataType::INT32}, std::make_shared<FixedColumn<int32_t>>(c));
+    ASSERT_EQ(chunk.schema().index_of("c"), 3);
+    ASSERT_EQ(chunk.column(3)->type(), DataType::INT32);
+}
+
+// a conjunction narrows the selection, the columns keep all their rows
+TEST(ChunkTest, Filter) {
+    for (size_t num_rows : std::vector<size_t>{0, 1, 63, 64, 1000, DEFAULT_CHUNK_SIZE}) {
+        Chunk chunk = make_chunk(num_rows);
+        const Vec<int64_t> a = chunk.values<int64_t>(0);
+        chunk.filter(a.compare_bits(CompareOp::GE, 100));
+        if (num_rows >= 64) {
+            ASSERT_EQ(chunk.selection().kind(), Selection::Kind::BITMAP);
+        }
+        chunk.filter(chunk.values<double>(1).compare_bits(CompareOp::LT, 400.0));
+        std::vector<int64_t> expect;
+        for (size_t i = 0; i < num_rows; ++i) {
+            if (a[i] >= 100 && a[i] < 800) {
+                expect.push_back(a[i]);
+            }
+        }
+        check_rows(chunk, expect);
+        // the columns of a few rows may be compacted already
+        ASSERT_EQ(chunk.column(2)->size(), chunk.num_physical_rows());
+        if (num_rows >= 64) {
+            ASSERT_EQ(chunk.num_physical_rows(), num_rows);
+        }
+
+        chunk.materialize();
+        ASSERT_TRUE(chunk.selection().all());
+        ASSERT_EQ(chunk.num_physical_rows(), expect.size());
+        for (size_t c = 0; c < chunk.num_columns(); ++c) {
+            ASSERT_EQ(chunk.column(c)->size(), expect.size());
+        }
+        check_rows(chunk, expect);
+    }
+}
+
+TEST(ChunkTest, Indices) {
+    Chunk chunk = make_chunk(1000);
+    const Vec<int64_t> a = chunk.values<int64_t>(0);
+    std::vector<uint16_t> indices;
+    for (uint16_t i = 0; i < 1000; i += 3) {
+        indices.push_back(i);
+    }
+    chunk.set_selection(Selection(1000, indices));
+    chunk.filter(a.compare_bits(CompareOp::LT, 500));
+    ASSERT_EQ(chunk.selection().kind(), Selection::Kind::INDICES);
+    std::vector<int64_t> expect;
+    for (uint16_t i : indices) {
+        if (a[i] < 500) {
+            expect.push_back(a[i]);
+        }
+    }
+    check_rows(chunk, expect);
+    BitVec bits = chunk.selection().to_bits();
+    ASSERT_EQ(bits.count(), expect.size());
+    chunk.materialize();
+    check_rows(chunk, expect);
+}
+
+// a column shared with a projection is copied by materialize()
+TEST(ChunkTest, SharedColumns) {
+    Chunk chunk = make_chunk(1000);
+    Chunk projection(Schema({chunk.schema().field(0)}), {chunk.column(0)});
+    chunk.filter(chunk.values<int64_t>(0).compare_bits(CompareOp::EQ, 7));
+    chunk.materialize();
+    ASSERT_EQ(projection.num_rows(), 1000);
+    ASSERT_EQ(projection.column(0)->size(), 1000);
+    for (size_t i = 0; i < chunk.num_rows(); ++i) {
+        ASSERT_EQ(chunk.values<int64_t>(0)[i], 7);
+    }
+}
+
+// the kind of the selection follows the share of the rows left
+TEST(ChunkTest, Adaptive) {
+    for (auto [percent, kind] : {std::pair{90, Selection::Kind::BITMAP},
+                                 {30, Selection::Kind::BITMAP},
+                                 {10, Selection::Kind::BITMAP},
+                                 {5, Selection::Kind::INDICES},
+                                 {2, Selection::Kind::INDICES},
+                                 {1, Selection::Kind::ALL},
+                                 {0, Selection::Kind::ALL}}) {
+        Chunk chunk = make_chunk(DEFAULT_CHUNK_SIZE);
+        const Vec<int64_t> a = chunk.values<int64_t>(0);
+        chunk.filter(a.compare_bits(CompareOp::LT, percent * 10));
+        ASSERT_EQ(chunk.selection().kind(), kind) << percent;
+        std::vector<int64_t> expect;
+        for (int i = 0; i < a.len(); ++i) {
+            if (a[i] < percent * 10) {
+                expect.push_back(a[i]);
+            }
+        }
+        check_rows(chunk, expect);
+        if (kind == Selection::Kind::ALL) {
+            ASSERT_EQ(chunk.num_physical_rows(), expect.size());
+        }
+    }
+}
+
+// the kernels give the same rows and sums for every kind of selection
+TEST(ChunkTest, Kernels) {
+    std::default_random_engine e(9);
+    for (int num_rows : {0, 1, 64, 100, 4096}) {
+        Vec<int32_t> values(num_rows);
+        BitVec bits(num_rows);
+        std::vector<int32_t> expect;
+        for (int i = 0; i < num_rows; ++i) {
+            values[i] = int(e() % 1000) - 500;
+            bits.set(i, e() % 3 == 0);
+            if (bits[i]) {
+                expect.push_back(values[i]);
+            }
+        }
+        int64_t expect_sum = 0;
+        for (int32_t value : expect) {
+            expect_sum += value;
+        }
+        Selection bitmap(bits);
+        Selection selections[] = {bitmap, Selection(num_rows, bitmap.to_indices())};
+        for (const auto& selection : selections) {
+            ASSERT_EQ(selection.count(), expect.size());
+            ASSERT_EQ(sum_rows(values.data(), selection), expect_sum);
+            std::vector<int32_t> dst(expect.size() + FILTER_DST_PADDING);
+            ASSERT_EQ(select_rows(values.data(), selection, dst.data()), expect.size());
+            dst.resize(expect.size());
+            ASSERT_EQ(dst, expect);
+        }
+        Selection all(num_rows);
+        int64_t sum = 0;
+        for (int i = 0; i < num_rows; ++i) {
+            sum += values[i];
+        }
+        ASSERT_EQ(sum_rows(values.data(), all), sum);
+    }
+    // an int64 sum wraps
+    const int64_t wrap[] = {std::numeric_limits<int64_t>::max(), 1};
+    ASSERT_EQ(sum_rows(wrap, Selection(2)), std::numeric_limits<int64_t>::min());
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
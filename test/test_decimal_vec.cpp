@@ -0,0 +1,272 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vec/decimal_vec.h"
+
+namespace vec {
+
+// rows of DECIMAL(precision, scale), a null row every null_every rows (0: none)
+DecimalVec make_decimal(int precision, int scale, const std::vector<__int128>& values,
+                        int null_every = 0) {
+    NullableVec<__int128> res;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (null_every > 0 && i % null_every == 0) {
+            res.push_back_null();
+        } else {
+            res.push_back(values[i]);
+        }
+    }
+    return DecimalVec(precision, scale, std::move(res));
+}
+
+__int128 pow10(int k) {
+    __int128 res = 1;
+    while (k-- > 0) {
+        res *= 10;
+    }
+    return res;
+}
+
+// random values of at most digits digits
+std::vector<__int128> random_values(size_t num_rows, int digits, std::default_random_engine& e) {
+    std::vector<__int128> values(num_rows);
+    const unsigned __int128 range = static_cast<unsigned __int128>(pow10(digits));
+    for (auto& value : values) {
+        unsigned __int128 bits = (static_cast<unsigned __int128>(e()) << 64) | e();
+        __int128 magnitude = static_cast<__int128>(bits % range);
+        value = e() % 2 ? -magnitude : magnitude;
+    }
+    return values;
+}
+
+void encode_be(__int128 value, int binsz, uint8_t* dst) {
+    for (int i = binsz - 1; i >= 0; --i) {
+        dst[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+TEST(DecimalVecTest, ToString) {
+    DecimalVec a = make_decimal(9, 2, {1230, -1230, 5, -5, 0, 100000});
+    std::vector<std::string> expect = {"12.30", "-12.30", "0.05", "-0.05", "0.00", "1000.00"};
+    for (int i = 0; i < a.len(); ++i) {
+        ASSERT_EQ(a.to_string(i), expect[i]);
+    }
+    DecimalVec b = make_decimal(38, 0, {pow10(38) - 1, 0}, 2);
+    ASSERT_EQ(b.to_string(0), "NULL");
+    ASSERT_EQ(b.to_string(1), "0");
+    b = make_decimal(38, 38, {-(pow10(38) - 1)});
+    ASSERT_EQ(b.to_string(0), "-0." + std::string(38, '9'));
+}
+
+// the bytes of a FIXED_LEN_BYTE_ARRAY column, the null rows have none
+TEST(DecimalVecTest, Decode) {
+    std::default_random_engine e(42);
+    for (int binsz = 1; binsz <= 16; ++binsz) {
+        // the digits binsz bytes always hold
+        int precision = std::max(1, std::min(DecimalVec::MAX_PRECISION, binsz * 12 / 5 - 1));
+        for (int num_rows : {0, 1, 7, 1000}) {
+            auto values = random_values(num_rows, precision, e);
+            std::vector<uint8_t> src(num_rows * binsz);
+            std::vector<uint8_t> nulls(num_rows);
+            std::vector<uint8_t> nullable_src;
+            for (int i = 0; i < num_rows; ++i) {
+                encode_be(values[i], binsz, src.data() + i * binsz);
+                nulls[i] = i % 5 == 1;
+                if (!nulls[i]) {
+                    nullable_src.resize(nullable_src.size() + binsz);
+                    encode_be(values[i], binsz, nullable_src.data() + nullable_src.size() - binsz);
+                }
+            }
+            DecimalVec a = DecimalVec::decode(precision, 0, src.data(), binsz, num_rows);
+            DecimalVec b = DecimalVec::decode(precision, 0, nullable_src.data(), binsz, num_rows,
+                                              nulls.data());
+            ASSERT_EQ(a.len(), num_rows);
+            ASSERT_EQ(b.len(), num_rows);
+            ASSERT_FALSE(a.has_null());
+            ASSERT_EQ(b.has_null(), num_rows > 1);
+            for (int i = 0; i < num_rows; ++i) {
+                ASSERT_TRUE(a[i] == values[i]) << "binsz " << binsz << ", at " << i;
+                ASSERT_EQ(b.is_null(i), nulls[i] != 0);
+                ASSERT_TRUE(b[i] == (nulls[i] ? 0 : values[i])) << "binsz " << binsz;
+            }
+        }
+    }
+}
+
+// 2 * |remainder| >= divisor rounds away from zero
+TEST(DecimalVecTest, ScaleDown) {
+    DecimalVec a = make_decimal(6, 3, {1250, -1250, 1249, -1249, 1500, 0, 999999, -999999});
+    // a digit more, 999.999 is 1000.0
+    DecimalVec b = a.rescale(1);
+    ASSERT_EQ(b.precision(), 5);
+    ASSERT_EQ(b.scale(), 1);
+    std::vector<__int128> expect = {13, -13, 12, -12, 15, 0, 10000, -10000};
+    for (int i = 0; i < b.len(); ++i) {
+        ASSERT_TRUE(b[i] == expect[i]) << i;
+    }
+    DecimalVec c = a.rescale(0);
+    ASSERT_EQ(c.precision(), 4);
+    ASSERT_EQ(c.to_string(0), "1");
+    ASSERT_EQ(c.to_string(6), "1000");
+
+    // over int64 and by more than 10^18, the same rounding
+    std::default_random_engine e(7);
+    for (int digits : {18, 38}) {
+        auto values = random_values(1000, digits, e);
+        DecimalVec d = make_decimal(38, 30, values, 3);
+        for (int scale : {29, 20, 11, 0}) {
+            DecimalVec r = d.rescale(scale);
+            __int128 divisor = pow10(30 - scale);
+            for (int i = 0; i < r.len(); ++i) {
+                ASSERT_EQ(r.is_null(i), i % 3 == 0);
+                if (r.is_null(i)) {
+                    continue;
+                }
+                __int128 v = values[i];
+                __int128 q = v / divisor;
+                __int128 twice = (v % divisor) * 2;
+                if (twice >= divisor || twice <= -divisor) {
+                    q += v < 0 ? -1 : 1;
+                }
+                ASSERT_TRUE(r[i] == q) << digits << " digits, scale " << scale << ", at " << i;
+            }
+        }
+    }
+}
+
+TEST(DecimalVecTest, ScaleUp) {
+    DecimalVec a = make_decimal(5, 2, {12345, -12345, 1, 0}, 0);
+    DecimalVec b = a.rescale(4);
+    ASSERT_EQ(b.precision(), 7);
+    ASSERT_EQ(b.to_string(0), "123.4500");
+    ASSERT_EQ(b.to_string(1), "-123.4500");
+    ASSERT_FALSE(b.has_null());
+
+    // past 38 digits a value is null
+    DecimalVec c = make_decimal(38, 0, {7, pow10(35) - 1, pow10(35), -pow10(35), 8, -9}, 4);
+    DecimalVec d = c.rescale(3);
+    ASSERT_EQ(d.precision(), 38);
+    ASSERT_EQ(d.scale(), 3);
+    ASSERT_TRUE(d.is_null(0));
+    ASSERT_TRUE(d[1] == (pow10(35) - 1) * 1000);
+    ASSERT_TRUE(d.is_null(2));
+    ASSERT_TRUE(d.is_null(3));
+    ASSERT_TRUE(d[2] == 0);
+    ASSERT_TRUE(d.is_null(4));
+    ASSERT_TRUE(d[5] == -9000);
+}
+
+TEST(DecimalVecTest, AddSub) {
+    std::default_random_engine e(11);
+    const int num_rows = 1000;
+    // DECIMAL(10, 2) and DECIMAL(12, 5): DECIMAL(14, 5)
+    auto x = random_values(num_rows, 10, e);
+    auto y = random_values(num_rows, 12, e);
+    for (auto [x_nulls, y_nulls] : {std::pair{0, 0}, {3, 0}, {0, 5}, {3, 5}}) {
+        DecimalVec a = make_decimal(10, 2, x, x_nulls);
+        DecimalVec b = make_decimal(12, 5, y, y_nulls);
+        DecimalVec sum = a + b;
+        DecimalVec diff = a - b;
+        DecimalVec reversed = b - a;
+        ASSERT_EQ(sum.precision(), 14);
+        ASSERT_EQ(sum.scale(), 5);
+        for (int i = 0; i < num_rows; ++i) {
+            bool is_null = (x_nulls > 0 && i % x_nulls == 0) || (y_nulls > 0 && i % y_nulls == 0);
+            ASSERT_EQ(sum.is_null(i), is_null);
+            ASSERT_EQ(reversed.is_null(i), is_null);
+            if (is_null) {
+                ASSERT_TRUE(sum[i] == 0);
+                continue;
+            }
+            ASSERT_TRUE(sum[i] == x[i] * 1000 + y[i]) << i;
+            ASSERT_TRUE(diff[i] == x[i] * 1000 - y[i]) << i;
+            ASSERT_TRUE(reversed[i] == y[i] - x[i] * 1000) << i;
+        }
+    }
+
+    // DECIMAL(38, 0) + DECIMAL(38, 0) is capped, the overflows are null
+    __int128 max_value = pow10(38) - 1;
+    DecimalVec a = make_decimal(38, 0, {max_value, max_value, -max_value, 5});
+    DecimalVec b = make_decimal(38, 0, {1, -1, -1, -pow10(37)});
+    DecimalVec sum = a + b;
+    ASSERT_EQ(sum.precision(), 38);
+    ASSERT_TRUE(sum.is_null(0));
+    ASSERT_TRUE(sum[1] == max_value - 1);
+    ASSERT_TRUE(sum.is_null(2));
+    ASSERT_TRUE(sum[3] == 5 - pow10(37));
+    DecimalVec diff = a - b;
+    ASSERT_TRUE(diff[0] == max_value - 1);
+    ASSERT_TRUE(diff.is_null(1));
+    ASSERT_TRUE(diff[2] == -max_value + 1);
+
+    // and with a scale too large to multiply
+    DecimalVec c = make_decimal(38, 10, {1, 2});
+    DecimalVec d = make_decimal(38, 0, {pow10(30), 1});
+    DecimalVec wide = c + d;
+    ASSERT_EQ(wide.scale(), 10);
+    ASSERT_TRUE(wide.is_null(0));
+    ASSERT_EQ(wide.to_string(1), "1.0000000002");
+}
+
+TEST(DecimalVecTest, Compare) {
+    std::default_random_engine e(13);
+    const int num_rows = 1000;
+    auto x = random_values(num_rows, 6, e);
+    auto y = random_values(num_rows, 36, e);
+    for (size_t i = 0; i < x.size(); i += 4) {
+        // equal at the scale of b
+        y[i] = x[i] * pow10(4);
+    }
+    DecimalVec a = make_decimal(6, 0, x, 7);
+    DecimalVec b = make_decimal(38, 4, y);
+    DecimalVec c = make_decimal(38, 38, y);
+    for (CompareOp op : {CompareOp::EQ, CompareOp::NE, CompareOp::LT, CompareOp::LE,
+                         CompareOp::GT, CompareOp::GE}) {
+        BitVec ab = a.compare_bits(op, b);
+        BitVec ba = b.compare_bits(op, a);
+        BitVec literal = a.compare_bits(op, 12345, 2);
+        // the literal has more digits than the column
+        BitVec fraction = b.compare_bits(op, pow10(20) + 1, 24);
+        BitVec ca = c.compare_bits(op, a);
+        for (int i = 0; i < num_rows; ++i) {
+            auto check = [&](__int128 lhs, __int128 rhs) {
+                switch (op) {
+                case CompareOp::EQ:
+                    return lhs == rhs;
+                case CompareOp::NE:
+                    return lhs != rhs;
+                case CompareOp::LT:
+                    return lhs < rhs;
+                case CompareOp::LE:
+                    return lhs <= rhs;
+                case CompareOp::GT:
+                    return lhs > rhs;
+                default:
+                    return lhs >= rhs;
+                }
+            };
+            bool a_null = i % 7 == 0;
+            ASSERT_EQ(ab[i], !a_null && check(x[i] * pow10(4), y[i])) << i;
+            ASSERT_EQ(ba[i], !a_null && check(y[i], x[i] * pow10(4))) << i;
+            ASSERT_EQ(literal[i], !a_null && check(x[i] * 100, 12345)) << i;
+            // y * 10^20 against 10^20 + 1
+            ASSERT_EQ(fraction[i], check(y[i] == 0 ? 0 : y[i] > 0 ? 2 : -2, 1)) << i;
+            // |c| < 1 and |a| >= 1 unless a is 0
+            int sign = x[i] > 0 ? 1 : x[i] < 0 ? -1 : 0;
+            if (!a_null && sign != 0) {
+                ASSERT_EQ(ca[i], check(0, sign)) << i;
+            }
+        }
+    }
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/filter.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+template <typename T>
+std::vector<T> reference_filter(const std::vector<uint8_t>& selection, const std::vector<T>& data) {
+    std::vector<T> res;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (selection[i]) res.push_back(data[i]);
+    }
+    return res;
+}
+
+// selected with probability percent / 100, selected bytes are not always 1
+std::vector<uint8_t> make_selection(size_t num_rows, int percent, std::default_random_engine& e) {
+    std::uniform_int_distribution<int> u(0, 99);
+    std::vector<uint8_t> selection(num_rows);
+    for (auto& s : selection) {
+        s = u(e) < percent ? 1 + u(e) % 255 : 0;
+    }
+    return selection;
+}
+
+template <typename T>
+void check_filter_at_level() {
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int64_t> u(-1000000, 1000000);
+    for (size_t num_rows : {0, 1, 7, 15, 16, 17, 31, 33, 63, 64, 65, 100, 129, 1000, 4096, 4099}) {
+        for (int percent : {0, 1, 50, 90, 99, 100}) {
+            std::vector<T> data(num_rows);
+            for (auto& v : data) {
+                v = static_cast<T>(u(e));
+            }
+            auto selection = make_selection(num_rows, percent, e);
+            auto expect = reference_filter(selection, data);
+            ASSERT_EQ(count_nonzero(selection.data(), num_rows), expect.size());
+
+            // separated destination with the required padding
+            std::vector<T> dst(expect.size() + FILTER_DST_PADDING / sizeof(T) + 1);
+            size_t cnt = filter(selection.data(), data.data(), num_rows, dst.data());
+            ASSERT_EQ(cnt, expect.size());
+            dst.resize(cnt);
+            ASSERT_EQ(dst, expect) << num_rows << " rows, " << percent << "%";
+
+            // in-place
+            cnt = filter(selection.data(), data.data(), num_rows, data.data());
+            ASSERT_EQ(cnt, expect.size());
+            data.resize(cnt);
+            ASSERT_EQ(data, expect) << num_rows << " rows, " << percent << "%";
+        }
+    }
+}
+
+template <typename T>
+void check_filter() {
+    for_each_simd_level(check_filter_at_level<T>);
+}
+
+TEST(FilterTest, Int8) {
+    check_filter<int8_t>();
+}
+
+TEST(FilterTest, Int16) {
+    check_filter<int16_t>();
+}
+
+TEST(FilterTest, Int32) {
+    check_filter<int32_t>();
+}
+
+TEST(FilterTest, Int64) {
+    check_filter<int64_t>();
+}
+
+TEST(FilterTest, Double) {
+    check_filter<double>();
+}
+
+TEST(FilterTest, Int128) {
+    check_filter<__int128>();
+}
+
+TEST(FilterTest, VecSelection) {
+    std::default_random_engine e(7);
+    const int num_rows = 4096;
+    Vec<int> ivec(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        ivec[i] = i;
+    }
+
+    auto selected = ivec[ivec > 100];
+    ASSERT_EQ(selected.len(), num_rows - 101);
+    ASSERT_LT(selected.capacity(), num_rows);
+    ASSERT_EQ(selected[0], 101);
+
+    // fast paths
+    ASSERT_EQ(ivec[ivec < 0].len(), 0);
+    auto all = ivec[ivec >= 0];
+    ASSERT_EQ(all.len(), num_rows);
+    ASSERT_EQ(all[num_rows - 1], num_rows - 1);
+
+    auto selection = make_selection(num_rows, 30, e);
+    Vec<bool> selector(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        selector[i] = selection[i] != 0;
+    }
+    std::vector<int> data(ivec.begin(), ivec.end());
+    auto expect = reference_filter(selection, data);
+
+    auto copied = ivec[selector];
+    ASSERT_EQ(std::vector<int>(copied.begin(), copied.end()), expect);
+
+    // in-place keeps the buffer
+    int* buffer = ivec.data();
+    ivec.filter(selector);
+    ASSERT_EQ(ivec.data(), buffer);
+    ASSERT_EQ(std::vector<int>(ivec.begin(), ivec.end()), expect);
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/hash.h"
+
+namespace vec {
+
+constexpr HashFunc ALL_FUNCS[] = {HashFunc::FNV1A, HashFunc::CRC32C, HashFunc::MURMUR3};
+
+uint32_t hash_string(HashFunc func, const std::string& s, uint32_t seed) {
+    return hash_bytes(func, s.data(), s.size(), seed);
+}
+
+TEST(HashTest, KnownValues) {
+    for_each_simd_level([] {
+        ASSERT_EQ(hash_string(HashFunc::FNV1A, "", FNV1A_SEED), FNV1A_SEED);
+        ASSERT_EQ(hash_string(HashFunc::FNV1A, "a", FNV1A_SEED), 0xE40C292Cu);
+        ASSERT_EQ(hash_string(HashFunc::FNV1A, "foobar", FNV1A_SEED), 0xBF9CF968u);
+        // the standard crc32c inverts the crc before and after
+        ASSERT_EQ(~hash_string(HashFunc::CRC32C, "123456789", CRC32C_SEED), 0xE3069283u);
+        ASSERT_EQ(hash_string(HashFunc::MURMUR3, "", 0), 0u);
+        ASSERT_EQ(hash_string(HashFunc::MURMUR3, "", 1), 0x514E28B7u);
+        ASSERT_EQ(hash_string(HashFunc::MURMUR3, "Hello, world!", 1234), 0xFAF6CDB3u);
+        ASSERT_EQ(hash_string(HashFunc::MURMUR3, "The quick brown fox jumps over the lazy dog", 0),
+                  0x2E4FF723u);
+    });
+}
+
+// an integer row hashes as its bytes, every size checks the tail of the vector loops
+template <typename T>
+void check_ints() {
+    std::default_random_engine e(42);
+    std::vector<T> keys(1000);
+    for (auto& key : keys) {
+        key = static_cast<T>(e() * uint64_t(0x9E3779B97F4A7C15));
+    }
+    keys[0] = 0;
+    keys[1] = -1;
+    for (HashFunc func : ALL_FUNCS) {
+        for (size_t num_rows : {0, 1, 7, 8, 15, 16, 17, 33, 1000}) {
+            std::vector<uint32_t> hashes(num_rows);
+            hash_column(func, keys.data(), num_rows, 17, hashes.data());
+            for (size_t i = 0; i < num_rows; ++i) {
+                ASSERT_EQ(hashes[i], hash_bytes(func, &keys[i], sizeof(T), 17))
+                        << static_cast<int>(func) << " " << num_rows << " rows, row " << i;
+            }
+        }
+    }
+}
+
+TEST(HashTest, Int32) {
+    for_each_simd_level([] { check_ints<int32_t>(); });
+}
+
+TEST(HashTest, Int64) {
+    for_each_simd_level([] { check_ints<int64_t>(); });
+}
+
+TEST(HashTest, Strings) {
+    std::vector<std::string> strings;
+    for (int i = 0; i < 300; ++i) {
+        strings.push_back(std::string(i % 41, 'x') + std::to_string(i));
+    }
+    strings.push_back("");
+    std::vector<Slice> slices;
+    for (const auto& s : strings) {
+        slices.emplace_back(s.data(), s.size());
+    }
+    FlatBinaryVec flat;
+    flat.build_strings(slices);
+    InlineBinaryVec inlined;
+    inlined.build_strings(slices);
+    ASSERT_EQ(flat.size(), slices.size());
+    ASSERT_EQ(inlined.size(), slices.size());
+    for_each_simd_level([&] {
+        for (HashFunc func : ALL_FUNCS) {
+            std::vector<uint32_t> hashes(slices.size());
+            std::vector<uint32_t> flat_hashes(slices.size());
+            std::vector<uint32_t> inline_hashes(slices.size());
+            hash_column(func, slices.data(), slices.size(), 5, hashes.data());
+            hash_column(func, flat, 5, flat_hashes.data());
+            hash_column(func, inlined, 5, inline_hashes.data());
+            for (size_t i = 0; i < strings.size(); ++i) {
+                ASSERT_EQ(hashes[i], hash_string(func, strings[i], 5)) << strings[i];
+            }
+            ASSERT_EQ(flat_hashes, hashes);
+            ASSERT_EQ(inline_hashes, hashes);
+        }
+    });
+}
+
+// a key of an int64 column and a string column
+TEST(HashTest, Combine) {
+    Vec<int64_t> ids(100);
+    std::vector<std::string> names;
+    std::vector<Slice> slices;
+    for (int i = 0; i < 100; ++i) {
+        ids[i] = i * 1000003;
+        names.push_back("name" + std::to_string(i % 7));
+    }
+    for (const auto& name : names) {
+        slices.emplace_back(name.data(), name.size());
+    }
+    for_each_simd_level([&] {
+        for (HashFunc func : ALL_FUNCS) {
+            std::vector<uint32_t> hashes(100);
+            hash_column(func, ids, 3, hashes.data());
+            hash_combine(func, slices.data(), slices.size(), hashes.data());
+            for (int i = 0; i < 100; ++i) {
+                uint32_t expect = hash_bytes(func, &ids[i], 8, 3);
+                ASSERT_EQ(hashes[i], hash_string(func, names[i], expect));
+            }
+        }
+    });
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
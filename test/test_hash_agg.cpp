@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vec/hash_agg.h"
+
+namespace vec {
+
+struct Expected {
+    int64_t sum = 0;
+    int64_t count = 0;
+    int32_t min = std::numeric_limits<int32_t>::max();
+    int32_t max = std::numeric_limits<int32_t>::min();
+};
+
+// Slice keys are checked by value
+template <typename K>
+using RefKey = std::conditional_t<std::is_same_v<K, Slice>, std::string, K>;
+
+template <typename K>
+RefKey<K> ref_key(const K& key) {
+    if constexpr (std::is_same_v<K, Slice>) {
+        return std::string(key.data, key.size);
+    } else {
+        return key;
+    }
+}
+
+// batches of random keys against a std::map, every aggregate of an int32 column
+template <typename K>
+void check_aggregate(const std::function<K(uint64_t)>& make_key, size_t num_distinct) {
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<uint64_t> u(0, num_distinct - 1);
+    std::uniform_int_distribution<int32_t> v(-1000000, 1000000);
+
+    GroupByHashTable<K> table;
+    AggColumn<AggFunc::SUM, int32_t> sum;
+    AggColumn<AggFunc::COUNT, int32_t> count;
+    AggColumn<AggFunc::MIN, int32_t> min;
+    AggColumn<AggFunc::MAX, int32_t> max;
+    AggColumn<AggFunc::AVG, int32_t> avg;
+    std::map<RefKey<K>, Expected> expected;
+    // the key of every group, in order of first appearance
+    std::vector<RefKey<K>> first_seen;
+
+    std::vector<uint32_t> group_ids(4096);
+    for (size_t batch_size : {4096, 1, 0, 1000, 4096, 4096}) {
+        std::vector<K> keys(batch_size);
+        std::vector<int32_t> values(batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            keys[i] = make_key(u(e));
+            values[i] = v(e);
+            auto [it, inserted] = expected.emplace(ref_key(keys[i]), Expected());
+            if (inserted) {
+                first_seen.push_back(it->first);
+            }
+            Expected& exp = it->second;
+            exp.sum += values[i];
+            exp.count++;
+            exp.min = std::min(exp.min, values[i]);
+            exp.max = std::max(exp.max, values[i]);
+        }
+        table.find_or_insert(keys.data(), batch_size, group_ids.data());
+        sum.update(group_ids.data(), values.data(), batch_size, table.num_groups());
+        count.update(group_ids.data(), nullptr, batch_size, table.num_groups());
+        min.update(group_ids.data(), values.data(), batch_size, table.num_groups());
+        max.update(group_ids.data(), values.data(), batch_size, table.num_groups());
+        avg.update(group_ids.data(), values.data(), batch_size, table.num_groups());
+        ASSERT_EQ(table.num_groups(), expected.size());
+    }
+
+    auto sums = sum.finalize();
+    auto counts = count.finalize();
+    auto mins = min.finalize();
+    auto maxs = max.finalize();
+    auto avgs = avg.finalize();
+    ASSERT_EQ(sums.len(), table.num_groups());
+    for (size_t g = 0; g < table.num_groups(); ++g) {
+        ASSERT_EQ(ref_key(table.keys()[g]), first_seen[g]);
+        const Expected& exp = expected[first_seen[g]];
+        ASSERT_EQ(sums[g], exp.sum);
+        ASSERT_EQ(counts[g], exp.count);
+        ASSERT_EQ(mins[g], exp.min);
+        ASSERT_EQ(maxs[g], exp.max);
+        ASSERT_DOUBLE_EQ(avgs[g], static_cast<double>(exp.sum) / exp.count);
+    }
+}
+
+TEST(HashAggTest, Int32) {
+    for (size_t num_distinct : {1, 100, 100000}) {
+        check_aggregate<int32_t>([](uint64_t v) { return static_cast<int32_t>(v * 7919) - 50; },
+                                 num_distinct);
+    }
+}
+
+TEST(HashAggTest, Int64) {
+    for (size_t num_distinct : {1, 100, 100000}) {
+        // keys differing in the high half only
+        check_aggregate<int64_t>([](uint64_t v) { return static_cast<int64_t>(v << 32); },
+                                 num_distinct);
+    }
+}
+
+TEST(HashAggTest, Slice) {
+    std::vector<std::string> strings;
+    for (int i = 0; i < 100000; ++i) {
+        // the empty string, short and long keys with a common prefix
+        strings.push_back(i == 0 ? std::string()
+                                 : std::string(i % 3 * 10, 'x') + std::to_string(i));
+    }
+    for (size_t num_distinct : {1, 100, 100000}) {
+        // the batch strings die with the batch, the table keeps copies
+        check_aggregate<Slice>(
+                [&](uint64_t v) { return Slice(strings[v].data(), strings[v].size()); },
+                num_distinct);
+    }
+}
+
+// a FlatBinaryVec batch gets the group ids of the same rows as Slices
+TEST(HashAggTest, FlatBinaryVec) {
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int> u(0, 499);
+    GroupByHashTable<Slice> flat_table;
+    GroupByHashTable<Slice> slice_table;
+    for (size_t batch_size : {1000, 0, 1, 4096}) {
+        std::vector<std::string> strings(batch_size);
+        std::vector<Slice> slices;
+        for (auto& s : strings) {
+            int v = u(e);
+            s = v == 0 ? std::string() : std::string(v % 3 * 10, 'y') + std::to_string(v);
+            slices.emplace_back(s.data(), s.size());
+        }
+        FlatBinaryVec column;
+        column.build_strings(slices);
+        std::vector<uint32_t> flat_ids(batch_size);
+        std::vector<uint32_t> slice_ids(batch_size);
+        flat_table.find_or_insert(column, flat_ids.data());
+        slice_table.find_or_insert(slices.data(), slices.size(), slice_ids.data());
+        ASSERT_EQ(flat_ids, slice_ids);
+        ASSERT_EQ(flat_table.num_groups(), slice_table.num_groups());
+    }
+    // the table owns copies of the keys, not the bytes of the column
+    for (size_t g = 0; g < flat_table.num_groups(); ++g) {
+        ASSERT_EQ(flat_table.keys()[g], slice_table.keys()[g]) << g;
+    }
+}
+
+// group ids are the order of first appearance, whichever way they are found
+template <typename K>
+void check_group_ids(GroupByHashTable<K>* table, const std::vector<K>& keys,
+                     std::map<K, uint32_t>* expected) {
+    std::vector<uint32_t> group_ids(keys.size());
+    table->find_or_insert(keys.data(), keys.size(), group_ids.data());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        uint32_t group = expected->emplace(keys[i], expected->size()).first->second;
+        ASSERT_EQ(group_ids[i], group) << keys[i];
+    }
+    ASSERT_EQ(table->num_groups(), expected->size());
+}
+
+TEST(HashAggTest, DenseGroups) {
+    std::default_random_engine e(42);
+    auto random_keys = [&](int64_t min, int64_t max) {
+        std::uniform_int_distribution<int64_t> u(min, max);
+        std::vector<int64_t> keys(4096);
+        for (auto& key : keys) {
+            key = u(e);
+        }
+        return keys;
+    };
+    GroupByHashTable<int64_t> table;
+    std::map<int64_t, uint32_t> expected;
+    ASSERT_TRUE(table.is_dense());
+    check_group_ids(&table, random_keys(-10, 10), &expected);
+    ASSERT_TRUE(table.is_dense());
+    // the window grows on both sides
+    check_group_ids(&table, random_keys(0, 1000), &expected);
+    check_group_ids(&table, random_keys(-30000, 0), &expected);
+    check_group_ids(&table, random_keys(-30000, 35000), &expected);
+    ASSERT_TRUE(table.is_dense());
+    // a span of 2^16 values or more goes to the hash table, with the same groups
+    check_group_ids(&table, {35536, std::numeric_limits<int64_t>::max(), 7}, &expected);
+    ASSERT_FALSE(table.is_dense());
+    check_group_ids(&table, random_keys(-30000, 35000), &expected);
+    check_group_ids(&table, {std::numeric_limits<int64_t>::min()}, &expected);
+
+    table.clear();
+    expected.clear();
+    ASSERT_TRUE(table.is_dense());
+    check_group_ids(&table, {std::numeric_limits<int64_t>::min(), 5}, &expected);
+    ASSERT_FALSE(table.is_dense());
+
+    GroupByHashTable<int32_t> hashed(0);
+    std::map<int32_t, uint32_t> expected32;
+    check_group_ids(&hashed, {1, 2, 1, 3}, &expected32);
+    ASSERT_FALSE(hashed.is_dense());
+    GroupByHashTable<int32_t> extremes;
+    std::map<int32_t, uint32_t> expected_extremes;
+    check_group_ids(&extremes, {std::numeric_limits<int32_t>::max() - 1}, &expected_extremes);
+    check_group_ids(&extremes, {std::numeric_limits<int32_t>::max()}, &expected_extremes);
+    ASSERT_TRUE(extremes.is_dense());
+}
+
+// a long run of one key, the same key in every state copy
+TEST(HashAggTest, Runs) {
+    std::vector<uint32_t> group_ids(4099, 1);
+    group_ids[0] = 0;
+    std::vector<int32_t> values(group_ids.size(), 2);
+    values[7] = -5;
+    AggColumn<AggFunc::SUM, int32_t> sum;
+    AggColumn<AggFunc::MIN, int32_t> min;
+    AggColumn<AggFunc::AVG, int32_t> avg;
+    sum.update(group_ids.data(), values.data(), values.size(), 2);
+    min.update(group_ids.data(), values.data(), values.size(), 2);
+    avg.update(group_ids.data(), values.data(), values.size(), 2);
+    ASSERT_EQ(sum.finalize()[1], 4097 * 2 - 5);
+    ASSERT_EQ(min.finalize()[1], -5);
+    ASSERT_DOUBLE_EQ(avg.finalize()[1], (4097 * 2 - 5) / 4098.0);
+
+    // the copies are merged past REPLICATED_GROUPS groups
+    std::vector<uint32_t> more(2000);
+    for (size_t i = 0; i < more.size(); ++i) {
+        more[i] = i % 2 == 0 ? 1 : i;
+    }
+    std::vector<int32_t> ones(more.size(), 1);
+    sum.update(more.data(), ones.data(), more.size(), more.size());
+    min.update(more.data(), ones.data(), more.size(), more.size());
+    avg.update(more.data(), ones.data(), more.size(), more.size());
+    ASSERT_EQ(sum.num_groups(), 2000);
+    ASSERT_EQ(sum.finalize()[0], 2);
+    ASSERT_EQ(sum.finalize()[1], 4097 * 2 - 5 + 1001);
+    ASSERT_EQ(sum.finalize()[1999], 1);
+    ASSERT_EQ(min.finalize()[1], -5);
+    ASSERT_DOUBLE_EQ(avg.finalize()[1], (4097 * 2 - 5 + 1001) / 5099.0);
+}
+
+// states of megabytes, the states of the rows ahead are prefetched
+TEST(HashAggTest, ManyGroups) {
+    constexpr size_t num_groups = 400000;
+    std::default_random_engine e(3);
+    std::vector<uint32_t> group_ids(num_groups * 2);
+    std::vector<int64_t> values(group_ids.size());
+    std::vector<int64_t> sums(num_groups);
+    std::vector<int64_t> counts(num_groups);
+    for (size_t i = 0; i < group_ids.size(); ++i) {
+        group_ids[i] = e() % num_groups;
+        values[i] = e() % 1000;
+        sums[group_ids[i]] += values[i];
+        counts[group_ids[i]]++;
+    }
+    AggColumn<AggFunc::SUM, int64_t> sum;
+    AggColumn<AggFunc::AVG, int64_t> avg;
+    for (size_t i = 0; i < group_ids.size(); i += 4096) {
+        size_t n = std::min<size_t>(4096, group_ids.size() - i);
+        sum.update(group_ids.data() + i, values.data() + i, n, num_groups);
+        avg.update(group_ids.data() + i, values.data() + i, n, num_groups);
+    }
+    auto sum_result = sum.finalize();
+    auto avg_result = avg.finalize();
+    for (size_t g = 0; g < num_groups; ++g) {
+        ASSERT_EQ(sum_result[g], sums[g]) << g;
+        if (counts[g] > 0) {
+            ASSERT_DOUBLE_EQ(avg_result[g], double(sums[g]) / counts[g]) << g;
+        }
+    }
+}
+
+TEST(HashAggTest, Clear) {
+    GroupByHashTable<int64_t> table;
+    std::vector<int64_t> keys = {5, 6, 5, 7};
+    std::vector<uint32_t> group_ids(4);
+    table.find_or_insert(keys.data(), keys.size(), group_ids.data());
+    ASSERT_EQ(group_ids, (std::vector<uint32_t>{0, 1, 0, 2}));
+    table.clear();
+    ASSERT_EQ(table.num_groups(), 0);
+    keys = {7, 7, 5, 6};
+    table.find_or_insert(keys.data(), keys.size(), group_ids.data());
+    ASSERT_EQ(group_ids, (std::vector<uint32_t>{0, 0, 1, 2}));
+    ASSERT_EQ(table.keys(), (std::vector<int64_t>{7, 5, 6}));
+
+    // the aggregates restart with the table, replicated again after many groups
+    std::vector<int64_t> many(3000);
+    std::vector<uint32_t> many_ids(many.size());
+    for (size_t i = 0; i < many.size(); ++i) {
+        many[i] = i * 7;
+    }
+    AggColumn<AggFunc::SUM, int64_t> sum;
+    AggColumn<AggFunc::AVG, int64_t> avg;
+    table.find_or_insert(many.data(), many.size(), many_ids.data());
+    sum.update(many_ids.data(), many.data(), many.size(), table.num_groups());
+    avg.update(many_ids.data(), many.data(), many.size(), table.num_groups());
+    table.clear();
+    sum.clear();
+    avg.clear();
+    ASSERT_EQ(sum.num_groups(), 0);
+    table.find_or_insert(keys.data(), keys.size(), group_ids.data());
+    sum.update(group_ids.data(), keys.data(), keys.size(), table.num_groups());
+    avg.update(group_ids.data(), keys.data(), keys.size(), table.num_groups());
+    ASSERT_EQ(sum.num_groups(), 3);
+    ASSERT_EQ(sum.finalize()[0], 14);
+    ASSERT_EQ(sum.finalize()[2], 6);
+    ASSERT_DOUBLE_EQ(avg.finalize()[0], 7.0);
+    ASSERT_DOUBLE_EQ(avg.finalize()[1], 5.0);
+}
+
+TEST(HashAggTest, AggTypes) {
+    std::vector<uint32_t> group_ids = {0, 1, 0, 1};
+    // no overflow of the int32 values into the sum
+    std::vector<int32_t> ints = {std::numeric_limits<int32_t>::max(), -3,
+                                 std::numeric_limits<int32_t>::max(), -5};
+    AggColumn<AggFunc::SUM, int32_t> sum;
+    sum.update(group_ids.data(), ints.data(), ints.size(), 2);
+    static_assert(std::is_same_v<decltype(sum)::Result, int64_t>);
+    ASSERT_EQ(sum.finalize()[0], int64_t(std::numeric_limits<int32_t>::max()) * 2);
+    ASSERT_EQ(sum.finalize()[1], -8);
+
+    // an int64 sum wraps, AVG of negative values keeps its sign
+    std::vector<int64_t> longs = {std::numeric_limits<int64_t>::max(), -3, 1, -5};
+    AggColumn<AggFunc::SUM, int64_t> wide_sum;
+    AggColumn<AggFunc::AVG, int64_t> wide_avg;
+    wide_sum.update(group_ids.data(), longs.data(), longs.size(), 2);
+    wide_avg.update(group_ids.data(), longs.data(), longs.size(), 2);
+    ASSERT_EQ(wide_sum.finalize()[0], std::numeric_limits<int64_t>::min());
+    ASSERT_DOUBLE_EQ(wide_avg.finalize()[1], -4.0);
+
+    Vec<double> doubles(4);
+    doubles[0] = 1.5;
+    doubles[1] = -1e300;
+    doubles[2] = 2.5;
+    doubles[3] = -2e300;
+    AggColumn<AggFunc::MAX, double> max;
+    AggColumn<AggFunc::MIN, double> min;
+    AggColumn<AggFunc::AVG, double> avg;
+    max.update(group_ids.data(), doubles, 2);
+    min.update(group_ids.data(), doubles, 2);
+    avg.update(group_ids.data(), doubles, 2);
+    ASSERT_EQ(max.finalize()[0], 2.5);
+    ASSERT_EQ(max.finalize()[1], -1e300);
+    ASSERT_EQ(min.finalize()[1], -2e300);
+    ASSERT_DOUBLE_EQ(avg.finalize()[0], 2.0);
+
+    // groups of a later batch start empty
+    std::vector<uint32_t> more = {2};
+    std::vector<double> value = {-7};
+    max.update(more.data(), value.data(), 1, 3);
+    ASSERT_EQ(max.finalize()[2], -7);
+    ASSERT_EQ(max.num_groups(), 3);
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
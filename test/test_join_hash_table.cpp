@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/join_hash_table.h"
+
+namespace vec {
+
+using Pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+struct SliceHash {
+    size_t operator()(const Slice& s) const {
+        return std::hash<std::string>()(std::string(s.data, s.size));
+    }
+};
+
+struct SliceEqual {
+    bool operator()(const Slice& lhs, const Slice& rhs) const {
+        return memequal(lhs.data, lhs.size, rhs.data, rhs.size);
+    }
+};
+
+template <typename K>
+using ReferenceMap =
+        std::conditional_t<std::is_same_v<K, Slice>,
+                           std::unordered_multimap<Slice, uint32_t, SliceHash, SliceEqual>,
+                           std::unordered_multimap<K, uint32_t>>;
+
+template <typename K>
+Pairs reference_join(const std::vector<K>& build, const std::vector<K>& probe) {
+    ReferenceMap<K> map;
+    for (size_t i = 0; i < build.size(); ++i) {
+        map.emplace(build[i], i);
+    }
+    Pairs pairs;
+    for (size_t i = 0; i < probe.size(); ++i) {
+        auto range = map.equal_range(probe[i]);
+        for (auto it = range.first; it != range.second; ++it) {
+            pairs.emplace_back(i, it->second);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+// every pair of a batch, through output buffers of capacity pairs
+template <typename K>
+Pairs join(const JoinHashTable<K>& table, const std::vector<K>& probe_keys, size_t capacity) {
+    typename JoinHashTable<K>::Probe probe;
+    table.start_probe(probe_keys.data(), probe_keys.size(), &probe);
+    std::vector<uint32_t> probe_rids(capacity);
+    std::vector<uint32_t> build_rids(capacity);
+    Pairs pairs;
+    while (!probe.done()) {
+        size_t cnt = table.probe(&probe, probe_rids.data(), build_rids.data(), capacity);
+        EXPECT_LE(cnt, capacity);
+        for (size_t i = 0; i < cnt; ++i) {
+            pairs.emplace_back(probe_rids[i], build_rids[i]);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+// keys of a domain of num_distinct values: duplicates on both sides and misses
+template <typename K>
+void check_join(const std::function<K(uint64_t)>& make_key) {
+    std::default_random_engine e(42);
+    for (size_t build_size : {0, 1, 17, 1000, 5000}) {
+        for (size_t num_distinct : {1, 10, 1000, 100000}) {
+            std::uniform_int_distribution<uint64_t> u(0, num_distinct - 1);
+            std::vector<K> build(build_size);
+            for (auto& key : build) {
+                key = make_key(u(e));
+            }
+            std::vector<K> probe(1000);
+            for (auto& key : probe) {
+                key = make_key(u(e) + num_distinct / 10);
+            }
+            JoinHashTable<K> table;
+            table.build(build.data(), build.size());
+            ASSERT_EQ(table.num_rows(), build_size);
+            Pairs expect = reference_join(build, probe);
+            for (size_t capacity : {1, 7, 16, 100, 4096}) {
+                ASSERT_EQ(join(table, probe, capacity), expect)
+                        << build_size << " build rows, " << num_distinct << " keys, capacity "
+                        << capacity;
+            }
+        }
+    }
+}
+
+TEST(JoinHashTableTest, Int32) {
+    for_each_simd_level([] {
+        check_join<int32_t>([](uint64_t v) { return static_cast<int32_t>(v * 2654435761u); });
+    });
+}
+
+TEST(JoinHashTableTest, Int64) {
+    for_each_simd_level([] {
+        // keys differing in the high half only
+        check_join<int64_t>([](uint64_t v) { return static_cast<int64_t>(v << 32 | (v & 3)); });
+    });
+}
+
+TEST(JoinHashTableTest, Slice) {
+    std::vector<std::string> strings;
+    for (int i = 0; i < 110000; ++i) {
+        // short, inlined-size and long keys with a common prefix
+        strings.push_back(std::string(i % 3 * 10, 'x') + std::to_string(i));
+    }
+    for_each_simd_level([&] {
+        check_join<Slice>([&](uint64_t v) { return Slice(strings[v].data(), strings[v].size()); });
+    });
+}
+
+// a table of megabytes, the probe prefetches the rows ahead
+template <typename K>
+void check_large_join(const std::function<K(uint64_t)>& make_key) {
+    std::default_random_engine e(7);
+    std::uniform_int_distribution<uint64_t> u(0, 150000);
+    std::vector<K> build(200000);
+    for (auto& key : build) {
+        key = make_key(u(e));
+    }
+    std::vector<K> probe(5000);
+    for (auto& key : probe) {
+        key = make_key(u(e) + 10000);
+    }
+    JoinHashTable<K> table;
+    table.build(build.data(), build.size());
+    Pairs expect = reference_join(build, probe);
+    for (size_t capacity : {100, 4096}) {
+        ASSERT_EQ(join(table, probe, capacity), expect) << "capacity " << capacity;
+    }
+}
+
+TEST(JoinHashTableTest, Large) {
+    for_each_simd_level([] {
+        check_large_join<int32_t>([](uint64_t v) { return static_cast<int32_t>(v * 2654435761u); });
+        check_large_join<int64_t>([](uint64_t v) { return static_cast<int64_t>(v << 32 | 1); });
+    });
+}
+
+TEST(JoinHashTableTest, Rebuild) {
+    JoinHashTable<int32_t> table;
+    std::vector<int32_t> keys = {1, 2, 2, 3};
+    table.build(keys.data(), keys.size());
+    std::vector<int32_t> probe = {2, 4};
+    ASSERT_EQ(join(table, probe, 16), (Pairs{{0, 1}, {0, 2}}));
+
+    keys = {4};
+    table.build(keys.data(), keys.size());
+    ASSERT_EQ(join(table, probe, 16), (Pairs{{1, 0}}));
+
+    // an empty probe batch is done at once
+    JoinHashTable<int32_t>::Probe state;
+    table.start_probe(probe.data(), 0, &state);
+    ASSERT_TRUE(state.done());
+}
+
+// every pair of a partitioned join, bits 0 picks the partitioning
+template <typename K>
+Pairs partitioned_join(const std::vector<K>& build, const std::vector<K>& probe, int bits) {
+    PartitionedJoin<K> join(bits);
+    join.build(build.data(), build.size());
+    EXPECT_EQ(join.num_rows(), build.size());
+    Pairs pairs;
+    join.probe(probe.data(), probe.size(),
+               [&](const uint32_t* probe_rids, const uint32_t* build_rids, size_t cnt) {
+                   EXPECT_LE(cnt, PartitionedJoin<K>::BATCH_SIZE);
+                   for (size_t i = 0; i < cnt; ++i) {
+                       pairs.emplace_back(probe_rids[i], build_rids[i]);
+                   }
+               });
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+template <typename K>
+void check_partitioned_join(const std::function<K(uint64_t)>& make_key) {
+    std::default_random_engine e(42);
+    for (size_t build_size : {0, 1, 1000, 20000}) {
+        for (size_t num_distinct : {10, 1000, 100000}) {
+            std::uniform_int_distribution<uint64_t> u(0, num_distinct - 1);
+            std::vector<K> build(build_size);
+            for (auto& key : build) {
+                key = make_key(u(e));
+            }
+            std::vector<K> probe(3000);
+            for (auto& key : probe) {
+                key = make_key(u(e) + num_distinct / 10);
+            }
+            Pairs expect = reference_join(build, probe);
+            for (int bits : {0, 1, 4, 11}) {
+                ASSERT_EQ(partitioned_join(build, probe, bits), expect)
+                        << build_size << " build rows, " << num_distinct << " keys, " << bits
+                        << " bits";
+            }
+        }
+    }
+}
+
+TEST(JoinHashTableTest, RadixPartition) {
+    std::default_random_engine e(42);
+    std::uniform_int_distribution<int64_t> u(0, 5000);
+    std::vector<int64_t> keys(10007);
+    for (auto& key : keys) {
+        key = u(e);
+    }
+    for (int bits : {0, 3, 10}) {
+        RadixPartitions<int64_t> parts;
+        radix_partition(keys.data(), keys.size(), bits, &parts);
+        ASSERT_EQ(parts.num_partitions(), size_t(1) << bits);
+        ASSERT_EQ(parts.offsets.back(), keys.size());
+        // every row once, with its key, and a key in a single partition
+        std::vector<int> seen(keys.size());
+        std::unordered_map<int64_t, size_t> partition_of;
+        for (size_t p = 0; p < parts.num_partitions(); ++p) {
+            for (size_t i = parts.offsets[p]; i < parts.offsets[p + 1]; ++i) {
+                ASSERT_EQ(parts.keys[i], keys[parts.rids[i]]);
+                ++seen[parts.rids[i]];
+                ASSERT_EQ(partition_of.emplace(parts.keys[i], p).first->second, p);
+            }
+        }
+        ASSERT_EQ(std::count(seen.begin(), seen.end(), 1), keys.size());
+    }
+}
+
+TEST(JoinHashTableTest, PartitionedJoin) {
+    std::vector<std::string> strings;
+    for (int i = 0; i < 110000; ++i) {
+        strings.push_back(std::string(i % 3 * 10, 'x') + std::to_string(i));
+    }
+    check_partitioned_join<int32_t>([](uint64_t v) { return static_cast<int32_t>(v); });
+    check_partitioned_join<int64_t>([](uint64_t v) { return static_cast<int64_t>(v << 32); });
+    check_partitioned_join<Slice>(
+            [&](uint64_t v) { return Slice(strings[v].data(), strings[v].size()); });
+
+    // large enough to be partitioned by default
+    std::vector<int32_t> build(400000);
+    for (size_t i = 0; i < build.size(); ++i) {
+        build[i] = i / 2;
+    }
+    std::vector<int32_t> probe = {0, 7, 199999, 200000};
+    PartitionedJoin<int32_t> join;
+    join.build(build.data(), build.size());
+    ASSERT_GT(join.radix_bits(), 0);
+    ASSERT_EQ(partitioned_join(build, probe, 0),
+              (Pairs{{0, 0}, {0, 1}, {1, 14}, {1, 15}, {2, 399998}, {2, 399999}}));
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
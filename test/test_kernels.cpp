@@ -0,0 +1,202 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/kernels.h"
+#include "vec/slice.h"
+
+namespace vec {
+
+int one() {
+    return 1;
+}
+
+int two() {
+    return 2;
+}
+
+TEST(CpuDispatchTest, Levels) {
+    SimdLevel max_level = CpuInfo::host().max_level();
+    ASSERT_LE(simd_level(), max_level);
+
+    set_simd_level(SimdLevel::SCALAR);
+    ASSERT_EQ(simd_level(), SimdLevel::SCALAR);
+    // never above the host
+    set_simd_level(SimdLevel::AVX512_VBMI2);
+    ASSERT_EQ(simd_level(), max_level);
+
+    // missing versions fall back to the level below
+    constexpr KernelTable<int (*)()> table(one, nullptr, two, nullptr, nullptr);
+    ASSERT_EQ(table[SimdLevel::SCALAR](), 1);
+    ASSERT_EQ(table[SimdLevel::SSE42](), 1);
+    ASSERT_EQ(table[SimdLevel::AVX2](), 2);
+    ASSERT_EQ(table[SimdLevel::AVX512_VBMI2](), 2);
+}
+
+TEST(KernelsTest, Memequal) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        std::vector<char> p1(300);
+        for (auto& c : p1) {
+            c = static_cast<char>(e());
+        }
+        for (size_t size = 0; size <= 260; ++size) {
+            std::vector<char> p2(p1.begin(), p1.begin() + size);
+            ASSERT_TRUE(memequal(p1.data(), p2.data(), size)) << size;
+            ASSERT_TRUE(memequal(p1.data(), size, p2.data(), size)) << size;
+            ASSERT_FALSE(memequal(p1.data(), size + 1, p2.data(), size)) << size;
+            for (size_t pos = 0; pos < size; ++pos) {
+                p2[pos] ^= 0x10;
+                ASSERT_FALSE(memequal(p1.data(), p2.data(), size)) << size << " " << pos;
+                ASSERT_FALSE(memequal(p1.data(), size, p2.data(), size)) << size << " " << pos;
+                p2[pos] ^= 0x10;
+            }
+        }
+    });
+}
+
+template <typename T>
+void check_gather(void (*gather)(const T*, const uint32_t*, size_t, T*)) {
+    std::default_random_engine e(42);
+    std::vector<T> src(1000);
+    for (auto& v : src) {
+        v = static_cast<T>(e()) * 31;
+    }
+    std::uniform_int_distribution<uint32_t> u(0, src.size() - 1);
+    for (size_t num_rows : {0, 1, 3, 4, 7, 8, 15, 16, 17, 100, 4099}) {
+        std::vector<uint32_t> indices(num_rows);
+        for (auto& index : indices) {
+            index = u(e);
+        }
+        std::vector<T> dst(num_rows);
+        gather(src.data(), indices.data(), num_rows, dst.data());
+        for (size_t i = 0; i < num_rows; ++i) {
+            ASSERT_EQ(dst[i], src[indices[i]]) << num_rows << " rows, at " << i;
+        }
+    }
+}
+
+TEST(KernelsTest, Gather) {
+    for_each_simd_level([] {
+        check_gather<uint32_t>(gather_u32);
+        check_gather<uint64_t>(gather_u64);
+        check_gather<uint16_t>(gather<uint16_t>);
+        check_gather<double>(gather<double>);
+        check_gather<__int128>(gather<__int128>);
+    });
+}
+
+TEST(KernelsTest, Histogram) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        for (uint32_t num_buckets : {1, 7, 255, 1024, 1025, 5000}) {
+            for (size_t num_keys : {0, 1, 5, 1000, 4096, 10003}) {
+                std::uniform_int_distribution<uint32_t> u(0, num_buckets - 1);
+                std::vector<uint32_t> keys(num_keys);
+                std::vector<uint32_t> expect(num_buckets, 1);
+                for (auto& key : keys) {
+                    key = u(e);
+                    expect[key]++;
+                }
+                // adds to the existing counts
+                std::vector<uint32_t> counts(num_buckets, 1);
+                histogram(keys.data(), num_keys, num_buckets, counts.data());
+                ASSERT_EQ(counts, expect) << num_buckets << " buckets, " << num_keys << " keys";
+            }
+        }
+    });
+}
+
+template <typename T>
+void check_zero_nulls(std::default_random_engine& e) {
+    for (size_t num_rows : {0, 1, 7, 8, 31, 32, 63, 64, 65, 1000, 4099}) {
+        for (int percent : {0, 5, 50, 100}) {
+            std::vector<uint8_t> nulls(num_rows);
+            std::vector<T> data(num_rows + 1);
+            for (size_t i = 0; i < num_rows; ++i) {
+                nulls[i] = static_cast<int>(e() % 100) < percent ? 1 + e() % 255 : 0;
+                data[i] = static_cast<T>(e() | 1);
+                if constexpr (sizeof(T) == 16) {
+                    data[i] |= static_cast<T>(e()) << 64;
+                }
+            }
+            // the row past the end is not touched
+            data[num_rows] = T(42);
+            std::vector<T> expect = data;
+            for (size_t i = 0; i < num_rows; ++i) {
+                if (nulls[i]) expect[i] = T();
+            }
+            zero_nulls(nulls.data(), num_rows, data.data());
+            ASSERT_TRUE(data == expect) << sizeof(T) << " bytes, " << num_rows << " rows";
+        }
+    }
+}
+
+TEST(KernelsTest, ZeroNulls) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        check_zero_nulls<int8_t>(e);
+        check_zero_nulls<uint16_t>(e);
+        check_zero_nulls<float>(e);
+        check_zero_nulls<int64_t>(e);
+        check_zero_nulls<double>(e);
+        check_zero_nulls<__int128>(e);
+    });
+}
+
+void encode_be(__int128 value, int binsz, uint8_t* dst) {
+    for (int i = binsz - 1; i >= 0; --i) {
+        dst[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+TEST(KernelsTest, DecodeBigEndian) {
+    for_each_simd_level([] {
+        std::default_random_engine e(42);
+        for (int binsz = 1; binsz <= 16; ++binsz) {
+            for (size_t num_rows : {0, 1, 2, 3, 4, 5, 9, 100, 1027}) {
+                std::vector<__int128> values(num_rows);
+                std::vector<uint8_t> nulls(num_rows);
+                // only non-null rows are in the nullable encoding
+                std::vector<uint8_t> src(num_rows * binsz);
+                std::vector<uint8_t> nullable_src;
+                for (size_t i = 0; i < num_rows; ++i) {
+                    // random bytes, sign extended from binsz bytes
+                    int shift = 128 - 8 * binsz;
+                    unsigned __int128 bits = (static_cast<unsigned __int128>(e()) << 64) | e();
+                    __int128 v = static_cast<__int128>(bits << shift) >> shift;
+                    values[i] = v;
+                    encode_be(v, binsz, src.data() + i * binsz);
+                    nulls[i] = e() % 3 == 0;
+                    if (!nulls[i]) {
+                        nullable_src.resize(nullable_src.size() + binsz);
+                        encode_be(v, binsz, nullable_src.data() + nullable_src.size() - binsz);
+                    }
+                }
+
+                std::vector<__int128> dst(num_rows);
+                decode_be_int128(src.data(), binsz, num_rows, dst.data());
+                ASSERT_TRUE(dst == values) << "binsz " << binsz << ", " << num_rows << " rows";
+
+                decode_be_int128_nullable(nullable_src.data(), nulls.data(), binsz, num_rows,
+                                          dst.data());
+                for (size_t i = 0; i < num_rows; ++i) {
+                    ASSERT_TRUE(dst[i] == (nulls[i] ? 0 : values[i]))
+                            << "binsz " << binsz << ", " << num_rows << " rows, at " << i;
+                }
+            }
+        }
+    });
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,202 @@
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vec/nullable_vec.h"
+
+namespace vec {
+
+using Rows = std::vector<std::optional<int64_t>>;
+
+NullableVec<int64_t> make_nullable(const Rows& rows) {
+    NullableVec<int64_t> res;
+    for (const auto& row : rows) {
+        if (row) {
+            res.push_back(*row);
+        } else {
+            res.push_back_null();
+        }
+    }
+    return res;
+}
+
+Rows to_rows(const NullableVec<int64_t>& vec) {
+    Rows rows;
+    for (int i = 0; i < vec.len(); ++i) {
+        // a null row always holds T()
+        if (vec.is_null(i)) {
+            EXPECT_EQ(vec[i], 0) << i;
+        }
+        rows.push_back(vec.is_null(i) ? std::nullopt : std::optional<int64_t>(vec[i]));
+    }
+    return rows;
+}
+
+// about percent% null rows of -10..10
+Rows random_rows(int len, int percent, std::default_random_engine& e) {
+    std::uniform_int_distribution<int> u(0, 99);
+    std::uniform_int_distribution<int64_t> v(-10, 10);
+    Rows rows(len);
+    for (auto& row : rows) {
+        if (u(e) >= percent) row = v(e);
+    }
+    return rows;
+}
+
+TEST(NullableVecTest, Basic) {
+    NullableVec<int64_t> vec(Vec<int64_t>(3));
+    ASSERT_FALSE(vec.has_null());
+    ASSERT_EQ(vec.null_data(), nullptr);
+    vec.set(1, 5);
+    vec.set_null(2);
+    ASSERT_TRUE(vec.has_null());
+    ASSERT_EQ(vec.null_count(), 1);
+    ASSERT_EQ(to_rows(vec), (Rows{0, 5, std::nullopt}));
+    vec.set(2, 7);
+    ASSERT_EQ(to_rows(vec), (Rows{0, 5, 7}));
+
+    // an all zero null map is dropped
+    Vec<uint8_t> nulls(3);
+    NullableVec<int64_t> no_null(Vec<int64_t>(3), nulls);
+    ASSERT_FALSE(no_null.has_null());
+    nulls[0] = 2;
+    Vec<int64_t> data(3);
+    data[0] = 42;
+    NullableVec<int64_t> with_null(data, nulls);
+    ASSERT_TRUE(with_null.has_null());
+    ASSERT_EQ(to_rows(with_null), (Rows{std::nullopt, 0, 0}));
+}
+
+TEST(NullableVecTest, Arithmetic) {
+    std::default_random_engine e(42);
+    for (int lhs_percent : {0, 5, 50}) {
+        for (int rhs_percent : {0, 5, 50}) {
+            Rows lhs_rows = random_rows(1000, lhs_percent, e);
+            Rows rhs_rows = random_rows(1000, rhs_percent, e);
+            NullableVec<int64_t> lhs = make_nullable(lhs_rows);
+            NullableVec<int64_t> rhs = make_nullable(rhs_rows);
+            ASSERT_EQ(lhs.has_null(), lhs_percent > 0);
+
+            Rows add, sub, mul, div, add_literal, div_literal, div_zero;
+            for (size_t i = 0; i < lhs_rows.size(); ++i) {
+                auto a = lhs_rows[i], b = rhs_rows[i];
+                bool null = !a || !b;
+                add.push_back(null ? std::nullopt : std::optional<int64_t>(*a + *b));
+                sub.push_back(null ? std::nullopt : std::optional<int64_t>(*a - *b));
+                mul.push_back(null ? std::nullopt : std::optional<int64_t>(*a * *b));
+                div.push_back(null || *b == 0 ? std::nullopt : std::optional<int64_t>(*a / *b));
+                add_literal.push_back(a ? std::optional<int64_t>(*a + 3) : std::nullopt);
+                div_literal.push_back(a ? std::optional<int64_t>(*a / 3) : std::nullopt);
+                div_zero.push_back(std::nullopt);
+            }
+            ASSERT_EQ(to_rows(lhs + rhs), add);
+            ASSERT_EQ(to_rows(lhs - rhs), sub);
+            ASSERT_EQ(to_rows(lhs * rhs), mul);
+            ASSERT_EQ(to_rows(lhs / rhs), div);
+            ASSERT_EQ(to_rows(lhs + 3), add_literal);
+            ASSERT_EQ(to_rows(lhs / 3), div_literal);
+            ASSERT_EQ(to_rows(lhs / 0), div_zero);
+        }
+    }
+}
+
+TEST(NullableVecTest, DivideOverflow) {
+    const int64_t min = std::numeric_limits<int64_t>::min();
+    NullableVec<int64_t> lhs = make_nullable({min, min, 7, std::nullopt, min});
+    NullableVec<int64_t> rhs = make_nullable({-1, std::nullopt, -1, -1, 0});
+    // the minimum wraps, the null rows and the zero divisor stay null
+    ASSERT_EQ(to_rows(lhs / rhs), (Rows{min, std::nullopt, -7, std::nullopt, std::nullopt}));
+    ASSERT_EQ(to_rows(lhs / -1), (Rows{min, min, -7, std::nullopt, min}));
+
+    NullableVec<int32_t> narrow(Vec<int32_t>(2));
+    narrow.set(0, std::numeric_limits<int32_t>::min());
+    narrow.set_null(1);
+    NullableVec<int32_t> quotient = narrow / -1;
+    ASSERT_EQ(quotient[0], std::numeric_limits<int32_t>::min());
+    ASSERT_TRUE(quotient.is_null(1));
+}
+
+TEST(NullableVecTest, Compare) {
+    std::default_random_engine e(42);
+    for (int percent : {0, 5, 50}) {
+        Rows lhs_rows = random_rows(1000, percent, e);
+        Rows rhs_rows = random_rows(1000, percent, e);
+        NullableVec<int64_t> lhs = make_nullable(lhs_rows);
+        NullableVec<int64_t> rhs = make_nullable(rhs_rows);
+
+        BitVec literal_bits = lhs.compare_bits(CompareOp::GT, 2);
+        BitVec column_bits = lhs.compare_bits(CompareOp::LE, rhs);
+        NullableVec<bool> literal = lhs.compare(CompareOp::GT, 2);
+        NullableVec<bool> column = lhs.compare(CompareOp::LE, rhs);
+        for (size_t i = 0; i < lhs_rows.size(); ++i) {
+            auto a = lhs_rows[i], b = rhs_rows[i];
+            // a null row is never selected
+            ASSERT_EQ(literal_bits[i], a && *a > 2) << i;
+            ASSERT_EQ(column_bits[i], a && b && *a <= *b) << i;
+            ASSERT_EQ(literal.is_null(i), !a) << i;
+            ASSERT_EQ(column.is_null(i), !a || !b) << i;
+            ASSERT_EQ(literal[i], a && *a > 2) << i;
+            ASSERT_EQ(column[i], a && b && *a <= *b) << i;
+        }
+    }
+
+    // a literal out of the range of the column matches every or no non-null row
+    NullableVec<int8_t> small(Vec<int8_t>(3));
+    small.set(0, 100);
+    small.set_null(1);
+    small.set(2, -100);
+    BitVec below = small.compare_bits(CompareOp::LT, 300);
+    ASSERT_TRUE(below[0] && !below[1] && below[2]);
+    ASSERT_TRUE(small.compare_bits(CompareOp::EQ, 300 - 256).none());
+    ASSERT_TRUE(small.compare_bits(CompareOp::GE, -300)[2]);
+}
+
+TEST(NullableVecTest, Selection) {
+    std::default_random_engine e(42);
+    for (int percent : {0, 5, 50}) {
+        Rows rows = random_rows(1000, percent, e);
+        NullableVec<int64_t> vec = make_nullable(rows);
+        Vec<bool> selector(rows.size());
+        Rows expect;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            selector[i] = i % 3 == 0;
+            if (selector[i]) expect.push_back(rows[i]);
+        }
+        BitVec bits = BitVec::from_bytes(reinterpret_cast<const uint8_t*>(selector.data()),
+                                         selector.len());
+        ASSERT_EQ(to_rows(vec[selector]), expect);
+        ASSERT_EQ(to_rows(vec[bits]), expect);
+        NullableVec<int64_t> filtered = vec;
+        filtered.filter(bits);
+        ASSERT_EQ(to_rows(filtered), expect);
+        vec.filter(selector);
+        ASSERT_EQ(to_rows(vec), expect);
+    }
+
+    // selecting only non-null rows drops the null map
+    NullableVec<int64_t> vec = make_nullable({1, std::nullopt, 3});
+    vec.filter(~vec.null_bits());
+    ASSERT_FALSE(vec.has_null());
+    ASSERT_EQ(to_rows(vec), (Rows{1, 3}));
+}
+
+TEST(NullableVecTest, Transform) {
+    NullableVec<int64_t> vec = make_nullable({1, std::nullopt, -3});
+    NullableVec<double> half = vec.transform<double>([](int64_t v) { return v / 2.0; });
+    ASSERT_EQ(half.len(), 3);
+    ASSERT_EQ(half[0], 0.5);
+    ASSERT_TRUE(half.is_null(1));
+    ASSERT_EQ(half[2], -1.5);
+    ASSERT_EQ(to_rows(vec.transform([](int64_t v) { return v + 1; })),
+              (Rows{2, std::nullopt, -2}));
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vec/sort.h"
+#include "vec/vec.h"
+#include "vec/vec_string.h"
+
+namespace vec {
+
+// every size around the std::sort cutoff and past the MSD split, the extremes of the
+// type and a column of few distinct values whose high bytes are all the same
+template <typename T>
+std::vector<std::vector<T>> make_columns() {
+    std::default_random_engine e(42);
+    std::vector<std::vector<T>> columns;
+    for (size_t num_rows : {0, 1, 2, 255, 256, 1000, 200000}) {
+        std::vector<T> values(num_rows);
+        for (auto& value : values) {
+            if constexpr (std::is_floating_point_v<T>) {
+                value = std::uniform_real_distribution<T>(-1e6, 1e6)(e);
+            } else {
+                value = static_cast<T>(e() * uint64_t(0x9E3779B97F4A7C15));
+            }
+        }
+        if (num_rows >= 2) {
+            values[0] = std::numeric_limits<T>::lowest();
+            values[1] = std::numeric_limits<T>::max();
+        }
+        columns.push_back(values);
+    }
+    std::vector<T> small(5000);
+    for (auto& value : small) {
+        value = static_cast<T>(e() % 10);
+    }
+    columns.push_back(small);
+    return columns;
+}
+
+template <typename T>
+void check_radix_sort() {
+    for (auto& values : make_columns<T>()) {
+        std::vector<T> expect = values;
+        std::sort(expect.begin(), expect.end());
+        std::vector<T> sorted = values;
+        radix_sort(sorted.data(), sorted.size());
+        ASSERT_EQ(sorted, expect) << values.size();
+
+        // stable: the rows of a key in order
+        std::vector<uint32_t> expect_perm(values.size());
+        std::iota(expect_perm.begin(), expect_perm.end(), 0);
+        std::stable_sort(expect_perm.begin(), expect_perm.end(),
+                         [&](uint32_t lhs, uint32_t rhs) { return values[lhs] < values[rhs]; });
+        std::vector<uint32_t> perm(values.size());
+        argsort(values.data(), values.size(), perm.data());
+        ASSERT_EQ(perm, expect_perm) << values.size();
+    }
+}
+
+TEST(SortTest, Int32) {
+    check_radix_sort<int32_t>();
+}
+
+TEST(SortTest, UInt32) {
+    check_radix_sort<uint32_t>();
+}
+
+TEST(SortTest, Int64) {
+    check_radix_sort<int64_t>();
+}
+
+TEST(SortTest, UInt64) {
+    check_radix_sort<uint64_t>();
+}
+
+TEST(SortTest, Float) {
+    check_radix_sort<float>();
+}
+
+TEST(SortTest, Double) {
+    check_radix_sort<double>();
+}
+
+// runs of uneven sizes, the splits of the merge among equal keys and a thread count
+// cut down for a small column
+template <typename T>
+void check_parallel_sort() {
+    std::default_random_engine e(5);
+    for (size_t num_rows : {size_t(1000), size_t(300001)}) {
+        for (int modulo : {0, 7}) {
+            std::vector<T> values(num_rows);
+            for (auto& value : values) {
+                uint64_t x = e() * uint64_t(0x9E3779B97F4A7C15);
+                value = static_cast<T>(modulo != 0 ? x % modulo : x);
+            }
+            std::vector<uint32_t> expect_perm(num_rows);
+            std::iota(expect_perm.begin(), expect_perm.end(), 0);
+            std::stable_sort(
+                    expect_perm.begin(), expect_perm.end(),
+                    [&](uint32_t lhs, uint32_t rhs) { return values[lhs] < values[rhs]; });
+            for (int num_threads : {1, 2, 3, 4}) {
+                std::vector<T> sorted = values;
+                parallel_sort(sorted.data(), sorted.size(), num_threads);
+                ASSERT_TRUE(std::is_sorted(sorted.begin(), sorted.end())) << num_threads;
+                std::vector<uint32_t> perm(num_rows);
+                parallel_argsort(values.data(), num_rows, perm.data(), num_threads);
+                ASSERT_EQ(perm, expect_perm) << num_threads;
+                for (size_t i = 0; i < num_rows; ++i) {
+                    ASSERT_EQ(sorted[i], values[perm[i]]);
+                }
+            }
+        }
+    }
+}
+
+TEST(SortTest, ParallelInt32) {
+    check_parallel_sort<int32_t>();
+}
+
+TEST(SortTest, ParallelUInt64) {
+    check_parallel_sort<uint64_t>();
+}
+
+TEST(SortTest, ParallelDouble) {
+    check_parallel_sort<double>();
+}
+
+// -0.0 before 0.0, infinities at the ends, a NaN by its sign bit
+TEST(SortTest, FloatSpecials) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> values(300, 1.0);
+    values[10] = 0.0;
+    values[20] = -0.0;
+    values[30] = inf;
+    values[40] = -inf;
+    values[50] = nan;
+    values[60] = -nan;
+    radix_sort(values.data(), values.size());
+    ASSERT_TRUE(std::isnan(values[0]) && std::signbit(values[0]));
+    ASSERT_EQ(values[1], -inf);
+    ASSERT_TRUE(values[2] == 0.0 && std::signbit(values[2]));
+    ASSERT_TRUE(values[3] == 0.0 && !std::signbit(values[3]));
+    ASSERT_EQ(values[298], inf);
+    ASSERT_TRUE(std::isnan(values[299]) && !std::signbit(values[299]));
+}
+
+TEST(SortTest, VecSort) {
+    Vec<int64_t> values(1000);
+    for (int i = 0; i < values.len(); ++i) {
+        values[i] = (i * 7919) % 1000 - 500;
+    }
+    values.sort();
+    for (int i = 0; i < values.len(); ++i) {
+        ASSERT_EQ(values[i], i - 500);
+    }
+    for (int i = 0; i < values.len(); ++i) {
+        values[i] = (i * 7919) % 1000 - 500;
+    }
+    values.sort(4);
+    for (int i = 0; i < values.len(); ++i) {
+        ASSERT_EQ(values[i], i - 500);
+    }
+
+    Vec<std::string> strings(3);
+    strings[0] = "b";
+    strings[1] = "ab";
+    strings[2] = "a";
+    uint32_t perm[3];
+    strings.argsort(perm);
+    ASSERT_EQ(std::vector<uint32_t>(perm, perm + 3), (std::vector<uint32_t>{2, 1, 0}));
+    strings.sort();
+    ASSERT_EQ(strings[0], "a");
+    ASSERT_EQ(strings[2], "b");
+}
+
+// the row of ORDER BY a DESC NULLS LAST, s ASC NULLS FIRST, d ASC
+struct Row {
+    bool a_null;
+    int32_t a;
+    bool s_null;
+    std::string s;
+    double d;
+};
+
+bool row_less(const Row& lhs, const Row& rhs) {
+    if (lhs.a_null != rhs.a_null) {
+        return rhs.a_null;
+    }
+    if (!lhs.a_null && lhs.a != rhs.a) {
+        return lhs.a > rhs.a;
+    }
+    if (lhs.s_null != rhs.s_null) {
+        return lhs.s_null;
+    }
+    if (!lhs.s_null && lhs.s != rhs.s) {
+        return lhs.s < rhs.s;
+    }
+    // -0.0 == 0.0
+    return lhs.d < rhs.d;
+}
+
+TEST(SortTest, NormalizedKeys) {
+    std::default_random_engine e(7);
+    // strings that tie on their 4 byte prefix, and on zero padding
+    const std::vector<std::string> strings = {"",     "a",    std::string("a\0", 2), "abcd",
+                                              "abcde", "abcdf", "abce", "b", "\xff",
+                                              std::string("abcd\0", 5)};
+    for (size_t num_rows : {0, 1, 20, 5000}) {
+        std::vector<Row> rows(num_rows);
+        for (auto& row : rows) {
+            row.a_null = e() % 5 == 0;
+            row.a = row.a_null ? 0 : static_cast<int32_t>(e() % 7) - 3;
+            row.s_null = e() % 7 == 0;
+            row.s = row.s_null ? "" : strings[e() % strings.size()];
+            row.d = e() % 3 == 0 ? -0.0 : static_cast<double>(e() % 5);
+        }
+        std::vector<uint8_t> a_nulls;
+        std::vector<int32_t> a;
+        std::vector<uint8_t> s_nulls;
+        std::vector<Slice> s;
+        std::vector<double> d;
+        for (const auto& row : rows) {
+            a_nulls.push_back(row.a_null);
+            a.push_back(row.a);
+            s_nulls.push_back(row.s_null);
+            s.emplace_back(row.s.data(), row.s.size());
+            d.push_back(row.d);
+        }
+        NormalizedKeys keys(num_rows);
+        keys.add_column(a.data(), a_nulls.data(), SortOrder::DESC, NullOrder::LAST);
+        keys.add_column(s.data(), s_nulls.data(), SortOrder::ASC, NullOrder::FIRST, 4);
+        keys.add_column(d.data(), nullptr, SortOrder::ASC, NullOrder::FIRST);
+        if (num_rows > 0) {
+            // data() of an empty vector is nullptr, not a nullable column
+            ASSERT_EQ(keys.key_size(), 5 + 5 + 8);
+        }
+        std::vector<uint32_t> perm(num_rows);
+        keys.sort(perm.data());
+
+        std::vector<uint32_t> expect(num_rows);
+        std::iota(expect.begin(), expect.end(), 0);
+        std::stable_sort(expect.begin(), expect.end(), [&](uint32_t lhs, uint32_t rhs) {
+            return row_less(rows[lhs], rows[rhs]);
+        });
+        ASSERT_EQ(perm, expect) << num_rows;
+    }
+}
+
+// a run that ties on the first string goes on to the second, whose cut prefix hides
+// the order of the int column after it
+TEST(SortTest, NormalizedKeysTwoStrings) {
+    std::default_random_engine e(11);
+    const std::vector<std::string> strings = {"a", "ab", "abc", "abd", std::string("a\0", 2), "b"};
+    const size_t num_rows = 3000;
+    std::vector<std::string> s1(num_rows);
+    std::vector<std::string> s2(num_rows);
+    std::vector<int64_t> x(num_rows);
+    std::vector<Slice> slices1;
+    std::vector<Slice> slices2;
+    for (size_t i = 0; i < num_rows; ++i) {
+        s1[i] = strings[e() % 2];
+        s2[i] = strings[e() % strings.size()];
+        x[i] = e() % 3;
+    }
+    for (size_t i = 0; i < num_rows; ++i) {
+        slices1.emplace_back(s1[i].data(), s1[i].size());
+        slices2.emplace_back(s2[i].data(), s2[i].size());
+    }
+    NormalizedKeys keys(num_rows);
+    keys.add_column(slices1.data(), nullptr, SortOrder::ASC, NullOrder::FIRST, 4);
+    keys.add_column(slices2.data(), nullptr, SortOrder::DESC, NullOrder::FIRST, 2);
+    keys.add_column(x.data(), nullptr, SortOrder::ASC, NullOrder::FIRST);
+    std::vector<uint32_t> perm(num_rows);
+    keys.sort(perm.data());
+
+    std::vector<uint32_t> expect(num_rows);
+    std::iota(expect.begin(), expect.end(), 0);
+    std::stable_sort(expect.begin(), expect.end(), [&](uint32_t lhs, uint32_t rhs) {
+        if (s1[lhs] != s1[rhs]) {
+            return s1[lhs] < s1[rhs];
+        }
+        if (s2[lhs] != s2[rhs]) {
+            return s2[lhs] > s2[rhs];
+        }
+        return x[lhs] < x[rhs];
+    });
+    ASSERT_EQ(perm, expect);
+}
+
+TEST(SortTest, NormalizedKeysDescStrings) {
+    std::vector<std::string> strings = {"b", "", "abc", "ab", "ab", "abcdefghijklmnop", "abd"};
+    std::vector<Slice> slices;
+    for (const auto& s : strings) {
+        slices.emplace_back(s.data(), s.size());
+    }
+    std::vector<__int128> decimals = {1, 1, 1, 1, -1, 1, (__int128)1 << 100};
+    NormalizedKeys keys(strings.size());
+    keys.add_column(decimals.data(), nullptr, SortOrder::ASC, NullOrder::FIRST);
+    keys.add_column(slices.data(), nullptr, SortOrder::DESC, NullOrder::FIRST, 2);
+    std::vector<uint32_t> perm(strings.size());
+    keys.sort(perm.data());
+    ASSERT_EQ(perm, (std::vector<uint32_t>{4, 0, 5, 2, 3, 1, 6}));
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
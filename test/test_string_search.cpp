@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simd_test_util.h"
+#include "vec/cpu_dispatch.h"
+#include "vec/string_search.h"
+
+namespace vec {
+
+using Strings = std::vector<std::string>;
+
+// few distinct bytes, the needles match often, across rows too
+Strings make_strings(size_t num_rows, size_t max_size, uint32_t seed) {
+    std::default_random_engine e(seed);
+    std::uniform_int_distribution<size_t> size(0, max_size);
+    const char alphabet[] = {'a', 'b', '/', '\0'};
+    Strings strings;
+    for (size_t i = 0; i < num_rows; ++i) {
+        std::string s(size(e), ' ');
+        for (auto& c : s) {
+            c = alphabet[e() % 4];
+        }
+        strings.push_back(s);
+    }
+    return strings;
+}
+
+FlatBinaryVec make_col(const Strings& strings) {
+    std::vector<Slice> slices;
+    for (const auto& s : strings) {
+        slices.emplace_back(s.data(), s.size());
+    }
+    FlatBinaryVec col;
+    col.build_strings(slices);
+    return col;
+}
+
+Strings make_needles() {
+    Strings needles = {"", "a", "/", std::string(1, '\0'), "ab", "a/b", "aaaa"};
+    for (size_t size : {5, 8, 15, 16, 17, 24}) {
+        needles.push_back(make_strings(1, size, size)[0]);
+        needles.back().resize(size, 'b');
+    }
+    return needles;
+}
+
+bool starts_with(const std::string& s, const std::string& prefix) {
+    return s.compare(0, prefix.size(), prefix) == 0 && s.size() >= prefix.size();
+}
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// views of a part of the column start past the first byte of the buffer
+TEST(StringSearchTest, Predicates) {
+    Strings strings = make_strings(2000, 40, 42);
+    FlatBinaryVec col = make_col(strings);
+    for_each_simd_level([&] {
+        for (const auto& needle : make_needles()) {
+            Slice slice(needle.data(), needle.size());
+            BitVec prefix = starts_with(col, slice);
+            BitVec suffix = ends_with(col, slice);
+            BitVec contained = contains(col, slice);
+            for (size_t i = 0; i < strings.size(); ++i) {
+                ASSERT_EQ(prefix[i], starts_with(strings[i], needle)) << i << " " << needle;
+                ASSERT_EQ(suffix[i], ends_with(strings[i], needle)) << i << " " << needle;
+                ASSERT_EQ(contained[i], strings[i].find(needle) != std::string::npos)
+                        << i << " " << needle;
+            }
+            for (size_t begin : {1, 7, 1900}) {
+                BitVec bits(strings.size() - begin);
+                contains(col.view(begin, strings.size()), slice, bits.words());
+                for (size_t i = begin; i < strings.size(); ++i) {
+                    ASSERT_EQ(bits[i - begin], strings[i].find(needle) != std::string::npos);
+                }
+            }
+        }
+    });
+}
+
+// long rows: a match skips the rest of its row, up to a whole search chunk
+TEST(StringSearchTest, LongRows) {
+    Strings strings = make_strings(50, 10000, 7);
+    strings.push_back(std::string(5000, 'a') + "needle");
+    strings.push_back("needle" + std::string(5000, 'a'));
+    strings.push_back("need");
+    strings.push_back("le");
+    FlatBinaryVec col = make_col(strings);
+    for_each_simd_level([&] {
+        for (const std::string needle : {"needle", "ab/ab", "bbbbbbbbbbbbbbbbbbbbb"}) {
+            BitVec bits = contains(col, Slice(needle.data(), needle.size()));
+            for (size_t i = 0; i < strings.size(); ++i) {
+                ASSERT_EQ(bits[i], strings[i].find(needle) != std::string::npos)
+                        << i << " " << needle;
+            }
+        }
+    });
+}
+
+TEST(StringSearchTest, StringSet) {
+    Strings strings = make_strings(1000, 6, 3);
+    FlatBinaryVec col = make_col(strings);
+    Strings values = {"", "a", "ab", "ab", "b/b", std::string(3, '\0'), "aaaaaa"};
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(std::string(70 + i, 'a'));
+    }
+    std::vector<Slice> slices;
+    for (const auto& value : values) {
+        slices.emplace_back(value.data(), value.size());
+    }
+    StringSet set(slices);
+    // the duplicate is dropped
+    ASSERT_EQ(set.size(), values.size() - 1);
+    for (const auto& value : values) {
+        ASSERT_TRUE(set.contains(Slice(value.data(), value.size()))) << value;
+    }
+    ASSERT_FALSE(set.contains(Slice("abc", 3)));
+    ASSERT_FALSE(set.contains(Slice(std::string(69, 'a').data(), 69)));
+    BitVec bits = contains(col, set);
+    for (size_t i = 0; i < strings.size(); ++i) {
+        bool expect = std::find(values.begin(), values.end(), strings[i]) != values.end();
+        ASSERT_EQ(bits[i], expect) << strings[i];
+    }
+    ASSERT_TRUE(contains(col, StringSet(std::vector<Slice>())).none());
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vec/binary_vec.h"
+#include "vec/top_n.h"
+#include "vec/vec.h"
+
+namespace vec {
+
+// the first limit rows of a stable sort
+template <typename T>
+std::vector<uint64_t> expect_rows(const std::vector<T>& values, size_t limit, SortOrder order) {
+    std::vector<uint64_t> rows(values.size());
+    std::iota(rows.begin(), rows.end(), 0);
+    std::stable_sort(rows.begin(), rows.end(), [&](uint64_t lhs, uint64_t rhs) {
+        return order == SortOrder::ASC ? values[lhs] < values[rhs] : values[lhs] > values[rhs];
+    });
+    rows.resize(std::min(limit, rows.size()));
+    return rows;
+}
+
+// batches of uneven sizes, values of a small domain so that many tie with the threshold
+template <typename T>
+void check_top_n() {
+    std::default_random_engine e(3);
+    for (int domain : {10, 1000000}) {
+        std::vector<T> values(20000);
+        for (auto& value : values) {
+            value = static_cast<T>(e() % domain) - static_cast<T>(domain / 3);
+        }
+        for (SortOrder order : {SortOrder::ASC, SortOrder::DESC}) {
+            for (size_t limit : {0, 1, 100, 5000, 30000}) {
+                TopN<T> top_n(limit, order);
+                for (size_t begin = 0; begin < values.size();) {
+                    size_t size = std::min<size_t>(e() % 7000, values.size() - begin);
+                    top_n.add(values.data() + begin, size);
+                    begin += size;
+                }
+                ASSERT_EQ(top_n.num_rows(), values.size());
+                std::vector<uint64_t> rows;
+                for (const auto& entry : top_n.sorted()) {
+                    ASSERT_EQ(entry.value, values[entry.row]);
+                    rows.push_back(entry.row);
+                }
+                ASSERT_EQ(rows, expect_rows(values, limit, order)) << domain << " " << limit;
+            }
+        }
+    }
+}
+
+TEST(TopNTest, Int32) {
+    check_top_n<int32_t>();
+}
+
+TEST(TopNTest, Int64) {
+    check_top_n<int64_t>();
+}
+
+TEST(TopNTest, Double) {
+    check_top_n<double>();
+}
+
+// no SIMD compare of its own
+TEST(TopNTest, UInt16) {
+    check_top_n<uint16_t>();
+}
+
+TEST(TopNTest, Vec) {
+    Vec<int64_t> values(10000);
+    for (int i = 0; i < values.len(); ++i) {
+        values[i] = (i * 7919) % 10000;
+    }
+    TopN<int64_t> top_n(3, SortOrder::DESC);
+    top_n.add(values.data(), values.len());
+    ASSERT_TRUE(top_n.full());
+    ASSERT_EQ(top_n.threshold(), 9997);
+    auto entries = top_n.sorted();
+    ASSERT_EQ(entries[0].value, 9999);
+    ASSERT_EQ(entries[2].value, 9997);
+}
+
+// strings that tie on their first 8 bytes or their 4 byte prefix, in both layouts
+TEST(TopNTest, Strings) {
+    std::default_random_engine e(9);
+    const std::vector<std::string> words = {"",         "a",        "abcd",      "abcdefgh",
+                                            "abcdefgz", "abcdefghi", "abcdefghij", "b",
+                                            "zzzzzzzzzzzzzzzz", std::string("a\0", 2)};
+    std::vector<std::string> strings(10000);
+    for (auto& s : strings) {
+        s = words[e() % words.size()];
+        if (e() % 2) {
+            s += std::to_string(e() % 100);
+        }
+    }
+    std::vector<Slice> slices;
+    for (const auto& s : strings) {
+        slices.emplace_back(s.data(), s.size());
+    }
+    FlatBinaryVec flat;
+    flat.build_strings(slices);
+    InlineBinaryVec inline_col;
+    inline_col.build_strings(slices);
+
+    for (SortOrder order : {SortOrder::ASC, SortOrder::DESC}) {
+        for (size_t limit : {1, 10, 500}) {
+            std::vector<uint64_t> expect = expect_rows(strings, limit, order);
+            StringTopN flat_top_n(limit, order);
+            StringTopN inline_top_n(limit, order);
+            for (size_t begin = 0; begin < strings.size(); begin += 3000) {
+                size_t end = std::min(begin + 3000, strings.size());
+                flat_top_n.add(flat.view(begin, end));
+                inline_top_n.add(inline_col.view(begin, end));
+            }
+            for (const auto* top_n : {&flat_top_n, &inline_top_n}) {
+                std::vector<uint64_t> rows;
+                for (const auto& entry : top_n->sorted()) {
+                    ASSERT_EQ(entry.value, strings[entry.row]);
+                    rows.push_back(entry.row);
+                }
+                ASSERT_EQ(rows, expect) << limit;
+            }
+        }
+    }
+}
+
+} // namespace vec
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}